@@ -0,0 +1,55 @@
+// $group over input sorted on the _id, by a $sort or by an index, returns the same groups as over
+// unsorted input.
+
+t = db.jstests_aggregation_group_sorted_input;
+t.drop();
+
+var values = [ 1, NumberLong(5), 2.5, 'x', 'y', null, undefined, [ 1 ], [ 1, 2 ], [],
+               { z:1 }, MinKey, MaxKey ];
+for ( var i = 0; i < 200; i++ ) {
+    var doc = { b:i, c:i % 3 };
+    if ( i % 17 != 0 ) {
+        doc.a = values[ i % values.length ];
+    }
+    t.save( doc );
+}
+
+var accumulators = { s:{ $sum:'$b' }, v:{ $avg:'$b' }, lo:{ $min:'$b' }, hi:{ $max:'$b' },
+                     n:{ $sum:1 }, all:{ $push:'$b' } };
+
+function groupSpec( id ) {
+    var spec = { _id:id };
+    for ( var field in accumulators ) {
+        spec[ field ] = accumulators[ field ];
+    }
+    return spec;
+}
+
+// Order the groups, and the values pushed into each of them, so results can be compared.
+function normalize( results ) {
+    results.forEach( function( group ) { group.all.sort( function( x, y ) { return x - y; } ); } );
+    return results.sort( function( x, y ) { return bsonWoCompare( { x:x._id }, { x:y._id } ); } );
+}
+
+function assertSameGroups( id, sort ) {
+    var expected = normalize( t.aggregate( { $group:groupSpec( id ) } ).toArray() );
+    var sorted = normalize( t.aggregate( { $sort:sort }, { $group:groupSpec( id ) } ).toArray() );
+    assert.eq( expected, sorted, tojson( sort ) );
+}
+
+function checkAll() {
+    assertSameGroups( '$a', { a:1 } );
+    assertSameGroups( '$a', { a:-1, c:1 } );
+    assertSameGroups( { x:'$a', y:'$c' }, { a:1, c:1 } );
+    assertSameGroups( { x:'$c', y:'$a' }, { a:1, c:-1 } );
+    assertSameGroups( '$c', { c:1 } );
+}
+
+// The $sort is done in the pipeline.
+checkAll();
+
+// The $sort is provided by a (multikey) index scan.
+t.ensureIndex( { a:1 } );
+t.ensureIndex( { a:1, c:1 } );
+t.ensureIndex( { c:1 } );
+checkAll();
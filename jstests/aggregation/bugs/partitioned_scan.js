@@ -0,0 +1,58 @@
+// A collection scan into a $group or $sort split across threads with internalAggregationPartitions
+// returns the same results as a single scan.
+
+t = db.jstests_aggregation_partitioned_scan;
+t.drop();
+
+var padding = new Array( 200 ).join( 'x' );
+for ( var i = 0; i < 20000; i++ ) {
+    t.save( { _id:i, a:i % 37, b:i % 101, c:( i * 7919 ) % 20000, s:padding } );
+}
+// There must be several extents for the scan to be split.
+assert.gt( t.stats().numExtents, 2 );
+
+var pipelines = [
+    [ { $group:{ _id:'$a', n:{ $sum:1 }, s:{ $sum:'$b' }, v:{ $avg:'$b' }, lo:{ $min:'$c' },
+                 hi:{ $max:'$c' } } },
+      { $sort:{ _id:1 } } ],
+    [ { $match:{ b:{ $lt:50 } } }, { $group:{ _id:{ a:'$a', odd:{ $mod:[ '$b', 2 ] } },
+                                              n:{ $sum:1 } } },
+      { $sort:{ '_id.a':1, '_id.odd':1 } } ],
+    [ { $project:{ c:1, d:{ $add:[ '$a', '$b' ] } } }, { $match:{ d:{ $gt:60 } } },
+      { $group:{ _id:null, n:{ $sum:1 }, d:{ $sum:'$d' } } } ],
+    [ { $sort:{ c:1 } }, { $project:{ a:1, c:1 } } ],
+    [ { $match:{ a:5 } }, { $sort:{ c:-1 } }, { $limit:10 } ],
+    [ { $sort:{ c:1 } }, { $skip:19990 } ]
+];
+
+function runAll() {
+    return pipelines.map( function( pipeline ) {
+        return t.aggregate( pipeline, { allowDiskUse:true } ).toArray();
+    } );
+}
+
+function setPartitions( n ) {
+    assert.commandWorked( db.adminCommand( { setParameter:1, internalAggregationPartitions:n } ) );
+}
+
+setPartitions( 0 );
+var expected = runAll();
+
+try {
+    setPartitions( 4 );
+    var partitioned = runAll();
+    for ( var i = 0; i < pipelines.length; i++ ) {
+        assert.eq( expected[ i ], partitioned[ i ], tojson( pipelines[ i ] ) );
+    }
+
+    // Results are still returned correctly through getMore, and a cursor that isn't exhausted can
+    // be killed by dropping the collection.
+    var cursor = t.aggregate( [ { $sort:{ c:1 } } ], { cursor:{ batchSize:10 } } );
+    for ( var i = 0; i < 100; i++ ) {
+        assert.eq( i, cursor.next().c );
+    }
+    t.drop();
+}
+finally {
+    setPartitions( 0 );
+}
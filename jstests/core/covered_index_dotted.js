@@ -0,0 +1,44 @@
+// Projections of dotted fields are never covered by an index, since the index key doesn't say
+// whether a part of the path was an array.
+
+var coll = db.getCollection("covered_index_dotted");
+coll.drop();
+for (var i = 0; i < 10; i++) {
+    coll.insert({a: {b: i, c: "c" + i, d: {e: i * 2}}, f: i, big: new Array(1000).join("x")});
+}
+coll.ensureIndex({"a.b": 1, "a.c": 1, "a.d.e": 1, f: 1});
+
+// Single dotted field, without any array
+var plan = coll.find({"a.b": 3}, {"a.b": 1, _id: 0}).explain();
+assert.eq(false, plan.indexOnly, "dotted.1.1 - indexOnly should be false for a dotted field");
+assert.eq([{a: {b: 3}}], coll.find({"a.b": 3}, {"a.b": 1, _id: 0}).toArray(), "dotted.1.1");
+
+// Several dotted fields sharing a prefix, at different depths, mixed with a top-level field
+var proj = {"a.c": 1, f: 1, "a.d.e": 1, "a.b": 1, _id: 0};
+plan = coll.find({"a.b": {$gte: 8}}, proj).explain();
+assert.eq(false, plan.indexOnly, "dotted.1.2 - indexOnly should be false for dotted fields");
+var results = coll.find({"a.b": {$gte: 8}}, proj).sort({"a.b": 1}).toArray();
+assert.eq(2, results.length, "dotted.1.2");
+for (var i = 0; i < results.length; i++) {
+    var n = 8 + i;
+    assert.eq({a: {b: n, c: "c" + n, d: {e: n * 2}}, f: n}, results[i], "dotted.1.2");
+}
+
+// An array with a single element generates a single key, so the index is not multikey, but the
+// array has to be in the output
+coll.insert({a: [{b: 100, c: "x", d: {e: 1}}], f: 100});
+plan = coll.find({"a.b": 100}, {"a.b": 1, _id: 0}).explain();
+assert.eq(false, plan.isMultiKey, "dotted.1.3 - index should not be multikey");
+assert.eq(false, plan.indexOnly, "dotted.1.3 - indexOnly should be false for a dotted field");
+assert.eq([{a: [{b: 100}]}], coll.find({"a.b": 100}, {"a.b": 1, _id: 0}).toArray(), "dotted.1.3");
+
+// Arrays with several elements
+coll.insert({a: [{b: 200, c: "y"}, {b: 201, c: "z"}], f: 200});
+plan = coll.find({"a.b": 200}, {"a.b": 1, _id: 0}).explain();
+assert.eq(true, plan.isMultiKey, "dotted.1.4 - index should be multikey");
+assert.eq(false, plan.indexOnly, "dotted.1.4 - indexOnly should be false for a dotted field");
+assert.eq([{a: [{b: 200}, {b: 201}]}], coll.find({"a.b": 200}, {"a.b": 1, _id: 0}).toArray(),
+          "dotted.1.4");
+assert.eq([{a: {b: 3}}], coll.find({"a.b": 3}, {"a.b": 1, _id: 0}).toArray(), "dotted.1.4");
+
+print('all tests pass');
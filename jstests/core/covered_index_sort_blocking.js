@@ -0,0 +1,31 @@
+// Covered index query test with a sort the index order can't provide
+
+var coll = db.getCollection("covered_sort_blocking")
+coll.drop()
+for (i=0;i<20;i++) {
+    coll.insert({a:i % 4, b:19 - i, c:i})
+}
+coll.ensureIndex({a:1, b:1})
+
+// Test range query sorted on the second field of the index
+var cursor = coll.find({a:{$gt:0}}, {a:1, b:1, _id:0}).sort({b:1}).hint({a:1, b:1})
+var results = cursor.toArray()
+assert.eq(15, results.length, "sort.blocking.1 - wrong number of results")
+for (i=1;i<results.length;i++) {
+    assert.lte(results[i-1].b, results[i].b, "sort.blocking.1 - results out of order")
+}
+assert.eq(undefined, results[0].c, "sort.blocking.1 - unprojected field returned")
+var plan = cursor.explain()
+assert.eq(true, plan.indexOnly, "sort.blocking.1 - indexOnly should be true on covered query")
+assert.eq(0, plan.nscannedObjects, "sort.blocking.1 - nscannedObjects should be 0 for covered query")
+
+// Test compound sort against the index order
+var plan = coll.find({a:{$gt:0}}, {a:1, b:1, _id:0}).sort({b:-1, a:1}).hint({a:1, b:1}).explain()
+assert.eq(true, plan.indexOnly, "sort.blocking.2 - indexOnly should be true on covered query")
+assert.eq(0, plan.nscannedObjects, "sort.blocking.2 - nscannedObjects should be 0 for covered query")
+
+// Test sort on a field the projection drops
+var plan = coll.find({a:{$gt:0}}, {a:1, _id:0}).sort({b:1}).hint({a:1, b:1}).explain()
+assert.eq(false, plan.indexOnly, "sort.blocking.3 - indexOnly should be false on non covered query")
+
+print ('all tests pass')
@@ -48,3 +48,11 @@ assert.eq({query: {a: 1, b: 1}, sort: {a: -1}, projection: {_id: 1, a: 1}}, shap
 assert.eq(1, t.find({a: 1, b: 1}).itcount(), 'unexpected document count');
 shapes = getShapes();
 assert.eq(2, shapes.length, 'unexpected number of shapes in planCacheListQueryShapes result');
+
+// The result also carries the cache's counters. Running a cached shape again is a hit.
+var stats = t.runCommand('planCacheListQueryShapes').stats;
+assert(stats, 'stats missing from planCacheListQueryShapes result');
+assert.eq(1, t.find({a: 1, b: 1}).itcount(), 'unexpected document count');
+var statsAfter = t.runCommand('planCacheListQueryShapes').stats;
+assert.gt(statsAfter.hits, stats.hits, 'cached plan lookup not counted as a hit');
+assert.gte(statsAfter.misses, stats.misses, 'misses should never decrease');
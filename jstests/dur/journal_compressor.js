@@ -0,0 +1,74 @@
+/* durability test: journal files written with journalCompressor=none, whose sections are flagged
+   uncompressed, and files written with the default snappy compressor are both recovered after
+   an unclean shutdown, whichever compressor the recovering mongod uses
+*/
+
+var testname = "journal_compressor";
+var step = 1;
+var conn = null;
+
+function log(str) {
+    if (str)
+        print("\n" + testname + " step " + step++ + " " + str);
+    else
+        print("\n" + testname + " step " + step++);
+}
+
+// compressible and incompressible documents, with _id set so that counts are exact
+function work(name) {
+    log("work " + name);
+    var coll = conn.getDB("test")[name];
+    var big = new Array(4000).join("x");
+    for (var i = 0; i < 200; i++) {
+        coll.insert({ _id: i, s: big, r: Math.random().toString() + Math.random().toString() });
+    }
+    for (var i = 0; i < 200; i += 2) {
+        coll.update({ _id: i }, { $set: { updated: true } });
+    }
+    coll.remove({ _id: { $gte: 150 } });
+
+    // assure writes applied in case we kill -9 on return from this function
+    assert.writeOK(coll.insert({ _id: "last" }, { writeConcern: { fsync: 1 }}));
+}
+
+function verify(name) {
+    log("verify " + name);
+    var coll = conn.getDB("test")[name];
+    assert.eq(151, coll.count(), name + " count");
+    assert.eq(75, coll.count({ updated: true }), name + " updates");
+    assert.eq(null, coll.findOne({ _id: 150 }), name + " remove");
+    assert.eq(1, coll.count({ s: { $exists: false } }), name + " only the last insert is small");
+}
+
+var path = MongoRunner.dataPath + testname;
+
+log("mongod with journalCompressor=none");
+conn = startMongodEmpty("--port", 30001, "--dbpath", path, "--dur", "--smallfiles",
+                        "--durOptions", 8, "--setParameter", "journalCompressor=none");
+work("uncompressed");
+verify("uncompressed");
+log("kill 9");
+stopMongod(30001, /*signal*/9);
+
+// replay the whole journal, not only what is newer than the last sync
+removeFile(path + "/lsn");
+
+log("recover uncompressed sections with snappy");
+conn = startMongodNoReset("--port", 30002, "--dbpath", path, "--dur", "--smallfiles",
+                          "--durOptions", 8);
+verify("uncompressed");
+work("compressed");
+verify("compressed");
+log("kill 9");
+stopMongod(30002, /*signal*/9);
+
+removeFile(path + "/lsn");
+
+log("recover compressed sections with journalCompressor=none");
+conn = startMongodNoReset("--port", 30003, "--dbpath", path, "--dur", "--smallfiles",
+                          "--setParameter", "journalCompressor=none");
+verify("uncompressed");
+verify("compressed");
+stopMongod(30003);
+
+print(testname + " SUCCESS");
@@ -0,0 +1,114 @@
+/* durability test: recovering with several threads gives the same data files as recovering
+   serially, for writes to several databases with a database drop in the middle
+*/
+
+var testname = "parallel_recovery";
+var step = 1;
+var conn = null;
+
+var dbNames = ["test", "test2", "test3"];
+
+function runDiff(a, b) {
+    function reSlash(s) {
+        var x = s;
+        if (_isWindows()) {
+            while (1) {
+                var y = x.replace('/', '\\');
+                if (y == x)
+                    break;
+                x = y;
+            }
+        }
+        return x;
+    }
+    a = reSlash(a);
+    b = reSlash(b);
+    print("diff " + a + " " + b);
+    return run("diff", a, b);
+}
+
+function log(str) {
+    if (str)
+        print("\n" + testname + " step " + step++ + " " + str);
+    else
+        print("\n" + testname + " step " + step++);
+}
+
+// set _id on inserts, so that the data files are the same on every run
+function work() {
+    log("work (writes to several databases, drop one of them)");
+
+    var big = new Array(2000).join("x");
+    for (var i = 0; i < 300; i++) {
+        for (var j = 0; j < dbNames.length; j++) {
+            conn.getDB(dbNames[j]).foo.insert({ _id: i, x: i, s: big });
+        }
+    }
+    for (var i = 0; i < 300; i += 3) {
+        conn.getDB("test").foo.update({ _id: i }, { $inc: { x: 1000 } });
+        conn.getDB("test2").foo.remove({ _id: i });
+    }
+
+    // a DurOp between writes to the same files
+    conn.getDB("test3").dropDatabase();
+    for (var i = 0; i < 50; i++) {
+        conn.getDB("test3").foo.insert({ _id: i, y: i });
+    }
+
+    // assure writes applied in case we kill -9 on return from this function
+    assert.writeOK(conn.getDB("test").foo.insert({ _id: "last" }, { writeConcern: { fsync: 1 }}));
+}
+
+function verify() {
+    log("verify");
+    assert.eq(301, conn.getDB("test").foo.count(), "test.foo");
+    assert.eq(1002, conn.getDB("test").foo.findOne({ _id: 2 }).x, "test.foo update");
+    assert.eq(200, conn.getDB("test2").foo.count(), "test2.foo");
+    assert.eq(null, conn.getDB("test2").foo.findOne({ _id: 3 }), "test2.foo remove");
+    assert.eq(50, conn.getDB("test3").foo.count(), "test3.foo");
+    assert.eq(null, conn.getDB("test3").foo.findOne({ s: { $exists: true } }), "test3 dropped");
+}
+
+// directories
+var serialPath = MongoRunner.dataPath + testname + "serial";
+var parallelPath = MongoRunner.dataPath + testname + "parallel";
+
+log("mongod dur");
+conn = startMongodEmpty("--port", 30001, "--dbpath", serialPath, "--dur", "--smallfiles",
+                        "--durOptions", 8);
+work();
+verify();
+
+// kill the process hard, so that everything is recovered from the journal
+log("kill 9");
+stopMongod(30001, /*signal*/9);
+
+// replay the whole journal, not only what is newer than the last sync
+removeFile(serialPath + "/lsn");
+copyDbpath(serialPath, parallelPath);
+
+log("recover with one thread");
+conn = startMongodNoReset("--port", 30002, "--dbpath", serialPath, "--dur", "--smallfiles",
+                          "--setParameter", "journalRecoveryThreads=1");
+verify();
+stopMongod(30002);
+
+log("recover with several threads");
+conn = startMongodNoReset("--port", 30003, "--dbpath", parallelPath, "--dur", "--smallfiles",
+                          "--setParameter", "journalRecoveryThreads=4");
+verify();
+stopMongod(30003);
+
+log("check data files match");
+dbNames.forEach(function(name) {
+    [".ns", ".0"].forEach(function(ext) {
+        var diff = runDiff(serialPath + "/" + name + ext, parallelPath + "/" + name + ext);
+        if (diff != "") {
+            print("\n\n\nDIFFERS\n");
+            print(diff);
+        }
+        assert(diff == "", "error " + name + ext + " files differ");
+    });
+});
+
+print(testname + " SUCCESS");
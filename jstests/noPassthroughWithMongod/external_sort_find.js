@@ -0,0 +1,33 @@
+// Ensure a find with $allowDiskUse can sort more than the in-memory sort limit on disk
+var t = db.external_sort_find;
+t.drop();
+t.ensureIndex({text: "text"});
+var big = Array(210000).join("asdf ");
+for (i = 0; i < 40; i++) {
+    // 40 strings over 1MB each to go over the 32MB in-memory sort limit
+    t.insert({_id: i, x: (i * 7) % 40, text: big});
+}
+
+// Without the option the sort fails as before.
+assert.throws(function() { t.find().sort({x: 1}).itcount(); });
+
+// With it, the results come back in order.
+var cursor = t.find().sort({x: -1}).addSpecial("$allowDiskUse", true);
+for (i = 39; i >= 0; i--) {
+    assert.eq(i, cursor.next().x);
+}
+assert(!cursor.hasNext());
+
+var spillsBefore = db.serverStatus().metrics.query.sort.spills;
+assert.eq(40, t.find().sort({x: 1}).addSpecial("$allowDiskUse", true).itcount());
+assert.gt(db.serverStatus().metrics.query.sort.spills, spillsBefore);
+
+// Text search metadata survives the trip to disk.
+var score = t.find({$text: {$search: "asdf"}}, {score: {$meta: "textScore"}}).next().score;
+var res = t.find({$text: {$search: "asdf"}}, {score: {$meta: "textScore"}, text: 0})
+           .sort({_id: 1}).addSpecial("$allowDiskUse", true).toArray();
+assert.eq(40, res.length);
+for (i = 0; i < 40; i++) {
+    assert.eq(i, res[i]._id);
+    assert.eq(score, res[i].score);
+}
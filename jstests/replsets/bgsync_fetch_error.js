@@ -0,0 +1,47 @@
+// An error in the oplog fetch loop, while a batch of fetched ops is only partly filled, must not
+// lose that batch: its ops still get applied, and the secondary can still become primary.
+
+var replSet = new ReplSetTest({name: 'bgsyncFetchError', nodes: 3});
+var nodes = replSet.startSet();
+replSet.initiate(
+    {
+        _id: 'bgsyncFetchError',
+        members:
+        [
+            {_id: 0, host: getHostName()+":"+replSet.ports[0], priority: 2},
+            {_id: 1, host: getHostName()+":"+replSet.ports[1]},
+            {_id: 2, host: getHostName()+":"+replSet.ports[2], priority: 0}
+        ]
+    }
+);
+
+replSet.waitForState(nodes[0], replSet.PRIMARY, 60 * 1000);
+var master = replSet.getMaster();
+var coll = master.getDB("foo").bar;
+assert.writeOK(coll.insert({_id: 0}));
+replSet.awaitReplication();
+
+jsTest.log("Throw from node 1's fetch loop right after the next op is staged");
+assert.commandWorked(nodes[1].getDB("admin").runCommand(
+    {configureFailPoint: 'rsBgSyncFetchThrow', mode: {times: 1}}));
+
+// the staged op has to reach node 1 for the write concern to be satisfied
+for (var i = 1; i <= 10; i++) {
+    assert.writeOK(coll.insert({_id: i}, {writeConcern: {w: 3, wtimeout: 60 * 1000}}));
+}
+nodes[1].setSlaveOk();
+assert.eq(11, nodes[1].getDB("foo").bar.count());
+
+jsTest.log("Step down node 0, node 1 must be able to take over");
+try {
+    master.getDB("admin").runCommand({replSetStepDown: 60, force: true});
+}
+catch (e) {
+    // the step down closes all connections
+}
+replSet.waitForState(nodes[1], replSet.PRIMARY, 60 * 1000);
+
+assert.writeOK(nodes[1].getDB("foo").bar.insert({_id: 11}));
+assert.eq(12, nodes[1].getDB("foo").bar.count());
+
+replSet.stopSet();
@@ -0,0 +1,90 @@
+//
+// Tests that queries through mongos return the same results with internalParallelCursorPrefetch,
+// which sends each shard's next getMore ahead of consuming its current batch, and that
+// abandoned cursors with a getMore in flight are cleaned up on the shards.
+//
+
+var st = new ShardingTest({ shards : 3, mongos : 1, other : { separateConfig : true } });
+st.stopBalancer();
+
+var mongos = st.s0;
+var admin = mongos.getDB( "admin" );
+var config = mongos.getDB( "config" );
+var shards = config.shards.find().toArray();
+var coll = mongos.getCollection( "foo.bar" );
+
+printjson(admin.runCommand({ enableSharding : coll.getDB() + "" }));
+printjson(admin.runCommand({ movePrimary : coll.getDB() + "", to : shards[0]._id }));
+printjson(admin.runCommand({ shardCollection : coll + "", key : { _id : 1 } }));
+printjson(admin.runCommand({ split : coll + "", middle : { _id : 1000 } }));
+printjson(admin.runCommand({ split : coll + "", middle : { _id : 2000 } }));
+printjson(admin.runCommand({ moveChunk : coll + "", find : { _id : 1000 }, to : shards[1]._id }));
+printjson(admin.runCommand({ moveChunk : coll + "", find : { _id : 2000 }, to : shards[2]._id }));
+
+jsTest.log("Collection set up...");
+st.printShardingStatus(true);
+
+var bulk = coll.initializeUnorderedBulkOp();
+for (var i = 0; i < 3000; i++) {
+    bulk.insert({ _id : i, x : (i * 7919) % 3000 });
+}
+assert.writeOK(bulk.execute());
+
+var queries = [ function() { return coll.find().batchSize(7); },
+                function() { return coll.find().sort({ x : 1 }).batchSize(7); },
+                function() { return coll.find({ x : { $gt : 100 } }).sort({ x : -1 }).batchSize(50); },
+                function() { return coll.find().sort({ x : 1 }).skip(1500).batchSize(3); } ];
+
+function runAll() {
+    return queries.map(function(query) {
+        return query().toArray().map(function(doc) { return doc._id; });
+    });
+}
+
+function setPrefetch(prefetch) {
+    assert.commandWorked(admin.runCommand({ setParameter : 1,
+                                            internalParallelCursorPrefetch : prefetch }));
+}
+
+function openShardCursors() {
+    var open = 0;
+    for (var i = 0; i < shards.length; i++) {
+        open += st["shard" + i].getDB("admin").serverStatus().metrics.cursor.open.total;
+    }
+    return open;
+}
+
+var expected = runAll();
+assert.eq(3000, expected[0].length);
+
+setPrefetch(true);
+
+jsTest.log("Compare results with prefetched getMores.");
+
+var prefetched = runAll();
+for (var i = 0; i < queries.length; i++) {
+    // Without a sort the order the shards' results are interleaved in may differ
+    if (i == 0) {
+        prefetched[i].sort();
+        expected[i].sort();
+    }
+    assert.eq(expected[i], prefetched[i], queries[i].toString());
+}
+
+jsTest.log("Abandon cursors with getMores in flight.");
+
+var cursor = coll.find().sort({ x : 1 }).batchSize(5);
+for (var i = 0; i < 20; i++) {
+    assert.eq(i, cursor.next().x);
+}
+assert.gt(openShardCursors(), 0);
+cursor.close();
+
+assert.soon(function() { return openShardCursors() == 0; },
+            "shard cursors left open: " + openShardCursors());
+
+setPrefetch(false);
+
+jsTest.log("DONE!");
+
+st.stop();
@@ -147,22 +147,41 @@ namespace mongo {
         return ok;
     }
 
+    void DBClientCursor::_assembleGetMore( Message& toSend ) {
+        BufBuilder b;
+        b.appendNum(opts);
+        b.appendStr(ns);
+        b.appendNum(nextBatchSize());
+        b.appendNum(cursorId);
+        toSend.setData(dbGetMore, b.buf(), b.len());
+    }
+
     void DBClientCursor::requestMore() {
         verify( cursorId && batch.pos == batch.nReturned );
 
+        auto_ptr<Message> response(new Message());
+
+        if ( _prefetchConn ) {
+            // The getMore was sent when the current batch was received
+            scoped_ptr<ScopedDbConnection> conn( _prefetchConn );
+            _prefetchConn = NULL;
+            uassert( 18656, "recv failed for prefetched getMore", conn->get()->recv( *response ) );
+            _client = conn->get();
+            this->batch.m = response;
+            dataReceived();
+            _client = 0;
+            conn->done();
+            prefetchMore();
+            return;
+        }
+
         if (haveLimit) {
             nToReturn -= batch.nReturned;
             verify(nToReturn > 0);
         }
-        BufBuilder b;
-        b.appendNum(opts);
-        b.appendStr(ns);
-        b.appendNum(nextBatchSize());
-        b.appendNum(cursorId);
 
         Message toSend;
-        toSend.setData(dbGetMore, b.buf(), b.len());
-        auto_ptr<Message> response(new Message());
+        _assembleGetMore( toSend );
 
         if ( _client ) {
             _client->call( toSend, *response );
@@ -178,9 +197,27 @@ namespace mongo {
             dataReceived();
             _client = 0;
             conn.done();
+            prefetchMore();
         }
     }
 
+    void DBClientCursor::prefetchMore() {
+        // A limit is applied to nToReturn when the next batch is requested, which more() relies
+        // on while the current batch is read, so only cursors without one prefetch.
+        if ( !_prefetch || _prefetchConn || _client || !cursorId || haveLimit || tailable() ||
+             ( opts & QueryOption_Exhaust ) )
+            return;
+
+        verify( _scopedHost.size() );
+
+        Message toSend;
+        _assembleGetMore( toSend );
+
+        auto_ptr<ScopedDbConnection> conn( new ScopedDbConnection( _scopedHost ) );
+        conn->get()->say( toSend );
+        _prefetchConn = conn.release();
+    }
+
     /** with QueryOption_Exhaust, the server just blasts data at us (marked at end with cursorid==0). */
     void DBClientCursor::exhaustReceiveMore() {
         verify( cursorId && batch.pos == batch.nReturned );
@@ -347,6 +384,8 @@ namespace mongo {
         conn->done();
         _client = 0;
         _lazyHost = "";
+
+        prefetchMore();
     }
 
     DBClientCursor::~DBClientCursor() {
@@ -355,6 +394,20 @@ namespace mongo {
 
         DESTRUCTOR_GUARD (
 
+        if ( _prefetchConn ) {
+            // Wait for the reply to the getMore in flight, so that the connection can be reused
+            // and the cursor isn't killed if that getMore exhausted it.
+            scoped_ptr<ScopedDbConnection> conn( _prefetchConn );
+            _prefetchConn = NULL;
+
+            Message response;
+            if ( conn->get()->recv( response ) && !response.empty() ) {
+                QueryResult::View qr = response.singleData().view2ptr();
+                cursorId = qr.getCursorId();
+                conn->done();
+            }
+        }
+
         if ( cursorId && _ownCursor && ! inShutdown() ) {
             BufBuilder b;
             b.appendNum( (int)0 ); // reserved
@@ -40,6 +40,7 @@
 namespace mongo {
 
     class AScopedConnection;
+    class ScopedDbConnection;
 
     /** for mock purposes only -- do not create variants of DBClientCursor, nor hang code here
         @see DBClientMockCursor
@@ -149,7 +150,9 @@ namespace mongo {
             resultFlags(0),
             cursorId(),
             _ownCursor( true ),
-            wasError( false ) {
+            wasError( false ),
+            _prefetch( false ),
+            _prefetchConn( NULL ) {
             _finishConsInit();
         }
 
@@ -165,7 +168,9 @@ namespace mongo {
             resultFlags(0),
             cursorId(_cursorId),
             _ownCursor(true),
-            wasError(false) {
+            wasError(false),
+            _prefetch(false),
+            _prefetchConn(NULL) {
             _finishConsInit();
         }
 
@@ -180,6 +185,15 @@ namespace mongo {
 
         void attach( AScopedConnection * conn );
 
+        /**
+         * Once attached, send the getMore for the next batch as soon as a batch is received
+         * rather than when it is consumed, so that the next batch is on its way while this one is
+         * being read. Holds a pooled connection to the host while the getMore is in flight.
+         *
+         * Cursors with a limit, tailable and exhaust cursors don't prefetch.
+         */
+        void setPrefetch( bool prefetch ) { _prefetch = prefetch; prefetchMore(); }
+
         std::string originalHost() const { return _originalHost; }
 
         std::string getns() const { return ns; }
@@ -239,10 +253,13 @@ namespace mongo {
         std::string _scopedHost;
         std::string _lazyHost;
         bool wasError;
+        bool _prefetch; // see setPrefetch()
+        ScopedDbConnection* _prefetchConn; // owned, set while a prefetched getMore is in flight
 
         void dataReceived() { bool retry; std::string lazyHost; dataReceived( retry, lazyHost ); }
         void dataReceived( bool& retry, std::string& lazyHost );
         void requestMore();
+        void prefetchMore();
         void exhaustReceiveMore(); // for exhaust
 
         // Don't call from a virtual function
@@ -254,6 +271,7 @@ namespace mongo {
 
         // init pieces
         void _assembleInit( Message& toSend );
+        void _assembleGetMore( Message& toSend );
     };
 
     /** iterate over objects in current batch only - will not cause a network call
@@ -38,6 +38,7 @@
 #include "mongo/client/dbclientcursor.h"
 #include "mongo/db/dbmessage.h"
 #include "mongo/db/query/lite_parsed_query.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/s/chunk.h"
 #include "mongo/s/chunk_version.h"
 #include "mongo/s/config.h"
@@ -50,6 +51,11 @@ namespace mongo {
 
     LabeledLevel pc( "pcursor", 2 );
 
+    // Sends the getMore for each shard's next batch as soon as its current batch is received, so
+    // that merging doesn't wait a round trip whenever a shard's batch runs out. Holds a pooled
+    // connection per shard for each open cursor.
+    MONGO_EXPORT_SERVER_PARAMETER( internalParallelCursorPrefetch, bool, false );
+
     void ParallelSortClusteredCursor::init() {
         if ( _didInit )
             return;
@@ -916,6 +922,7 @@ namespace mongo {
 
                     // Finalize state
                     state->cursor->attach( state->conn.get() ); // Closes connection for us
+                    state->cursor->setPrefetch( internalParallelCursorPrefetch );
 
                     LOG( pc ) << "finished on shard " << shard
                         << ", current connection state is " << mdata.toBSON() << endl;
@@ -34,6 +34,9 @@
 
 #include "mongo/db/catalog/index_create.h"
 
+#include <boost/thread/condition.hpp>
+#include <boost/thread/mutex.hpp>
+
 #include "mongo/base/error_codes.h"
 #include "mongo/client/dbclientinterface.h"
 #include "mongo/db/audit.h"
@@ -46,12 +49,18 @@
 #include "mongo/db/repl/repl_coordinator_global.h"
 #include "mongo/db/repl/rs.h"
 #include "mongo/db/operation_context.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/util/concurrency/thread_pool.h"
 #include "mongo/util/log.h"
 #include "mongo/util/processinfo.h"
 #include "mongo/util/progress_meter.h"
 
 namespace mongo {
 
+    // Threads generating index keys during a foreground build. 0 generates them on the thread
+    // scanning the collection.
+    MONGO_EXPORT_SERVER_PARAMETER(internalIndexBuildKeyGenThreads, int, 0);
+
     /**
      * On rollback sets MultiIndexBlock::_needToCleanup to true.
      */
@@ -66,6 +75,134 @@ namespace mongo {
         MultiIndexBlock* const _indexer;
     };
 
+    /**
+     * Feeds the documents of a collection scan to the bulk builders of a foreground index build
+     * from a pool of worker threads, so that key generation overlaps with the scan and the keys
+     * of different indexes are generated concurrently.
+     *
+     * Documents are handed over in batches: while the workers insert one batch into every index,
+     * the scan fills the next. A bulk builder is not thread safe, so each index is only ever
+     * worked on by one thread at a time.
+     */
+    class MultiIndexBlock::ParallelKeyGenerator {
+        MONGO_DISALLOW_COPYING(ParallelKeyGenerator);
+    public:
+        ParallelKeyGenerator(OperationContext* txn,
+                             std::vector<IndexToBuild>* indexes,
+                             int threads)
+            : _txn(txn),
+              _indexes(indexes),
+              _filling(new Batch()),
+              _tasksInFlight(0),
+              _status(Status::OK()),
+              _pool(threads) {
+        }
+
+        /**
+         * Queues a document. Returns the error of an earlier batch, if any.
+         */
+        Status add(const BSONObj& doc, const DiskLoc& loc) {
+            _filling->docs.push_back(std::make_pair(doc.getOwned(), loc));
+            _filling->bytes += doc.objsize();
+
+            if (_filling->docs.size() < kMaxBatchDocs && _filling->bytes < kMaxBatchBytes)
+                return Status::OK();
+
+            return _dispatch();
+        }
+
+        /**
+         * Inserts the remaining documents and waits for the workers to finish.
+         */
+        Status done() {
+            Status status = _dispatch();
+            if (!status.isOK())
+                return status;
+            return _wait();
+        }
+
+    private:
+        static const size_t kMaxBatchDocs = 1000;
+        static const size_t kMaxBatchBytes = 16 * 1024 * 1024;
+
+        struct Batch {
+            Batch() : bytes(0) {}
+            std::vector<std::pair<BSONObj, DiskLoc> > docs;
+            size_t bytes;
+        };
+
+        /**
+         * Waits for the previous batch and hands the one being filled to the workers.
+         */
+        Status _dispatch() {
+            Status status = _wait();
+            if (!status.isOK() || _filling->docs.empty())
+                return status;
+
+            boost::shared_ptr<Batch> batch;
+            batch.swap(_filling);
+            _filling.reset(new Batch());
+
+            {
+                boost::lock_guard<boost::mutex> lk(_mutex);
+                _tasksInFlight = _indexes->size();
+            }
+            for (size_t i = 0; i < _indexes->size(); i++) {
+                _pool.schedule(&ParallelKeyGenerator::_insertBatch, this, i, batch);
+            }
+            return Status::OK();
+        }
+
+        Status _wait() {
+            boost::unique_lock<boost::mutex> lk(_mutex);
+            while (_tasksInFlight)
+                _batchDone.wait(lk);
+            return _status;
+        }
+
+        /**
+         * Runs on a pool thread. Bulk builders only generate keys and add them to their sorter,
+         * so sharing the OperationContext with the scanning thread is safe.
+         */
+        void _insertBatch(size_t index, boost::shared_ptr<Batch> batch) {
+            IndexToBuild& toBuild = (*_indexes)[index];
+            Status status = Status::OK();
+            try {
+                for (size_t i = 0; i < batch->docs.size() && status.isOK(); i++) {
+                    int64_t unused = 0;
+                    status = toBuild.bulk->insert(_txn,
+                                                  batch->docs[i].first,
+                                                  batch->docs[i].second,
+                                                  toBuild.options,
+                                                  &unused);
+                }
+            }
+            catch (const DBException& e) {
+                status = e.toStatus();
+            }
+            catch (const std::exception& e) {
+                status = Status(ErrorCodes::InternalError, e.what());
+            }
+
+            boost::lock_guard<boost::mutex> lk(_mutex);
+            if (!status.isOK() && _status.isOK())
+                _status = status;
+            if (--_tasksInFlight == 0)
+                _batchDone.notify_all();
+        }
+
+        OperationContext* const _txn;
+        std::vector<IndexToBuild>* const _indexes;
+        boost::shared_ptr<Batch> _filling;
+
+        boost::mutex _mutex; // guards the fields below
+        boost::condition _batchDone;
+        size_t _tasksInFlight;
+        Status _status; // first error from any batch
+
+        ThreadPool _pool; // declared last so it is joined before anything else is destroyed
+    };
+
     MultiIndexBlock::MultiIndexBlock(OperationContext* txn, Collection* collection)
         : _collection(collection),
           _txn(txn),
@@ -204,10 +341,28 @@ namespace mongo {
                                                                       _collection->ns().ns(),
                                                                       _collection));
 
+        // Bulk builders write nothing until doneInserting(), so their keys can be generated off
+        // the scanning thread.
+        scoped_ptr<ParallelKeyGenerator> keyGenerator;
+        bool allBulk = !_indexes.empty();
+        for (size_t i = 0; i < _indexes.size(); i++) {
+            allBulk = allBulk && _indexes[i].bulk != NULL;
+        }
+        if (allBulk && internalIndexBuildKeyGenThreads > 0) {
+            keyGenerator.reset(new ParallelKeyGenerator(_txn,
+                                                        &_indexes,
+                                                        internalIndexBuildKeyGenThreads));
+        }
+
         BSONObj objToIndex;
         DiskLoc loc;
         while (PlanExecutor::ADVANCED == exec->getNext(&objToIndex, &loc)) {
-            {
+            if (keyGenerator) {
+                Status ret = keyGenerator->add(objToIndex, loc);
+                if (!ret.isOK())
+                    return ret;
+            }
+            else {
                 bool shouldCommitWUnit = true;
                 WriteUnitOfWork wunit(_txn);
                 Status ret = insert(objToIndex, loc);
@@ -236,6 +391,13 @@ namespace mongo {
             progress->setTotalWhileRunning( _collection->numRecords() );
         }
 
+        if (keyGenerator) {
+            Status ret = keyGenerator->done();
+            if (!ret.isOK())
+                return ret;
+            keyGenerator.reset();
+        }
+
         progress->finished();
 
         Status ret = doneInserting(dupsOut);
@@ -109,6 +109,10 @@ namespace mongo {
         /**
          * Inserts all documents in the Collection into the indexes and logs with timing info.
          *
+         * All indexes are built from a single scan of the collection. For foreground builds the
+         * keys can be generated on internalIndexBuildKeyGenThreads worker threads while the scan
+         * continues.
+         *
          * This is a simplified replacement for insert and doneInserting. Do not call this if you
          * are calling either of them.
          *
@@ -174,6 +178,7 @@ namespace mongo {
 
     private:
         class SetNeedToCleanupOnRollback;
+        class ParallelKeyGenerator;
 
         struct IndexToBuild {
             IndexToBuild() : real(NULL) {}
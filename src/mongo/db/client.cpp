@@ -117,6 +117,15 @@ namespace mongo {
         clients.insert(this);
     }
 
+    void Client::setThreadId() {
+#ifndef _WIN32
+        stringstream temp;
+        temp << hex << showbase << pthread_self();
+        scoped_lock bl(clientsMutex);
+        _threadId = temp.str();
+#endif
+    }
+
     Client::~Client() {
         _god = 0;
 
@@ -104,6 +104,12 @@ namespace mongo {
         ConnectionId getConnectionId() const { return _connectionId; }
         const std::string& getThreadId() const { return _threadId; }
 
+        /**
+         * Records the current thread as the one running this client.  For clients that move
+         * between threads, such as those of the network reactor.
+         */
+        void setThreadId();
+
         // XXX(hk): this is per-thread mmapv1 recovery unit stuff, move into that
         // impl of recovery unit
         void writeHappened() { _hasWrittenSinceCheckpoint = true; }
@@ -1562,8 +1562,8 @@ namespace mongo {
                 if ( confOut->isSharded(config.outputOptions.finalNamespace) ) {
                     ChunkManagerPtr cm = confOut->getChunkManager(
                             config.outputOptions.finalNamespace);
-                    const ChunkMap& chunkMap = cm->getChunkMap();
-                    for ( ChunkMap::const_iterator it = chunkMap.begin(); it != chunkMap.end(); ++it ) {
+                    const ChunkRoutingTable& chunkMap = cm->getChunks();
+                    for ( ChunkRoutingTable::const_iterator it = chunkMap.begin(); it != chunkMap.end(); ++it ) {
                         ChunkPtr chunk = it->second;
                         if (chunk->getShard().getName() == shardName) chunks.push_back(chunk);
                     }
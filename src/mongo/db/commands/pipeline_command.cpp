@@ -220,12 +220,10 @@ namespace mongo {
 
                 Collection* collection = ctx.ctx().db()->getCollection(txn, ns);
 
-                // This does mongod-specific stuff like creating the input PlanExecutor and adding
-                // it to the front of the pipeline if needed.
-                boost::shared_ptr<PlanExecutor> input = PipelineD::prepareCursorSource(txn,
-                                                                                       collection,
-                                                                                       pPipeline,
-                                                                                       pCtx);
+                // This does mongod-specific stuff like creating the input PlanExecutors and adding
+                // them to the front of the pipeline if needed.
+                const vector<boost::shared_ptr<PlanExecutor> > inputs =
+                    PipelineD::prepareCursorSource(txn, collection, pPipeline, pCtx);
                 pPipeline->stitch();
 
                 // Create the PlanExecutor which returns results from the pipeline. The WorkingSet
@@ -233,7 +231,7 @@ namespace mongo {
                 // PlanExecutor.
                 auto_ptr<WorkingSet> ws(new WorkingSet());
                 auto_ptr<PipelineProxyStage> proxy(
-                    new PipelineProxyStage(pPipeline, input, ws.get()));
+                    new PipelineProxyStage(pPipeline, inputs, ws.get()));
                 if (NULL == collection) {
                     execHolder.reset(new PlanExecutor(ws.release(), proxy.release(), ns));
                 }
@@ -242,11 +240,13 @@ namespace mongo {
                 }
                 exec = execHolder.get();
 
-                if (!collection && input) {
+                if (!collection) {
                     // If we don't have a collection, we won't be able to register any executors, so
                     // make sure that the input PlanExecutor (likely wrapping an EOFStage) doesn't
                     // need to be registered.
-                    invariant(!input->collection());
+                    for (size_t i = 0; i < inputs.size(); i++) {
+                        invariant(!inputs[i]->collection());
+                    }
                 }
 
                 if (collection) {
@@ -256,6 +256,14 @@ namespace mongo {
         }
         arrayBuilder.doneFast();
 
+        const PlanCache::Stats stats = planCache.getStats();
+        BSONObjBuilder statsBuilder(bob->subobjStart("stats"));
+        statsBuilder.appendNumber("hits", stats.hits);
+        statsBuilder.appendNumber("misses", stats.misses);
+        statsBuilder.appendNumber("evictions", stats.evictions);
+        statsBuilder.appendNumber("contended", stats.contended);
+        statsBuilder.doneFast();
+
         return Status::OK();
     }
 
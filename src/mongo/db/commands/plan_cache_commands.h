@@ -104,6 +104,8 @@ namespace mongo {
      *
      * { planCacheListQueryShapes: <collection> }
      *
+     * Besides the shapes, reports the cache's hit, miss, eviction and lock contention counters
+     * under 'stats'.
      */
     class PlanCacheListQueryShapes : public PlanCacheCommand {
     public:
@@ -115,7 +117,7 @@ namespace mongo {
 
         /**
          * Looks up cache keys for collection's plan cache.
-         * Inserts keys for query into BSON builder.
+         * Inserts keys for query and the cache's counters into BSON builder.
          */
         static Status list(const PlanCache& planCache, BSONObjBuilder* bob);
     };
@@ -206,6 +206,9 @@ namespace mongo {
                 bb.append( "current" , Listener::globalTicketHolder.used() );
                 bb.append( "available" , Listener::globalTicketHolder.available() );
                 bb.append( "totalCreated" , Listener::globalConnectionNumber.load() );
+                BSONObjBuilder tickets( bb.subobjStart( "tickets" ) );
+                Listener::globalTicketHolder.appendStats( tickets );
+                tickets.done();
                 return bb.obj();
             }
 
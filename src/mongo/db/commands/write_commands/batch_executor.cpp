@@ -57,9 +57,11 @@
 #include "mongo/db/stats/counters.h"
 #include "mongo/db/operation_context_impl.h"
 #include "mongo/db/write_concern.h"
+#include "mongo/s/chunk_load_stats.h"
 #include "mongo/s/collection_metadata.h"
 #include "mongo/s/d_logic.h"
 #include "mongo/s/shard_key_pattern.h"
+#include "mongo/s/shardkey.h"
 #include "mongo/s/write_ops/batched_upsert_detail.h"
 #include "mongo/s/write_ops/write_error_detail.h"
 #include "mongo/util/elapsed_tracker.h"
@@ -497,6 +499,27 @@ namespace mongo {
         return true;
     }
 
+    /**
+     * Counts a write in the chunk of 'doc' for load-aware balancing.  'doc' is either the document
+     * inserted or the query of an update or delete, which is only counted if it is on a single
+     * shard key value.  Does nothing unless the balancer is using the counts.
+     */
+    static void noteChunkWrite( const StringData& ns, const BSONObj& doc ) {
+        if ( !shardingState.enabled() || !chunkLoadStats.isTracking() )
+            return;
+
+        CollectionMetadataPtr metadata = shardingState.getCollectionMetadata( ns.toString() );
+        if ( !metadata )
+            return;
+
+        ShardKeyPattern shardKeyPattern( metadata->getKeyPattern() );
+        if ( !shardKeyPattern.hasTargetableShardKey( doc ) )
+            return;
+
+        KeyPattern keyPattern( metadata->getKeyPattern() );
+        chunkLoadStats.noteWrite( ns.toString(), *metadata, keyPattern.extractSingleKey( doc ) );
+    }
+
     //
     // HELPERS FOR CUROP MANAGEMENT AND GLOBAL STATS
     //
@@ -1049,6 +1072,7 @@ namespace mongo {
             repl::logOp( txn, "i", insertNS.c_str(), docToInsert );
             result->getStats().n = 1;
             wunit.commit();
+            noteChunkWrite( insertNS, docToInsert );
         }
     }
 
@@ -1137,6 +1161,8 @@ namespace mongo {
             result->getStats().nModified = didInsert ? 0 : numDocsModified;
             result->getStats().n = didInsert ? 1 : numMatched;
             result->getStats().upsertedID = resUpsertedID;
+
+            noteChunkWrite( nsString.ns(), updateItem.getUpdate()->getQuery() );
         }
         catch (const DBException& ex) {
             status = ex.toStatus();
@@ -1187,6 +1213,7 @@ namespace mongo {
 
         try {
             result->getStats().n = executor.execute(ctx.db());
+            noteChunkWrite( nss.ns(), removeItem.getDelete()->getQuery() );
         }
         catch ( const DBException& ex ) {
             status = ex.toStatus();
@@ -369,7 +369,7 @@ namespace mongo {
         }
     }
 
-    void Lock::DBWrite::lockNestable(Nestable db) { 
+    bool Lock::DBWrite::lockNestable(Nestable db, int timeoutms) { 
         _nested = true;
 
         if (_lockState->nestableCount()) {
@@ -381,10 +381,17 @@ namespace mongo {
         }
         else {
             fassert(16132,_weLocked==0);
+            if ( timeoutms != -1 ) {
+                if ( !nestableLocks[db]->lock_try(timeoutms) )
+                    return false;
+            }
+            else {
+                nestableLocks[db]->lock();
+            }
             _lockState->lockedNestable(db, 1);
             _weLocked = nestableLocks[db];
-            _weLocked->lock();
         }
+        return true;
     }
     void Lock::DBRead::lockNestable(Nestable db) { 
         _nested = true;
@@ -433,7 +440,7 @@ namespace mongo {
         _weLocked = _lockState->otherLock();
     }
 
-    void Lock::DBWrite::lockOtherWrite(const StringData& db) {
+    bool Lock::DBWrite::lockOtherWrite(const StringData& db, int timeoutms) {
         fassert(16252, !db.empty());
 
         // we do checks first, as on assert destructor won't be called so don't want to be half finished with our work.
@@ -441,7 +448,7 @@ namespace mongo {
             // nested. if/when we do temprelease with DBWrite we will need to increment here
             // (so we can not release or assert if nested).
             invariant(db == _lockState->otherName());
-            return;
+            return true;
         }
 
         // first lock for this db. check consistent order with local db lock so we never deadlock. local always comes last
@@ -463,8 +470,17 @@ namespace mongo {
         
         fassert(16134,_weLocked==0);
 
-        _lockState->otherLock()->lock();
+        if ( timeoutms != -1 ) {
+            if ( !_lockState->otherLock()->lock_try(timeoutms) ) {
+                _lockState->unlockedOther();
+                return false;
+            }
+        }
+        else {
+            _lockState->otherLock()->lock();
+        }
         _weLocked = _lockState->otherLock();
+        return true;
     }
 
     static Lock::Nestable n(const StringData& db) { 
@@ -475,9 +491,18 @@ namespace mongo {
         return Lock::notnestable;
     }
 
-    void Lock::DBWrite::lockDB(const string& ns) {
+    // what is left of timeoutms after t, or -1 for no timeout
+    static int remainingMillis(int timeoutms, const Timer& t) {
+        if ( timeoutms == -1 )
+            return -1;
+        int left = timeoutms - t.millis();
+        return left > 0 ? left : 0;
+    }
+
+    void Lock::DBWrite::lockDB(const string& ns, int timeoutms) {
         fassert( 16253, !ns.empty() );
 
+        Timer t;
         Acquiring a(this, *_lockState);
         _locked_W=false;
         _locked_w=false; 
@@ -492,23 +517,33 @@ namespace mongo {
         Nestable nested = n(db);
         if( nested == admin ) { 
             // we can't nestedly lock both admin and local as implemented. so lock_W.
-            qlk.lock_W(_lockState);
+            if ( timeoutms != -1 ) {
+                if ( !qlk.lock_W_try(_lockState, timeoutms) )
+                    throw DBTryLockTimeoutException();
+            }
+            else {
+                qlk.lock_W(_lockState);
+            }
             _locked_W = true;
             return;
         } 
 
         if (!nested) {
             if (_isIntentWrite) {
+                invariant(timeoutms == -1);
                 lockOtherRead(db);
             }
-            else {
-                lockOtherWrite(db);
+            else if (!lockOtherWrite(db, timeoutms)) {
+                throw DBTryLockTimeoutException();
             }
         }
 
-        lockTop();
-        if( nested )
-            lockNestable(nested);
+        // on a timeout, give back what we already have: the destructor won't run
+        if (!lockTop(remainingMillis(timeoutms, t)) ||
+                (nested && !lockNestable(nested, remainingMillis(timeoutms, t)))) {
+            unlockDB();
+            throw DBTryLockTimeoutException();
+        }
     }
 
     void Lock::DBRead::lockDB(const string& ns) {
@@ -530,12 +565,13 @@ namespace mongo {
             lockNestable(nested);
     }
 
-    Lock::DBWrite::DBWrite(LockState* lockState, const StringData& ns, bool intentWrite)
+    Lock::DBWrite::DBWrite(LockState* lockState, const StringData& ns, bool intentWrite,
+                           int timeoutms)
         : ScopedLock(lockState, 'w'),
           _isIntentWrite(intentWrite),
           _what(ns.toString()),
           _nested(false) {
-        lockDB(_what);
+        lockDB(_what, timeoutms);
     }
 
     Lock::DBRead::DBRead(LockState* lockState, const StringData& ns)
@@ -596,7 +632,7 @@ namespace mongo {
         _locked_r = false;
     }
 
-    void Lock::DBWrite::lockTop() { 
+    bool Lock::DBWrite::lockTop(int timeoutms) { 
         switch (_lockState->threadState()) {
         case 'w':
             break;
@@ -605,9 +641,18 @@ namespace mongo {
         case  0  : 
             verify(_lockState->threadState() == 0);
             _lockState->lockedStart('w');
-            qlk.q.lock_w();
+            if ( timeoutms != -1 ) {
+                if ( !qlk.q.lock_w_try(timeoutms) ) {
+                    _lockState->unlocked();
+                    return false;
+                }
+            }
+            else {
+                qlk.q.lock_w();
+            }
             _locked_w = true;
         }
+        return true;
     }
     void Lock::DBRead::lockTop() { 
         switch (_lockState->threadState()) {
@@ -703,6 +748,23 @@ namespace mongo {
 
     }
 
+    dbwritelocktry::dbwritelocktry(LockState* lockState, const StringData& dbOrNs, int tryms) :
+        _got( false ),
+        _dbwlock( NULL )
+    {
+        try {
+            _dbwlock.reset(new Lock::DBWrite(lockState, dbOrNs, false, tryms));
+        }
+        catch ( DBTryLockTimeoutException & ) {
+            return;
+        }
+        _got = true;
+    }
+
+    dbwritelocktry::~dbwritelocktry() {
+
+    }
+
     // note: the 'already' concept here might be a bad idea as a temprelease wouldn't notice it is nested then
     readlocktry::readlocktry(LockState* lockState, int tryms) :
         _got( false ),
@@ -168,11 +168,12 @@ namespace mongo {
              *   2) unlockDB
              */
 
-            void lockTop();
-            void lockNestable(Nestable db);
-            void lockOtherWrite(const StringData& db);
+            // with timeoutms != -1 these give up after that long and return false
+            bool lockTop(int timeoutms = -1);
+            bool lockNestable(Nestable db, int timeoutms = -1);
+            bool lockOtherWrite(const StringData& db, int timeoutms = -1);
             void lockOtherRead(const StringData& db);
-            void lockDB(const std::string& ns);
+            void lockDB(const std::string& ns, int timeoutms = -1);
             void unlockDB();
 
         protected:
@@ -180,7 +181,9 @@ namespace mongo {
             void _relock();
 
         public:
-            DBWrite(LockState* lockState, const StringData& dbOrNs, bool intentWrite = false);
+            // timeoutms is only for dbwritelocktry
+            DBWrite(LockState* lockState, const StringData& dbOrNs, bool intentWrite = false,
+                    int timeoutms = -1);
             virtual ~DBWrite();
 
         private:
@@ -250,4 +253,14 @@ namespace mongo {
         ~writelocktry();
         bool got() const { return _got; }
     };
+
+    /** DBWrite that gives up if it can't get the database lock within tryms. */
+    class dbwritelocktry : boost::noncopyable {
+        bool _got;
+        scoped_ptr<Lock::DBWrite> _dbwlock;
+    public:
+        dbwritelocktry(LockState* lockState, const StringData& dbOrNs, int tryms);
+        ~dbwritelocktry();
+        bool got() const { return _got; }
+    };
 }
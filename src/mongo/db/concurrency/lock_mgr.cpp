@@ -89,6 +89,9 @@ namespace mongo {
                << "\t# deadlocks: " << getNumDeadlocks() << endl
                << "\t# downgrades: " << getNumDowngrades() << endl
                << "\t# upgrades: " << getNumUpgrades() << endl
+               << "\t# fast shared grants: " << getNumFastSharedGrants() << endl
+               << "\t# partition contended: " << getNumPartitionContended() << endl
+               << "\t# us partition wait: " << getNumMicrosPartitionWait() << endl
             ;
         return result.str();
     }
@@ -99,10 +102,12 @@ namespace mongo {
         _numSameRequests += other._numSameRequests;
         _numBlocks += other._numBlocks;
         _numDeadlocks += other._numDeadlocks;
-        _numBlocks += other._numBlocks;
         _numDowngrades += other._numDowngrades;
         _numUpgrades += other._numUpgrades;
         _numMillisBlocked += other._numMillisBlocked;
+        _numFastSharedGrants += other._numFastSharedGrants;
+        _numPartitionContended += other._numPartitionContended;
+        _numMicrosPartitionWait += other._numMicrosPartitionWait;
         return *this;
     }
 
@@ -292,37 +297,54 @@ namespace mongo {
     LockManager::LockManager(const Policy& policy)
         : _policy(policy)
         , _mutex()
-        , _shuttingDown(false)
+        , _shuttingDown(0)
         , _millisToQuiesce(-1)
         , _systemTransaction(new Transaction(0))
         , _numCurrentActiveReadRequests(0)
         , _numCurrentActiveWriteRequests(0)
-    { }
+    {
+        dassert(reinterpret_cast<uintptr_t>(_partitions) % kPartitionAlignment == 0);
+    }
 
     LockManager::~LockManager() {
         delete _systemTransaction;
     }
 
+    void* LockManager::operator new(size_t size) {
+        // over-allocate, round up to the alignment, and keep the address of the allocation
+        // just before the aligned pointer for operator delete
+        void* allocation = ::operator new(size + kPartitionAlignment + sizeof(void*));
+        uintptr_t aligned = reinterpret_cast<uintptr_t>(allocation) + sizeof(void*);
+        aligned = (aligned + kPartitionAlignment - 1) & ~(uintptr_t(kPartitionAlignment) - 1);
+        reinterpret_cast<void**>(aligned)[-1] = allocation;
+        return reinterpret_cast<void*>(aligned);
+    }
+
+    void LockManager::operator delete(void* p) {
+        if (!p) return;
+        ::operator delete(static_cast<void**>(p)[-1]);
+    }
+
     void LockManager::shutdown(const unsigned& millisToQuiesce) {
         boost::unique_lock<boost::mutex> lk(_mutex);
 
 #ifdef DONT_ALLOW_CHANGE_TO_QUIESCE_PERIOD
         // XXX not sure whether we want to allow multiple shutdowns
         // in order to change quiesce period?
-        if (_shuttingDown) {
+        if (_shuttingDown.load()) {
             return; // already in shutdown, don't extend quiescence(?)
         }
 #endif
 
-        _shuttingDown = true;
         _millisToQuiesce = millisToQuiesce;
         _timer.millisReset();
+        _shuttingDown.store(1);
     }
 
     LockManager::Policy LockManager::getPolicy() const {
         boost::unique_lock<boost::mutex> lk(_mutex);
         _throwIfShuttingDown();
-        return _policy;
+        return _getPolicy();
     }
 
     Transaction* LockManager::getPolicySetter() const {
@@ -335,11 +357,11 @@ namespace mongo {
         boost::unique_lock<boost::mutex> lk(_mutex);
         _throwIfShuttingDown();
         
-        if (policy == _policy) return;
+        Policy oldPolicy = _getPolicy();
+        if (policy == oldPolicy) return;
 
         _policySetter = tx;
-        Policy oldPolicy = _policy;
-        _policy = policy;
+        _policy.store(policy);
 
         // if moving away from {READERS,WRITERS}_ONLY, awaken requests that were pending
         //
@@ -389,18 +411,22 @@ namespace mongo {
 
         invariant(lr);
 
-        {
-            boost::unique_lock<boost::mutex> lk(_mutex);
-            _throwIfShuttingDown();
-        }
+        _throwIfShuttingDown();
 
         // don't accept requests from aborted transactions
         if (Transaction::kAborted == lr->requestor->_state) {
             throw AbortException();
         }
-        boost::unique_lock<boost::mutex> lk(_resourceMutexes[lr->slice]);
+        boost::unique_lock<boost::mutex> lk(_partitions[lr->slice].mutex, boost::defer_lock);
+        _lockPartition(lr->slice, lk);
+
+        LockRequest* queue = _partitions[lr->slice].resourceLocks[lr->resId];
+        if (_isFastSharedGrant(lr->requestor, lr->mode, queue)) {
+            _grantSharedFast(lr);
+            _incStatsForMode(lr->mode);
+            return;
+        }
 
-        LockRequest* queue = _resourceLocks[lr->slice][lr->resId];
         LockRequest* conflictPosition = queue;
         ResourceStatus status = _getConflictInfo(lr->requestor, lr->mode, lr->resId, lr->slice,
                                                  queue, conflictPosition);
@@ -421,19 +447,23 @@ namespace mongo {
             return;
         }
 
-        {
-            boost::unique_lock<boost::mutex> lk(_mutex);
-            _throwIfShuttingDown();
-        }
+        _throwIfShuttingDown();
 
         // don't accept requests from aborted transactions
         if (Transaction::kAborted == requestor->_state) {
             throw AbortException();
         }
         unsigned slice = partitionResource(resId);
-        boost::unique_lock<boost::mutex> lk(_resourceMutexes[slice]);
+        boost::unique_lock<boost::mutex> lk(_partitions[slice].mutex, boost::defer_lock);
+        _lockPartition(slice, lk);
+
+        LockRequest* queue = _partitions[slice].resourceLocks[resId];
+        if (_isFastSharedGrant(requestor, mode, queue)) {
+            _grantSharedFast(new LockRequest(resId, mode, requestor, true));
+            _incStatsForMode(mode);
+            return;
+        }
 
-        LockRequest* queue = _resourceLocks[slice][resId];
         LockRequest* conflictPosition = queue;
         ResourceStatus status = _getConflictInfo(requestor, mode, resId, slice,
                                                  queue, conflictPosition);
@@ -452,10 +482,7 @@ namespace mongo {
                                 const LockMode& mode,
                                 const vector<ResourceId>& resources,
                                 Notifier* notifier) {
-        {
-            boost::unique_lock<boost::mutex> lk(_mutex);
-            _throwIfShuttingDown(requestor);
-        }
+        _throwIfShuttingDown(requestor);
 
         // don't accept requests from aborted transactions
         if (Transaction::kAborted == requestor->_state) {
@@ -470,7 +497,8 @@ namespace mongo {
             unsigned slice = partitionResource(resId);
             bool isAvailable = false;
             {
-                boost::unique_lock<boost::mutex> lk(_resourceMutexes[slice]);
+                boost::unique_lock<boost::mutex> lk(_partitions[slice].mutex, boost::defer_lock);
+                _lockPartition(slice, lk);
                 isAvailable = _isAvailable(requestor, mode, resId, slice);
             }
             if (isAvailable) {
@@ -487,11 +515,9 @@ namespace mongo {
     LockManager::LockStatus LockManager::releaseLock(LockRequest* lr) {
         if (!useExperimentalDocLocking) return kLockNotFound;
         invariant(lr);
-        {
-            boost::unique_lock<boost::mutex> lk(_mutex);
-            _throwIfShuttingDown(lr->requestor);
-        }
-        boost::unique_lock<boost::mutex> lk(_resourceMutexes[lr->slice]);
+        _throwIfShuttingDown(lr->requestor);
+        boost::unique_lock<boost::mutex> lk(_partitions[lr->slice].mutex, boost::defer_lock);
+        _lockPartition(lr->slice, lk);
         _decStatsForMode(lr->mode);
         return _releaseInternal(lr);
     }
@@ -503,12 +529,10 @@ namespace mongo {
             return kLockNotFound;
         }
 
-        {
-            boost::unique_lock<boost::mutex> lk(_mutex);
-            _throwIfShuttingDown(holder);
-        }
+        _throwIfShuttingDown(holder);
         unsigned slice = partitionResource(resId);
-        boost::unique_lock<boost::mutex> lk(_resourceMutexes[slice]);
+        boost::unique_lock<boost::mutex> lk(_partitions[slice].mutex, boost::defer_lock);
+        _lockPartition(slice, lk);
 
         LockRequest* lr;
         LockStatus status = _findLock(holder, mode, resId, slice, lr);
@@ -524,10 +548,7 @@ namespace mongo {
      * release all resource acquired by a transaction, returning the count
      */
     size_t LockManager::release(Transaction* holder) {
-        {
-            boost::unique_lock<boost::mutex> lk(_mutex);
-            _throwIfShuttingDown(holder);
-        }
+        _throwIfShuttingDown(holder);
 
         TxLockMap::iterator lockIdsHeld = _xaLocks.find(holder);
         if (lockIdsHeld == _xaLocks.end()) { return 0; }
@@ -538,8 +559,8 @@ namespace mongo {
 
             _decStatsForMode(_locks[*nextLockId]->mode);
 
-            if ((kPolicyWritersOnly == _policy && 0 == _stats.numActiveReads()) ||
-                (kPolicyReadersOnly == _policy && 0 == _stats.numActiveWrites())) {
+            if ((kPolicyWritersOnly == _getPolicy() && 0 == _stats.numActiveReads()) ||
+                (kPolicyReadersOnly == _getPolicy() && 0 == _stats.numActiveWrites())) {
                 _policyLock.notify_one();
             }
             numLocksReleased++;
@@ -548,10 +569,7 @@ namespace mongo {
     }
 #endif
     void LockManager::abort(Transaction* goner) {   
-        {
-            boost::unique_lock<boost::mutex> lk(_mutex);
-            _throwIfShuttingDown(goner);
-        }
+        _throwIfShuttingDown(goner);
         _abortInternal(goner);
     }
 
@@ -561,11 +579,20 @@ namespace mongo {
 
         LockStats result;
         for (unsigned ix=0; ix < kNumResourcePartitions; ix++) {
-            result += _stats[ix];
+            boost::unique_lock<boost::mutex> partitionLock(_partitions[ix].mutex);
+            result += _partitions[ix].stats;
         }
         return result;
     }
 
+    LockManager::LockStats LockManager::getPartitionStats(unsigned partition) const {
+        invariant(partition < kNumResourcePartitions);
+        _throwIfShuttingDown();
+
+        boost::unique_lock<boost::mutex> lk(_partitions[partition].mutex);
+        return _partitions[partition].stats;
+    }
+
     string LockManager::toString() const {
 //     boost::unique_lock<boost::mutex> lk(_mutex);
 #ifdef DONT_CARE_ABOUT_DEBUG_EVEN_WHEN_SHUTTING_DOWN
@@ -574,7 +601,7 @@ namespace mongo {
 #endif
         stringstream result;
         result << "Policy: ";
-        switch(_policy) {
+        switch(_getPolicy()) {
         case kPolicyFirstCome:
             result << "FirstCome";
             break;
@@ -596,15 +623,16 @@ namespace mongo {
         }
         result << endl;
 
-        if (_shuttingDown)
+        if (_shuttingDown.load())
             result << " shutting down in " << _millisToQuiesce - _timer.millis();
 
         result << "\t_resourceLocks:" << endl;
         bool firstResource=true;
         result << "resources=" << ": {";
         for (unsigned slice=0; slice < kNumResourcePartitions; ++slice) {
-            for (map<ResourceId, LockRequest*>::const_iterator nextResource = _resourceLocks[slice].begin();
-                 nextResource != _resourceLocks[slice].end(); ++nextResource) {
+            const map<ResourceId, LockRequest*>& resourceLocks = _partitions[slice].resourceLocks;
+            for (map<ResourceId, LockRequest*>::const_iterator nextResource = resourceLocks.begin();
+                 nextResource != resourceLocks.end(); ++nextResource) {
                 if (firstResource) firstResource=false;
                 else result << ", ";
                 result << nextResource->first << ": {";
@@ -640,25 +668,19 @@ namespace mongo {
         if (!useExperimentalDocLocking) {
             return false;
         }
-        {
-            boost::unique_lock<boost::mutex> lk(_mutex);
-            _throwIfShuttingDown(holder);
-        }
+        _throwIfShuttingDown(holder);
 
         LockRequest* unused=NULL;
         return kLockFound == _findLock(holder, mode, resId, partitionResource(resId), unused);
     }
 
     unsigned LockManager::partitionResource(const ResourceId& resId) {
-        // when resIds are DiskLocs, their low-order bits are mostly zero
-        // so add up nibbles as cheap hash
-        size_t resIdValue = resId;
-        size_t resIdHash = 0;
-        size_t mask = 0xf;
-        for (unsigned ix=0; ix < 2*sizeof(size_t); ++ix) {
-            resIdHash += (resIdValue >> ix*4) & mask;
-        }
-        return resIdHash % kNumResourcePartitions;
+        // when resIds are DiskLocs or pointers, their low-order bits are mostly zero and
+        // neighbouring resources differ in only a few bits, so mix all the bits with a
+        // multiplicative hash and take the partition from the high-order ones
+        uint64_t resIdValue = static_cast<size_t>(resId);
+        uint64_t resIdHash = resIdValue * 0x9E3779B97F4A7C15ULL;
+        return static_cast<unsigned>(resIdHash >> 32) % kNumResourcePartitions;
     }
 #ifdef REGISTER_TRANSACTIONS
     unsigned LockManager::partitionTransaction(unsigned xid) {
@@ -666,10 +688,20 @@ namespace mongo {
     }
 #endif
 
+    void LockManager::_lockPartition(unsigned slice, boost::unique_lock<boost::mutex>& guard) {
+        if (guard.try_lock()) {
+            return;
+        }
+
+        Timer timer;
+        guard.lock();
+        _partitions[slice].stats.incPartitionContended(timer.micros());
+    }
+
     void LockManager::_push_back(LockRequest* lr) {
-        LockRequest* nextLock = _resourceLocks[lr->slice][lr->resId];
+        LockRequest* nextLock = _partitions[lr->slice].resourceLocks[lr->resId];
         if (NULL == nextLock) {
-            _resourceLocks[lr->slice][lr->resId] = lr;
+            _partitions[lr->slice].resourceLocks[lr->resId] = lr;
             return;
         }
 
@@ -688,10 +720,10 @@ namespace mongo {
             lr->prevOnResource->nextOnResource = lr->nextOnResource;
         }
         else if (NULL == lr->nextOnResource) {
-            _resourceLocks[lr->slice].erase(lr->resId);
+            _partitions[lr->slice].resourceLocks.erase(lr->resId);
         }
         else {
-            _resourceLocks[lr->slice][lr->resId] = lr->nextOnResource;
+            _partitions[lr->slice].resourceLocks[lr->resId] = lr->nextOnResource;
         }
         lr->nextOnResource = NULL;
         lr->prevOnResource = NULL;
@@ -736,14 +768,14 @@ namespace mongo {
                                                               unsigned slice,
                                                               LockRequest* queue,
                                                               LockRequest*& conflictPosition) {
-        _stats[slice].incRequests();
+        _partitions[slice].stats.incRequests();
 
-        if (queue) { _stats[slice].incPreexisting(); }
+        if (queue) { _partitions[slice].stats.incPreexisting(); }
 
         ResourceStatus resourceStatus = _conflictExists(requestor, mode, resId,
                                                         slice, queue, conflictPosition);
         if (kResourceAcquired == resourceStatus) {
-            _stats[slice].incSame();
+            _partitions[slice].stats.incSame();
             ++conflictPosition->count;
         }
         return resourceStatus;
@@ -760,8 +792,8 @@ namespace mongo {
             if (!conflictPosition)
                 _push_back(lr);
             else if (conflictPosition == queue) {
-                lr->nextOnResource = _resourceLocks[lr->slice][lr->resId];
-                _resourceLocks[lr->slice][lr->resId] = lr;
+                lr->nextOnResource = _partitions[lr->slice].resourceLocks[lr->resId];
+                _partitions[lr->slice].resourceLocks[lr->resId] = lr;
             }
             else {
                 conflictPosition->prevOnResource->nextOnResource = lr;
@@ -812,7 +844,7 @@ namespace mongo {
             (*sleepNotifier)(lr->requestor);
         }
 
-        _stats[lr->slice].incBlocks();
+        _partitions[lr->slice].stats.incBlocks();
 
         // this loop typically executes once
         do {
@@ -836,10 +868,10 @@ namespace mongo {
             while (lr->isBlocked()) {
                 Timer timer;
                 lr->lock.wait(guard);
-                _stats[lr->slice].incTimeBlocked(timer.millis());
+                _partitions[lr->slice].stats.incTimeBlocked(timer.millis());
             }
 
-            queue = conflictPosition = _resourceLocks[lr->slice][lr->resId];
+            queue = conflictPosition = _partitions[lr->slice].resourceLocks[lr->resId];
             resourceStatus = _conflictExists(lr->requestor, lr->mode, lr->resId, lr->slice,
                                              queue, conflictPosition);
         } while (hasConflict(resourceStatus));
@@ -882,7 +914,7 @@ namespace mongo {
         }
 
         // use LockManager's default policy
-        switch (_policy) {
+        switch (_getPolicy()) {
         case kPolicyFirstCome:
             _push_back(lr);
             position = NULL;
@@ -949,9 +981,9 @@ namespace mongo {
                                               const LockRequest* oldRequest) const {
 
         // handle special policies
-        if (kPolicyReadersOnly == _policy && kShared == mode && oldRequest->isBlocked())
+        if (kPolicyReadersOnly == _getPolicy() && kShared == mode && oldRequest->isBlocked())
             return true;
-        if (kPolicyWritersOnly == _policy && kExclusive == mode && oldRequest->isBlocked())
+        if (kPolicyWritersOnly == _getPolicy() && kExclusive == mode && oldRequest->isBlocked())
             return true;
 
         if (requestor->getPriority() >
@@ -959,7 +991,7 @@ namespace mongo {
             return true;
         }
 
-        switch (_policy) {
+        switch (_getPolicy()) {
         case kPolicyFirstCome:
             return false;
         case kPolicyReadersFirst:
@@ -982,8 +1014,8 @@ namespace mongo {
                                                              LockRequest*& nextLock) {
 
         // handle READERS/kPolicyWritersOnly policy conflicts
-        if ((kPolicyReadersOnly == _policy && isExclusive(mode)) ||
-            (kPolicyWritersOnly == _policy && isShared(mode))) {
+        if ((kPolicyReadersOnly == _getPolicy() && isExclusive(mode)) ||
+            (kPolicyWritersOnly == _getPolicy() && isShared(mode))) {
 
             if (NULL == nextLock) { return kResourcePolicyConflict; }
 
@@ -1030,20 +1062,20 @@ namespace mongo {
                 // an upgrade or downgrade request, can't conflict with ourselves
                 if (isShared(mode)) {
                     // downgrade
-                    _stats[slice].incDowngrades();
+                    _partitions[slice].stats.incDowngrades();
                     nextLock = nextLock->nextOnResource;
                     return kResourceAvailable;
                 }
 
                 // upgrade
                 alreadyHadLock = true;
-                _stats[slice].incUpgrades();
+                _partitions[slice].stats.incUpgrades();
                 // position after initial readers
                 continue;
             }
 
             if (isShared(nextLock->mode)) {
-                invariant(!nextLock->isBlocked() || kPolicyWritersOnly == _policy);
+                invariant(!nextLock->isBlocked() || kPolicyWritersOnly == _getPolicy());
 
                 sharedOwners.insert(nextLock->requestor);
 
@@ -1103,7 +1135,7 @@ namespace mongo {
                 // the transaction that would block requestor is already blocked by requestor
                 // if requestor waited for nextLockRequest, there would be a deadlock
                 //
-                _stats[slice].incDeadlocks();
+                _partitions[slice].stats.incDeadlocks();
                 _abortInternal(requestor);
             }
             return kResourceConflict;
@@ -1127,7 +1159,7 @@ namespace mongo {
                 // the transaction that would block requestor is already blocked by requestor
                 // if requestor waited for nextLockRequest, there would be a deadlock
                 //
-                _stats[slice].incDeadlocks();
+                _partitions[slice].stats.incDeadlocks();
                 _abortInternal(requestor);
             }
             return kResourceConflict;
@@ -1144,8 +1176,9 @@ namespace mongo {
         outLock = NULL; // set invalid;
 
         // get iterator for resId's locks
-        map<ResourceId,LockRequest*>::const_iterator resLocks = _resourceLocks[slice].find(resId);
-        if (resLocks == _resourceLocks[slice].end()) { return kLockResourceNotFound; }
+        const map<ResourceId,LockRequest*>& resourceLocks = _partitions[slice].resourceLocks;
+        map<ResourceId,LockRequest*>::const_iterator resLocks = resourceLocks.find(resId);
+        if (resLocks == resourceLocks.end()) { return kLockResourceNotFound; }
 
         // look for an existing lock request from holder in mode
         for (LockRequest* nextLock = resLocks->second;
@@ -1158,6 +1191,43 @@ namespace mongo {
         return kLockModeNotFound;
     }
 
+    bool LockManager::_isFastSharedGrant(const Transaction* requestor,
+                                         const LockMode& mode,
+                                         const LockRequest* queue) const {
+        // under kPolicyWritersOnly even an uncontended shared request must wait
+        if (!isShared(mode) || kPolicyWritersOnly == _getPolicy()) {
+            return false;
+        }
+
+        for (; queue; queue = queue->nextOnResource) {
+            // our own earlier requests make this a re-acquire, upgrade or downgrade, and any
+            // exclusive or blocked request needs the queue ordered by policy
+            if (queue->requestor == requestor || !isShared(queue->mode) || queue->isBlocked()) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void LockManager::_grantSharedFast(LockRequest* lr) {
+        ResourcePartition& partition = _partitions[lr->slice];
+        LockRequest*& queue = partition.resourceLocks[lr->resId];
+
+        partition.stats.incRequests();
+        partition.stats.incFastSharedGrants();
+
+        // all requests on the queue are active, and their order is irrelevant,
+        // so push on the front rather than walking to the end
+        if (queue) {
+            partition.stats.incPreexisting();
+            queue->prevOnResource = lr;
+        }
+        lr->nextOnResource = queue;
+        queue = lr;
+
+        lr->requestor->addLock(lr);
+    }
+
     /*
      * Used by acquireOne
      * XXX: there's overlap between this, _conflictExists and _findLock
@@ -1168,14 +1238,14 @@ namespace mongo {
                                    unsigned slice) const {
 
         // check for exceptional policies
-        if (kPolicyReadersOnly == _policy && isExclusive(mode))
+        if (kPolicyReadersOnly == _getPolicy() && isExclusive(mode))
             return false;
-        else if (kPolicyWritersOnly == _policy && isShared(mode))
+        else if (kPolicyWritersOnly == _getPolicy() && isShared(mode))
             return false;
 
         
         // walk over the queue of previous requests for this ResourceId
-        for (const LockRequest* nextLock = _resourceLocks[slice].at(resId);
+        for (const LockRequest* nextLock = _partitions[slice].resourceLocks.at(resId);
              nextLock; nextLock = nextLock->nextOnResource) {
 
             if (nextLock->matches(requestor, mode, resId)) {
@@ -1202,12 +1272,12 @@ namespace mongo {
         Transaction* holder = lr->requestor;
         const LockMode& mode = lr->mode;
 
-        if ((kPolicyWritersOnly == _policy && 0 == _numActiveReads()) ||
-            (kPolicyReadersOnly == _policy && 0 == _numActiveWrites())) {
+        if ((kPolicyWritersOnly == _getPolicy() && 0 == _numActiveReads()) ||
+            (kPolicyReadersOnly == _getPolicy() && 0 == _numActiveWrites())) {
             _policyLock.notify_one();
         }
 
-        LockRequest* queue = _resourceLocks[lr->slice][lr->resId];
+        LockRequest* queue = _partitions[lr->slice].resourceLocks[lr->resId];
         if (NULL == queue) {
             return kLockResourceNotFound;
         }
@@ -1302,7 +1372,7 @@ namespace mongo {
 
     void LockManager::_throwIfShuttingDown(const Transaction* tx) const {
 
-        if (_shuttingDown && (_timer.millis() >= _millisToQuiesce))
+        if (_shuttingDown.load() && (_timer.millis() >= _millisToQuiesce))
 
 #ifdef LOCK_MANAGER_TRANSACTION_REGISTRATION
             ||
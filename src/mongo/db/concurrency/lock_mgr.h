@@ -334,7 +334,10 @@ namespace mongo {
             , _numDeadlocks(0)
             , _numDowngrades(0)
             , _numUpgrades(0)
-            , _numMillisBlocked(0) { }
+            , _numMillisBlocked(0)
+            , _numFastSharedGrants(0)
+            , _numPartitionContended(0)
+            , _numMicrosPartitionWait(0) { }
 
             void incRequests() { _numRequests++; }
             void incPreexisting() { _numPreexistingRequests++; }
@@ -344,6 +347,11 @@ namespace mongo {
             void incDowngrades() { _numDowngrades++; }
             void incUpgrades() { _numUpgrades++; }
             void incTimeBlocked(size_t numMillis ) { _numMillisBlocked += numMillis; }
+            void incFastSharedGrants() { _numFastSharedGrants++; }
+            void incPartitionContended(size_t numMicros) {
+                _numPartitionContended++;
+                _numMicrosPartitionWait += numMicros;
+            }
 
             size_t getNumRequests() const { return _numRequests; }
             size_t getNumPreexistingRequests() const { return _numPreexistingRequests; }
@@ -353,6 +361,9 @@ namespace mongo {
             size_t getNumDowngrades() const { return _numDowngrades; }
             size_t getNumUpgrades() const { return _numUpgrades; }
             size_t getNumMillisBlocked() const { return _numMillisBlocked; }
+            size_t getNumFastSharedGrants() const { return _numFastSharedGrants; }
+            size_t getNumPartitionContended() const { return _numPartitionContended; }
+            size_t getNumMicrosPartitionWait() const { return _numMicrosPartitionWait; }
 
             LockStats& operator+=(const LockStats& other);
             std::string toString() const;
@@ -380,6 +391,15 @@ namespace mongo {
 
             // aggregates time requests spent blocked.
             size_t _numMillisBlocked;
+
+            // the number of shared requests granted without conflict resolution because
+            // every request already on the resource was a granted shared request
+            size_t _numFastSharedGrants;
+
+            // the number of times a request found its resource partition's mutex held by
+            // another thread, and the total time spent waiting for it
+            size_t _numPartitionContended;
+            size_t _numMicrosPartitionWait;
         };
 
 
@@ -398,6 +418,13 @@ namespace mongo {
         explicit LockManager(const Policy& policy=kPolicyFirstCome);
         ~LockManager();
 
+        /**
+         * The resource partitions are cache line aligned, which the global operator new
+         * doesn't honor for heap allocated LockManagers, so allocate them aligned here.
+         */
+        static void* operator new(size_t size);
+        static void operator delete(void* p);
+
         /**
          * Change the current Policy.  For READERS/kPolicyWritersOnly, this
          * call may block until all current writers/readers have released their locks.
@@ -483,12 +510,19 @@ namespace mongo {
          */
         LockStats getStats() const;
 
+        /**
+         * returns a copy of the stats of a single resource partition,
+         * for finding hot partitions.  partition must be < getNumPartitions()
+         */
+        LockStats getPartitionStats(unsigned partition) const;
+
         /**
          * slices the space of ResourceIds and TransactionIds into
          * multiple partitions that can be separately guarded to
          * spread the cost of mutex locking.
          */
         static unsigned partitionResource(const ResourceId& resId);
+        static unsigned getNumPartitions() { return kNumResourcePartitions; }
         static unsigned partitionTransaction(unsigned txId);
 
 
@@ -588,6 +622,20 @@ namespace mongo {
 					LockRequest* queue,
 					LockRequest*& conflictPosition);
 
+        /**
+         * returns true if a shared request can be granted without conflict resolution:
+         * every request already on the resource is a granted shared request of another
+         * transaction, so the new request can neither block nor take part in a deadlock.
+         */
+        bool _isFastSharedGrant(const Transaction* requestor,
+                                const LockMode& mode,
+                                const LockRequest* queue) const;
+
+        /**
+         * grants a request for which _isFastSharedGrant returned true
+         */
+        void _grantSharedFast(LockRequest* lr);
+
         /**
          * returns true if acquire would return without waiting
          * used by acquireOne
@@ -597,6 +645,11 @@ namespace mongo {
                           const ResourceId& resId,
                           unsigned slice) const;
 
+        /**
+         * locks a resource partition's mutex, counting contention in the partition's stats
+         */
+        void _lockPartition(unsigned slice, boost::unique_lock<boost::mutex>& guard);
+
         /**
          * maintain the resourceLocks queue
          */
@@ -612,7 +665,8 @@ namespace mongo {
 
         /**
          * called at start of public APIs, throws exception
-         * if quiescing period has expired, or if xid is new
+         * if quiescing period has expired, or if xid is new.
+         * does not need _mutex, so that acquire and release only lock their partition.
          */
         void _throwIfShuttingDown(const Transaction* tx=NULL) const;
 
@@ -631,6 +685,8 @@ namespace mongo {
                 _numCurrentActiveWriteRequests.fetchAndSubtract(1);
         }
 
+        Policy _getPolicy() const { return static_cast<Policy>(_policy.load()); }
+
         unsigned _numActiveReads() const { return _numCurrentActiveReadRequests.loadRelaxed(); }
         unsigned _numActiveWrites() const { return _numCurrentActiveWriteRequests.loadRelaxed(); }
 
@@ -646,39 +702,55 @@ namespace mongo {
         // request would lead to a deadlock is aborted.  Since deadlocks are rare,
         // careful choices may not matter much.
         //
-        Policy _policy;
+        // Only changed under _mutex, but read without it by requests which only lock their
+        // resource partition, so it is atomic.  Read it with _getPolicy().
+        //
+        AtomicUInt32 _policy;
 
         // transaction which last set policy, for reporting cause of conflicts. not owned
         Transaction* _policySetter;
 
-        // synchronizes access to the lock manager, which is shared across threads
-        static const unsigned kNumResourcePartitions = 16;
-        mutable boost::mutex _resourceMutexes[kNumResourcePartitions];
+        // Lock requests are partitioned by a hash of their ResourceId.  Each partition has
+        // its own mutex, queues and stats, and is aligned to a cache line so that threads
+        // working on different partitions do not share lines.  kPartitionAlignment must match
+        // the alignment of ResourcePartition, which has to be spelled as a literal.
+        static const unsigned kNumResourcePartitions = 64;
+        static const size_t kPartitionAlignment = 64;
+
+        struct MONGO_COMPILER_ALIGN_TYPE(64) ResourcePartition {
+            mutable boost::mutex mutex;
+
+            // Lists of lock requests associated with a resource,
+            //
+            // The lock-request lists have two sections.  Some number (at least one) of
+            // requests at the front of a list are "active".  All remaining lock requests are
+            // blocked by some earlier (not necessarily active) lock request, and are waiting.
+            // The order of lock request in the waiting section is determined by the
+            // LockPolicy.  The order of lock request in the active/front portion of the list
+            // is irrelevant.
+            //
+            std::map<ResourceId, LockRequest*> resourceLocks;
+
+            LockStats stats;
+        };
+        ResourcePartition _partitions[kNumResourcePartitions];
 
 #ifdef REGISTER_TRANSACTIONS
         static const unsigned kNumTransactionPartitions = 16;
         mutable boost::mutex _transactionMutexes[kNumTransactionPartitions];
 #endif
+        // guards policy changes and shutdown
         mutable boost::mutex _mutex;
 
         // for blocking when setting kPolicyReadersOnly or kPolicyWritersOnly policy
         boost::condition_variable _policyLock;
 
-        // only meaningful when _policy == SHUTDOWN
-        bool _shuttingDown;
+        // set once shutdown() has been called.  _millisToQuiesce and _timer are written
+        // before _shuttingDown is, and only read after it has been seen set.
+        AtomicUInt32 _shuttingDown;
         int _millisToQuiesce;
         Timer _timer;
 
-        // Lists of lock requests associated with a resource,
-        //
-        // The lock-request lists have two sections.  Some number (at least one) of requests
-        // at the front of a list are "active".  All remaining lock requests are blocked by
-        // some earlier (not necessarily active) lock request, and are waiting.  The order
-        // of lock request in the waiting section is determined by the LockPolicty.
-        // The order of lock request in the active/front portion of the list is irrelevant.
-        //
-        std::map<ResourceId, LockRequest*> _resourceLocks[kNumResourcePartitions];
-
 #ifdef REGISTER_TRANSACTIONS
         std::set<Transaction*> _activeTransactions[kNumTransactionPartitions];
 #endif
@@ -686,9 +758,6 @@ namespace mongo {
         // used to track conflicts due to kPolicyReadersOnly or WritersOnly
         Transaction* _systemTransaction;
 
-        // stats
-        LockStats _stats[kNumResourcePartitions];
-
         // used when changing policy to/from Readers/Writers Only
         AtomicUInt32 _numCurrentActiveReadRequests;
         AtomicUInt32 _numCurrentActiveWriteRequests;
@@ -42,6 +42,7 @@
  * before waiting for a response.
  */
 
+#include <boost/scoped_array.hpp>
 #include <boost/scoped_ptr.hpp>
 #include <boost/thread/thread.hpp>
 #include "mongo/unittest/unittest.h"
@@ -389,6 +390,57 @@ TEST(LockManagerTest, SingleTx) {
     ASSERT(! lm.isLocked(&t1, kExclusive, r1));
 }
 
+TEST(LockManagerTest, SharedFastPath) {
+    LockManager lm;
+    Transaction t1(1);
+    Transaction t2(2);
+    ResourceId r1 = 1;
+
+    // uncontended and shared-only queues skip conflict resolution
+    lm.acquire(&t1, kShared, r1);
+    lm.acquire(&t2, kShared, r1);
+    ASSERT(lm.isLocked(&t1, kShared, r1));
+    ASSERT(lm.isLocked(&t2, kShared, r1));
+    ASSERT_EQUALS(2U, lm.getStats().getNumFastSharedGrants());
+
+    // a re-acquire is counted on the existing request, not granted again
+    lm.acquire(&t1, kShared, r1);
+    ASSERT_EQUALS(2U, lm.getStats().getNumFastSharedGrants());
+    ASSERT(LockManager::kLockCountDecremented == lm.release(&t1, kShared, r1));
+    ASSERT(LockManager::kLockReleased == lm.release(&t1, kShared, r1));
+
+    // an upgrade goes through the slow path
+    lm.acquire(&t2, kExclusive, r1);
+    ASSERT(lm.isLocked(&t2, kExclusive, r1));
+    lm.release(&t2, kExclusive, r1);
+    lm.release(&t2, kShared, r1);
+
+    // once the exclusive holder is gone the fast path applies again
+    lm.acquire(&t1, kExclusive, r1);
+    lm.release(&t1, kExclusive, r1);
+    lm.acquire(&t1, kShared, r1);
+    lm.release(&t1, kShared, r1);
+    ASSERT_EQUALS(3U, lm.getStats().getNumFastSharedGrants());
+
+    // per partition stats add up to the totals
+    size_t numRequests = 0;
+    for (unsigned ix = 0; ix < LockManager::getNumPartitions(); ++ix) {
+        numRequests += lm.getPartitionStats(ix).getNumRequests();
+    }
+    ASSERT_EQUALS(lm.getStats().getNumRequests(), numRequests);
+    ASSERT(lm.getPartitionStats(LockManager::partitionResource(r1)).getNumRequests() > 0);
+}
+
+TEST(LockManagerTest, HeapAllocatedIsAligned) {
+    // the resource partitions are cache line aligned, so heap allocations have to be too
+    for (int i = 0; i < 16; i++) {
+        boost::scoped_array<char> skew(new char[i * 8 + 1]);
+        boost::scoped_ptr<LockManager> lm(new LockManager(LockManager::kPolicyReadersFirst));
+        ASSERT_EQUALS(0U, reinterpret_cast<uintptr_t>(lm.get()) % 64);
+        ASSERT(LockManager::kPolicyReadersFirst == lm->getPolicy());
+    }
+}
+
 TEST(LockManagerTest, TxConflict) {
     LockManager lm;
     ClientTransaction t1(&lm, 1);
@@ -33,6 +33,7 @@
 #include "mongo/db/namespace_string.h"
 #include "mongo/util/log.h"
 #include "mongo/util/mongoutils/str.h"
+#include "mongo/util/time_support.h"
 
 
 namespace mongo {
@@ -308,4 +309,18 @@ namespace mongo {
         _ls._lockPendingParallelWriter = false;
     }
 
+    bool WrapperForRWLock::lock_try(int millis) {
+        if ( sharedLatching )
+            return rw.lock_try(millis);
+
+        // a plain mutex has no timed acquire
+        unsigned long long end = curTimeMillis64() + millis;
+        while ( !m.try_lock() ) {
+            if ( curTimeMillis64() >= end )
+                return false;
+            sleepmillis(1);
+        }
+        return true;
+    }
+
 }
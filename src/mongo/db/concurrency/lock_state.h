@@ -149,6 +149,7 @@ namespace mongo {
             sharedLatching = name != "local";
         }
         void lock()          { if ( sharedLatching ) { rw.lock(); } else { m.lock(); } }
+        bool lock_try(int millis);
         void lock_shared()   { if ( sharedLatching ) { rw.lock_shared(); } else { m.lock(); } }
         void unlock()        { if ( sharedLatching ) { rw.unlock(); } else { m.unlock(); } }
         void unlock_shared() { if ( sharedLatching ) { rw.unlock_shared(); } else { m.unlock(); } }
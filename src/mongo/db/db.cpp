@@ -49,6 +49,7 @@
 #include "mongo/db/catalog/index_key_validate.h"
 #include "mongo/db/client.h"
 #include "mongo/db/clientcursor.h"
+#include "mongo/db/commands/copydb_getnonce.h"
 #include "mongo/db/commands/server_status.h"
 #include "mongo/db/commands/server_status_metric.h"
 #include "mongo/db/concurrency/d_concurrency.h"
@@ -85,6 +86,7 @@
 #include "mongo/db/storage_options.h"
 #include "mongo/db/ttl.h"
 #include "mongo/platform/process_id.h"
+#include "mongo/s/d_logic.h"
 #include "mongo/s/d_writeback.h"
 #include "mongo/scripting/engine.h"
 #include "mongo/util/background.h"
@@ -232,6 +234,42 @@ namespace mongo {
             if( c ) c->shutdown();
         }
 
+        virtual bool canDetachSessions() const { return true; }
+
+        virtual void* detachSession( AbstractMessagingPort* p ) {
+            Session* s = new Session();
+            s->client = currentClient.release();
+            s->shardInfo = ShardedConnectionInfo::release();
+            s->authConn = authConn_.release();
+            return s;
+        }
+
+        virtual void attachSession( AbstractMessagingPort* p , void* session ) {
+            scoped_ptr<Session> s( static_cast<Session*>( session ) );
+            currentClient.reset( s->client );
+            if ( s->client )
+                s->client->setThreadId();
+            ShardedConnectionInfo::attach( s->shardInfo );
+            authConn_.reset( s->authConn );
+        }
+
+        virtual void destroySession( void* session ) {
+            scoped_ptr<Session> s( static_cast<Session*>( session ) );
+            delete s->client;
+            delete s->shardInfo;
+            delete s->authConn;
+        }
+
+    private:
+        /**
+         * The per connection thread locals of a mongod client while it is parked in the
+         * network reactor.
+         */
+        struct Session {
+            Client* client;
+            ShardedConnectionInfo* shardInfo;
+            DBClientBase* authConn;
+        };
     };
 
     static void logStartup() {
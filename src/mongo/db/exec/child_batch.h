@@ -0,0 +1,150 @@
+/**
+ *    Copyright (C) 2014 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <vector>
+
+#include "mongo/db/exec/plan_stage.h"
+#include "mongo/db/exec/working_set.h"
+#include "mongo/db/exec/working_set_common.h"
+#include "mongo/util/mongoutils/str.h"
+
+namespace mongo {
+
+    /**
+     * Runs PlanStage::workBatch() on a child stage on behalf of a parent's own workBatch().
+     *
+     * A stage that passes its child's results through one at a time performs one unit of work
+     * per unit of work of its child, so the parent can account for the whole batch from the
+     * child's stats: every unit of the child is one of the parent's works, and every unit that
+     * produced neither a result nor a terminal state is one of the parent's needTimes.
+     *
+     * The child's results are left in 'out' from index 'begin' on.  If the child failed, its
+     * failure id is taken off the end of 'out' so that the parent only sees results; the
+     * parent puts it back with appendFailure() once it is done with them.
+     */
+    class ChildBatch {
+    public:
+        ChildBatch(PlanStage* child, size_t maxWorks, std::vector<WorkingSetID>* out)
+            : begin(out->size()),
+              failureId(WorkingSet::INVALID_ID) {
+
+            const CommonStats* stats = child->getCommonStats();
+            if (NULL == stats) {
+                // Without stats we can't tell how much work the child did; do it one at a time.
+                workEach(child, maxWorks, out);
+            }
+            else {
+                const size_t worksBefore = stats->works;
+                state = child->workBatch(maxWorks, out);
+                works = child->getCommonStats()->works - worksBefore;
+            }
+
+            if (PlanStage::FAILURE == state) {
+                failureId = out->back();
+                out->pop_back();
+            }
+
+            const size_t numResults = out->size() - begin;
+            const size_t numTerminal = isTerminal() ? 1 : 0;
+            needTime = (works > numResults + numTerminal) ? works - numResults - numTerminal : 0;
+        }
+
+        bool isTerminal() const {
+            return PlanStage::ADVANCED != state && PlanStage::NEED_TIME != state;
+        }
+
+        /**
+         * On FAILURE, appends the child's failure id to 'out', allocating a status member that
+         * names 'stageName' if the child did not provide one, as work() does.
+         */
+        void appendFailure(WorkingSet* ws,
+                           const char* stageName,
+                           std::vector<WorkingSetID>* out) const {
+            if (PlanStage::FAILURE != state) {
+                return;
+            }
+
+            WorkingSetID id = failureId;
+            if (WorkingSet::INVALID_ID == id) {
+                mongoutils::str::stream ss;
+                ss << stageName << " stage failed to read in results from child";
+                Status status(ErrorCodes::InternalError, ss);
+                id = WorkingSetCommon::allocateStatusMember(ws, status);
+            }
+            out->push_back(id);
+        }
+
+        /**
+         * The state for the parent's workBatch() to return, once it has dropped or transformed
+         * the results in 'out' and called appendFailure().
+         */
+        PlanStage::StageState parentState(const std::vector<WorkingSetID>& out) const {
+            if (isTerminal()) {
+                return state;
+            }
+            return out.size() > begin ? PlanStage::ADVANCED : PlanStage::NEED_TIME;
+        }
+
+        // Index in 'out' of the first result of the batch.
+        const size_t begin;
+
+        // The state the child's workBatch() returned.
+        PlanStage::StageState state;
+
+        // If 'state' is FAILURE, the id the child returned with it.
+        WorkingSetID failureId;
+
+        // Units of work the child performed, and how many of those returned NEED_TIME.
+        size_t works;
+        size_t needTime;
+
+    private:
+        void workEach(PlanStage* child, size_t maxWorks, std::vector<WorkingSetID>* out) {
+            state = PlanStage::NEED_TIME;
+            for (works = 0; works < maxWorks; ) {
+                WorkingSetID id = WorkingSet::INVALID_ID;
+                PlanStage::StageState childState = child->work(&id);
+                ++works;
+                if (PlanStage::ADVANCED == childState) {
+                    out->push_back(id);
+                    state = PlanStage::ADVANCED;
+                }
+                else if (PlanStage::NEED_TIME != childState) {
+                    if (PlanStage::FAILURE == childState) {
+                        out->push_back(id);
+                    }
+                    state = childState;
+                    return;
+                }
+            }
+        }
+    };
+
+}  // namespace mongo
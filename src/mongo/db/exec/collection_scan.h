@@ -53,6 +53,7 @@ namespace mongo {
                        const MatchExpression* filter);
 
         virtual StageState work(WorkingSetID* out);
+        virtual StageState workBatch(size_t maxWorks, std::vector<WorkingSetID>* out);
         virtual bool isEOF();
 
         virtual void invalidate(const DiskLoc& dl, InvalidationType type);
@@ -72,6 +73,11 @@ namespace mongo {
         static const char* kStageType;
 
     private:
+        /**
+         * A unit of work, without the timing done by work() and workBatch().
+         */
+        StageState doWork(WorkingSetID* out);
+
         /**
          * Returns true if the record 'loc' references is in memory, false otherwise.
          */
@@ -29,6 +29,7 @@
 #include "mongo/db/exec/fetch.h"
 
 #include "mongo/db/catalog/collection.h"
+#include "mongo/db/exec/child_batch.h"
 #include "mongo/db/exec/filter.h"
 #include "mongo/db/exec/working_set_common.h"
 #include "mongo/util/fail_point_service.h"
@@ -51,6 +52,35 @@ namespace mongo {
 
     FetchStage::~FetchStage() { }
 
+    PlanStage::StageState FetchStage::workBatch(size_t maxWorks, vector<WorkingSetID>* out) {
+        // Adds the amount of time taken by workBatch() to executionTimeMillis.
+        ScopedTimer timer(&_commonStats.executionTimeMillis);
+
+        if (isEOF()) {
+            ++_commonStats.works;
+            return PlanStage::IS_EOF;
+        }
+
+        ChildBatch batch(_child.get(), maxWorks, out);
+        _commonStats.works += batch.works;
+        _commonStats.needTime += batch.needTime;
+
+        // Fetch and filter the child's results, keeping the ones that match in place.
+        size_t kept = batch.begin;
+        for (size_t i = batch.begin; i < out->size(); ++i) {
+            WorkingSetID id = (*out)[i];
+            WorkingSetMember* member = _ws->get(id);
+            fetch(member);
+            if (PlanStage::ADVANCED == returnIfMatches(member, id, &id)) {
+                (*out)[kept++] = id;
+            }
+        }
+        out->resize(kept);
+
+        batch.appendFailure(_ws, "fetch", out);
+        return batch.parentState(*out);
+    }
+
     bool FetchStage::isEOF() {
         return _child->isEOF();
     }
@@ -70,24 +100,7 @@ namespace mongo {
 
         if (PlanStage::ADVANCED == status) {
             WorkingSetMember* member = _ws->get(id);
-
-            // If there's an obj there, there is no fetching to perform.
-            if (member->hasObj()) {
-                ++_specificStats.alreadyHasObj;
-            }
-            else {
-                // We need a valid loc to fetch from and this is the only state that has one.
-                verify(WorkingSetMember::LOC_AND_IDX == member->state);
-                verify(member->hasLoc());
-
-                // Don't need index data anymore as we have an obj.
-                member->keyData.clear();
-                member->obj = _collection->docFor(member->loc);
-                member->state = WorkingSetMember::LOC_AND_UNOWNED_OBJ;
-            }
-
-            ++_specificStats.docsExamined;
-
+            fetch(member);
             return returnIfMatches(member, id, out);
         }
         else if (PlanStage::FAILURE == status) {
@@ -127,6 +140,25 @@ namespace mongo {
         _child->invalidate(dl, type);
     }
 
+    void FetchStage::fetch(WorkingSetMember* member) {
+        // If there's an obj there, there is no fetching to perform.
+        if (member->hasObj()) {
+            ++_specificStats.alreadyHasObj;
+        }
+        else {
+            // We need a valid loc to fetch from and this is the only state that has one.
+            verify(WorkingSetMember::LOC_AND_IDX == member->state);
+            verify(member->hasLoc());
+
+            // Don't need index data anymore as we have an obj.
+            member->keyData.clear();
+            member->obj = _collection->docFor(member->loc);
+            member->state = WorkingSetMember::LOC_AND_UNOWNED_OBJ;
+        }
+
+        ++_specificStats.docsExamined;
+    }
+
     PlanStage::StageState FetchStage::returnIfMatches(WorkingSetMember* member,
                                                       WorkingSetID memberID,
                                                       WorkingSetID* out) {
@@ -54,6 +54,7 @@ namespace mongo {
 
         virtual bool isEOF();
         virtual StageState work(WorkingSetID* out);
+        virtual StageState workBatch(size_t maxWorks, std::vector<WorkingSetID>* out);
 
         virtual void saveState();
         virtual void restoreState(OperationContext* opCtx);
@@ -73,6 +74,11 @@ namespace mongo {
 
     private:
 
+        /**
+         * Reads the document for a member produced by our child, unless it already has one.
+         */
+        void fetch(WorkingSetMember* member);
+
         /**
          * If the member (with id memberID) passes our filter, set *out to memberID and return that
          * ADVANCED.  Otherwise, free memberID and return NEED_TIME.
@@ -135,10 +135,33 @@ namespace mongo {
     }
 
     PlanStage::StageState IndexScan::work(WorkingSetID* out) {
-        ++_commonStats.works;
-
         // Adds the amount of time taken by work() to executionTimeMillis.
         ScopedTimer timer(&_commonStats.executionTimeMillis);
+        return doWork(out);
+    }
+
+    PlanStage::StageState IndexScan::workBatch(size_t maxWorks, vector<WorkingSetID>* out) {
+        // One timer for the whole batch rather than one per unit of work.
+        ScopedTimer timer(&_commonStats.executionTimeMillis);
+
+        const size_t begin = out->size();
+        for (size_t i = 0; i < maxWorks; ++i) {
+            WorkingSetID id = WorkingSet::INVALID_ID;
+            StageState state = doWork(&id);
+            if (PlanStage::ADVANCED == state) {
+                out->push_back(id);
+            }
+            else if (PlanStage::NEED_TIME != state) {
+                // An index scan never fails, so there is no failure id to pass on.
+                invariant(PlanStage::FAILURE != state);
+                return state;
+            }
+        }
+        return out->size() > begin ? PlanStage::ADVANCED : PlanStage::NEED_TIME;
+    }
+
+    PlanStage::StageState IndexScan::doWork(WorkingSetID* out) {
+        ++_commonStats.works;
 
         // If we examined multiple keys in a prior work cycle, make up for it here by returning
         // NEED_TIME. This is done for plan ranking. Refer to the comment for '_checkEndKeys'
@@ -88,6 +88,7 @@ namespace mongo {
         virtual ~IndexScan() { }
 
         virtual StageState work(WorkingSetID* out);
+        virtual StageState workBatch(size_t maxWorks, std::vector<WorkingSetID>* out);
         virtual bool isEOF();
         virtual void saveState();
         virtual void restoreState(OperationContext* opCtx);
@@ -106,6 +107,11 @@ namespace mongo {
         static const char* kStageType;
 
     private:
+        /**
+         * A unit of work, without the timing done by work() and workBatch().
+         */
+        StageState doWork(WorkingSetID* out);
+
         /**
          * Initialize the underlying IndexCursor, grab information from the catalog for stats.
          */
@@ -27,6 +27,10 @@
  */
 
 #include "mongo/db/exec/limit.h"
+
+#include <algorithm>
+
+#include "mongo/db/exec/child_batch.h"
 #include "mongo/db/exec/working_set_common.h"
 #include "mongo/util/mongoutils/str.h"
 
@@ -40,6 +44,30 @@ namespace mongo {
 
     LimitStage::~LimitStage() { }
 
+    PlanStage::StageState LimitStage::workBatch(size_t maxWorks, vector<WorkingSetID>* out) {
+        // Adds the amount of time taken by workBatch() to executionTimeMillis.
+        ScopedTimer timer(&_commonStats.executionTimeMillis);
+
+        if (0 == _numToReturn) {
+            // We've returned as many results as we're limited to.
+            ++_commonStats.works;
+            return PlanStage::IS_EOF;
+        }
+
+        // Every unit of work produces at most one result, so this can't overshoot the limit.
+        const size_t childWorks = std::min(maxWorks, static_cast<size_t>(_numToReturn));
+        ChildBatch batch(_child.get(), childWorks, out);
+        _commonStats.works += batch.works;
+        _commonStats.needTime += batch.needTime;
+
+        const size_t numResults = out->size() - batch.begin;
+        _numToReturn -= numResults;
+        _commonStats.advanced += numResults;
+
+        batch.appendFailure(_ws, "limit", out);
+        return batch.parentState(*out);
+    }
+
     bool LimitStage::isEOF() { return (0 == _numToReturn) || _child->isEOF(); }
 
     PlanStage::StageState LimitStage::work(WorkingSetID* out) {
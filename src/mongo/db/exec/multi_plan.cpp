@@ -31,6 +31,7 @@
 #include "mongo/platform/basic.h"
 
 #include "mongo/db/exec/multi_plan.h"
+#include "mongo/db/exec/shard_filter.h"
 #include "mongo/db/exec/working_set_common.h"
 #include "mongo/util/mongoutils/str.h"
 
@@ -52,6 +53,41 @@ namespace mongo {
     // static
     const char* MultiPlanStage::kStageType = "MULTI_PLAN";
 
+    namespace {
+
+        void getShardFilters(PlanStage* root, vector<ShardFilterStage*>* out) {
+            if (STAGE_SHARDING_FILTER == root->stageType()) {
+                out->push_back(static_cast<ShardFilterStage*>(root));
+            }
+
+            vector<PlanStage*> children = root->getChildren();
+            for (size_t i = 0; i < children.size(); ++i) {
+                getShardFilters(children[i], out);
+            }
+        }
+
+        /**
+         * The reads counted by the sharding filters of a candidate plan are held back until it
+         * is chosen, so that the trial runs of the losing plans don't add to the chunk loads.
+         */
+        void holdShardFilterReads(PlanStage* root) {
+            vector<ShardFilterStage*> filters;
+            getShardFilters(root, &filters);
+            for (size_t i = 0; i < filters.size(); ++i) {
+                filters[i]->holdReads();
+            }
+        }
+
+        void releaseShardFilterReads(PlanStage* root, bool countHeld) {
+            vector<ShardFilterStage*> filters;
+            getShardFilters(root, &filters);
+            for (size_t i = 0; i < filters.size(); ++i) {
+                filters[i]->releaseHeldReads(countHeld);
+            }
+        }
+
+    }  // namespace
+
     MultiPlanStage::MultiPlanStage(const Collection* collection, CanonicalQuery* cq)
         : _collection(collection),
           _query(cq),
@@ -78,6 +114,7 @@ namespace mongo {
     void MultiPlanStage::addPlan(QuerySolution* solution, PlanStage* root,
                                  WorkingSet* ws) {
         _candidates.push_back(CandidatePlan(solution, root, ws));
+        holdShardFilterReads(root);
     }
 
     bool MultiPlanStage::isEOF() {
@@ -128,12 +165,14 @@ namespace mongo {
 
             _bestPlanIdx = _backupPlanIdx;
             _backupPlanIdx = kNoSuchPlan;
+            releaseShardFilterReads(_candidates[_bestPlanIdx].root, true);
 
             return _candidates[_bestPlanIdx].root->work(out);
         }
 
         if (hasBackupPlan() && PlanStage::ADVANCED == state) {
             QLOG() << "Best plan had a blocking stage, became unblocked\n";
+            releaseShardFilterReads(_candidates[_backupPlanIdx].root, false);
             _backupPlanIdx = kNoSuchPlan;
         }
 
@@ -204,6 +243,13 @@ namespace mongo {
             }
         }
 
+        // Only the reads of the plan which is going to run count
+        for (size_t ix = 0; ix < _candidates.size(); ++ix) {
+            if (ix == static_cast<size_t>(_backupPlanIdx)) { continue; }
+            releaseShardFilterReads(_candidates[ix].root,
+                                    ix == static_cast<size_t>(_bestPlanIdx));
+        }
+
         // Logging for tied plans.
         if (ranking->tieForBest && NULL != _collection) {
             // These arrays having two or more entries is implied by 'tieForBest'.
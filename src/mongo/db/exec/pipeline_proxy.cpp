@@ -36,11 +36,11 @@
 namespace mongo {
 
     PipelineProxyStage::PipelineProxyStage(intrusive_ptr<Pipeline> pipeline,
-                                           const boost::shared_ptr<PlanExecutor>& child,
+                                           const vector<boost::shared_ptr<PlanExecutor> >& children,
                                            WorkingSet* ws)
         : _pipeline(pipeline)
         , _includeMetaData(_pipeline->getContext()->inShard) // send metadata to merger
-        , _childExec(child)
+        , _childExecs(children.begin(), children.end())
         , _ws(ws)
     {}
 
@@ -82,9 +82,11 @@ namespace mongo {
     }
 
     void PipelineProxyStage::invalidate(const DiskLoc& dl, InvalidationType type) {
-        // propagate to child executor if still in use
-        if (boost::shared_ptr<PlanExecutor> exec = _childExec.lock()) {
-            exec->invalidate(dl, type);
+        // propagate to child executors if still in use
+        for (size_t i = 0; i < _childExecs.size(); i++) {
+            if (boost::shared_ptr<PlanExecutor> exec = _childExecs[i].lock()) {
+                exec->invalidate(dl, type);
+            }
         }
     }
 
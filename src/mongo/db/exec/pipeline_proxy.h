@@ -44,8 +44,12 @@ namespace mongo {
      */
     class PipelineProxyStage : public PlanStage {
     public:
+        /**
+         * @param children the executors feeding the pipeline, which invalidations are passed on
+         *        to. See PipelineD::prepareCursorSource().
+         */
         PipelineProxyStage(intrusive_ptr<Pipeline> pipeline,
-                           const boost::shared_ptr<PlanExecutor>& child,
+                           const std::vector<boost::shared_ptr<PlanExecutor> >& children,
                            WorkingSet* ws);
 
         virtual PlanStage::StageState work(WorkingSetID* out);
@@ -87,7 +91,7 @@ namespace mongo {
         const intrusive_ptr<Pipeline> _pipeline;
         vector<BSONObj> _stash;
         const bool _includeMetaData;
-        boost::weak_ptr<PlanExecutor> _childExec;
+        std::vector<boost::weak_ptr<PlanExecutor> > _childExecs;
 
         // Not owned by us.
         WorkingSet* _ws;
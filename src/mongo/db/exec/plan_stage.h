@@ -28,6 +28,8 @@
 
 #pragma once
 
+#include <vector>
+
 #include "mongo/db/exec/plan_stats.h"
 #include "mongo/db/exec/working_set.h"
 #include "mongo/db/invalidation_type.h"
@@ -155,6 +157,39 @@ namespace mongo {
          */
         virtual StageState work(WorkingSetID* out) = 0;
 
+        /**
+         * Perform up to 'maxWorks' units of work in one call, as if work() had been called that
+         * many times, appending the id of every result produced to 'out'.  This lets a tree of
+         * stages pass results up in batches rather than making a chain of virtual calls per
+         * result.
+         *
+         * Stops early once a unit of work returns IS_EOF, DEAD or FAILURE, and returns that state.
+         * Otherwise returns ADVANCED if any result was appended and NEED_TIME if none was.  The
+         * results appended to 'out' are valid whatever the returned state, and the caller must
+         * consume or free them before acting on it.  On FAILURE the last id appended to 'out' is
+         * not a result but the id work() would have returned with FAILURE.
+         *
+         * Stages that can do better than calling work() in a loop override this; the stats they
+         * report must be the same as if work() had been called instead.
+         */
+        virtual StageState workBatch(size_t maxWorks, std::vector<WorkingSetID>* out) {
+            const size_t begin = out->size();
+            for (size_t i = 0; i < maxWorks; ++i) {
+                WorkingSetID id = WorkingSet::INVALID_ID;
+                StageState state = work(&id);
+                if (ADVANCED == state) {
+                    out->push_back(id);
+                }
+                else if (NEED_TIME != state) {
+                    if (FAILURE == state) {
+                        out->push_back(id);
+                    }
+                    return state;
+                }
+            }
+            return out->size() > begin ? ADVANCED : NEED_TIME;
+        }
+
         /**
          * Returns true if no more work can be done on the query / out of results.
          */
@@ -436,7 +436,7 @@ namespace mongo {
     };
 
     struct ProjectionStats : public SpecificStats {
-        ProjectionStats() { }
+        ProjectionStats() : covered(false) { }
 
         virtual SpecificStats* clone() const {
             ProjectionStats* specific = new ProjectionStats(*this);
@@ -445,10 +445,13 @@ namespace mongo {
 
         // Object specifying the projection transformation to apply.
         BSONObj projObj;
+
+        // True if the projection is computed from index keys without fetching documents.
+        bool covered;
     };
 
     struct SortStats : public SpecificStats {
-        SortStats() : forcedFetches(0), memUsage(0), memLimit(0) { }
+        SortStats() : forcedFetches(0), memUsage(0), memLimit(0), spills(0), spilledBytes(0) { }
 
         virtual ~SortStats() { }
 
@@ -471,6 +474,10 @@ namespace mongo {
 
         // The pattern according to which we are sorting.
         BSONObj sortPattern;
+
+        // How many sorted runs did we write to disk, and how much buffered data did they hold?
+        size_t spills;
+        long long spilledBytes;
     };
 
     struct MergeSortStats : public SpecificStats {
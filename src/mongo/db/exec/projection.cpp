@@ -29,6 +29,7 @@
 #include "mongo/db/exec/projection.h"
 
 #include "mongo/db/diskloc.h"
+#include "mongo/db/exec/child_batch.h"
 #include "mongo/db/exec/plan_stage.h"
 #include "mongo/db/exec/working_set_common.h"
 #include "mongo/db/jsobj.h"
@@ -52,6 +53,7 @@ namespace mongo {
           _projImpl(params.projImpl) {
 
         _projObj = params.projObj;
+        _specificStats.covered = params.covered;
 
         if (ProjectionStageParams::NO_FAST_PATH == _projImpl) {
             _exec.reset(new ProjectionExec(params.projObj, 
@@ -193,6 +195,43 @@ namespace mongo {
 
     ProjectionStage::~ProjectionStage() { }
 
+    PlanStage::StageState ProjectionStage::workBatch(size_t maxWorks, vector<WorkingSetID>* out) {
+        // Adds the amount of time taken by workBatch() to executionTimeMillis.
+        ScopedTimer timer(&_commonStats.executionTimeMillis);
+
+        // work() doesn't count NEED_TIMEs, so neither do we.
+        ChildBatch batch(_child.get(), maxWorks, out);
+        _commonStats.works += batch.works;
+
+        for (size_t i = batch.begin; i < out->size(); ++i) {
+            WorkingSetMember* member = _ws->get((*out)[i]);
+            // Punt to our specific projection impl.
+            Status projStatus = transform(member);
+            if (!projStatus.isOK()) {
+                warning() << "Couldn't execute projection, status = "
+                          << projStatus.toString() << endl;
+
+                // The results before this one are still good; this one and the rest are not.
+                for (size_t j = i; j < out->size(); ++j) {
+                    _ws->free((*out)[j]);
+                }
+                out->resize(i);
+                if (PlanStage::FAILURE == batch.state &&
+                    WorkingSet::INVALID_ID != batch.failureId) {
+                    _ws->free(batch.failureId);
+                }
+
+                out->push_back(WorkingSetCommon::allocateStatusMember(_ws, projStatus));
+                return PlanStage::FAILURE;
+            }
+
+            ++_commonStats.advanced;
+        }
+
+        batch.appendFailure(_ws, "projection", out);
+        return batch.parentState(*out);
+    }
+
     bool ProjectionStage::isEOF() { return _child->isEOF(); }
 
     PlanStage::StageState ProjectionStage::work(WorkingSetID* out) {
@@ -49,7 +49,7 @@ namespace mongo {
         };
 
         ProjectionStageParams(const MatchExpressionParser::WhereCallback& wc) 
-            : projImpl(NO_FAST_PATH), fullExpression(NULL), whereCallback(&wc) { }
+            : projImpl(NO_FAST_PATH), fullExpression(NULL), covered(false), whereCallback(&wc) { }
 
         ProjectionImplementation projImpl;
 
@@ -65,6 +65,9 @@ namespace mongo {
         // from.  Otherwise, this field is ignored.
         BSONObj coveredKeyObj;
 
+        // Does the plan below the projection avoid fetching documents?  Only reported in explain.
+        bool covered;
+
         // Used for creating context for the $where clause processing. Not owned.
         const MatchExpressionParser::WhereCallback* whereCallback;
     };
@@ -82,6 +85,7 @@ namespace mongo {
 
         virtual bool isEOF();
         virtual StageState work(WorkingSetID* out);
+        virtual StageState workBatch(size_t maxWorks, std::vector<WorkingSetID>* out);
 
         virtual void saveState();
         virtual void restoreState(OperationContext* opCtx);
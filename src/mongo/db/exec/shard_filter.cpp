@@ -29,18 +29,36 @@
 #include "mongo/db/exec/shard_filter.h"
 
 #include "mongo/db/keypattern.h"
+#include "mongo/s/chunk_load_stats.h"
+#include "mongo/util/time_support.h"
 
 namespace mongo {
 
     // static
     const char* ShardFilterStage::kStageType = "SHARDING_FILTER";
 
-    ShardFilterStage::ShardFilterStage(const CollectionMetadataPtr& metadata,
+    // Most reads counted before adding them to chunkLoadStats, so that a long running cursor's
+    // reads are not all counted when it is done.
+    static const long long kMaxPendingReads = 128;
+
+    ShardFilterStage::ShardFilterStage(const string& ns,
+                                       const CollectionMetadataPtr& metadata,
                                        WorkingSet* ws,
                                        PlanStage* child)
-        : _ws(ws), _child(child), _commonStats(kStageType), _metadata(metadata) { }
-
-    ShardFilterStage::~ShardFilterStage() { }
+        : _ns(ns),
+          _ws(ws),
+          _child(child),
+          _commonStats(kStageType),
+          _metadata(metadata),
+          _trackReads(chunkLoadStats.isTracking()),
+          _pendingReads(0),
+          _holdingReads(false) { }
+
+    ShardFilterStage::~ShardFilterStage() {
+        if (!_holdingReads) {
+            _flushReads();
+        }
+    }
 
     bool ShardFilterStage::isEOF() { return _child->isEOF(); }
 
@@ -64,11 +82,16 @@ namespace mongo {
                 WorkingSetMember* member = _ws->get(*out);
 
                 // This performs excessive BSONObj creation but that's OK for now.
-                if (!_metadata->keyBelongsToMe(kp.extractSingleKey(member->obj))) {
+                BSONObj key = kp.extractSingleKey(member->obj);
+                if (!_metadata->keyBelongsToMe(key)) {
                     _ws->free(*out);
                     ++_specificStats.chunkSkips;
                     return PlanStage::NEED_TIME;
                 }
+
+                if (_trackReads) {
+                    _noteRead(key);
+                }
             }
 
             // If we're here either we have shard state and our doc passed, or we have no shard
@@ -84,6 +107,75 @@ namespace mongo {
         }
     }
 
+    void ShardFilterStage::_noteRead(const BSONObj& key) {
+        if (!_readChunkMin.isEmpty() && rangeContains(_readChunkMin, _readChunkMax, key)) {
+            if (++_pendingReads >= kMaxPendingReads) {
+                _flushReads();
+            }
+            return;
+        }
+
+        _flushReads();
+
+        ChunkType chunk;
+        if (!_metadata->getChunkContaining(key, &chunk)) {
+            return;
+        }
+
+        _readChunkMin = chunk.getMin();
+        _readChunkMax = chunk.getMax();
+        _pendingReads = 1;
+    }
+
+    void ShardFilterStage::_flushReads() {
+        if (_pendingReads == 0) {
+            return;
+        }
+
+        if (_holdingReads) {
+            if (!_heldReads.empty() &&
+                    _heldReads.back().chunkMin.woCompare(_readChunkMin) == 0) {
+                _heldReads.back().reads += _pendingReads;
+            }
+            else {
+                ChunkReads held;
+                held.chunkMin = _readChunkMin;
+                held.chunkMax = _readChunkMax;
+                held.reads = _pendingReads;
+                _heldReads.push_back(held);
+            }
+        }
+        else {
+            chunkLoadStats.noteOps(_ns, _readChunkMin, _readChunkMax, _pendingReads, 0,
+                                   curTimeMillis64());
+        }
+        _pendingReads = 0;
+    }
+
+    void ShardFilterStage::holdReads() {
+        _flushReads();
+        _holdingReads = true;
+    }
+
+    void ShardFilterStage::releaseHeldReads(bool countHeld) {
+        if (!_holdingReads) {
+            return;
+        }
+
+        _flushReads();
+        _holdingReads = false;
+
+        if (countHeld) {
+            const unsigned long long nowMillis = curTimeMillis64();
+            for (size_t i = 0; i < _heldReads.size(); ++i) {
+                const ChunkReads& held = _heldReads[i];
+                chunkLoadStats.noteOps(_ns, held.chunkMin, held.chunkMax, held.reads, 0,
+                                       nowMillis);
+            }
+        }
+        _heldReads.clear();
+    }
+
     void ShardFilterStage::saveState() {
         ++_commonStats.yields;
         _child->saveState();
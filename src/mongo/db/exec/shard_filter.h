@@ -74,7 +74,10 @@ namespace mongo {
      */
     class ShardFilterStage : public PlanStage {
     public:
-        ShardFilterStage(const CollectionMetadataPtr& metadata, WorkingSet* ws, PlanStage* child);
+        ShardFilterStage(const std::string& ns,
+                         const CollectionMetadataPtr& metadata,
+                         WorkingSet* ws,
+                         PlanStage* child);
         virtual ~ShardFilterStage();
 
         virtual bool isEOF();
@@ -96,7 +99,37 @@ namespace mongo {
 
         static const char* kStageType;
 
+        /**
+         * Holds back the reads counted from now on instead of adding them to chunkLoadStats, for
+         * a plan which may only run as a trial.  Reads still held back when the stage is destroyed
+         * are forgotten.
+         */
+        void holdReads();
+
+        /**
+         * Stops holding back reads, and adds those held back so far to chunkLoadStats if
+         * 'countHeld' is true, or forgets them.
+         */
+        void releaseHeldReads(bool countHeld);
+
     private:
+        // Reads of one chunk held back, see holdReads
+        struct ChunkReads {
+            BSONObj chunkMin;
+            BSONObj chunkMax;
+            long long reads;
+        };
+
+        /**
+         * Counts a read of the document with shard key 'key' in chunkLoadStats.  Reads are counted
+         * in batches while they hit the same chunk, see _flushReads.
+         */
+        void _noteRead(const BSONObj& key);
+
+        /** Adds the reads counted so far to chunkLoadStats, or to _heldReads if holding. */
+        void _flushReads();
+
+        const std::string _ns;
         WorkingSet* _ws;
         scoped_ptr<PlanStage> _child;
 
@@ -107,6 +140,17 @@ namespace mongo {
         // Note: it is important that this is the metadata from the time this stage is constructed.
         // See class comment for details.
         const CollectionMetadataPtr _metadata;
+
+        // Whether reads are counted in chunkLoadStats, decided once for the whole query
+        const bool _trackReads;
+
+        // Reads not added to chunkLoadStats yet, in the chunk [_readChunkMin, _readChunkMax)
+        BSONObj _readChunkMin;
+        BSONObj _readChunkMax;
+        long long _pendingReads;
+
+        bool _holdingReads;
+        std::vector<ChunkReads> _heldReads;
     };
 
 }  // namespace mongo
@@ -27,6 +27,8 @@
 */
 
 #include "mongo/db/exec/skip.h"
+
+#include "mongo/db/exec/child_batch.h"
 #include "mongo/db/exec/working_set_common.h"
 #include "mongo/util/mongoutils/str.h"
 
@@ -40,6 +42,34 @@ namespace mongo {
 
     SkipStage::~SkipStage() { }
 
+    PlanStage::StageState SkipStage::workBatch(size_t maxWorks, vector<WorkingSetID>* out) {
+        // Adds the amount of time taken by workBatch() to executionTimeMillis.
+        ScopedTimer timer(&_commonStats.executionTimeMillis);
+
+        ChildBatch batch(_child.get(), maxWorks, out);
+        _commonStats.works += batch.works;
+        _commonStats.needTime += batch.needTime;
+
+        // Drop results while we're still skipping, and pass on the rest.
+        size_t kept = batch.begin;
+        for (size_t i = batch.begin; i < out->size(); ++i) {
+            WorkingSetID id = (*out)[i];
+            if (_toSkip > 0) {
+                --_toSkip;
+                _ws->free(id);
+                ++_commonStats.needTime;
+            }
+            else {
+                (*out)[kept++] = id;
+                ++_commonStats.advanced;
+            }
+        }
+        out->resize(kept);
+
+        batch.appendFailure(_ws, "skip", out);
+        return batch.parentState(*out);
+    }
+
     bool SkipStage::isEOF() { return _child->isEOF(); }
 
     PlanStage::StageState SkipStage::work(WorkingSetID* out) {
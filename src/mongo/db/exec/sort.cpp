@@ -30,7 +30,9 @@
 
 #include <algorithm>
 
+#include "mongo/base/counter.h"
 #include "mongo/db/catalog/collection.h"
+#include "mongo/db/commands/server_status_metric.h"
 #include "mongo/db/index_names.h"
 #include "mongo/db/exec/working_set_common.h"
 #include "mongo/db/exec/working_set_computed_data.h"
@@ -38,6 +40,7 @@
 #include "mongo/db/query/lite_parsed_query.h"
 #include "mongo/db/query/qlog.h"
 #include "mongo/db/query/query_planner.h"
+#include "mongo/db/storage_options.h"
 
 namespace mongo {
 
@@ -45,6 +48,82 @@ namespace mongo {
 
     const size_t kMaxBytes = 32 * 1024 * 1024;
 
+    static Counter64 sortSpills;
+    static ServerStatusMetricField<Counter64> displaySortSpills("query.sort.spills",
+                                                                &sortSpills);
+
+    static Counter64 sortSpilledBytes;
+    static ServerStatusMetricField<Counter64> displaySortSpilledBytes("query.sort.spilledBytes",
+                                                                      &sortSpilledBytes);
+
+    struct SortStage::SpilledMember {
+        SpilledMember() : hasTextScore(false), textScore(0.0) { }
+
+        // members for Sorter
+        struct SorterDeserializeSettings {}; // unused
+
+        void serializeForSorter(BufBuilder& buf) const {
+            loc.serializeForSorter(buf);
+            buf.appendChar(hasTextScore ? 1 : 0);
+            if (hasTextScore) {
+                buf.appendNum(textScore);
+            }
+            obj.serializeForSorter(buf);
+        }
+
+        static SpilledMember deserializeForSorter(BufReader& buf,
+                                                  const SorterDeserializeSettings&) {
+            SpilledMember out;
+            out.loc = DiskLoc::deserializeForSorter(buf, DiskLoc::SorterDeserializeSettings());
+            out.hasTextScore = buf.read<char>();
+            if (out.hasTextScore) {
+                out.textScore = buf.read<double>();
+            }
+            out.obj = BSONObj::deserializeForSorter(buf, BSONObj::SorterDeserializeSettings());
+            return out;
+        }
+
+        int memUsageForSorter() const {
+            return sizeof(SpilledMember) + obj.objsize();
+        }
+
+        SpilledMember getOwned() const {
+            SpilledMember out(*this);
+            out.obj = obj.getOwned();
+            return out;
+        }
+
+        // For the Sorter's debug checks.
+        friend std::ostream& operator<<(std::ostream& stream, const SpilledMember& member) {
+            return stream << member.loc.toString() << ' ' << member.obj.toString();
+        }
+
+        DiskLoc loc;
+        BSONObj obj;
+        bool hasTextScore;
+        double textScore;
+    };
+
+    /**
+     * Orders spilled members the same way WorkingSetComparator orders buffered ones.
+     */
+    class SortStage::SpilledMemberComparator {
+    public:
+        explicit SpilledMemberComparator(const BSONObj& pattern) : _pattern(pattern) { }
+
+        int operator()(const SpillIterator::Data& lhs, const SpillIterator::Data& rhs) const {
+            // False means ignore field names.
+            int result = lhs.first.woCompare(rhs.first, _pattern, false);
+            if (0 != result) {
+                return result;
+            }
+            return lhs.second.loc.compare(rhs.second.loc);
+        }
+
+    private:
+        BSONObj _pattern;
+    };
+
     // static
     const char* SortStage::kStageType = "SORT";
 
@@ -288,6 +367,7 @@ namespace mongo {
           _query(params.query),
           _limit(params.limit),
           _sorted(false),
+          _allowDiskUse(params.allowDiskUse && 0 == params.limit),
           _resultIterator(_data.end()),
           _commonStats(kStageType),
           _memUsage(0) {
@@ -298,7 +378,8 @@ namespace mongo {
     bool SortStage::isEOF() {
         // We're done when our child has no more results, we've sorted the child's results, and
         // we've returned all sorted results.
-        return _child->isEOF() && _sorted && (_data.end() == _resultIterator);
+        return _child->isEOF() && _sorted && (_data.end() == _resultIterator)
+            && (NULL == _spillMerger || !_spillMerger->more());
     }
 
     PlanStage::StageState SortStage::work(WorkingSetID* out) {
@@ -320,6 +401,16 @@ namespace mongo {
             return PlanStage::NEED_TIME;
         }
 
+        if (_memUsage > kMaxBytes && _allowDiskUse) {
+            Status status = spill();
+            if (!status.isOK()) {
+                *out = WorkingSetCommon::allocateStatusMember(_ws, status);
+                return PlanStage::FAILURE;
+            }
+            ++_commonStats.needTime;
+            return PlanStage::NEED_TIME;
+        }
+
         if (_memUsage > kMaxBytes) {
             mongoutils::str::stream ss;
             ss << "sort stage buffered data usage of " << _memUsage
@@ -371,7 +462,20 @@ namespace mongo {
             else if (PlanStage::IS_EOF == code) {
                 // TODO: We don't need the lock for this.  We could ask for a yield and do this work
                 // unlocked.  Also, this is performing a lot of work for one call to work(...)
-                sortBuffer();
+                if (_spilledRuns.empty()) {
+                    sortBuffer();
+                }
+                else {
+                    // Whatever is left in memory becomes the last run.
+                    Status status = spill();
+                    if (!status.isOK()) {
+                        *out = WorkingSetCommon::allocateStatusMember(_ws, status);
+                        return PlanStage::FAILURE;
+                    }
+                    SpilledMemberComparator cmp(_sortKeyComparator->pattern);
+                    _spillMerger.reset(SpillIterator::merge(_spilledRuns, SortOptions(), cmp));
+                    _spilledRuns.clear();
+                }
                 _resultIterator = _data.begin();
                 _sorted = true;
                 ++_commonStats.needTime;
@@ -399,6 +503,28 @@ namespace mongo {
         }
 
         // Returning results.
+        if (NULL != _spillMerger) {
+            // Rebuild the WSM from disk.  If its DiskLoc was invalidated while it was spilled, it
+            // comes back as an owned object, the same as a buffered WSM would have.
+            SpillIterator::Data next = _spillMerger->next();
+            *out = _ws->allocate();
+            WorkingSetMember* member = _ws->get(*out);
+            member->obj = next.second.obj.getOwned();
+            if (!next.second.loc.isNull() && 1 == _spilledLocs.erase(next.second.loc)) {
+                member->loc = next.second.loc;
+                member->state = WorkingSetMember::LOC_AND_UNOWNED_OBJ;
+            }
+            else {
+                member->state = WorkingSetMember::OWNED_OBJ;
+            }
+            if (next.second.hasTextScore) {
+                member->addComputed(new TextScoreComputedData(next.second.textScore));
+            }
+
+            ++_commonStats.advanced;
+            return PlanStage::ADVANCED;
+        }
+
         verify(_resultIterator != _data.end());
         verify(_sorted);
         *out = _resultIterator->wsid;
@@ -438,6 +564,9 @@ namespace mongo {
         // be at the same spot in the WorkingSet.  As such, we don't need to modify _data.
         DataMap::iterator it = _wsidByDiskLoc.find(dl);
 
+        // The spilled copy of the document stays as it was, but it can't keep its DiskLoc.
+        _spilledLocs.erase(dl);
+
         // If we're holding on to data that's got the DiskLoc we're invalidating...
         if (_wsidByDiskLoc.end() != it) {
             // Grab the WSM that we're nuking.
@@ -562,6 +691,62 @@ namespace mongo {
         }
     }
 
+    Status SortStage::spill() {
+        verify(0 == _limit);
+
+        const WorkingSetComparator& cmp = *_sortKeyComparator;
+        std::sort(_data.begin(), _data.end(), cmp);
+
+        SortedFileWriter<BSONObj, SpilledMember> writer(
+            SortOptions().TempDir(storageGlobalParams.dbpath + "/_tmp"));
+
+        for (vector<SortableDataItem>::const_iterator it = _data.begin(); it != _data.end(); ++it) {
+            WorkingSetMember* member = _ws->get(it->wsid);
+
+            // The text score is the only computed data that can be written out.
+            for (int i = 0; i < WSM_COMPUTED_NUM_TYPES; ++i) {
+                if (WSM_COMPUTED_TEXT_SCORE != i
+                    && member->hasComputed(static_cast<WorkingSetComputedDataType>(i))) {
+                    return Status(ErrorCodes::BadValue,
+                                  "sort stage can't spill results carrying computed metadata");
+                }
+            }
+
+            SpilledMember spilled;
+            spilled.loc = it->loc;
+            spilled.obj = member->obj;
+            if (member->hasComputed(WSM_COMPUTED_TEXT_SCORE)) {
+                const TextScoreComputedData* scoreData
+                    = static_cast<const TextScoreComputedData*>(
+                            member->getComputed(WSM_COMPUTED_TEXT_SCORE));
+                spilled.hasTextScore = true;
+                spilled.textScore = scoreData->getScore();
+            }
+            writer.addAlreadySorted(it->sortKey, spilled);
+        }
+
+        // The documents are on disk now, and only their DiskLocs are left to invalidate.
+        for (vector<SortableDataItem>::const_iterator it = _data.begin(); it != _data.end(); ++it) {
+            WorkingSetMember* member = _ws->get(it->wsid);
+            if (member->hasLoc()) {
+                _wsidByDiskLoc.erase(member->loc);
+                _spilledLocs.insert(member->loc);
+            }
+            _ws->free(it->wsid);
+        }
+        _data.clear();
+
+        _spilledRuns.push_back(boost::shared_ptr<SpillIterator>(writer.done()));
+
+        ++_specificStats.spills;
+        _specificStats.spilledBytes += _memUsage;
+        sortSpills.increment();
+        sortSpilledBytes.increment(_memUsage);
+        _memUsage = 0;
+
+        return Status::OK();
+    }
+
     void SortStage::sortBuffer() {
         if (_limit == 0) {
             const WorkingSetComparator& cmp = *_sortKeyComparator;
@@ -582,3 +767,6 @@ namespace mongo {
     }
 
 }  // namespace mongo
+
+#include "mongo/db/sorter/sorter.cpp"
+// Explicit instantiation unneeded since we aren't exposing Sorter outside of this file.
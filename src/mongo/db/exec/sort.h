@@ -29,6 +29,7 @@
 #pragma once
 
 #include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
 #include <vector>
 #include <set>
 
@@ -37,7 +38,9 @@
 #include "mongo/db/exec/plan_stage.h"
 #include "mongo/db/exec/working_set.h"
 #include "mongo/db/query/index_bounds.h"
+#include "mongo/db/sorter/sorter.h"
 #include "mongo/platform/unordered_map.h"
+#include "mongo/platform/unordered_set.h"
 
 
 namespace mongo {
@@ -47,7 +50,7 @@ namespace mongo {
     // Parameters that must be provided to a SortStage
     class SortStageParams {
     public:
-        SortStageParams() : collection(NULL), limit(0) { }
+        SortStageParams() : collection(NULL), limit(0), allowDiskUse(false) { }
 
         // Used for resolving DiskLocs to BSON
         const Collection* collection;
@@ -60,6 +63,10 @@ namespace mongo {
 
         // Equal to 0 for no limit.
         size_t limit;
+
+        // May we write sorted runs to disk rather than fail when the data outgrows the memory
+        // limit?  Only used when there is no limit.
+        bool allowDiskUse;
     };
 
     /**
@@ -139,6 +146,10 @@ namespace mongo {
      *
      * Preconditions: For each field in 'pattern', all inputs in the child must handle a
      * getFieldDotted for that field.
+     *
+     * If the query allows it and there is no limit, data that outgrows the memory limit is
+     * sorted and written to disk in runs, which are merged once the child is done.  Results
+     * read back from disk are owned objects without a DiskLoc, as if they had been invalidated.
      */
     class SortStage : public PlanStage {
     public:
@@ -238,6 +249,29 @@ namespace mongo {
          */
         void sortBuffer();
 
+        //
+        // External sort
+        //
+
+        // A spilled WSM: what we need to rebuild it, and its DiskLoc to break ties.
+        struct SpilledMember;
+        class SpilledMemberComparator;
+        typedef SortIteratorInterface<BSONObj, SpilledMember> SpillIterator;
+
+        /**
+         * Sorts the data buffer, writes it to disk as a run, and frees the buffered WSMs.
+         */
+        Status spill();
+
+        // Equal to true if we may spill.  Set from the params and the limit.
+        bool _allowDiskUse;
+
+        // Runs spilled so far.  Merged into _spillMerger once the child is done.
+        std::vector<boost::shared_ptr<SpillIterator> > _spilledRuns;
+
+        // If we spilled, returns all results in order once we're sorted.  _data is empty then.
+        boost::scoped_ptr<SpillIterator> _spillMerger;
+
         // Comparator for data buffer
         // Initialization follows sort key generator
         scoped_ptr<WorkingSetComparator> _sortKeyComparator;
@@ -260,6 +294,11 @@ namespace mongo {
         typedef unordered_map<DiskLoc, WorkingSetID, DiskLoc::Hasher> DataMap;
         DataMap _wsidByDiskLoc;
 
+        // The DiskLocs of the spilled WSMs which haven't been invalidated since.  A spilled WSM
+        // gets its DiskLoc back when it is returned, unless it was invalidated.
+        typedef unordered_set<DiskLoc, DiskLoc::Hasher> DiskLocSet;
+        DiskLocSet _spilledLocs;
+
         //
         // Stats
         //
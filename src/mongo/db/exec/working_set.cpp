@@ -28,48 +28,109 @@
 
 #include "mongo/db/exec/working_set.h"
 
+#include <boost/thread/tss.hpp>
+
 #include "mongo/db/index/index_descriptor.h"
 
 namespace mongo {
 
-    WorkingSet::MemberHolder::MemberHolder() : member(NULL) { }
-    WorkingSet::MemberHolder::~MemberHolder() {}
+    /**
+     * Per-thread cache of slabs.  A WorkingSet is usually created, used and destroyed by one
+     * thread, so most queries find their first slabs here rather than allocating them.  Only a
+     * couple of slabs are kept per thread, since there may be many threads.
+     */
+    class WorkingSet::SlabCache {
+    public:
+        static const size_t kMaxCachedSlabs = 2;
+
+        SlabCache() : _numSlabs(0) { }
+
+        ~SlabCache() {
+            for (size_t i = 0; i < _numSlabs; i++) {
+                delete _slabs[i];
+            }
+        }
+
+        static Slab* acquire() {
+            SlabCache* cache = _cache.get();
+            if (NULL != cache && cache->_numSlabs > 0) {
+                return cache->_slabs[--cache->_numSlabs];
+            }
+            return new Slab();
+        }
+
+        /**
+         * All members of 's' must have been cleared.
+         */
+        static void release(Slab* s) {
+            SlabCache* cache = _cache.get();
+            if (NULL == cache) {
+                cache = new SlabCache();
+                _cache.reset(cache);
+            }
+            if (cache->_numSlabs == kMaxCachedSlabs) {
+                delete s;
+                return;
+            }
+            cache->_slabs[cache->_numSlabs++] = s;
+        }
 
-    WorkingSet::WorkingSet() : _freeList(INVALID_ID) { }
+    private:
+        static boost::thread_specific_ptr<SlabCache> _cache;
+
+        size_t _numSlabs;
+        Slab* _slabs[kMaxCachedSlabs];
+    };
+
+    boost::thread_specific_ptr<WorkingSet::SlabCache> WorkingSet::SlabCache::_cache;
+
+    WorkingSet::WorkingSet() : _numIds(0), _numSlabs(0), _freeList(INVALID_ID) { }
 
     WorkingSet::~WorkingSet() {
-        for (size_t i = 0; i < _data.size(); i++) {
-            delete _data[i].member;
+        clearMembers();
+        for (size_t i = 0; i < _numSlabs; i++) {
+            SlabCache::release(i < kInlineSlabs ? _inlineSlabs[i] : _moreSlabs[i - kInlineSlabs]);
         }
     }
 
     WorkingSetID WorkingSet::allocate() {
         if (_freeList == INVALID_ID) {
-            // The free list is empty so we need to make a single new WSM to return. This relies on
-            // vector::resize being amortized O(1) for efficient allocation. Note that the free list
-            // remains empty until something is returned by a call to free().
-            WorkingSetID id = _data.size();
-            _data.resize(_data.size() + 1);
-            _data.back().nextFreeOrSelf = id;
-            _data.back().member = new WorkingSetMember();
+            // The free list is empty so we need to hand out a new id, and a new slab if its
+            // slab doesn't exist yet.  Note that the free list remains empty until something is
+            // returned by a call to free().
+            WorkingSetID id = _numIds;
+            const size_t slab = id >> kSlabShift;
+            if (slab == _numSlabs) {
+                Slab* s = SlabCache::acquire();
+                if (slab < kInlineSlabs) {
+                    _inlineSlabs[slab] = s;
+                }
+                else {
+                    _moreSlabs.push_back(s);
+                }
+                ++_numSlabs;
+            }
+            ++_numIds;
+            entry(id).nextFreeOrSelf = id;
             return id;
         }
 
         // Pop the head off the free list and return it.
         WorkingSetID id = _freeList;
-        _freeList = _data[id].nextFreeOrSelf;
-        _data[id].nextFreeOrSelf = id; // set to self to mark as in-use
+        Entry& e = entry(id);
+        _freeList = e.nextFreeOrSelf;
+        e.nextFreeOrSelf = id; // set to self to mark as in-use
         return id;
     }
 
     void WorkingSet::free(const WorkingSetID& i) {
-        MemberHolder& holder = _data[i];
-        verify(i < _data.size()); // ID has been allocated.
-        verify(holder.nextFreeOrSelf == i); // ID currently in use.
+        verify(i < _numIds); // ID has been allocated.
+        Entry& e = entry(i);
+        verify(e.nextFreeOrSelf == i); // ID currently in use.
 
         // Free resources and push this WSM to the head of the freelist.
-        holder.member->clear();
-        holder.nextFreeOrSelf = _freeList;
+        e.member.clear();
+        e.nextFreeOrSelf = _freeList;
         _freeList = i;
     }
 
@@ -84,15 +145,14 @@ namespace mongo {
     }
 
     bool WorkingSet::isFlagged(WorkingSetID id) const {
-        invariant(id < _data.size());
-        return _flagged.end() != _flagged.find(id);
+        invariant(id < _numIds);
+        return !_flagged.empty() && _flagged.end() != _flagged.find(id);
     }
 
     void WorkingSet::clear() {
-        for (size_t i = 0; i < _data.size(); i++) {
-            delete _data[i].member;
-        }
-        _data.clear();
+        // The slabs are kept; ids are handed out from the start of the first one again.
+        clearMembers();
+        _numIds = 0;
 
         // Since working set is now empty, the free list pointer should
         // point to nothing.
@@ -101,6 +161,15 @@ namespace mongo {
         _flagged.clear();
     }
 
+    void WorkingSet::clearMembers() {
+        for (WorkingSetID i = 0; i < _numIds; i++) {
+            Entry& e = entry(i);
+            if (e.nextFreeOrSelf == i) {
+                e.member.clear();
+            }
+        }
+    }
+
     WorkingSetMember::WorkingSetMember() : state(WorkingSetMember::INVALID) { }
 
     WorkingSetMember::~WorkingSetMember() { }
@@ -110,8 +179,10 @@ namespace mongo {
             _computed[i].reset();
         }
 
+        // clear() rather than swap, so a pooled member keeps the vector's storage.
         keyData.clear();
         obj = BSONObj();
+        loc = DiskLoc();
         state = WorkingSetMember::INVALID;
     }
 
@@ -38,99 +38,8 @@
 
 namespace mongo {
 
-    class WorkingSetMember;
-
     typedef size_t WorkingSetID;
 
-    /**
-     * All data in use by a query.  Data is passed through the stage tree by referencing the ID of
-     * an element of the working set.  Stages can add elements to the working set, delete elements
-     * from the working set, or mutate elements in the working set.
-     *
-     * Concurrency Notes:
-     * flagForReview() can only be called with a write lock covering the collection this WorkingSet
-     * is for. All other methods should only be called by the thread owning this WorkingSet while
-     * holding the read lock covering the collection.
-     */
-    class WorkingSet {
-        MONGO_DISALLOW_COPYING(WorkingSet);
-    public:
-        static const WorkingSetID INVALID_ID = WorkingSetID(-1);
-
-        WorkingSet();
-        ~WorkingSet();
-
-        /**
-         * Allocate a new query result and return the ID used to get and free it.
-         */
-        WorkingSetID allocate();
-
-        /**
-         * Get the i-th mutable query result. The pointer will be valid for this id until freed.
-         * Do not delete the returned pointer as the WorkingSet retains ownership. Call free() to
-         * release it.
-         */
-        WorkingSetMember* get(const WorkingSetID& i) const {
-            dassert(i < _data.size()); // ID has been allocated.
-            dassert(_data[i].nextFreeOrSelf == i); // ID currently in use.
-            return _data[i].member;
-        }
-
-        /**
-         * Deallocate the i-th query result and release its resources.
-         */
-        void free(const WorkingSetID& i);
-
-        /**
-         * The DiskLoc in WSM 'i' was invalidated while being processed.  Any predicates over the
-         * WSM could not be fully evaluated, so the WSM may or may not satisfy them.  As such, if we
-         * wish to output the WSM, we must do some clean-up work later.  Adds the WSM with id 'i' to
-         * the list of flagged WSIDs.
-         *
-         * The WSM must be in the state OWNED_OBJ.
-         */
-        void flagForReview(const WorkingSetID& i);
-
-        /**
-         * Return true if the provided ID is flagged.
-         */
-        bool isFlagged(WorkingSetID id) const;
-
-        /**
-         * Return the set of all WSIDs passed to flagForReview.
-         */
-        const unordered_set<WorkingSetID>& getFlagged() const;
-
-        /**
-         * Removes and deallocates all members of this working set.
-         */
-        void clear();
-
-    private:
-        struct MemberHolder {
-            MemberHolder();
-            ~MemberHolder();
-
-            // Free list link if freed. Points to self if in use.
-            WorkingSetID nextFreeOrSelf;
-
-            // Owning pointer
-            WorkingSetMember* member;
-        };
-
-        // All WorkingSetIDs are indexes into this, except for INVALID_ID.
-        // Elements are added to _freeList rather than removed when freed.
-        std::vector<MemberHolder> _data;
-
-        // Index into _data, forming a linked-list using MemberHolder::nextFreeOrSelf as the next
-        // link. INVALID_ID is the list terminator since 0 is a valid index.
-        // If _freeList == INVALID_ID, the free list is empty and all elements in _data are in use.
-        WorkingSetID _freeList;
-
-        // An insert-only set of WorkingSetIDs that have been flagged for review.
-        unordered_set<WorkingSetID> _flagged;
-    };
-
     /**
      * The key data extracted from an index.  Keeps track of both the key (currently a BSONObj) and
      * the index that provided the key.  The index key pattern is required to correctly interpret
@@ -224,10 +133,10 @@ namespace mongo {
         // Core attributes
         //
 
+        MemberState state;
         DiskLoc loc;
         BSONObj obj;
         std::vector<IndexKeyDatum> keyData;
-        MemberState state;
 
         bool hasLoc() const;
         bool hasObj() const;
@@ -262,4 +171,123 @@ namespace mongo {
         boost::scoped_ptr<WorkingSetComputedData> _computed[WSM_COMPUTED_NUM_TYPES];
     };
 
+    /**
+     * All data in use by a query.  Data is passed through the stage tree by referencing the ID of
+     * an element of the working set.  Stages can add elements to the working set, delete elements
+     * from the working set, or mutate elements in the working set.
+     *
+     * Concurrency Notes:
+     * flagForReview() can only be called with a write lock covering the collection this WorkingSet
+     * is for. All other methods should only be called by the thread owning this WorkingSet while
+     * holding the read lock covering the collection.
+     *
+     * Members are pooled: a freed member keeps its key data vector for the next allocation, and
+     * a destroyed WorkingSet hands its first few slabs of members on to the next one created by
+     * the same thread, so a short query normally allocates no members at all.
+     */
+    class WorkingSet {
+        MONGO_DISALLOW_COPYING(WorkingSet);
+    public:
+        static const WorkingSetID INVALID_ID = WorkingSetID(-1);
+
+        WorkingSet();
+        ~WorkingSet();
+
+        /**
+         * Allocate a new query result and return the ID used to get and free it.
+         */
+        WorkingSetID allocate();
+
+        /**
+         * Get the i-th mutable query result. The pointer will be valid for this id until freed.
+         * Do not delete the returned pointer as the WorkingSet retains ownership. Call free() to
+         * release it.
+         */
+        WorkingSetMember* get(const WorkingSetID& i) const {
+            dassert(i < _numIds); // ID has been allocated.
+            Entry& e = entry(i);
+            dassert(e.nextFreeOrSelf == i); // ID currently in use.
+            return &e.member;
+        }
+
+        /**
+         * Deallocate the i-th query result and release its resources.
+         */
+        void free(const WorkingSetID& i);
+
+        /**
+         * The DiskLoc in WSM 'i' was invalidated while being processed.  Any predicates over the
+         * WSM could not be fully evaluated, so the WSM may or may not satisfy them.  As such, if we
+         * wish to output the WSM, we must do some clean-up work later.  Adds the WSM with id 'i' to
+         * the list of flagged WSIDs.
+         *
+         * The WSM must be in the state OWNED_OBJ.
+         */
+        void flagForReview(const WorkingSetID& i);
+
+        /**
+         * Return true if the provided ID is flagged.
+         */
+        bool isFlagged(WorkingSetID id) const;
+
+        /**
+         * Return the set of all WSIDs passed to flagForReview.
+         */
+        const unordered_set<WorkingSetID>& getFlagged() const;
+
+        /**
+         * Removes and deallocates all members of this working set.
+         */
+        void clear();
+
+    private:
+        // Members are kept in fixed size slabs so that their addresses are stable, neighbouring
+        // ids are neighbours in memory, and growing the set never moves a member.  The first
+        // kInlineSlabs slab pointers live in the WorkingSet itself.
+        static const size_t kSlabShift = 5;
+        static const size_t kSlabSize = size_t(1) << kSlabShift;
+        static const size_t kInlineSlabs = 4;
+
+        struct Entry {
+            // Free list link if freed. Points to self if in use.
+            WorkingSetID nextFreeOrSelf;
+
+            WorkingSetMember member;
+        };
+
+        struct Slab {
+            Entry entries[kSlabSize];
+        };
+
+        // Slabs of destroyed WorkingSets, kept for reuse by the next WorkingSet created on the
+        // same thread.  See working_set.cpp.
+        class SlabCache;
+
+        Entry& entry(WorkingSetID i) const {
+            const size_t slab = i >> kSlabShift;
+            Slab* s = slab < kInlineSlabs ? _inlineSlabs[slab] : _moreSlabs[slab - kInlineSlabs];
+            return s->entries[i & (kSlabSize - 1)];
+        }
+
+        // Clears every member in use, leaving the slabs full of free members.
+        void clearMembers();
+
+        // All WorkingSetIDs below this have been handed out at some point, and are either in use
+        // or on the free list.
+        WorkingSetID _numIds;
+
+        size_t _numSlabs;
+        Slab* _inlineSlabs[kInlineSlabs];
+        std::vector<Slab*> _moreSlabs;
+
+        // Index of an entry, forming a linked-list using Entry::nextFreeOrSelf as the next
+        // link. INVALID_ID is the list terminator since 0 is a valid index.
+        // If _freeList == INVALID_ID, the free list is empty and all entries below _numIds are
+        // in use.
+        WorkingSetID _freeList;
+
+        // An insert-only set of WorkingSetIDs that have been flagged for review.
+        unordered_set<WorkingSetID> _flagged;
+    };
+
 }  // namespace mongo
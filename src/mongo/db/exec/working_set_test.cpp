@@ -147,4 +147,53 @@ namespace {
         ASSERT_FALSE(member->getFieldDotted("y", &elt));
     }
 
+    // Members must stay put while the set grows across many slabs.
+    TEST(WorkingSetTest, MembersAreStableAcrossSlabs) {
+        WorkingSet ws;
+        vector<WorkingSetID> ids;
+        vector<WorkingSetMember*> members;
+        for (int i = 0; i < 1000; ++i) {
+            WorkingSetID id = ws.allocate();
+            WorkingSetMember* member = ws.get(id);
+            member->state = WorkingSetMember::OWNED_OBJ;
+            member->obj = BSON("x" << i);
+            ids.push_back(id);
+            members.push_back(member);
+        }
+
+        for (int i = 0; i < 1000; ++i) {
+            ASSERT_EQUALS(members[i], ws.get(ids[i]));
+            ASSERT_EQUALS(i, ws.get(ids[i])->obj["x"].numberInt());
+        }
+
+        // Freed ids are handed out again before new ones.
+        ws.free(ids[500]);
+        ws.free(ids[3]);
+        ASSERT_EQUALS(ids[3], ws.allocate());
+        ASSERT_EQUALS(ids[500], ws.allocate());
+    }
+
+    // Recycled members, whether from this set or from one destroyed earlier, must be empty.
+    TEST(WorkingSetTest, RecycledMembersAreCleared) {
+        for (int round = 0; round < 3; ++round) {
+            WorkingSet ws;
+            for (int i = 0; i < 100; ++i) {
+                WorkingSetMember* member = ws.get(ws.allocate());
+                ASSERT_EQUALS(WorkingSetMember::INVALID, member->state);
+                ASSERT_TRUE(member->keyData.empty());
+                ASSERT_TRUE(member->obj.isEmpty());
+                ASSERT_TRUE(member->loc.isNull());
+                member->state = WorkingSetMember::LOC_AND_IDX;
+                member->loc = DiskLoc(1, i);
+                member->keyData.push_back(IndexKeyDatum(BSON("a" << 1), BSON("" << i)));
+            }
+
+            ws.clear();
+            WorkingSetID id = ws.allocate();
+            ASSERT_EQUALS(WorkingSetID(0), id);
+            ASSERT_EQUALS(WorkingSetMember::INVALID, ws.get(id)->state);
+            ASSERT_TRUE(ws.get(id)->keyData.empty());
+        }
+    }
+
 }  // namespace
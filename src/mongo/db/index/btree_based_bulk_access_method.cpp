@@ -34,12 +34,17 @@
 
 #include "mongo/db/curop.h"
 #include "mongo/db/operation_context.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/storage_options.h"
 #include "mongo/util/log.h"
 #include "mongo/util/progress_meter.h"
 
 namespace mongo {
 
+    // Threads that sort and write spilled runs while the collection scan continues. Each
+    // in-flight run takes a share of the sort memory, so more threads mean smaller runs.
+    MONGO_EXPORT_SERVER_PARAMETER(internalIndexBuildSpillThreads, int, 0);
+
     //
     // Comparison for external sorter interface
     //
@@ -82,10 +87,17 @@ namespace mongo {
         _keysInserted = 0;
         _isMultiKey = false;
 
+        const size_t maxMemoryUsageBytes = 100*1024*1024;
+        const size_t spillThreads = std::max(0, internalIndexBuildSpillThreads);
+
+        // The sort memory is free again by the time the runs are merged, so the merge gets the
+        // same budget for its read buffers.
         _sorter.reset(BSONObjExternalSorter::make(
                     SortOptions().TempDir(storageGlobalParams.dbpath + "/_tmp")
                                  .ExtSortAllowed()
-                                 .MaxMemoryUsageBytes(100*1024*1024),
+                                 .MaxMemoryUsageBytes(maxMemoryUsageBytes / (spillThreads + 1))
+                                 .SpillThreads(spillThreads)
+                                 .MergeReadAheadBytes(maxMemoryUsageBytes),
                     BtreeExternalSortComparison(descriptor->keyPattern(), descriptor->version())));
     }
 
@@ -61,6 +61,41 @@ namespace mongo {
         /// Reset this accumulator to a fresh state ready to receive input.
         virtual void reset() = 0;
 
+        /**
+         * Accumulators whose state has a fixed size can keep it in memory owned by the caller,
+         * which lets $group store the state of each group inline in its group table and drive
+         * all groups through a single Accumulator. The *InlineState() methods below may only be
+         * called if this returns non-zero.
+         *
+         * @return the size of the state in bytes, or 0 if it can't be kept inline.
+         */
+        virtual size_t inlineStateSize() const { return 0; }
+
+        /// Constructs a fresh state in inlineStateSize() bytes of suitably aligned memory.
+        virtual void constructInlineState(void* state) const { verify(false); }
+        virtual void destroyInlineState(void* state) const { verify(false); }
+
+        /**
+         * Like process(), but updates 'state' rather than this Accumulator.
+         * @return the change in the approximate memory used by 'state'.
+         */
+        virtual int processInlineState(void* state, const Value& input, bool merging) const {
+            verify(false);
+            return 0;
+        }
+
+        /// Like getValue(), but for 'state' rather than this Accumulator.
+        virtual Value getInlineStateValue(const void* state, bool toBeMerged) const {
+            verify(false);
+            return Value();
+        }
+
+        /// Approximate memory used by 'state', including inlineStateSize().
+        virtual int inlineStateMemUsage(const void* state) const {
+            verify(false);
+            return 0;
+        }
+
     protected:
         Accumulator() : _memUsageBytes(0) {}
 
@@ -72,6 +107,67 @@ namespace mongo {
     };
 
 
+    /**
+     * Base for Accumulators whose state is a fixed size State struct. Derived implements
+     *     void processState(State* state, const Value& input, bool merging) const;
+     *     Value getStateValue(const State& state, bool toBeMerged) const;
+     * and State implements a default constructor for the fresh state and
+     *     int memUsage() const;
+     */
+    template <typename Derived, typename State>
+    class FixedSizeAccumulator : public Accumulator {
+    public:
+        virtual Value getValue(bool toBeMerged) const {
+            return derived().getStateValue(_state, toBeMerged);
+        }
+
+        virtual void reset() {
+            _state = State();
+            _memUsageBytes = sizeof(Derived);
+        }
+
+        virtual size_t inlineStateSize() const { return sizeof(State); }
+
+        virtual void constructInlineState(void* state) const {
+            new (state) State();
+        }
+
+        virtual void destroyInlineState(void* state) const {
+            static_cast<State*>(state)->~State();
+        }
+
+        virtual int processInlineState(void* state, const Value& input, bool merging) const {
+            State* typedState = static_cast<State*>(state);
+            const int oldMemUsage = typedState->memUsage();
+            derived().processState(typedState, input, merging);
+            return typedState->memUsage() - oldMemUsage;
+        }
+
+        virtual Value getInlineStateValue(const void* state, bool toBeMerged) const {
+            return derived().getStateValue(*static_cast<const State*>(state), toBeMerged);
+        }
+
+        virtual int inlineStateMemUsage(const void* state) const {
+            return static_cast<const State*>(state)->memUsage();
+        }
+
+    protected:
+        FixedSizeAccumulator() {
+            _memUsageBytes = sizeof(Derived);
+        }
+
+        virtual void processInternal(const Value& input, bool merging) {
+            derived().processState(&_state, input, merging);
+            _memUsageBytes = sizeof(Derived) - sizeof(State) + _state.memUsage();
+        }
+
+    private:
+        const Derived& derived() const { return static_cast<const Derived&>(*this); }
+
+        State _state;
+    };
+
+
     class AccumulatorAddToSet : public Accumulator {
     public:
         virtual void processInternal(const Value& input, bool merging);
@@ -88,62 +184,96 @@ namespace mongo {
     };
 
 
-    class AccumulatorFirst : public Accumulator {
+    struct AccumulatorFirstState {
+        AccumulatorFirstState() : haveFirst(false) {}
+        int memUsage() const {
+            return sizeof(*this) + first.getApproximateSize() - sizeof(Value);
+        }
+
+        bool haveFirst;
+        Value first;
+    };
+
+    class AccumulatorFirst : public FixedSizeAccumulator<AccumulatorFirst,
+                                                         AccumulatorFirstState> {
     public:
-        virtual void processInternal(const Value& input, bool merging);
-        virtual Value getValue(bool toBeMerged) const;
+        typedef AccumulatorFirstState State;
+
+        void processState(State* state, const Value& input, bool merging) const;
+        Value getStateValue(const State& state, bool toBeMerged) const;
         virtual const char* getOpName() const;
-        virtual void reset();
 
         static intrusive_ptr<Accumulator> create();
 
     private:
-        AccumulatorFirst();
-
-        bool _haveFirst;
-        Value _first;
+        AccumulatorFirst() {}
     };
 
 
-    class AccumulatorLast : public Accumulator {
+    struct AccumulatorLastState {
+        int memUsage() const {
+            return sizeof(*this) + last.getApproximateSize() - sizeof(Value);
+        }
+
+        Value last;
+    };
+
+    class AccumulatorLast : public FixedSizeAccumulator<AccumulatorLast,
+                                                        AccumulatorLastState> {
     public:
-        virtual void processInternal(const Value& input, bool merging);
-        virtual Value getValue(bool toBeMerged) const;
+        typedef AccumulatorLastState State;
+
+        void processState(State* state, const Value& input, bool merging) const;
+        Value getStateValue(const State& state, bool toBeMerged) const;
         virtual const char* getOpName() const;
-        virtual void reset();
 
         static intrusive_ptr<Accumulator> create();
 
     private:
-        AccumulatorLast();
-        Value _last;
+        AccumulatorLast() {}
     };
 
 
-    class AccumulatorSum : public Accumulator {
+    struct AccumulatorSumState {
+        AccumulatorSumState() : totalType(NumberInt), longTotal(0), doubleTotal(0) {}
+        int memUsage() const { return sizeof(*this); }
+
+        BSONType totalType;
+        long long longTotal;
+        double doubleTotal;
+    };
+
+    class AccumulatorSum : public FixedSizeAccumulator<AccumulatorSum, AccumulatorSumState> {
     public:
-        virtual void processInternal(const Value& input, bool merging);
-        virtual Value getValue(bool toBeMerged) const;
+        typedef AccumulatorSumState State;
+
+        void processState(State* state, const Value& input, bool merging) const;
+        Value getStateValue(const State& state, bool toBeMerged) const;
         virtual const char* getOpName() const;
-        virtual void reset();
 
         static intrusive_ptr<Accumulator> create();
 
     private:
-        AccumulatorSum();
-
-        BSONType totalType;
-        long long longTotal;
-        double doubleTotal;
+        AccumulatorSum() {}
     };
 
 
-    class AccumulatorMinMax : public Accumulator {
+    struct AccumulatorMinMaxState {
+        int memUsage() const {
+            return sizeof(*this) + val.getApproximateSize() - sizeof(Value);
+        }
+
+        Value val;
+    };
+
+    class AccumulatorMinMax : public FixedSizeAccumulator<AccumulatorMinMax,
+                                                          AccumulatorMinMaxState> {
     public:
-        virtual void processInternal(const Value& input, bool merging);
-        virtual Value getValue(bool toBeMerged) const;
+        typedef AccumulatorMinMaxState State;
+
+        void processState(State* state, const Value& input, bool merging) const;
+        Value getStateValue(const State& state, bool toBeMerged) const;
         virtual const char* getOpName() const;
-        virtual void reset();
 
         static intrusive_ptr<Accumulator> createMin();
         static intrusive_ptr<Accumulator> createMax();
@@ -151,7 +281,6 @@ namespace mongo {
     private:
         AccumulatorMinMax(int theSense);
 
-        Value _val;
         const int _sense; /* 1 for min, -1 for max; used to "scale" comparison */
     };
 
@@ -172,19 +301,25 @@ namespace mongo {
     };
 
 
-    class AccumulatorAvg : public Accumulator {
+    struct AccumulatorAvgState {
+        AccumulatorAvgState() : total(0), count(0) {}
+        int memUsage() const { return sizeof(*this); }
+
+        double total;
+        long long count;
+    };
+
+    class AccumulatorAvg : public FixedSizeAccumulator<AccumulatorAvg, AccumulatorAvgState> {
     public:
-        virtual void processInternal(const Value& input, bool merging);
-        virtual Value getValue(bool toBeMerged) const;
+        typedef AccumulatorAvgState State;
+
+        void processState(State* state, const Value& input, bool merging) const;
+        Value getStateValue(const State& state, bool toBeMerged) const;
         virtual const char* getOpName() const;
-        virtual void reset();
 
         static intrusive_ptr<Accumulator> create();
 
     private:
-        AccumulatorAvg();
-
-        double _total;
-        long long _count;
+        AccumulatorAvg() {}
     };
 }
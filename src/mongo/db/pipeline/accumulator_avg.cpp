@@ -40,21 +40,21 @@ namespace {
     const char countName[] = "count";
 }
 
-    void AccumulatorAvg::processInternal(const Value& input, bool merging) {
+    void AccumulatorAvg::processState(State* state, const Value& input, bool merging) const {
         if (!merging) {
             // non numeric types have no impact on average
             if (!input.numeric())
                 return;
 
-            _total += input.getDouble();
-            _count += 1;
+            state->total += input.getDouble();
+            state->count += 1;
         }
         else {
             // We expect an object that contains both a subtotal and a count.
             // This is what getValue(true) produced below.
             verify(input.getType() == Object);
-            _total += input[subTotalName].getDouble();
-            _count += input[countName].getLong();
+            state->total += input[subTotalName].getDouble();
+            state->count += input[countName].getLong();
         }
     }
 
@@ -62,32 +62,19 @@ namespace {
         return new AccumulatorAvg();
     }
 
-    Value AccumulatorAvg::getValue(bool toBeMerged) const {
+    Value AccumulatorAvg::getStateValue(const State& state, bool toBeMerged) const {
         if (!toBeMerged) {
-            if (_count == 0)
+            if (state.count == 0)
                 return Value(0.0);
 
-            return Value(_total / static_cast<double>(_count));
+            return Value(state.total / static_cast<double>(state.count));
         }
         else {
-            return Value(DOC(subTotalName << _total
-                          << countName << _count));
+            return Value(DOC(subTotalName << state.total
+                          << countName << state.count));
         }
     }
 
-    AccumulatorAvg::AccumulatorAvg()
-        : _total(0)
-        , _count(0)
-    {
-        // This is a fixed size Accumulator so we never need to update this
-        _memUsageBytes = sizeof(*this);
-    }
-
-    void AccumulatorAvg::reset() {
-        _total = 0;
-        _count = 0;
-    }
-
     const char *AccumulatorAvg::getOpName() const {
         return "$avg";
     }
@@ -33,33 +33,19 @@
 
 namespace mongo {
 
-    void AccumulatorFirst::processInternal(const Value& input, bool merging) {
+    void AccumulatorFirst::processState(State* state, const Value& input, bool merging) const {
         /* only remember the first value seen */
-        if (!_haveFirst) {
+        if (!state->haveFirst) {
             // can't use pValue.missing() since we want the first value even if missing
-            _haveFirst = true;
-            _first = input;
-            _memUsageBytes = sizeof(*this) + input.getApproximateSize() - sizeof(Value);
+            state->haveFirst = true;
+            state->first = input;
         }
     }
 
-    Value AccumulatorFirst::getValue(bool toBeMerged) const {
-        return _first;
+    Value AccumulatorFirst::getStateValue(const State& state, bool toBeMerged) const {
+        return state.first;
     }
 
-    AccumulatorFirst::AccumulatorFirst()
-        : _haveFirst(false)
-    {
-        _memUsageBytes = sizeof(*this);
-    }
-
-    void AccumulatorFirst::reset() {
-        _haveFirst = false;
-        _first = Value();
-        _memUsageBytes = sizeof(*this);
-    }
-
-
     intrusive_ptr<Accumulator> AccumulatorFirst::create() {
         return new AccumulatorFirst();
     }
@@ -33,23 +33,13 @@
 
 namespace mongo {
 
-    void AccumulatorLast::processInternal(const Value& input, bool merging) {
+    void AccumulatorLast::processState(State* state, const Value& input, bool merging) const {
         /* always remember the last value seen */
-        _last = input;
-        _memUsageBytes = sizeof(*this) + _last.getApproximateSize() - sizeof(Value);
+        state->last = input;
     }
 
-    Value AccumulatorLast::getValue(bool toBeMerged) const {
-        return _last;
-    }
-
-    AccumulatorLast::AccumulatorLast() {
-        _memUsageBytes = sizeof(*this);
-    }
-
-    void AccumulatorLast::reset() {
-        _memUsageBytes = sizeof(*this);
-        _last = Value();
+    Value AccumulatorLast::getStateValue(const State& state, bool toBeMerged) const {
+        return state.last;
     }
 
     intrusive_ptr<Accumulator> AccumulatorLast::create() {
@@ -33,32 +33,25 @@
 
 namespace mongo {
 
-    void AccumulatorMinMax::processInternal(const Value& input, bool merging) {
+    void AccumulatorMinMax::processState(State* state, const Value& input, bool merging) const {
         // nullish values should have no impact on result
         if (!input.nullish()) {
             /* compare with the current value; swap if appropriate */
-            int cmp = Value::compare(_val, input) * _sense;
-            if (cmp > 0 || _val.missing()) { // missing is lower than all other values
-                _val = input;
-                _memUsageBytes = sizeof(*this) + input.getApproximateSize() - sizeof(Value);
+            int cmp = Value::compare(state->val, input) * _sense;
+            if (cmp > 0 || state->val.missing()) { // missing is lower than all other values
+                state->val = input;
             }
         }
     }
 
-    Value AccumulatorMinMax::getValue(bool toBeMerged) const {
-        return _val;
+    Value AccumulatorMinMax::getStateValue(const State& state, bool toBeMerged) const {
+        return state.val;
     }
 
     AccumulatorMinMax::AccumulatorMinMax(int theSense)
         :_sense(theSense)
     {
         verify((_sense == 1) || (_sense == -1));
-        _memUsageBytes = sizeof(*this);
-    }
-
-    void AccumulatorMinMax::reset() {
-        _val = Value();
-        _memUsageBytes = sizeof(*this);
     }
 
     intrusive_ptr<Accumulator> AccumulatorMinMax::createMin() {
@@ -33,22 +33,22 @@
 
 namespace mongo {
 
-    void AccumulatorSum::processInternal(const Value& input, bool merging) {
+    void AccumulatorSum::processState(State* state, const Value& input, bool merging) const {
         // do nothing with non numeric types
         if (!input.numeric())
             return;
 
         // upgrade to the widest type required to hold the result
-        totalType = Value::getWidestNumeric(totalType, input.getType());
+        state->totalType = Value::getWidestNumeric(state->totalType, input.getType());
 
-        if (totalType == NumberInt || totalType == NumberLong) {
+        if (state->totalType == NumberInt || state->totalType == NumberLong) {
             long long v = input.coerceToLong();
-            longTotal += v;
-            doubleTotal += v;
+            state->longTotal += v;
+            state->doubleTotal += v;
         }
-        else if (totalType == NumberDouble) {
+        else if (state->totalType == NumberDouble) {
             double v = input.coerceToDouble();
-            doubleTotal += v;
+            state->doubleTotal += v;
         }
         else {
             // non numerics should have returned above so we should never get here
@@ -60,36 +60,21 @@ namespace mongo {
         return new AccumulatorSum();
     }
 
-    Value AccumulatorSum::getValue(bool toBeMerged) const {
-        if (totalType == NumberLong) {
-            return Value(longTotal);
+    Value AccumulatorSum::getStateValue(const State& state, bool toBeMerged) const {
+        if (state.totalType == NumberLong) {
+            return Value(state.longTotal);
         }
-        else if (totalType == NumberDouble) {
-            return Value(doubleTotal);
+        else if (state.totalType == NumberDouble) {
+            return Value(state.doubleTotal);
         }
-        else if (totalType == NumberInt) {
-            return Value::createIntOrLong(longTotal);
+        else if (state.totalType == NumberInt) {
+            return Value::createIntOrLong(state.longTotal);
         }
         else {
             massert(16000, "$sum resulted in a non-numeric type", false);
         }
     }
 
-    AccumulatorSum::AccumulatorSum()
-        : totalType(NumberInt)
-        , longTotal(0)
-        , doubleTotal(0)
-    {
-        // This is a fixed size Accumulator so we never need to update this
-        _memUsageBytes = sizeof(*this);
-    }
-
-    void AccumulatorSum::reset() {
-        totalType = NumberInt;
-        longTotal = 0;
-        doubleTotal = 0;
-    }
-
     const char *AccumulatorSum::getOpName() const {
         return "$sum";
     }
@@ -58,7 +58,7 @@ namespace mongo {
             }
         }
         else { // linear scan
-            for (DocumentStorageIterator it = iteratorAll(); !it.atEnd(); it.advance()) {
+            for (DocumentStorageIterator it = decodedIteratorAll(); !it.atEnd(); it.advance()) {
                 if (it->nameLen == reqSize
                     && memcmp(requested.rawData(), it->_name, reqSize) == 0) {
                     return it.position();
@@ -66,10 +66,78 @@ namespace mongo {
             }
         }
 
+        if (MONGO_unlikely(_bsonNext)) {
+            // Logically const: this only decodes more of the fields we already have.
+            return const_cast<DocumentStorage*>(this)->decodeLazyFields(requested);
+        }
+
         // if we got here, there's no such field
         return Position();
     }
 
+    Value DocumentStorage::lazyValue(const BSONElement& elem, const BSONObj& holder) {
+        switch (elem.type()) {
+        case Object: {
+            intrusive_ptr<DocumentStorage> sub (new DocumentStorage());
+            sub->initLazy(elem.embeddedObject(), holder, false);
+            return Value(Document(sub.get()));
+        }
+
+        case Array: {
+            vector<Value> values;
+            BSONForEach(sub, elem.embeddedObject()) {
+                values.push_back(lazyValue(sub, holder));
+            }
+            return Value::consume(values);
+        }
+
+        default:
+            return Value(elem);
+        }
+    }
+
+    void DocumentStorage::initLazy(const BSONObj& bson, const BSONObj& holder, bool withMetaData) {
+        fassert(18654, !_buffer && !_bson);
+
+        _bson = bson.objdata();
+        _bsonNext = bson.isEmpty() ? NULL : _bson + sizeof(int);
+        _bsonHolder = holder;
+
+        if (withMetaData) {
+            BSONForEach(elem, bson) {
+                if (elem.fieldName()[0] == '$'
+                        && elem.fieldNameStringData() == Document::metaFieldTextScore) {
+                    setTextScore(elem.Double());
+                    _bsonHasMetaData = true;
+                }
+            }
+        }
+    }
+
+    Position DocumentStorage::decodeLazyFields(StringData name) {
+        while (_bsonNext) {
+            const BSONElement elem (_bsonNext);
+            if (elem.eoo()) {
+                _bsonNext = NULL;
+                break;
+            }
+            _bsonNext += elem.size();
+
+            const StringData fieldName = elem.fieldNameStringData();
+            if (_bsonHasMetaData && fieldName == Document::metaFieldTextScore)
+                continue;
+
+            const Position pos = getNextPosition();
+            Value value = lazyValue(elem, _bsonHolder);
+            appendField(fieldName) = value;
+
+            if (name.rawData() && fieldName == name)
+                return pos;
+        }
+
+        return Position();
+    }
+
     Value& DocumentStorage::appendField(StringData name) {
         Position pos = getNextPosition();
         const int nameSize = name.size();
@@ -182,6 +250,10 @@ namespace mongo {
     }
 
     intrusive_ptr<DocumentStorage> DocumentStorage::clone() const {
+        // The clone is about to be modified so it doesn't need to be lazy, but it must have all of
+        // our fields at the same positions.
+        loadLazyFields();
+
         intrusive_ptr<DocumentStorage> out (new DocumentStorage());
 
         // Make a copy of the buffer.
@@ -209,7 +281,7 @@ namespace mongo {
     DocumentStorage::~DocumentStorage() {
         boost::scoped_array<char> deleteBufferAtScopeEnd (_buffer);
 
-        for (DocumentStorageIterator it = iteratorAll(); !it.atEnd(); it.advance()) {
+        for (DocumentStorageIterator it = decodedIteratorAll(); !it.atEnd(); it.advance()) {
             it->val.~Value(); // explicit destructor call
         }
     }
@@ -234,6 +306,18 @@ namespace mongo {
     }
 
     void Document::toBson(BSONObjBuilder* pBuilder) const {
+        if (const char* bson = storage().bson()) {
+            // Unmodified lazy document: copy the original elements without decoding them.
+            const bool skipMetaData = storage().bsonHasMetaData();
+            const BSONObj original (bson);
+            BSONForEach(elem, original) {
+                if (skipMetaData && elem.fieldNameStringData() == metaFieldTextScore)
+                    continue;
+                pBuilder->append(elem);
+            }
+            return;
+        }
+
         for (DocumentStorageIterator it = storage().iterator(); !it.atEnd(); it.advance()) {
             *pBuilder << it->nameSD() << it->val;
         }
@@ -275,6 +359,13 @@ namespace mongo {
         return md.freeze();
     }
 
+    Document Document::fromBsonWithMetaDataLazily(const BSONObj& bson) {
+        const BSONObj owned = bson.getOwned();
+        intrusive_ptr<DocumentStorage> storage (new DocumentStorage());
+        storage->initLazy(owned, owned, true);
+        return Document(storage.get());
+    }
+
     MutableDocument::MutableDocument(size_t expectedFields)
         : _storageHolder(NULL)
         , _storage(_storageHolder)
@@ -353,7 +444,11 @@ namespace mongo {
         size_t size = sizeof(DocumentStorage);
         size += storage().allocatedBytes();
 
-        for (DocumentStorageIterator it = storage().iterator(); !it.atEnd(); it.advance()) {
+        // A lazy document also holds on to its BSON, whether or not all fields are decoded.
+        if (const char* bson = storage().bson())
+            size += BSONObj(bson).objsize();
+
+        for (DocumentStorageIterator it = storage().decodedIterator(); !it.atEnd(); it.advance()) {
             size += it->val.getApproximateSize();
             size -= sizeof(Value); // already accounted for above
         }
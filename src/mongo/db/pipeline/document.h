@@ -155,6 +155,16 @@ namespace mongo {
          */
         static Document fromBsonWithMetaData(const BSONObj& bson);
 
+        /**
+         * Like fromBsonWithMetaData, but fields, and the fields of sub-documents, are only
+         * converted to Values when first looked up, and toBson() copies the original elements
+         * while the document is unmodified. Use this when only a few fields of large documents
+         * are likely to be read. The result shares (or owns a copy of) bson's buffer.
+         *
+         * See DocumentStorage::initLazy() for a threading restriction.
+         */
+        static Document fromBsonWithMetaDataLazily(const BSONObj& bson);
+
         // Support BSONObjBuilder and BSONArrayBuilder "stream" API
         friend BSONObjBuilder& operator << (BSONObjBuilderValueStream& builder, const Document& d);
 
@@ -188,6 +198,7 @@ namespace mongo {
         const void* getPtr() const { return _storage.get(); }
 
     private:
+        friend class DocumentStorage;
         friend class FieldIterator;
         friend class ValueStorage;
         friend class MutableDocument;
@@ -424,7 +435,9 @@ namespace mongo {
                 return clonedStorage();
 
             // This function exists to ensure this is safe
-            return const_cast<DocumentStorage&>(*storagePtr());
+            DocumentStorage& storage = const_cast<DocumentStorage&>(*storagePtr());
+            storage.prepareForWriting();
+            return storage;
         }
         DocumentStorage& newStorage() {
             reset(new DocumentStorage);
@@ -168,6 +168,9 @@ namespace mongo {
                           , _hashTabMask(0)
                           , _hasTextScore(false)
                           , _textScore(0)
+                          , _bson(NULL)
+                          , _bsonNext(NULL)
+                          , _bsonHasMetaData(false)
         {}
         ~DocumentStorage();
 
@@ -187,7 +190,9 @@ namespace mongo {
         /// Returns the position of the next field to be inserted
         Position getNextPosition() const { return Position(_usedBytes); }
 
-        /// Returns the position of the named field (may be missing) or Position()
+        /** Returns the position of the named field (may be missing) or Position()
+         *  In lazy mode this decodes fields up to the requested one if it isn't decoded yet.
+         */
         Position findField(StringData name) const;
 
         // Document uses these
@@ -224,14 +229,53 @@ namespace mongo {
 
         /// This skips missing values
         DocumentStorageIterator iterator() const {
+            loadLazyFields();
             return DocumentStorageIterator(_firstElement, end(), false);
         }
 
         /// This includes missing values
         DocumentStorageIterator iteratorAll() const {
+            loadLazyFields();
             return DocumentStorageIterator(_firstElement, end(), true);
         }
 
+        /// Like iterator() but only visits the fields decoded so far in lazy mode
+        DocumentStorageIterator decodedIterator() const {
+            return DocumentStorageIterator(_firstElement, end(), false);
+        }
+
+        /** Puts a new, empty storage in lazy mode: fields are decoded from 'bson' one at a time
+         *  as they are looked up rather than all upfront. 'holder' must keep the memory 'bson'
+         *  points into alive; it may be an enclosing object. If 'withMetaData', top-level
+         *  metadata fields are parsed now, as fromBsonWithMetaData does, and never decoded.
+         *
+         *  Lazy decoding happens in const methods, so unlike other Documents a lazy one must not
+         *  be read by several threads at once until it has been fully decoded.
+         */
+        void initLazy(const BSONObj& bson, const BSONObj& holder, bool withMetaData);
+
+        /** The BSON this storage was lazily created from while it still has the same fields in
+         *  the same order, or NULL. Metadata fields must be skipped if bsonHasMetaData().
+         */
+        const char* bson() const { return _bson; }
+        bool bsonHasMetaData() const { return _bsonHasMetaData; }
+
+        /// Decodes the remaining fields in lazy mode. This only changes the representation.
+        void loadLazyFields() const {
+            if (MONGO_unlikely(_bsonNext))
+                const_cast<DocumentStorage*>(this)->decodeLazyFields(StringData());
+        }
+
+        /// Called by MutableDocument before modifying. Leaves lazy mode for good.
+        void prepareForWriting() {
+            if (MONGO_unlikely(_bson != NULL)) {
+                loadLazyFields();
+                _bson = NULL;
+                _bsonHasMetaData = false;
+                _bsonHolder = BSONObj();
+            }
+        }
+
         /// Shallow copy of this. Caller owns memory.
         intrusive_ptr<DocumentStorage> clone() const;
 
@@ -261,6 +305,21 @@ namespace mongo {
         /// Same as lastElement->next() or firstElement() if empty.
         const ValueElement* end() const { return _firstElement->plusBytes(_usedBytes); }
 
+        /// Iterates only decoded fields, including missing ones. For use by internals.
+        DocumentStorageIterator decodedIteratorAll() const {
+            return DocumentStorageIterator(_firstElement, end(), true);
+        }
+
+        /** Decodes fields from _bsonNext on until one named 'name' is decoded, returning its
+         *  Position, or until the end of the BSON if 'name' is null or not found.
+         */
+        Position decodeLazyFields(StringData name);
+
+        /** Converts a field of a lazily decoded document. Unlike Value(BSONElement), sub-documents,
+         *  including those in arrays, are lazily decoded too and share the 'holder'.
+         */
+        static Value lazyValue(const BSONElement& elem, const BSONObj& holder);
+
         /// Allocates space in _buffer. Copies existing data if there is any.
         void alloc(unsigned newSize);
 
@@ -291,7 +350,7 @@ namespace mongo {
         /// Adds all fields to the hash table
         void rehash() {
             hashTabInit();
-            for (DocumentStorageIterator it = iteratorAll(); !it.atEnd(); it.advance())
+            for (DocumentStorageIterator it = decodedIteratorAll(); !it.atEnd(); it.advance())
                 addFieldToHashTable(it.position());
         }
 
@@ -327,6 +386,14 @@ namespace mongo {
 
         bool _hasTextScore; // When adding more metadata fields, this should become a bitvector
         double _textScore;
+
+        // Lazy mode, see initLazy(). Fields from _bsonNext on haven't been decoded yet; it is
+        // NULL once all have been. _bson is NULL unless in lazy mode, even if fully decoded.
+        const char* _bson;
+        const char* _bsonNext;
+        bool _bsonHasMetaData;
+        BSONObj _bsonHolder; // keeps _bson alive. Never touched in emptyDoc()
+
         // When adding a field, make sure to update clone() method
     };
 }
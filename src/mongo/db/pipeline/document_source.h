@@ -41,6 +41,7 @@
 #include "mongo/db/pipeline/dependencies.h"
 #include "mongo/db/pipeline/expression_context.h"
 #include "mongo/db/pipeline/expression.h"
+#include "mongo/db/pipeline/group_table.h"
 #include "mongo/db/pipeline/value.h"
 #include "mongo/db/sorter/sorter.h"
 #include "mongo/s/shard.h"
@@ -55,6 +56,7 @@ namespace mongo {
     class ExpressionFieldPath;
     class ExpressionObject;
     class DocumentSourceLimit;
+    class Pipeline;
     class PlanExecutor;
 
     class DocumentSource : public IntrusiveCounterUnsigned {
@@ -155,6 +157,12 @@ namespace mongo {
         /// Returns true if doesn't require an input source (most DocumentSources do).
         virtual bool isValidInitialSource() const { return false; }
 
+        /**
+         * Returns the order in which this source is known to return documents, as a sort
+         * pattern such as {a: 1, b: -1}, or an empty object if the order is not known.
+         */
+        virtual BSONObj getOutputSortOrder() const { return BSONObj(); }
+
     protected:
         /**
            Base constructor.
@@ -203,6 +211,23 @@ namespace mongo {
         virtual ~SplittableDocumentSource() {}
     };
 
+    /** This class marks initial DocumentSources whose output is the union of several streams that
+     *  are each sorted by the shard half of a split $sort, like the results of each shard. A
+     *  $sort with $mergePresorted after such a source merges the streams rather than sorting.
+     */
+    class SortedStreamsDocumentSource {
+    public:
+        virtual size_t numSortedStreams() const = 0;
+
+        /** Returns the next Document of one stream or boost::none at its end.
+         *  getNext() must not be called on a source that is read through this.
+         */
+        virtual boost::optional<Document> getNextFromStream(size_t stream) = 0;
+    protected:
+        // It is invalid to delete through a SortedStreamsDocumentSource-typed pointer.
+        virtual ~SortedStreamsDocumentSource() {}
+    };
+
 
     /** This class marks DocumentSources which need mongod-specific functionality.
      *  It causes a MongodInterface to be injected when in a mongod and prevents mongos from
@@ -383,12 +408,15 @@ namespace mongo {
           This should be captured after any optimizations are applied to
           the pipeline so that it reflects what is really used.
 
-          This gets used for explain output.
+          This gets used for explain output, and tells a following $group
+          that its input is sorted.
 
           @param pBsonObj the sort to record
          */
         void setSort(const BSONObj& sort) { _sort = sort; }
 
+        virtual BSONObj getOutputSortOrder() const { return _sort; }
+
         /**
          * Informs this object of projection and dependency information.
          *
@@ -424,6 +452,66 @@ namespace mongo {
     };
 
 
+    /**
+     * Runs the shard half of a pipeline split by Pipeline::splitForSharded() over several
+     * partitions of a collection scan at once, each on its own thread, and returns the union of
+     * their output to the merge half, like a mongos merging the results of shards.
+     *
+     * Each partition is a pipeline starting with its own DocumentSourceCursor and using its own
+     * ExpressionContext and OperationContext. The threads are started by the first call to
+     * getNext() or getNextFromStream() and each buffers a bounded number of results, so they
+     * only run ahead of the merger by that much.
+     */
+    class DocumentSourcePartitionedCursor : public DocumentSource
+                                          , public SortedStreamsDocumentSource {
+    public:
+        // virtuals from DocumentSource
+        virtual ~DocumentSourcePartitionedCursor();
+        virtual boost::optional<Document> getNext();
+        virtual const char *getSourceName() const;
+        virtual Value serialize(bool explain = false) const;
+        virtual void setSource(DocumentSource *pSource);
+        virtual bool isValidInitialSource() const { return true; }
+        virtual void dispose();
+
+        // virtuals from SortedStreamsDocumentSource
+        virtual size_t numSortedStreams() const;
+        virtual boost::optional<Document> getNextFromStream(size_t stream);
+
+        /**
+         * @param partitions stitched pipelines, one per partition, each starting with a
+         *        DocumentSourceCursor. They must not share any state, including their
+         *        ExpressionContext, with each other or the merging pipeline, since they are handed
+         *        over to other threads.
+         * @param shardPipeline the serialized partition pipeline, for explain.
+         */
+        static intrusive_ptr<DocumentSourcePartitionedCursor> create(
+            const std::vector<intrusive_ptr<Pipeline> >& partitions,
+            const Value& shardPipeline,
+            const intrusive_ptr<ExpressionContext>& pExpCtx);
+
+        static const char partitionedCursorName[];
+
+    private:
+        class Partition;
+        struct Exchange;
+
+        DocumentSourcePartitionedCursor(
+            const std::vector<intrusive_ptr<Pipeline> >& partitions,
+            const Value& shardPipeline,
+            const intrusive_ptr<ExpressionContext>& pExpCtx);
+
+        /// Starts the partitions' threads if that hasn't been done yet.
+        void start();
+
+        const Value _shardPipeline;
+        boost::shared_ptr<Exchange> _exchange;
+        std::vector<boost::shared_ptr<Partition> > _partitions;
+        bool _started;
+        size_t _nextPartition; // where getNext() looks for results first
+    };
+
+
     class DocumentSourceGroup : public DocumentSource
                               , public SplittableDocumentSource {
     public:
@@ -434,6 +522,7 @@ namespace mongo {
         virtual GetDepsReturn getDependencies(DepsTracker* deps) const;
         virtual void dispose();
         virtual Value serialize(bool explain = false) const;
+        virtual void setSource(DocumentSource* pSource);
 
         /**
           Create a new grouping DocumentSource.
@@ -463,6 +552,13 @@ namespace mongo {
         /// Tell this source if it is doing a merge from shards. Defaults to false.
         void setDoingMerge(bool doingMerge) { _doingMerge = doingMerge; }
 
+        /**
+         * True if the input is sorted such that documents with the same _id are adjacent, in
+         * which case groups are returned as soon as they are complete rather than after all of
+         * the input has been read. Set by setSource().
+         */
+        bool isStreaming() const { return _streaming; }
+
         /**
           Create a grouping DocumentSource from BSON.
 
@@ -502,6 +598,26 @@ namespace mongo {
         void populate();
         bool populated;
 
+        /// Adds the current ROOT document to the group for 'id', spilling if needed.
+        void accumulateIntoTable(const Value& id);
+
+        /// Prepares to return the groups in the table, or merge them if any were spilled.
+        void finishPopulate();
+
+        /**
+         * Whether groups can be returned as soon as the _id changes when the input is in
+         * 'sortOrder', given in the form of getOutputSortOrder().
+         */
+        bool canStreamInputSortedBy(const BSONObj& sortOrder) const;
+
+        /**
+         * Whether the documents with group key 'id' are all adjacent in sorted input. Nullish
+         * and array keys may not be, see getNextStreaming().
+         */
+        bool isStreamableId(const Value& id) const;
+
+        boost::optional<Document> getNextStreaming();
+
         /**
          * Parses the raw id expression into _idExpressions and possibly _idFieldNames.
          */
@@ -520,8 +636,7 @@ namespace mongo {
 
 
         typedef std::vector<intrusive_ptr<Accumulator> > Accumulators;
-        typedef boost::unordered_map<Value, Accumulators, Value::Hash> GroupsMap;
-        GroupsMap groups;
+        scoped_ptr<GroupTable> _groups; // created on first use, once all accumulators are added
 
         /*
           The field names for the result documents and the accumulator
@@ -541,8 +656,10 @@ namespace mongo {
 
 
         Document makeDocument(const Value& id, const Accumulators& accums, bool mergeableOutput);
+        Document makeDocument(const GroupTable::Group* group, bool mergeableOutput);
 
         bool _doingMerge;
+        bool _streaming;
         bool _spilled;
         const bool _extSortAllowed;
         const int _maxMemoryUsageBytes;
@@ -550,14 +667,23 @@ namespace mongo {
         std::vector<std::string> _idFieldNames; // used when id is a document
         std::vector<intrusive_ptr<Expression> > _idExpressions;
 
+        // only used while populating
+        std::vector<shared_ptr<Sorter<Value, Value>::Iterator> > _sortedFiles; // from spill()
+        int _memoryUsageBytes;
+
         // only used when !_spilled
-        GroupsMap::iterator groupsIterator;
+        size_t _groupsPosition; // of the next group to return from _groups
 
         // only used when _spilled
         scoped_ptr<Sorter<Value, Value>::Iterator> _sorterIterator;
         std::pair<Value, Value> _firstPartOfNextGroup;
+
+        // used when _spilled, and when _streaming for the group being accumulated
         Value _currentId;
         Accumulators _currentAccumulators;
+
+        // only used when _streaming
+        bool _haveCurrentGroup;
     };
 
 
@@ -817,6 +943,8 @@ namespace mongo {
         /// Write out a Document whose contents are the sort key.
         Document serializeSortKey(bool explain) const;
 
+        virtual BSONObj getOutputSortOrder() const;
+
         /**
           Create a sorting DocumentSource from BSON.
 
@@ -871,6 +999,10 @@ namespace mongo {
         void populateFromCursors(const std::vector<DBClientCursor*>& cursors);
         void populateFromBsonArrays(const std::vector<BSONArray>& arrays);
 
+        // Used to merge pre-sorted results from a SortedStreamsDocumentSource.
+        class IteratorFromStream;
+        void populateFromStreams(SortedStreamsDocumentSource* source);
+
         /* these two parallel each other */
         typedef std::vector<intrusive_ptr<Expression> > SortKey;
         SortKey vSortKey;
@@ -83,6 +83,10 @@ namespace mongo {
         Lock::DBRead lk(pExpCtx->opCtx->lockState(), _ns);
         Client::Context ctx(pExpCtx->opCtx, _ns, /*doVersion=*/false);
 
+        // A killed DocumentSourcePartitionedCursor partition may no longer receive invalidations,
+        // so it must stop before touching the executor again.
+        pExpCtx->opCtx->checkForInterrupt();
+
         _exec->restoreState(pExpCtx->opCtx);
 
         int memUsageBytes = 0;
@@ -93,7 +97,9 @@ namespace mongo {
                 _currentBatch.push_back(_dependencies->extractFields(obj));
             }
             else {
-                _currentBatch.push_back(Document::fromBsonWithMetaData(obj));
+                // The whole document may be needed, but usually only a few fields are looked at
+                // before it is passed on or written back out as BSON.
+                _currentBatch.push_back(Document::fromBsonWithMetaDataLazily(obj));
             }
 
             if (_limit) {
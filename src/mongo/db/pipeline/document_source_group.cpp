@@ -47,8 +47,16 @@ namespace mongo {
     boost::optional<Document> DocumentSourceGroup::getNext() {
         pExpCtx->checkForInterrupt();
 
-        if (!populated)
-            populate();
+        if (!populated) {
+            if (!_streaming) {
+                populate();
+            }
+            else if (boost::optional<Document> out = getNextStreaming()) {
+                return out;
+            }
+            // otherwise the input is exhausted and any groups left are in _groups
+            invariant(populated);
+        }
 
         if (_spilled) {
             if (!_sorterIterator)
@@ -95,32 +103,145 @@ namespace mongo {
             return makeDocument(_currentId, _currentAccumulators, pExpCtx->inShard);
 
         } else {
-            if (groups.empty())
+            if (!_groups || _groupsPosition >= _groups->size())
                 return boost::none;
 
-            Document out = makeDocument(groupsIterator->first,
-                                        groupsIterator->second,
-                                        pExpCtx->inShard);
+            Document out = makeDocument(_groups->groups()[_groupsPosition], pExpCtx->inShard);
 
-            if (++groupsIterator == groups.end())
+            if (++_groupsPosition == _groups->size())
                 dispose();
 
             return out;
         }
     }
 
+    boost::optional<Document> DocumentSourceGroup::getNextStreaming() {
+        const size_t numAccumulators = vpAccumulatorFactory.size();
+
+        while (boost::optional<Document> input = pSource->getNext()) {
+            _variables->setRoot(*input);
+
+            Value id = computeId(_variables.get());
+
+            if (!isStreamableId(id)) {
+                // Sorted input doesn't keep all documents with such an _id together. An index
+                // orders a document with an array by one of its elements, and missing values
+                // sort along with undefined rather than with null, which we group them with.
+                // These groups are gathered in _groups and returned after the streamed ones.
+                if (id.missing())
+                    id = Value(BSONNULL);
+                accumulateIntoTable(id);
+                _variables->clearRoot();
+                continue;
+            }
+
+            boost::optional<Document> out;
+            if (!_haveCurrentGroup) {
+                if (_currentAccumulators.empty()) {
+                    _currentAccumulators.reserve(numAccumulators);
+                    for (size_t i = 0; i < numAccumulators; i++) {
+                        _currentAccumulators.push_back(vpAccumulatorFactory[i]());
+                    }
+                }
+                _currentId = id;
+                _haveCurrentGroup = true;
+            }
+            else if (Value::compare(id, _currentId) != 0) {
+                // the input has moved on to the next group so the current one is complete
+                out = makeDocument(_currentId, _currentAccumulators, pExpCtx->inShard);
+                for (size_t i = 0; i < numAccumulators; i++) {
+                    _currentAccumulators[i]->reset();
+                }
+                _currentId = id;
+            }
+
+            for (size_t i = 0; i < numAccumulators; i++) {
+                _currentAccumulators[i]->process(vpExpression[i]->evaluate(_variables.get()),
+                                                 _doingMerge);
+            }
+
+            _variables->clearRoot();
+
+            if (out)
+                return out;
+        }
+
+        boost::optional<Document> last;
+        if (_haveCurrentGroup) {
+            last = makeDocument(_currentId, _currentAccumulators, pExpCtx->inShard);
+            _haveCurrentGroup = false;
+        }
+
+        finishPopulate();
+        return last;
+    }
+
     void DocumentSourceGroup::dispose() {
         // free our resources
-        GroupsMap().swap(groups);
+        _groups.reset();
+        _sortedFiles.clear();
         _sorterIterator.reset();
 
         // make us look done
-        groupsIterator = groups.end();
+        _groupsPosition = 0;
 
         // free our source's resources
         pSource->dispose();
     }
 
+    void DocumentSourceGroup::setSource(DocumentSource* pSource) {
+        DocumentSource::setSource(pSource);
+        _streaming = canStreamInputSortedBy(pSource->getOutputSortOrder());
+    }
+
+    bool DocumentSourceGroup::canStreamInputSortedBy(const BSONObj& sortOrder) const {
+        if (sortOrder.isEmpty())
+            return false;
+
+        // Every part of the _id must be a path in the input document.
+        set<string> idPaths;
+        for (size_t i = 0; i < _idExpressions.size(); i++) {
+            const ExpressionFieldPath* expr =
+                dynamic_cast<ExpressionFieldPath*>(_idExpressions[i].get());
+            if (!expr)
+                return false;
+
+            const FieldPath& path = expr->getFieldPath();
+            if (path.getPathLength() < 2)
+                return false; // grouping on a whole document or variable
+
+            const string& variable = path.getFieldName(0);
+            if (variable != "CURRENT" && variable != "ROOT")
+                return false;
+
+            idPaths.insert(path.tail().getPath(false));
+        }
+
+        // Equal _ids are adjacent if those paths lead the sort order, in any order or direction.
+        set<string> sortPaths;
+        BSONObjIterator it(sortOrder);
+        while (it.more() && sortPaths.size() < idPaths.size()) {
+            const BSONElement elem = it.next();
+            if (!elem.isNumber())
+                return false; // e.g. {$meta: "textScore"}
+            sortPaths.insert(elem.fieldName());
+        }
+
+        return sortPaths == idPaths;
+    }
+
+    bool DocumentSourceGroup::isStreamableId(const Value& id) const {
+        if (_idExpressions.size() == 1)
+            return !id.nullish() && id.getType() != Array;
+
+        const vector<Value>& parts = id.getArray();
+        for (size_t i = 0; i < parts.size(); i++) {
+            if (parts[i].nullish() || parts[i].getType() == Array)
+                return false;
+        }
+        return true;
+    }
+
     void DocumentSourceGroup::optimize() {
         // TODO if all _idExpressions are ExpressionConstants after optimization, then we know there
         // will only be one group. We should take advantage of that to avoid going through the hash
@@ -196,9 +317,13 @@ namespace mongo {
         : DocumentSource(pExpCtx)
         , populated(false)
         , _doingMerge(false)
+        , _streaming(false)
         , _spilled(false)
         , _extSortAllowed(pExpCtx->extSortAllowed && !pExpCtx->inRouter)
         , _maxMemoryUsageBytes(100*1024*1024)
+        , _memoryUsageBytes(0)
+        , _groupsPosition(0)
+        , _haveCurrentGroup(false)
     {}
 
     void DocumentSourceGroup::addAccumulator(
@@ -348,23 +473,10 @@ namespace mongo {
     }
 
     void DocumentSourceGroup::populate() {
-        const size_t numAccumulators = vpAccumulatorFactory.size();
-        dassert(numAccumulators == vpExpression.size());
-
-        // pushed to on spill()
-        vector<shared_ptr<Sorter<Value, Value>::Iterator> > sortedFiles;
-        int memoryUsageBytes = 0;
+        dassert(vpAccumulatorFactory.size() == vpExpression.size());
 
         // This loop consumes all input from pSource and buckets it based on pIdExpression.
         while (boost::optional<Document> input = pSource->getNext()) {
-            if (memoryUsageBytes > _maxMemoryUsageBytes) {
-                uassert(16945, "Exceeded memory limit for $group, but didn't allow external sort."
-                               " Pass allowDiskUse:true to opt in.",
-                        _extSortAllowed);
-                sortedFiles.push_back(spill());
-                memoryUsageBytes = 0;
-            }
-
             _variables->setRoot(*input);
 
             /* get the _id value */
@@ -374,76 +486,88 @@ namespace mongo {
             if (id.missing())
                 id = Value(BSONNULL);
 
-            /*
-              Look for the _id value in the map; if it's not there, add a
-              new entry with a blank accumulator.
-            */
-            const size_t oldSize = groups.size();
-            vector<intrusive_ptr<Accumulator> >& group = groups[id];
-            const bool inserted = groups.size() != oldSize;
+            accumulateIntoTable(id);
 
-            if (inserted) {
-                memoryUsageBytes += id.getApproximateSize();
+            // We are done with the ROOT document so release it.
+            _variables->clearRoot();
+        }
 
-                // Add the accumulators
-                group.reserve(numAccumulators);
-                for (size_t i = 0; i < numAccumulators; i++) {
-                    group.push_back(vpAccumulatorFactory[i]());
-                }
-            } else {
-                for (size_t i = 0; i < numAccumulators; i++) {
-                    // subtract old mem usage. New usage added back after processing.
-                    memoryUsageBytes -= group[i]->memUsageForSorter();
-                }
-            }
+        finishPopulate();
+    }
 
-            /* tickle all the accumulators for the group we found */
-            dassert(numAccumulators == group.size());
-            for (size_t i = 0; i < numAccumulators; i++) {
-                group[i]->process(vpExpression[i]->evaluate(_variables.get()), _doingMerge);
-                memoryUsageBytes += group[i]->memUsageForSorter();
-            }
+    void DocumentSourceGroup::accumulateIntoTable(const Value& id) {
+        const size_t numAccumulators = vpAccumulatorFactory.size();
 
-            // We are done with the ROOT document so release it.
-            _variables->clearRoot();
+        if (_memoryUsageBytes > _maxMemoryUsageBytes) {
+            uassert(16945, "Exceeded memory limit for $group, but didn't allow external sort."
+                           " Pass allowDiskUse:true to opt in.",
+                    _extSortAllowed);
+            _sortedFiles.push_back(spill());
+            _memoryUsageBytes = 0;
+        }
 
-            DEV {
-                // In debug mode, spill every time we have a duplicate id to stress merge logic.
-                if (!inserted // is a dup
-                        && !pExpCtx->inRouter // can't spill to disk in router
-                        && !_extSortAllowed // don't change behavior when testing external sort
-                        && sortedFiles.size() < 20 // don't open too many FDs
-                        ) {
-                    sortedFiles.push_back(spill());
-                }
+        if (!_groups)
+            _groups.reset(new GroupTable(vpAccumulatorFactory));
+
+        /*
+          Look for the _id value in the table; if it's not there, add a
+          new entry with blank accumulators.
+        */
+        bool inserted;
+        GroupTable::Group* group = _groups->findOrInsert(id, &inserted);
+        if (inserted)
+            _memoryUsageBytes += _groups->memUsage(group);
+
+        /* tickle all the accumulators for the group we found */
+        for (size_t i = 0; i < numAccumulators; i++) {
+            _memoryUsageBytes += _groups->process(group, i,
+                                                  vpExpression[i]->evaluate(_variables.get()),
+                                                  _doingMerge);
+        }
+
+        DEV {
+            // In debug mode, spill every time we have a duplicate id to stress merge logic.
+            if (!inserted // is a dup
+                    && !pExpCtx->inRouter // can't spill to disk in router
+                    && !_extSortAllowed // don't change behavior when testing external sort
+                    && _sortedFiles.size() < 20 // don't open too many FDs
+                    ) {
+                _sortedFiles.push_back(spill());
             }
         }
+    }
+
+    void DocumentSourceGroup::finishPopulate() {
+        const size_t numAccumulators = vpAccumulatorFactory.size();
 
         // These blocks do any final steps necessary to prepare to output results.
-        if (!sortedFiles.empty()) {
+        if (!_sortedFiles.empty()) {
             _spilled = true;
-            if (!groups.empty()) {
-                sortedFiles.push_back(spill());
+            if (!_groups->empty()) {
+                _sortedFiles.push_back(spill());
             }
 
             // We won't be using groups again so free its memory.
-            GroupsMap().swap(groups);
+            _groups.reset();
 
             _sorterIterator.reset(
                     Sorter<Value,Value>::Iterator::merge(
-                        sortedFiles, SortOptions(), SorterComparator()));
+                        _sortedFiles, SortOptions(), SorterComparator()));
+            _sortedFiles.clear();
 
             // prepare current to accumulate data
-            _currentAccumulators.reserve(numAccumulators);
-            for (size_t i = 0; i < numAccumulators; i++) {
-                _currentAccumulators.push_back(vpAccumulatorFactory[i]());
+            if (_currentAccumulators.empty()) {
+                _currentAccumulators.reserve(numAccumulators);
+                for (size_t i = 0; i < numAccumulators; i++) {
+                    _currentAccumulators.push_back(vpAccumulatorFactory[i]());
+                }
             }
 
             verify(_sorterIterator->more()); // we put data in, we should get something out.
             _firstPartOfNextGroup = _sorterIterator->next();
         } else {
             // start the group iterator
-            groupsIterator = groups.begin();
+            _groupsPosition = 0;
         }
 
         populated = true;
@@ -451,47 +575,47 @@ namespace mongo {
 
     class DocumentSourceGroup::SpillSTLComparator {
     public:
-        bool operator() (const GroupsMap::value_type* lhs, const GroupsMap::value_type* rhs) const {
-            return Value::compare(lhs->first, rhs->first) < 0;
+        explicit SpillSTLComparator(const GroupTable& groups) : _groups(groups) {}
+        bool operator() (const GroupTable::Group* lhs, const GroupTable::Group* rhs) const {
+            return Value::compare(_groups.getKey(lhs), _groups.getKey(rhs)) < 0;
         }
+    private:
+        const GroupTable& _groups;
     };
 
     shared_ptr<Sorter<Value, Value>::Iterator> DocumentSourceGroup::spill() {
-        vector<const GroupsMap::value_type*> ptrs; // using pointers to speed sorting
-        ptrs.reserve(groups.size());
-        for (GroupsMap::const_iterator it=groups.begin(), end=groups.end(); it != end; ++it) {
-            ptrs.push_back(&*it);
-        }
+        // using pointers to speed sorting
+        vector<const GroupTable::Group*> ptrs(_groups->groups().begin(), _groups->groups().end());
 
-        stable_sort(ptrs.begin(), ptrs.end(), SpillSTLComparator());
+        stable_sort(ptrs.begin(), ptrs.end(), SpillSTLComparator(*_groups));
 
         SortedFileWriter<Value, Value> writer(SortOptions().TempDir(pExpCtx->tempDir));
-        switch (vpAccumulatorFactory.size()) { // same as ptrs[i]->second.size() for all i.
+        switch (vpAccumulatorFactory.size()) {
         case 0: // no values, essentially a distinct
             for (size_t i=0; i < ptrs.size(); i++) {
-                writer.addAlreadySorted(ptrs[i]->first, Value());
+                writer.addAlreadySorted(_groups->getKey(ptrs[i]), Value());
             }
             break;
 
         case 1: // just one value, use optimized serialization as single Value
             for (size_t i=0; i < ptrs.size(); i++) {
-                writer.addAlreadySorted(ptrs[i]->first,
-                                        ptrs[i]->second[0]->getValue(/*toBeMerged=*/true));
+                writer.addAlreadySorted(_groups->getKey(ptrs[i]),
+                                        _groups->getValue(ptrs[i], 0, /*toBeMerged=*/true));
             }
             break;
 
         default: // multiple values, serialize as array-typed Value
             for (size_t i=0; i < ptrs.size(); i++) {
                 vector<Value> accums;
-                for (size_t j=0; j < ptrs[i]->second.size(); j++) {
-                    accums.push_back(ptrs[i]->second[j]->getValue(/*toBeMerged=*/true));
+                for (size_t j=0; j < vpAccumulatorFactory.size(); j++) {
+                    accums.push_back(_groups->getValue(ptrs[i], j, /*toBeMerged=*/true));
                 }
-                writer.addAlreadySorted(ptrs[i]->first, Value::consume(accums));
+                writer.addAlreadySorted(_groups->getKey(ptrs[i]), Value::consume(accums));
             }
             break;
         }
 
-        groups.clear();
+        _groups->clear();
 
         return shared_ptr<Sorter<Value, Value>::Iterator>(writer.done());
     }
@@ -587,6 +711,27 @@ namespace mongo {
         return out.freeze();
     }
 
+    Document DocumentSourceGroup::makeDocument(const GroupTable::Group* group,
+                                               bool mergeableOutput) {
+        const size_t n = vFieldName.size();
+        MutableDocument out (1 + n);
+
+        out.addField("_id", expandId(_groups->getKey(group)));
+
+        for(size_t i = 0; i < n; ++i) {
+            Value val = _groups->getValue(group, i, mergeableOutput);
+            if (val.missing()) {
+                // we return null in this case so return objects are predictable
+                out.addField(vFieldName[i], Value(BSONNULL));
+            }
+            else {
+                out.addField(vFieldName[i], val);
+            }
+        }
+
+        return out.freeze();
+    }
+
     intrusive_ptr<DocumentSource> DocumentSourceGroup::getShardSource() {
         return this; // No modifications necessary when on shard
     }
@@ -0,0 +1,371 @@
+/**
+ * Copyright (c) 2014 MongoDB Inc.
+ *
+ * This program is free software: you can redistribute it and/or  modify
+ * it under the terms of the GNU Affero General Public License, version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, the copyright holders give permission to link the
+ * code of portions of this program with the OpenSSL library under certain
+ * conditions as described in each individual source file and distribute
+ * linked combinations including the program with the OpenSSL library. You
+ * must comply with the GNU Affero General Public License in all respects for
+ * all of the code used other than as permitted herein. If you modify file(s)
+ * with this exception, you may extend this exception to your version of the
+ * file(s), but you are not obligated to do so. If you do not wish to do so,
+ * delete this exception statement from your version. If you delete this
+ * exception statement from all source files in the program, then also delete
+ * it in the license file.
+ */
+
+#include "mongo/pch.h"
+
+#include "mongo/db/pipeline/document_source.h"
+
+#include <boost/bind.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+
+#include "mongo/db/client.h"
+#include "mongo/db/curop.h"
+#include "mongo/db/operation_context_impl.h"
+#include "mongo/db/pipeline/pipeline.h"
+
+namespace mongo {
+
+    const char DocumentSourcePartitionedCursor::partitionedCursorName[] = "$partitionedCursor";
+
+namespace {
+    // A partition hands its results to the merger this many at a time.
+    const size_t kBatchSize = 100;
+
+    // A partition waits while this many of its results haven't been taken by the merger.
+    const size_t kMaxBufferedResults = 1000;
+
+    // How often a merger waiting for results checks whether it was interrupted.
+    const boost::posix_time::milliseconds kInterruptCheckPeriod(100);
+}
+
+    /// State shared by the merger and the threads of all partitions.
+    struct DocumentSourcePartitionedCursor::Exchange {
+        Exchange() : cancelled(false) {}
+
+        boost::mutex mutex;
+        boost::condition_variable produced; // a partition has new results or is done
+        bool cancelled; // the merger doesn't want any more results
+    };
+
+    /**
+     * One partition and the thread running it. The thread owns a reference to its Partition, so
+     * that it can finish on its own once the merger has given up on it.
+     */
+    class DocumentSourcePartitionedCursor::Partition : boost::noncopyable {
+    public:
+        Partition(const intrusive_ptr<Pipeline>& pipeline,
+                  const boost::shared_ptr<Exchange>& exchange)
+            : _pipeline(pipeline)
+            , _exchange(exchange)
+            , _done(false)
+            , _status(Status::OK())
+            , _curOp(NULL)
+        {}
+
+        /// Body of the partition's thread.
+        static void run(boost::shared_ptr<Partition> partition);
+
+        //
+        // These are only called by the merger, with _exchange->mutex held.
+        //
+
+        bool hasResults() const { return !_results.empty(); }
+
+        /// True once the thread has stopped producing results.
+        bool hasFinished() const { return _done; }
+
+        /// True once all results have been taken. Throws if the partition failed.
+        bool isDone() const {
+            uassertStatusOK(_status);
+            return _done && _results.empty();
+        }
+
+        /// Moves the results buffered so far to 'taken', letting the thread produce more.
+        void takeResults() {
+            dassert(taken.empty());
+            taken.swap(_results);
+            _consumed.notify_one();
+        }
+
+        /// Stops the thread at its next interrupt check.
+        void kill() {
+            if (_curOp)
+                _curOp->kill();
+            _consumed.notify_one();
+        }
+
+        // Only used by the merger, without the mutex.
+        std::deque<Document> taken;
+        boost::scoped_ptr<boost::thread> thread;
+
+    private:
+        void runPipeline();
+
+        /// Hands 'batch' to the merger. Returns false if the merger doesn't want more results.
+        bool publish(std::vector<Document>* batch);
+
+        intrusive_ptr<Pipeline> _pipeline; // only used by the partition's thread
+        const boost::shared_ptr<Exchange> _exchange;
+
+        // Protected by _exchange->mutex.
+        std::deque<Document> _results;
+        boost::condition_variable _consumed; // the merger took _results or was cancelled
+        bool _done;
+        Status _status;
+        CurOp* _curOp; // of the partition's thread while it runs
+    };
+
+    void DocumentSourcePartitionedCursor::Partition::run(boost::shared_ptr<Partition> partition) {
+        Client::initThread("aggPartition");
+        {
+            OperationContextImpl txn;
+            {
+                boost::lock_guard<boost::mutex> lk(partition->_exchange->mutex);
+                partition->_curOp = txn.getCurOp();
+                if (partition->_exchange->cancelled)
+                    partition->_curOp->kill();
+            }
+
+            Status status = Status::OK();
+            try {
+                partition->_pipeline->getContext()->opCtx = &txn;
+                partition->runPipeline();
+            }
+            catch (const DBException& e) {
+                status = e.toStatus();
+            }
+            catch (const std::exception& e) {
+                status = Status(ErrorCodes::InternalError, e.what());
+            }
+
+            // Release the executor and any sorter files while we still have an OperationContext.
+            partition->_pipeline.reset();
+
+            boost::lock_guard<boost::mutex> lk(partition->_exchange->mutex);
+            partition->_curOp = NULL;
+            partition->_status = status;
+            partition->_done = true;
+            partition->_exchange->produced.notify_one();
+        }
+        cc().shutdown();
+    }
+
+    void DocumentSourcePartitionedCursor::Partition::runPipeline() {
+        DocumentSource* output = _pipeline->output();
+
+        std::vector<Document> batch;
+        batch.reserve(kBatchSize);
+        while (boost::optional<Document> next = output->getNext()) {
+            batch.push_back(*next);
+            if (batch.size() == kBatchSize && !publish(&batch))
+                return;
+        }
+
+        publish(&batch);
+    }
+
+    bool DocumentSourcePartitionedCursor::Partition::publish(std::vector<Document>* batch) {
+        {
+            boost::unique_lock<boost::mutex> lk(_exchange->mutex);
+            while (_results.size() >= kMaxBufferedResults && !_exchange->cancelled) {
+                _consumed.wait(lk);
+            }
+
+            if (_exchange->cancelled)
+                return false;
+
+            _results.insert(_results.end(), batch->begin(), batch->end());
+            _exchange->produced.notify_one();
+        }
+
+        batch->clear();
+        return true;
+    }
+
+    DocumentSourcePartitionedCursor::DocumentSourcePartitionedCursor(
+            const std::vector<intrusive_ptr<Pipeline> >& partitions,
+            const Value& shardPipeline,
+            const intrusive_ptr<ExpressionContext>& pExpCtx)
+        : DocumentSource(pExpCtx)
+        , _shardPipeline(shardPipeline)
+        , _exchange(boost::make_shared<Exchange>())
+        , _started(false)
+        , _nextPartition(0) {
+        for (size_t i = 0; i < partitions.size(); i++) {
+            _partitions.push_back(boost::make_shared<Partition>(partitions[i], _exchange));
+        }
+    }
+
+    intrusive_ptr<DocumentSourcePartitionedCursor> DocumentSourcePartitionedCursor::create(
+            const std::vector<intrusive_ptr<Pipeline> >& partitions,
+            const Value& shardPipeline,
+            const intrusive_ptr<ExpressionContext>& pExpCtx) {
+        return new DocumentSourcePartitionedCursor(partitions, shardPipeline, pExpCtx);
+    }
+
+    DocumentSourcePartitionedCursor::~DocumentSourcePartitionedCursor() {
+        dispose();
+    }
+
+    const char *DocumentSourcePartitionedCursor::getSourceName() const {
+        return partitionedCursorName;
+    }
+
+    void DocumentSourcePartitionedCursor::setSource(DocumentSource *pSource) {
+        /* this doesn't take a source */
+        verify(false);
+    }
+
+    Value DocumentSourcePartitionedCursor::serialize(bool explain) const {
+        // we never parse a DocumentSourcePartitionedCursor, so we only serialize for explain
+        if (!explain)
+            return Value();
+
+        return Value(DOC(getSourceName() << DOC("partitions" << int(_partitions.size())
+                                             << "pipeline" << _shardPipeline)));
+    }
+
+    void DocumentSourcePartitionedCursor::start() {
+        if (_started)
+            return;
+        _started = true;
+
+        for (size_t i = 0; i < _partitions.size(); i++) {
+            _partitions[i]->thread.reset(new boost::thread(boost::bind(&Partition::run,
+                                                                       _partitions[i])));
+        }
+    }
+
+    boost::optional<Document> DocumentSourcePartitionedCursor::getNext() {
+        pExpCtx->checkForInterrupt();
+
+        if (_partitions.empty())
+            return boost::none; // disposed
+
+        start();
+
+        while (true) {
+            std::deque<Document>& current = _partitions[_nextPartition]->taken;
+            if (!current.empty()) {
+                Document out = current.front();
+                current.pop_front();
+                return out;
+            }
+
+            {
+                boost::unique_lock<boost::mutex> lk(_exchange->mutex);
+
+                // Take the results of the next partition that has some, so that one busy
+                // partition doesn't hold up the others.
+                bool allDone = true;
+                for (size_t n = 1; n <= _partitions.size(); n++) {
+                    const size_t i = (_nextPartition + n) % _partitions.size();
+                    Partition& partition = *_partitions[i];
+                    if (partition.hasResults()) {
+                        partition.takeResults();
+                        _nextPartition = i;
+                        allDone = false;
+                        break;
+                    }
+
+                    if (!partition.isDone())
+                        allDone = false;
+                }
+
+                if (allDone)
+                    return boost::none;
+
+                if (_partitions[_nextPartition]->taken.empty())
+                    _exchange->produced.timed_wait(lk, kInterruptCheckPeriod);
+            }
+
+            if (_partitions[_nextPartition]->taken.empty() && pExpCtx->opCtx)
+                pExpCtx->opCtx->checkForInterrupt();
+        }
+    }
+
+    size_t DocumentSourcePartitionedCursor::numSortedStreams() const {
+        return _partitions.size();
+    }
+
+    boost::optional<Document> DocumentSourcePartitionedCursor::getNextFromStream(size_t stream) {
+        pExpCtx->checkForInterrupt();
+
+        verify(stream < _partitions.size());
+        start();
+
+        Partition& partition = *_partitions[stream];
+        while (partition.taken.empty()) {
+            {
+                boost::unique_lock<boost::mutex> lk(_exchange->mutex);
+                if (partition.hasResults()) {
+                    partition.takeResults();
+                    break;
+                }
+
+                if (partition.isDone())
+                    return boost::none;
+
+                _exchange->produced.timed_wait(lk, kInterruptCheckPeriod);
+            }
+
+            if (pExpCtx->opCtx)
+                pExpCtx->opCtx->checkForInterrupt();
+        }
+
+        Document out = partition.taken.front();
+        partition.taken.pop_front();
+        return out;
+    }
+
+    void DocumentSourcePartitionedCursor::dispose() {
+        if (_partitions.empty())
+            return;
+
+        std::vector<bool> done(_partitions.size());
+        {
+            boost::lock_guard<boost::mutex> lk(_exchange->mutex);
+            _exchange->cancelled = true;
+            for (size_t i = 0; i < _partitions.size(); i++) {
+                Partition& partition = *_partitions[i];
+                partition.kill();
+                done[i] = partition.hasFinished();
+            }
+        }
+
+        // Don't wait for partitions that are still running, since this may be called with locks
+        // held (for instance when the cursor is killed) that they need to stop. Killed partitions
+        // stop at their next interrupt check, and DocumentSourceCursor checks for interrupts
+        // before touching its executor, so they don't need to receive invalidations anymore.
+        for (size_t i = 0; i < _partitions.size(); i++) {
+            if (boost::thread* thread = _partitions[i]->thread.get()) {
+                if (done[i]) {
+                    thread->join();
+                }
+                else {
+                    thread->detach();
+                }
+            }
+        }
+
+        _partitions.clear();
+    }
+
+}
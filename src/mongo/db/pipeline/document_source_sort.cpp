@@ -129,6 +129,10 @@ namespace mongo {
         return keyObj.freeze();
     }
 
+    BSONObj DocumentSourceSort::getOutputSortOrder() const {
+        return serializeSortKey(/*explain*/false).toBson();
+    }
+
     DocumentSource::GetDepsReturn DocumentSourceSort::getDependencies(DepsTracker* deps) const {
         for(size_t i = 0; i < vSortKey.size(); ++i) {
             vSortKey[i]->addDependencies(deps);
@@ -221,12 +225,16 @@ namespace mongo {
         if (_mergingPresorted) {
             typedef DocumentSourceMergeCursors DSCursors;
             typedef DocumentSourceCommandShards DSCommands;
+            typedef SortedStreamsDocumentSource DSStreams;
             if (DSCursors* castedSource = dynamic_cast<DSCursors*>(pSource)) {
                 populateFromCursors(castedSource->getCursors());
             } else if (DSCommands* castedSource = dynamic_cast<DSCommands*>(pSource)) {
                 populateFromBsonArrays(castedSource->getArrays());
+            } else if (DSStreams* castedSource = dynamic_cast<DSStreams*>(pSource)) {
+                populateFromStreams(castedSource);
             } else {
-                msgasserted(17196, "can only mergePresorted from MergeCursors and CommandShards");
+                msgasserted(17196, "can only mergePresorted from MergeCursors, CommandShards and"
+                                   " sorted streams");
             }
         } else {
             scoped_ptr<MySorter> sorter (MySorter::make(makeSortOptions(), Comparator(*this)));
@@ -290,6 +298,47 @@ namespace mongo {
         _output.reset(MySorter::Iterator::merge(iterators, makeSortOptions(), Comparator(*this)));
     }
 
+    class DocumentSourceSort::IteratorFromStream : public MySorter::Iterator {
+    public:
+        IteratorFromStream(DocumentSourceSort* sorter,
+                           SortedStreamsDocumentSource* source,
+                           size_t stream)
+            : _sorter(sorter)
+            , _source(source)
+            , _stream(stream)
+            , _atEnd(false)
+        {}
+
+        bool more() {
+            if (!_next && !_atEnd) {
+                _next = _source->getNextFromStream(_stream);
+                _atEnd = !_next;
+            }
+            return !_atEnd;
+        }
+        Data next() {
+            verify(more());
+            const Document doc = *_next;
+            _next = boost::none;
+            return make_pair(_sorter->extractKey(doc), doc);
+        }
+    private:
+        DocumentSourceSort* _sorter;
+        SortedStreamsDocumentSource* _source;
+        const size_t _stream;
+        boost::optional<Document> _next;
+        bool _atEnd;
+    };
+
+    void DocumentSourceSort::populateFromStreams(SortedStreamsDocumentSource* source) {
+        vector<boost::shared_ptr<MySorter::Iterator> > iterators;
+        for (size_t i = 0; i < source->numSortedStreams(); i++) {
+            iterators.push_back(boost::make_shared<IteratorFromStream>(this, source, i));
+        }
+
+        _output.reset(MySorter::Iterator::merge(iterators, makeSortOptions(), Comparator(*this)));
+    }
+
     Value DocumentSourceSort::extractKey(const Document& d) const {
         Variables vars(0, d);
         if (vSortKey.size() == 1) {
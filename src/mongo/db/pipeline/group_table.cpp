@@ -0,0 +1,235 @@
+/**
+ * Copyright (c) 2014 MongoDB Inc.
+ *
+ * This program is free software: you can redistribute it and/or  modify
+ * it under the terms of the GNU Affero General Public License, version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, the copyright holders give permission to link the
+ * code of portions of this program with the OpenSSL library under certain
+ * conditions as described in each individual source file and distribute
+ * linked combinations including the program with the OpenSSL library. You
+ * must comply with the GNU Affero General Public License in all respects for
+ * all of the code used other than as permitted herein. If you modify file(s)
+ * with this exception, you may extend this exception to your version of the
+ * file(s), but you are not obligated to do so. If you do not wish to do so,
+ * delete this exception statement from your version. If you delete this
+ * exception statement from all source files in the program, then also delete
+ * it in the license file.
+ */
+
+#include "mongo/pch.h"
+
+#include "mongo/db/pipeline/group_table.h"
+
+#include <algorithm>
+
+namespace mongo {
+
+    struct GroupTable::Group {
+        size_t hash;
+        Value key;
+        // followed by the state of each accumulator, see _offsets
+    };
+
+namespace {
+    typedef intrusive_ptr<Accumulator> AccumulatorPtr;
+
+    const size_t kAlignment = 8;
+    const size_t kChunkBytes = 64 * 1024;
+
+    size_t alignUp(size_t bytes) {
+        return (bytes + kAlignment - 1) & ~(kAlignment - 1);
+    }
+
+    /**
+     * Value::Hash is a plain combination of the hashes of the parts of a value, so small integers
+     * hash to themselves. Mix the bits so that linear probing doesn't cluster on such keys. This
+     * is the finalizer of MurmurHash3.
+     */
+    size_t mixHash(size_t hash) {
+        unsigned long long h = hash;
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        h *= 0xc4ceb9fe1a85ec53ULL;
+        h ^= h >> 33;
+        return static_cast<size_t>(h);
+    }
+}
+
+    GroupTable::GroupTable(const std::vector<AccumulatorFactory>& factories,
+                           size_t initialCapacity)
+        : _factories(factories)
+        , _chunkUsed(0) {
+
+        size_t offset = alignUp(sizeof(Group));
+        int stateBytes = 0;
+        for (size_t i = 0; i < _factories.size(); i++) {
+            AccumulatorPtr accumulator = _factories[i]();
+            const size_t inlineSize = accumulator->inlineStateSize();
+
+            _kernels.push_back(accumulator);
+            _inline.push_back(inlineSize != 0);
+            _offsets.push_back(offset);
+
+            const size_t size = inlineSize ? inlineSize : sizeof(AccumulatorPtr);
+            offset += alignUp(size);
+            stateBytes += size;
+        }
+        _groupBytes = offset;
+        _chunkBytes = std::max(kChunkBytes, _groupBytes);
+
+        // Each group is also referenced from _groups and, at the maximum load factor, from two
+        // slots.
+        _baseMemUsage = _groupBytes - stateBytes - sizeof(Value) + 3 * sizeof(Group*);
+
+        size_t capacity = 16;
+        while (capacity < initialCapacity)
+            capacity <<= 1;
+        _slots.resize(capacity, NULL);
+    }
+
+    GroupTable::~GroupTable() {
+        clear();
+    }
+
+    void* GroupTable::stateFor(const Group* group, size_t i) const {
+        return const_cast<char*>(reinterpret_cast<const char*>(group)) + _offsets[i];
+    }
+
+    GroupTable::Group* GroupTable::findOrInsert(const Value& key, bool* inserted) {
+        const size_t hash = mixHash(Value::Hash()(key));
+        const size_t mask = _slots.size() - 1;
+
+        size_t slot = slotFor(hash);
+        for (Group* group; (group = _slots[slot]); slot = (slot + 1) & mask) {
+            if (group->hash == hash && Value::compare(group->key, key) == 0) {
+                *inserted = false;
+                return group;
+            }
+        }
+
+        // Keep the load factor at or below 1/2 so that probe sequences stay short.
+        if ((_groups.size() + 1) * 2 > _slots.size()) {
+            grow();
+            slot = slotFor(hash);
+            while (_slots[slot])
+                slot = (slot + 1) & (_slots.size() - 1);
+        }
+
+        Group* group = allocateGroup();
+        group->hash = hash;
+        new (&group->key) Value(key);
+        for (size_t i = 0; i < _kernels.size(); i++) {
+            void* state = stateFor(group, i);
+            if (_inline[i]) {
+                _kernels[i]->constructInlineState(state);
+            }
+            else {
+                new (state) AccumulatorPtr(_factories[i]());
+            }
+        }
+
+        _slots[slot] = group;
+        _groups.push_back(group);
+        *inserted = true;
+        return group;
+    }
+
+    int GroupTable::process(Group* group, size_t i, const Value& input, bool merging) {
+        void* state = stateFor(group, i);
+        if (_inline[i])
+            return _kernels[i]->processInlineState(state, input, merging);
+
+        Accumulator* accumulator = static_cast<AccumulatorPtr*>(state)->get();
+        const int oldMemUsage = accumulator->memUsageForSorter();
+        accumulator->process(input, merging);
+        return accumulator->memUsageForSorter() - oldMemUsage;
+    }
+
+    Value GroupTable::getValue(const Group* group, size_t i, bool toBeMerged) const {
+        const void* state = stateFor(group, i);
+        if (_inline[i])
+            return _kernels[i]->getInlineStateValue(state, toBeMerged);
+
+        return (*static_cast<const AccumulatorPtr*>(state))->getValue(toBeMerged);
+    }
+
+    const Value& GroupTable::getKey(const Group* group) const {
+        return group->key;
+    }
+
+    int GroupTable::memUsage(const Group* group) const {
+        int bytes = _baseMemUsage + group->key.getApproximateSize();
+        for (size_t i = 0; i < _kernels.size(); i++) {
+            const void* state = stateFor(group, i);
+            if (_inline[i]) {
+                bytes += _kernels[i]->inlineStateMemUsage(state);
+            }
+            else {
+                bytes += sizeof(AccumulatorPtr)
+                       + (*static_cast<const AccumulatorPtr*>(state))->memUsageForSorter();
+            }
+        }
+        return bytes;
+    }
+
+    void GroupTable::clear() {
+        for (size_t g = 0; g < _groups.size(); g++) {
+            Group* group = _groups[g];
+            for (size_t i = 0; i < _kernels.size(); i++) {
+                void* state = stateFor(group, i);
+                if (_inline[i]) {
+                    _kernels[i]->destroyInlineState(state);
+                }
+                else {
+                    static_cast<AccumulatorPtr*>(state)->~AccumulatorPtr();
+                }
+            }
+            group->key.~Value();
+        }
+        _groups.clear();
+
+        for (size_t i = 0; i < _chunks.size(); i++) {
+            delete [] _chunks[i];
+        }
+        _chunks.clear();
+        _chunkUsed = 0;
+
+        std::fill(_slots.begin(), _slots.end(), static_cast<Group*>(NULL));
+    }
+
+    GroupTable::Group* GroupTable::allocateGroup() {
+        if (_chunks.empty() || _chunkUsed + _groupBytes > _chunkBytes) {
+            _chunks.push_back(new char[_chunkBytes]);
+            _chunkUsed = 0;
+        }
+
+        Group* group = reinterpret_cast<Group*>(_chunks.back() + _chunkUsed);
+        _chunkUsed += _groupBytes;
+        return group;
+    }
+
+    void GroupTable::grow() {
+        std::vector<Group*> slots(_slots.size() * 2, static_cast<Group*>(NULL));
+        _slots.swap(slots);
+
+        const size_t mask = _slots.size() - 1;
+        for (size_t g = 0; g < _groups.size(); g++) {
+            size_t slot = slotFor(_groups[g]->hash);
+            while (_slots[slot])
+                slot = (slot + 1) & mask;
+            _slots[slot] = _groups[g];
+        }
+    }
+
+}
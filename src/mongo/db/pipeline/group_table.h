@@ -0,0 +1,117 @@
+/**
+ * Copyright (c) 2014 MongoDB Inc.
+ *
+ * This program is free software: you can redistribute it and/or  modify
+ * it under the terms of the GNU Affero General Public License, version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, the copyright holders give permission to link the
+ * code of portions of this program with the OpenSSL library under certain
+ * conditions as described in each individual source file and distribute
+ * linked combinations including the program with the OpenSSL library. You
+ * must comply with the GNU Affero General Public License in all respects for
+ * all of the code used other than as permitted herein. If you modify file(s)
+ * with this exception, you may extend this exception to your version of the
+ * file(s), but you are not obligated to do so. If you do not wish to do so,
+ * delete this exception statement from your version. If you delete this
+ * exception statement from all source files in the program, then also delete
+ * it in the license file.
+ */
+
+#pragma once
+
+#include <boost/noncopyable.hpp>
+#include <vector>
+
+#include "mongo/db/pipeline/accumulator.h"
+#include "mongo/db/pipeline/value.h"
+
+namespace mongo {
+
+    /**
+     * The groups of a $group stage, keyed by the group's _id.
+     *
+     * This is an open addressing hash table with linear probing. Each group is a single block
+     * carved out of large chunks of memory, holding the key followed by the state of each
+     * accumulator. Accumulators that support it (see Accumulator::inlineStateSize()) keep their
+     * state inline in that block and are driven through one shared Accumulator per field, so
+     * adding a group only allocates when the key or a variable size accumulator needs to. The
+     * other accumulators are created by their factory and only their pointer is inline.
+     */
+    class GroupTable : boost::noncopyable {
+    public:
+        typedef intrusive_ptr<Accumulator> (*AccumulatorFactory)();
+
+        /// Opaque handle to a group. Valid until clear() or the GroupTable is destroyed.
+        struct Group;
+
+        static const size_t kDefaultInitialCapacity = 1024;
+
+        /**
+         * @param factories one per accumulator of each group, in output order
+         * @param initialCapacity slots to pre-size the table to; rounded up to a power of two
+         */
+        explicit GroupTable(const std::vector<AccumulatorFactory>& factories,
+                            size_t initialCapacity = kDefaultInitialCapacity);
+        ~GroupTable();
+
+        /**
+         * Finds the group for 'key', adding one with fresh accumulators if there is none.
+         * @param inserted set to whether a new group was added
+         */
+        Group* findOrInsert(const Value& key, bool* inserted);
+
+        /**
+         * Feeds 'input' to the i'th accumulator of 'group'.
+         * @return the change in the approximate memory used by the group.
+         */
+        int process(Group* group, size_t i, const Value& input, bool merging);
+
+        Value getValue(const Group* group, size_t i, bool toBeMerged) const;
+
+        const Value& getKey(const Group* group) const;
+
+        /// Approximate memory used by 'group', including its key.
+        int memUsage(const Group* group) const;
+
+        /// The groups in the order they were added.
+        const std::vector<Group*>& groups() const { return _groups; }
+
+        size_t size() const { return _groups.size(); }
+        bool empty() const { return _groups.empty(); }
+
+        /// Removes all groups, keeping the table's current capacity.
+        void clear();
+
+    private:
+        Group* allocateGroup();
+        void grow();
+        size_t slotFor(size_t hash) const { return hash & (_slots.size() - 1); }
+        void* stateFor(const Group* group, size_t i) const;
+
+        // One per accumulator. The ones with inline state are shared by all groups, the others
+        // are only used to check whether the state can be inline.
+        std::vector<AccumulatorFactory> _factories;
+        std::vector<intrusive_ptr<Accumulator> > _kernels;
+        std::vector<bool> _inline;
+        std::vector<size_t> _offsets;   // of each accumulator's state from the group's start
+        size_t _groupBytes;             // size of a group's block
+        int _baseMemUsage;              // memory used by an empty group, excluding key and state
+
+        std::vector<Group*> _slots;     // power of two sized, NULL for empty slots
+        std::vector<Group*> _groups;    // in insertion order, for iteration
+
+        std::vector<char*> _chunks;     // memory the groups are carved out of
+        size_t _chunkBytes;
+        size_t _chunkUsed;              // bytes of _chunks.back() already handed out
+    };
+
+}
@@ -30,18 +30,26 @@
 
 #include "mongo/db/pipeline/pipeline_d.h"
 
+#include "mongo/base/owned_pointer_vector.h"
 #include "mongo/client/dbclientinterface.h"
 #include "mongo/db/catalog/collection.h"
 #include "mongo/db/catalog/database.h"
+#include "mongo/db/exec/multi_iterator.h"
+#include "mongo/db/exec/working_set.h"
 #include "mongo/db/instance.h"
 #include "mongo/db/pipeline/document_source.h"
 #include "mongo/db/pipeline/pipeline.h"
 #include "mongo/db/query/get_executor.h"
 #include "mongo/db/query/query_planner.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/s/d_logic.h"
 
 namespace mongo {
 
+    // Number of threads a whole collection scan feeding a $group or $sort is split across. 0 or 1
+    // scans the collection from the thread running the pipeline.
+    MONGO_EXPORT_SERVER_PARAMETER(internalAggregationPartitions, int, 0);
+
 namespace {
     class MongodImplementation : public DocumentSourceNeedsMongod::MongodInterface {
     public:
@@ -74,7 +82,7 @@ namespace {
     };
 }
 
-    boost::shared_ptr<PlanExecutor> PipelineD::prepareCursorSource(
+    std::vector<boost::shared_ptr<PlanExecutor> > PipelineD::prepareCursorSource(
             OperationContext* txn,
             Collection* collection,
             const intrusive_ptr<Pipeline>& pPipeline,
@@ -104,16 +112,18 @@ namespace {
                 // on secondaries, this is needed.
                 ShardedConnectionInfo::addHook();
             }
-            return boost::shared_ptr<PlanExecutor>(); // don't need a cursor
+            return std::vector<boost::shared_ptr<PlanExecutor> >(); // don't need a cursor
         }
 
 
         // Look for an initial match. This works whether we got an initial query or not.
         // If not, it results in a "{}" query, which will be what we want in that case.
         const BSONObj queryObj = pPipeline->getInitialQuery();
+        intrusive_ptr<DocumentSource> initialMatch;
         if (!queryObj.isEmpty()) {
             // This will get built in to the Cursor we'll create, so
             // remove the match from the pipeline
+            initialMatch = sources.front();
             sources.pop_front();
         }
 
@@ -208,6 +218,14 @@ namespace {
             exec.reset(rawExec);
         }
 
+        // A whole collection scan can be split across threads instead.
+        std::vector<boost::shared_ptr<PlanExecutor> > execs;
+        if (!sortInRunner
+                && exec->getRootStage()->stageType() == STAGE_COLLSCAN
+                && preparePartitionedSource(txn, collection, pPipeline, pExpCtx, initialMatch,
+                                            &execs)) {
+            return execs;
+        }
 
         // DocumentSourceCursor expects a yielding PlanExecutor that has had its state saved.
         exec->saveState();
@@ -229,7 +247,111 @@ namespace {
 
         pPipeline->addInitialSource(pSource);
 
-        return exec;
+        execs.push_back(exec);
+        return execs;
+    }
+
+    bool PipelineD::preparePartitionedSource(
+            OperationContext* txn,
+            Collection* collection,
+            const intrusive_ptr<Pipeline>& pPipeline,
+            const intrusive_ptr<ExpressionContext>& pExpCtx,
+            const intrusive_ptr<DocumentSource>& initialMatch,
+            std::vector<boost::shared_ptr<PlanExecutor> >* execs) {
+        const int maxPartitions = internalAggregationPartitions;
+        if (maxPartitions <= 1 || !collection || pPipeline->isExplain())
+            return false;
+
+        // The partitions' executors can't filter out documents that don't belong to this shard.
+        if (shardingState.needCollectionMetadata(pExpCtx->ns.ns()))
+            return false;
+
+        // Only split in front of a stage that reduces or orders the documents, so that the
+        // partitions do most of the work and their results can be merged. Everything before it
+        // is a per document transformation that can run in any thread.
+        Pipeline::SourceContainer& sources = pPipeline->sources;
+        Pipeline::SourceContainer::const_iterator split = sources.begin();
+        while (split != sources.end() && !dynamic_cast<SplittableDocumentSource*>(split->get())) {
+            ++split;
+        }
+        if (split == sources.end()
+                || !(dynamic_cast<DocumentSourceGroup*>(split->get())
+                     || dynamic_cast<DocumentSourceSort*>(split->get()))) {
+            return false;
+        }
+
+        OwnedPointerVector<RecordIterator> iterators(collection->getManyIterators(txn));
+        if (iterators.size() < 2)
+            return false;
+
+        const size_t numPartitions = std::min(size_t(maxPartitions), iterators.size());
+
+        // Each partition scans a share of the collection's extents, like the executors of
+        // parallelCollectionScan.
+        std::vector<boost::shared_ptr<PlanExecutor> > partitionExecs;
+        for (size_t i = 0; i < numPartitions; i++) {
+            WorkingSet* ws = new WorkingSet();
+            MultiIteratorStage* mis = new MultiIteratorStage(ws, collection);
+            // Takes ownership of 'ws' and 'mis'.
+            partitionExecs.push_back(boost::make_shared<PlanExecutor>(ws, mis, collection));
+        }
+        for (size_t i = 0; i < iterators.size(); i++) {
+            PlanExecutor* exec = partitionExecs[i % numPartitions].get();
+            static_cast<MultiIteratorStage*>(exec->getRootStage())->addIterator(
+                iterators.releaseAt(i));
+        }
+
+        // The partitions run the shard half of the pipeline, including the initial $match since
+        // their executors don't apply the query.
+        if (initialMatch)
+            sources.push_front(initialMatch);
+        const intrusive_ptr<Pipeline> shardPipeline = pPipeline->splitForSharded();
+        const BSONObj shardCommand = shardPipeline->serialize().toBson();
+
+        // Each partition gets its own copy of the shard pipeline, since DocumentSources and
+        // ExpressionContexts can't be shared between threads.
+        std::vector<intrusive_ptr<Pipeline> > partitions;
+        for (size_t i = 0; i < numPartitions; i++) {
+            intrusive_ptr<ExpressionContext> partitionCtx =
+                new ExpressionContext(txn, pExpCtx->ns);
+            partitionCtx->tempDir = pExpCtx->tempDir;
+            partitionCtx->inShard = true; // so that the results can be merged
+
+            std::string errmsg;
+            intrusive_ptr<Pipeline> partition =
+                Pipeline::parseCommand(errmsg, shardCommand, partitionCtx);
+            massert(18655, str::stream() << "failed to copy pipeline for partition: " << errmsg,
+                    partition);
+
+            // DocumentSourceCursor expects a yielding PlanExecutor that has had its state saved.
+            partitionExecs[i]->saveState();
+
+            intrusive_ptr<DocumentSourceCursor> pSource =
+                DocumentSourceCursor::create(pExpCtx->ns.ns(), partitionExecs[i], partitionCtx);
+
+            const DepsTracker deps = partition->getDependencies(BSONObj());
+            pSource->setProjection(deps.toProjection(), deps.toParsedDeps());
+
+            while (!partition->sources.empty() && pSource->coalesce(partition->sources.front())) {
+                partition->sources.pop_front();
+            }
+
+            partition->addInitialSource(pSource);
+            partition->stitch();
+
+            // Set by the partition's thread.
+            partitionCtx->opCtx = NULL;
+
+            partitions.push_back(partition);
+        }
+
+        pPipeline->addInitialSource(
+            DocumentSourcePartitionedCursor::create(partitions,
+                                                    Value(shardCommand[Pipeline::pipelineName]),
+                                                    pExpCtx));
+
+        execs->swap(partitionExecs);
+        return true;
     }
 
 } // namespace mongo
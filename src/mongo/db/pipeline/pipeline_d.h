@@ -29,9 +29,11 @@
 #pragma once
 
 #include <boost/smart_ptr.hpp>
+#include <vector>
 
 namespace mongo {
     class Collection;
+    class DocumentSource;
     class DocumentSourceCursor;
     struct ExpressionContext;
     class OperationContext;
@@ -65,13 +67,19 @@ namespace mongo {
          *
          * Must have a ReadContext before entering.
          *
-         * If the returned PlanExecutor is non-null, you are responsible for ensuring
-         * it receives appropriate invalidate and kill messages.
+         * When the internalAggregationPartitions server parameter is above one and the pipeline
+         * would scan a whole unsharded collection into a $group or $sort, the collection is
+         * instead split into partitions that each run the part of the pipeline up to that stage
+         * on their own thread, and a DocumentSourcePartitionedCursor merging their results is
+         * added to the front of the pipeline.
+         *
+         * You are responsible for ensuring that the returned PlanExecutors, if any, receive
+         * appropriate invalidate and kill messages.
          *
          * @param pPipeline the logical "this" for this operation
          * @param pExpCtx the expression context for this pipeline
          */
-        static boost::shared_ptr<PlanExecutor> prepareCursorSource(
+        static std::vector<boost::shared_ptr<PlanExecutor> > prepareCursorSource(
             OperationContext* txn,
             Collection* collection,
             const intrusive_ptr<Pipeline> &pPipeline,
@@ -79,6 +87,22 @@ namespace mongo {
 
     private:
         PipelineD(); // does not exist:  prevent instantiation
+
+        /**
+         * Splits pPipeline into partitions over the collection's extents, as described above.
+         *
+         * @param initialMatch the $match removed from the front of the pipeline for the query,
+         *        if any. The partitions have to apply it themselves.
+         * @param execs filled with the executors of the partitions
+         * @return false, leaving the pipeline as it was, if it can't or shouldn't be split.
+         */
+        static bool preparePartitionedSource(
+            OperationContext* txn,
+            Collection* collection,
+            const intrusive_ptr<Pipeline>& pPipeline,
+            const intrusive_ptr<ExpressionContext>& pExpCtx,
+            const intrusive_ptr<DocumentSource>& initialMatch,
+            std::vector<boost::shared_ptr<PlanExecutor> >* execs);
     };
 
 } // namespace mongo
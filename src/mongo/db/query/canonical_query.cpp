@@ -28,9 +28,14 @@
 
 #include "mongo/db/query/canonical_query.h"
 
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+
 #include "mongo/db/jsobj.h"
 #include "mongo/db/matcher/expression_array.h"
 #include "mongo/db/matcher/expression_geo.h"
+#include "mongo/db/query/lru_key_value.h"
+#include "mongo/db/query/query_knobs.h"
 #include "mongo/db/query/query_planner_common.h"
 #include "mongo/util/log.h"
 
@@ -312,6 +317,152 @@ namespace {
         }
     }
 
+    /**
+     * What normalizing a query of a given shape produces, apart from the constants.
+     *
+     * Queries whose parsed trees have the same encodePlanCacheKeyTree() encoding differ only in
+     * their constants, and normalizeTree(), sortTree() and the cache key look at nothing else.
+     * So the child order that sortTree() picked for the first query of a shape, and the
+     * encoding of its normalized tree, hold for every later query of that shape.
+     */
+    struct QueryShapeTemplate {
+        // For each node with a child vector, in the post-order in which sortTree() visits them,
+        // the original positions of its children in sorted order.
+        std::vector<size_t> childOrder;
+
+        // encodePlanCacheKeyTree() of the normalized and sorted tree.
+        std::string treeKey;
+    };
+
+    /**
+     * Process wide LRU cache of QueryShapeTemplates, keyed by the encoding of the parsed tree
+     * before normalization.  The cache is split into partitions by the hash of the shape, each
+     * with its own mutex and LRU list, so that queries of different shapes don't contend.
+     */
+    class QueryShapeCache {
+    public:
+        // Shapes are a property of the application rather than of a collection, so this is
+        // plenty for one process.
+        static const size_t kMaxShapes = 1024;
+        static const size_t kNumPartitions = 16;
+
+        // Filters larger than this aren't looked up, since encoding them costs more than the
+        // normalization it saves, and shapes larger than this aren't kept.
+        static const size_t kMaxShapeBytes = 4 * 1024;
+
+        /**
+         * Returns the template for 'shape', or an empty pointer if there is none.
+         */
+        boost::shared_ptr<const QueryShapeTemplate> get(const string& shape) {
+            Partition& partition = _partitionFor(shape);
+            boost::lock_guard<boost::mutex> lk(partition.mutex);
+            boost::shared_ptr<const QueryShapeTemplate>* entry;
+            if (!partition.templates.get(shape, &entry).isOK()) {
+                return boost::shared_ptr<const QueryShapeTemplate>();
+            }
+            return *entry;
+        }
+
+        void add(const string& shape, const boost::shared_ptr<const QueryShapeTemplate>& entry) {
+            if (shape.size() + entry->treeKey.size() > kMaxShapeBytes) {
+                return;
+            }
+
+            Partition& partition = _partitionFor(shape);
+            boost::lock_guard<boost::mutex> lk(partition.mutex);
+            partition.templates.add(shape,
+                                    new boost::shared_ptr<const QueryShapeTemplate>(entry));
+        }
+
+    private:
+        struct Partition {
+            Partition() : templates(kMaxShapes / kNumPartitions) { }
+
+            boost::mutex mutex;
+            LRUKeyValue<string, boost::shared_ptr<const QueryShapeTemplate> > templates;
+        };
+
+        Partition& _partitionFor(const string& shape) {
+            return _partitions[StringData::Hasher()(shape) % kNumPartitions];
+        }
+
+        Partition _partitions[kNumPartitions];
+    };
+
+    QueryShapeCache queryShapeCache;
+
+    /**
+     * Orders positions in a child vector by OperatorAndFieldNameComparison of the children.
+     */
+    class ChildPositionComparison {
+    public:
+        explicit ChildPositionComparison(const std::vector<MatchExpression*>& children)
+            : _children(children) { }
+
+        bool operator()(size_t lhs, size_t rhs) const {
+            return OperatorAndFieldNameComparison(_children[lhs], _children[rhs]);
+        }
+
+    private:
+        const std::vector<MatchExpression*>& _children;
+    };
+
+    /**
+     * Rearranges 'children' so that child i is the one that was at position order[i].
+     */
+    void reorderChildren(std::vector<MatchExpression*>* children,
+                         std::vector<size_t>::const_iterator order) {
+        std::vector<MatchExpression*> reordered(children->size());
+        for (size_t i = 0; i < reordered.size(); ++i) {
+            reordered[i] = (*children)[order[i]];
+        }
+        children->swap(reordered);
+    }
+
+    /**
+     * Same as CanonicalQuery::sortTree, but also appends the order chosen at each node to
+     * 'childOrder' in the format of QueryShapeTemplate::childOrder.
+     */
+    void sortTreeRecordingOrder(MatchExpression* tree, std::vector<size_t>* childOrder) {
+        for (size_t i = 0; i < tree->numChildren(); ++i) {
+            sortTreeRecordingOrder(tree->getChild(i), childOrder);
+        }
+        std::vector<MatchExpression*>* children = tree->getChildVector();
+        if (NULL == children) {
+            return;
+        }
+
+        std::vector<size_t> order(children->size());
+        for (size_t i = 0; i < order.size(); ++i) {
+            order[i] = i;
+        }
+        std::sort(order.begin(), order.end(), ChildPositionComparison(*children));
+        reorderChildren(children, order.begin());
+        childOrder->insert(childOrder->end(), order.begin(), order.end());
+    }
+
+    /**
+     * Sorts 'tree' the way sortTreeRecordingOrder sorted the tree it recorded 'childOrder' from,
+     * without comparing any nodes.  'tree' must be a normalized tree of the same shape.
+     * 'pos' is the position in 'childOrder' to start reading from, and is advanced past what
+     * was read.
+     */
+    void replayChildOrder(MatchExpression* tree,
+                          const std::vector<size_t>& childOrder,
+                          size_t* pos) {
+        for (size_t i = 0; i < tree->numChildren(); ++i) {
+            replayChildOrder(tree->getChild(i), childOrder, pos);
+        }
+        std::vector<MatchExpression*>* children = tree->getChildVector();
+        if (NULL == children) {
+            return;
+        }
+
+        invariant(*pos + children->size() <= childOrder.size());
+        reorderChildren(children, childOrder.begin() + *pos);
+        *pos += children->size();
+    }
+
 } // namespace
 
 namespace mongo {
@@ -499,17 +650,55 @@ namespace mongo {
                                 MatchExpression* root) {
         _pq.reset(lpq);
 
+        // Look for a query of the same shape seen before.  If there is one, the tree normalizes
+        // exactly like it did, so sorting and encoding it again can be skipped.
+        string shape;
+        boost::shared_ptr<const QueryShapeTemplate> shapeTemplate;
+        const bool useShapeTemplates = internalQueryCacheShapeTemplates &&
+            static_cast<size_t>(_pq->getFilter().objsize()) <= QueryShapeCache::kMaxShapeBytes;
+        if (useShapeTemplates) {
+            mongoutils::str::stream ss;
+            encodePlanCacheKeyTree(root, &ss);
+            shape = ss;
+            shapeTemplate = queryShapeCache.get(shape);
+        }
+
         // Normalize, sort and validate tree.
         root = normalizeTree(root);
 
-        sortTree(root);
+        boost::shared_ptr<QueryShapeTemplate> newTemplate;
+        if (shapeTemplate) {
+            size_t pos = 0;
+            replayChildOrder(root, shapeTemplate->childOrder, &pos);
+            invariant(pos == shapeTemplate->childOrder.size());
+        }
+        else if (useShapeTemplates) {
+            newTemplate.reset(new QueryShapeTemplate());
+            sortTreeRecordingOrder(root, &newTemplate->childOrder);
+        }
+        else {
+            sortTree(root);
+        }
         _root.reset(root);
         Status validStatus = isValid(root, *_pq);
         if (!validStatus.isOK()) {
             return validStatus;
         }
 
-        this->generateCacheKey();
+        if (shapeTemplate) {
+            this->generateCacheKey(shapeTemplate->treeKey);
+        }
+        else {
+            mongoutils::str::stream ss;
+            encodePlanCacheKeyTree(_root.get(), &ss);
+            const string treeKey = ss;
+            this->generateCacheKey(treeKey);
+
+            if (newTemplate) {
+                newTemplate->treeKey = treeKey;
+                queryShapeCache.add(shape, newTemplate);
+            }
+        }
 
         // Validate the projection if there is one.
         if (!_pq->getProj().isEmpty()) {
@@ -568,9 +757,9 @@ namespace mongo {
         return _cacheKey;
     }
 
-    void CanonicalQuery::generateCacheKey(void) {
+    void CanonicalQuery::generateCacheKey(const string& treeKey) {
         mongoutils::str::stream ss;
-        encodePlanCacheKeyTree(_root.get(), &ss);
+        ss << treeKey;
         encodePlanCacheKeySort(_pq->getSort(), &ss);
         encodePlanCacheKeyProj(_pq->getProj(), &ss);
         _cacheKey = ss;
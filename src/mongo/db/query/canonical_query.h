@@ -196,9 +196,9 @@ namespace mongo {
 
         /**
          * Computes and stores the cache key / query shape
-         * for this query.
+         * for this query, given the encoding of the normalized tree.
          */
-        void generateCacheKey(void);
+        void generateCacheKey(const std::string& treeKey);
 
         /**
          * Takes ownership of 'root' and 'lpq'.
@@ -29,6 +29,7 @@
 #include "mongo/db/query/canonical_query.h"
 
 #include "mongo/db/json.h"
+#include "mongo/db/query/query_knobs.h"
 #include "mongo/unittest/unittest.h"
 
 using namespace mongo;
@@ -527,6 +528,98 @@ namespace {
                            "{$and: [{a: 1}, {b: 1}, {c: 1}]}");
     }
 
+    /**
+     * Sets internalQueryCacheShapeTemplates for the life of the guard, so that a failed assertion
+     * doesn't leave it changed for the tests which follow.
+     */
+    class ShapeTemplatesGuard {
+    public:
+        explicit ShapeTemplatesGuard(bool enabled)
+            : _oldEnabled(internalQueryCacheShapeTemplates) {
+            internalQueryCacheShapeTemplates = enabled;
+        }
+
+        ~ShapeTemplatesGuard() {
+            internalQueryCacheShapeTemplates = _oldEnabled;
+        }
+
+        void set(bool enabled) {
+            internalQueryCacheShapeTemplates = enabled;
+        }
+
+    private:
+        bool _oldEnabled;
+    };
+
+    /**
+     * Canonicalizes 'firstStr' and then 'secondStr', which must have the same shape, so that the
+     * second is normalized from the template the first left behind.  Checks that the second comes
+     * out the same as when normalized from scratch.
+     */
+    void testNormalizeFromShapeTemplate(const char* firstStr, const char* secondStr) {
+        ShapeTemplatesGuard shapeTemplates(false);
+        auto_ptr<CanonicalQuery> expected(canonicalize(secondStr));
+
+        shapeTemplates.set(true);
+        auto_ptr<CanonicalQuery> first(canonicalize(firstStr));
+        auto_ptr<CanonicalQuery> second(canonicalize(secondStr));
+
+        assertEquivalent(secondStr, expected->root(), second->root());
+        ASSERT_EQUALS(expected->getPlanCacheKey(), second->getPlanCacheKey());
+        ASSERT_EQUALS(first->getPlanCacheKey(), second->getPlanCacheKey());
+    }
+
+    TEST(CanonicalQueryTest, NormalizeFromShapeTemplate) {
+        testNormalizeFromShapeTemplate("{b: 1, a: 2}", "{b: 'x', a: 3}");
+        testNormalizeFromShapeTemplate("{a: {$gt: 5}, a: {$lt: 10}}", "{a: {$gt: 1}, a: {$lt: 2}}");
+        testNormalizeFromShapeTemplate("{a: 1, a: 2}", "{a: 4, a: 3}");
+        testNormalizeFromShapeTemplate("{z: 1, a: {$elemMatch: {c: 1, b: 1}}}",
+                                       "{z: 2, a: {$elemMatch: {c: 3, b: 4}}}");
+        testNormalizeFromShapeTemplate("{$or: [{$and: [{c: 1}, {b: 1}]}, {a: 1}]}",
+                                       "{$or: [{$and: [{c: 2}, {b: 2}]}, {a: 2}]}");
+        testNormalizeFromShapeTemplate("{$or: [{b: 1}, {$or: [{a: 1}, {c: 1}]}], d: {$ne: 1}}",
+                                       "{$or: [{b: 2}, {$or: [{a: 2}, {c: 2}]}], d: {$ne: 2}}");
+        testNormalizeFromShapeTemplate("{$and: [{$or: [{b: 1}, {a: 1}]}, {$or: [{d: 1}, {c: 1}]}]}",
+                                       "{$and: [{$or: [{b: 2}, {a: 2}]}, {$or: [{d: 2}, {c: 2}]}]}");
+    }
+
+    // Queries that only look alike must not share a template.
+    TEST(CanonicalQueryTest, ShapeTemplateDistinguishesShapes) {
+        ShapeTemplatesGuard shapeTemplates(true);
+        auto_ptr<CanonicalQuery> eq(canonicalize("{b: 1, a: 1}"));
+        auto_ptr<CanonicalQuery> ne(canonicalize("{b: 1, a: {$ne: 1}}"));
+        auto_ptr<CanonicalQuery> in(canonicalize("{b: 1, a: {$in: [1, 2]}}"));
+        ASSERT_NOT_EQUALS(eq->getPlanCacheKey(), ne->getPlanCacheKey());
+        ASSERT_NOT_EQUALS(eq->getPlanCacheKey(), in->getPlanCacheKey());
+        ASSERT_NOT_EQUALS(ne->getPlanCacheKey(), in->getPlanCacheKey());
+
+        // Legacy and GeoJSON geometries of the same operator are different shapes.
+        auto_ptr<CanonicalQuery> legacy(canonicalize("{a: {$geoWithin: "
+                                                     "{$box: [[-180, -90], [180, 90]]}}}"));
+        auto_ptr<CanonicalQuery> geoJSON(canonicalize("{a: {$geoWithin: "
+                                                      "{$geometry: {type: 'Polygon', coordinates: "
+                                                      "[[[0, 0], [0, 90], [90, 0], [0, 0]]]}}}}"));
+        ASSERT_NOT_EQUALS(legacy->getPlanCacheKey(), geoJSON->getPlanCacheKey());
+    }
+
+    // Filters too large to be worth a template are still normalized from scratch.
+    TEST(CanonicalQueryTest, LargeFilterSkipsShapeTemplate) {
+        mongoutils::str::stream first;
+        mongoutils::str::stream second;
+        first << "{";
+        second << "{";
+        for (int i = 500; i > 0; --i) {
+            first << (i == 500 ? "" : ", ") << "f" << i << ": " << i;
+            second << (i == 500 ? "" : ", ") << "f" << i << ": 'x" << i << "'";
+        }
+        first << "}";
+        second << "}";
+        const string firstStr = first;
+        const string secondStr = second;
+        ASSERT_GREATER_THAN(fromjson(firstStr).objsize(), 4 * 1024);
+        testNormalizeFromShapeTemplate(firstStr.c_str(), secondStr.c_str());
+    }
+
     /**
      * Test functions for getPlanCacheKey.
      * Cache keys are intentionally obfuscated and are meaningful only
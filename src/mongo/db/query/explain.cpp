@@ -344,6 +344,7 @@ namespace mongo {
         else if (STAGE_PROJECTION == stats.stageType) {
             ProjectionStats* spec = static_cast<ProjectionStats*>(stats.specific.get());
             bob->append("transformBy", spec->projObj);
+            bob->appendBool("covered", spec->covered);
         }
         else if (STAGE_SHARDING_FILTER == stats.stageType) {
             ShardingFilterStats* spec = static_cast<ShardingFilterStats*>(stats.specific.get());
@@ -363,6 +364,11 @@ namespace mongo {
             if (verbosity >= Explain::EXEC_STATS) {
                 bob->appendNumber("memUsage", spec->memUsage);
                 bob->appendNumber("memLimit", spec->memLimit);
+
+                if (spec->spills > 0) {
+                    bob->appendNumber("spills", spec->spills);
+                    bob->appendNumber("spilledBytes", spec->spilledBytes);
+                }
             }
 
             if (spec->limit > 0) {
@@ -213,7 +213,8 @@ namespace mongo {
                 // Might have to filter out orphaned docs.
                 if (plannerParams.options & QueryPlannerParams::INCLUDE_SHARD_FILTER) {
                     *rootOut =
-                        new ShardFilterStage(shardingState.getCollectionMetadata(collection->ns()),
+                        new ShardFilterStage(collection->ns().ns(),
+                                             shardingState.getCollectionMetadata(collection->ns()),
                                              ws, *rootOut);
                 }
 
@@ -451,7 +452,8 @@ namespace mongo {
 
         // Might have to filter out orphaned docs.
         if (plannerOptions & QueryPlannerParams::INCLUDE_SHARD_FILTER) {
-            root = new ShardFilterStage(shardingState.getCollectionMetadata(collection->ns()), ws,
+            root = new ShardFilterStage(collection->ns().ns(),
+                                        shardingState.getCollectionMetadata(collection->ns()), ws,
                                         root);
         }
 
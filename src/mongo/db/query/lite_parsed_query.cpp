@@ -221,7 +221,8 @@ namespace mongo {
     }
 
     LiteParsedQuery::LiteParsedQuery() : _wantMore(true), _explain(false), _snapshot(false),
-                                         _returnKey(false), _showDiskLoc(false), _maxScan(0),
+                                         _returnKey(false), _showDiskLoc(false),
+                                         _allowDiskUse(false), _maxScan(0),
                                          _maxTimeMS(0) { }
 
     Status LiteParsedQuery::init(const string& ns, int ntoskip, int ntoreturn, int queryOptions,
@@ -421,6 +422,10 @@ namespace mongo {
                         _proj = projBob.obj();
                     }
                 }
+                else if (str::equals("allowDiskUse", name)) {
+                    // Won't throw.
+                    _allowDiskUse = e.trueValue();
+                }
                 else if (str::equals("maxTimeMS", name)) {
                     StatusWith<int> maxTimeMS = parseMaxTimeMS(e);
                     if (!maxTimeMS.isOK()) {
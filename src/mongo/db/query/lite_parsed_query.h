@@ -144,6 +144,7 @@ namespace mongo {
         bool isSnapshot() const { return _snapshot; }
         bool returnKey() const { return _returnKey; }
         bool showDiskLoc() const { return _showDiskLoc; }
+        bool allowDiskUse() const { return _allowDiskUse; }
 
         const BSONObj& getMin() const { return _min; }
         const BSONObj& getMax() const { return _max; }
@@ -172,6 +173,7 @@ namespace mongo {
         bool _snapshot;
         bool _returnKey;
         bool _showDiskLoc;
+        bool _allowDiskUse;
         bool _hasReadPref;
         BSONObj _min;
         BSONObj _max;
@@ -242,8 +242,9 @@ namespace mongo {
         pp->_source = spec;
         pp->_returnKey = hasIndexKeyProjection;
 
-        // Dotted fields aren't covered, non-simple require match details, and as for include, "if
-        // we default to including then we can't use an index because we don't know what we're
+        // Dotted fields aren't covered, since an index key doesn't say whether any part of the
+        // path was an array, non-simple require match details, and as for include, "if we
+        // default to including then we can't use an index because we don't know what we're
         // missing."
         pp->_requiresDocument = include || hasNonSimple || hasDottedField;
 
@@ -136,6 +136,12 @@ namespace {
         ASSERT_EQUALS(fields[0], "a");
     }
 
+    // The index key doesn't say whether 'a' was an array, so the document has to be fetched.
+    TEST(ParsedProjectionTest, MakeDottedFieldNotCovered) {
+        auto_ptr<ParsedProjection> parsedProj(createParsedProjection("{}", "{_id: 0, 'a.b': 1}"));
+        ASSERT(parsedProj->requiresDocument());
+    }
+
     //
     // Positional operator validation
     //
@@ -35,6 +35,7 @@
 #include <algorithm>
 #include <math.h>
 #include <memory>
+#include "boost/functional/hash.hpp"
 #include "boost/thread/locks.hpp"
 #include "mongo/base/owned_pointer_vector.h"
 #include "mongo/client/dbclientinterface.h"   // For QueryOption_foobar
@@ -293,12 +294,46 @@ namespace mongo {
     // PlanCache
     //
 
-    PlanCache::PlanCache() : _cache(internalQueryCacheSize) { }
+    /**
+     * Locks a partition, counting the acquisitions that find it already locked.
+     */
+    class PlanCache::PartitionLock {
+        MONGO_DISALLOW_COPYING(PartitionLock);
+    public:
+        explicit PartitionLock(Partition& partition)
+            : _lock(partition.mutex, boost::try_to_lock) {
+            if (!_lock.owns_lock()) {
+                _lock.lock();
+                partition.stats.contended++;
+            }
+        }
+
+    private:
+        boost::unique_lock<boost::mutex> _lock;
+    };
 
-    PlanCache::PlanCache(const std::string& ns) : _cache(internalQueryCacheSize), _ns(ns) { }
+    PlanCache::PlanCache() {
+        _init();
+    }
+
+    PlanCache::PlanCache(const std::string& ns) : _ns(ns) {
+        _init();
+    }
 
     PlanCache::~PlanCache() { }
 
+    void PlanCache::_init() {
+        const size_t totalSize = std::max(internalQueryCacheSize, 1);
+        const size_t partitionSize = (totalSize + kNumPartitions - 1) / kNumPartitions;
+        for (size_t i = 0; i < kNumPartitions; ++i) {
+            _partitions.push_back(boost::make_shared<Partition>(partitionSize));
+        }
+    }
+
+    PlanCache::Partition& PlanCache::_partitionFor(const PlanCacheKey& key) const {
+        return *_partitions[boost::hash<PlanCacheKey>()(key) % kNumPartitions];
+    }
+
     Status PlanCache::add(const CanonicalQuery& query,
                           const std::vector<QuerySolution*>& solns,
                           PlanRankingDecision* why) {
@@ -340,13 +375,21 @@ namespace mongo {
             }
         }
 
-        boost::lock_guard<boost::mutex> cacheLock(_cacheMutex);
-        std::auto_ptr<PlanCacheEntry> evictedEntry = _cache.add(query.getPlanCacheKey(), entry);
+        const PlanCacheKey& key = query.getPlanCacheKey();
+        Partition& partition = _partitionFor(key);
+        std::auto_ptr<boost::shared_ptr<PlanCacheEntry> > evictedEntry;
+        {
+            PartitionLock lock(partition);
+            evictedEntry = partition.cache.add(key, new boost::shared_ptr<PlanCacheEntry>(entry));
+            if (NULL != evictedEntry.get()) {
+                partition.stats.evictions++;
+            }
+        }
 
         if (NULL != evictedEntry.get()) {
             LOG(1) << _ns << ": plan cache maximum size exceeded - "
                    << "removed least recently used entry "
-                   << evictedEntry->toString();
+                   << (*evictedEntry)->toString();
         }
 
         return Status::OK();
@@ -356,14 +399,23 @@ namespace mongo {
         const PlanCacheKey& key = query.getPlanCacheKey();
         verify(crOut);
 
-        boost::lock_guard<boost::mutex> cacheLock(_cacheMutex);
-        PlanCacheEntry* entry;
-        Status cacheStatus = _cache.get(key, &entry);
-        if (!cacheStatus.isOK()) {
-            return cacheStatus;
+        Partition& partition = _partitionFor(key);
+        boost::shared_ptr<PlanCacheEntry> entry;
+        {
+            PartitionLock lock(partition);
+            boost::shared_ptr<PlanCacheEntry>* found;
+            Status cacheStatus = partition.cache.get(key, &found);
+            if (!cacheStatus.isOK()) {
+                partition.stats.misses++;
+                return cacheStatus;
+            }
+            partition.stats.hits++;
+            entry = *found;
         }
         invariant(entry);
 
+        // The planner data copied here is never modified once the entry is in the cache, and
+        // 'entry' keeps it alive if the entry is evicted meanwhile.
         *crOut = new CachedSolution(key, *entry);
 
         return Status::OK();
@@ -427,12 +479,14 @@ namespace mongo {
         std::auto_ptr<PlanCacheEntryFeedback> autoFeedback(feedback);
         const PlanCacheKey& ck = cq.getPlanCacheKey();
 
-        boost::lock_guard<boost::mutex> cacheLock(_cacheMutex);
-        PlanCacheEntry* entry;
-        Status cacheStatus = _cache.get(ck, &entry);
+        Partition& partition = _partitionFor(ck);
+        PartitionLock lock(partition);
+        boost::shared_ptr<PlanCacheEntry>* found;
+        Status cacheStatus = partition.cache.get(ck, &found);
         if (!cacheStatus.isOK()) {
             return cacheStatus;
         }
+        PlanCacheEntry* entry = found->get();
         invariant(entry);
 
         if (entry->feedback.size() >= size_t(internalQueryCacheFeedbacksStored)) {
@@ -441,7 +495,7 @@ namespace mongo {
             if (hasCachedPlanPerformanceDegraded(entry, autoFeedback.get())) {
                 LOG(1) << _ns << ": removing plan cache entry " << entry->toString()
                        << " - detected degradation in performance of cached solution.";
-                _cache.remove(ck);
+                partition.cache.remove(ck);
             }
         }
         else {
@@ -453,13 +507,17 @@ namespace mongo {
     }
 
     Status PlanCache::remove(const CanonicalQuery& canonicalQuery) {
-        boost::lock_guard<boost::mutex> cacheLock(_cacheMutex);
-        return _cache.remove(canonicalQuery.getPlanCacheKey());
+        const PlanCacheKey& key = canonicalQuery.getPlanCacheKey();
+        Partition& partition = _partitionFor(key);
+        PartitionLock lock(partition);
+        return partition.cache.remove(key);
     }
 
     void PlanCache::clear() {
-        boost::lock_guard<boost::mutex> cacheLock(_cacheMutex);
-        _cache.clear();
+        for (size_t i = 0; i < _partitions.size(); ++i) {
+            PartitionLock lock(*_partitions[i]);
+            _partitions[i]->cache.clear();
+        }
         _writeOperations.store(0);
     }
 
@@ -467,39 +525,61 @@ namespace mongo {
         const PlanCacheKey& key = query.getPlanCacheKey();
         verify(entryOut);
 
-        boost::lock_guard<boost::mutex> cacheLock(_cacheMutex);
-        PlanCacheEntry* entry;
-        Status cacheStatus = _cache.get(key, &entry);
+        // The copy includes the feedback, which is modified under the lock.
+        Partition& partition = _partitionFor(key);
+        PartitionLock lock(partition);
+        boost::shared_ptr<PlanCacheEntry>* found;
+        Status cacheStatus = partition.cache.get(key, &found);
         if (!cacheStatus.isOK()) {
             return cacheStatus;
         }
-        invariant(entry);
+        invariant(*found);
 
-        *entryOut = entry->clone();
+        *entryOut = (*found)->clone();
 
         return Status::OK();
     }
 
     std::vector<PlanCacheEntry*> PlanCache::getAllEntries() const {
-        boost::lock_guard<boost::mutex> cacheLock(_cacheMutex);
         std::vector<PlanCacheEntry*> entries;
-        typedef std::list< std::pair<PlanCacheKey, PlanCacheEntry*> >::const_iterator ConstIterator;
-        for (ConstIterator i = _cache.begin(); i != _cache.end(); i++) {
-            PlanCacheEntry* entry = i->second;
-            entries.push_back(entry->clone());
+        for (size_t i = 0; i < _partitions.size(); ++i) {
+            PartitionLock lock(*_partitions[i]);
+            const EntryCache& cache = _partitions[i]->cache;
+            for (EntryCache::KVListConstIt it = cache.begin(); it != cache.end(); it++) {
+                entries.push_back((*it->second)->clone());
+            }
         }
 
         return entries;
     }
 
     bool PlanCache::contains(const CanonicalQuery& cq) const {
-        boost::lock_guard<boost::mutex> cacheLock(_cacheMutex);
-        return _cache.hasKey(cq.getPlanCacheKey());
+        const PlanCacheKey& key = cq.getPlanCacheKey();
+        Partition& partition = _partitionFor(key);
+        PartitionLock lock(partition);
+        return partition.cache.hasKey(key);
     }
 
     size_t PlanCache::size() const {
-        boost::lock_guard<boost::mutex> cacheLock(_cacheMutex);
-        return _cache.size();
+        size_t total = 0;
+        for (size_t i = 0; i < _partitions.size(); ++i) {
+            PartitionLock lock(*_partitions[i]);
+            total += _partitions[i]->cache.size();
+        }
+        return total;
+    }
+
+    PlanCache::Stats PlanCache::getStats() const {
+        Stats total;
+        for (size_t i = 0; i < _partitions.size(); ++i) {
+            boost::lock_guard<boost::mutex> lock(_partitions[i]->mutex);
+            const Stats& stats = _partitions[i]->stats;
+            total.hits += stats.hits;
+            total.misses += stats.misses;
+            total.evictions += stats.evictions;
+            total.contended += stats.contended;
+        }
+        return total;
     }
 
     void PlanCache::notifyOfWriteOp() {
@@ -30,6 +30,7 @@
 
 #include <set>
 #include <boost/optional/optional.hpp>
+#include <boost/shared_ptr.hpp>
 #include <boost/thread/mutex.hpp>
 
 #include "mongo/db/exec/plan_stats.h"
@@ -273,11 +274,27 @@ namespace mongo {
      * mapping, the cache contains information on why that mapping was made and statistics on the
      * cache entry's actual performance on subsequent runs.
      *
+     * The cache is split into partitions by hashing the cache key, each with its own lock and
+     * LRU list, so that lookups of different query shapes do not contend.  A lookup only holds
+     * the partition lock while it finds the entry; the copy returned to the caller is made
+     * afterwards.
      */
     class PlanCache {
     private:
         MONGO_DISALLOW_COPYING(PlanCache);
     public:
+        /**
+         * Counters reported by planCacheListQueryShapes.
+         */
+        struct Stats {
+            Stats() : hits(0), misses(0), evictions(0), contended(0) {}
+
+            long long hits;         // get() calls that found an entry
+            long long misses;       // get() calls that did not
+            long long evictions;    // entries pushed out by the LRU policy
+            long long contended;    // lock acquisitions that had to wait for another thread
+        };
+
         /**
          * We don't want to cache every possible query. This function
          * encapsulates the criteria for what makes a canonical query
@@ -380,6 +397,11 @@ namespace mongo {
          */
         size_t size() const;
 
+        /**
+         * Returns the counters summed over all partitions.  Not an atomic snapshot.
+         */
+        Stats getStats() const;
+
         /**
          *  You must notify the cache if you are doing writes, as query plan utility will change.
          *  Cache is flushed after every 1000 notifications.
@@ -387,20 +409,28 @@ namespace mongo {
         void notifyOfWriteOp();
 
     private:
+        class PartitionLock;
 
-        /**
-         * Releases resources associated with each cache entry
-         * and clears map.
-         * Invoked by clear() and during destruction.
-         */
-        void _clear();
+        static const size_t kNumPartitions = 16;
 
-        LRUKeyValue<PlanCacheKey, PlanCacheEntry> _cache;
+        // Entries are shared with lookups in progress so they can be copied outside the lock.
+        typedef LRUKeyValue<PlanCacheKey, boost::shared_ptr<PlanCacheEntry> > EntryCache;
 
-        /**
-         * Protects _cache.
-         */
-        mutable boost::mutex _cacheMutex;
+        struct Partition {
+            explicit Partition(size_t maxSize) : cache(maxSize) {}
+
+            // Protects the fields below.
+            boost::mutex mutex;
+            EntryCache cache;
+            Stats stats;
+        };
+
+        Partition& _partitionFor(const PlanCacheKey& key) const;
+
+        void _init();
+
+        // Each holds 1/kNumPartitions of internalQueryCacheSize entries.
+        std::vector<boost::shared_ptr<Partition> > _partitions;
 
         /**
          * Counter for write notifications since initialization or last clear() invocation.
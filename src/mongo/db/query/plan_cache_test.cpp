@@ -35,6 +35,7 @@
 #include <algorithm>
 #include <ostream>
 #include <memory>
+#include "mongo/base/owned_pointer_vector.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/json.h"
 #include "mongo/db/query/qlog.h"
@@ -418,6 +419,72 @@ namespace {
         ASSERT_EQUALS(planCache.size(), 1U);
     }
 
+    TEST(PlanCacheTest, Stats) {
+        PlanCache planCache;
+        auto_ptr<CanonicalQuery> cq(canonicalize("{a: 1}"));
+        QuerySolution qs;
+        qs.cacheData.reset(new SolutionCacheData());
+        qs.cacheData->tree.reset(new PlanCacheIndexTree());
+        std::vector<QuerySolution*> solns;
+        solns.push_back(&qs);
+
+        CachedSolution* rawCs;
+        ASSERT_NOT_OK(planCache.get(*cq, &rawCs));
+        ASSERT_OK(planCache.add(*cq, solns, createDecision(1U)));
+        ASSERT_OK(planCache.get(*cq, &rawCs));
+        delete rawCs;
+        ASSERT_OK(planCache.get(*cq, &rawCs));
+        delete rawCs;
+
+        PlanCache::Stats stats = planCache.getStats();
+        ASSERT_EQUALS(stats.hits, 2);
+        ASSERT_EQUALS(stats.misses, 1);
+        ASSERT_EQUALS(stats.evictions, 0);
+
+        // Counters survive clearing the cache.
+        planCache.clear();
+        ASSERT_NOT_OK(planCache.get(*cq, &rawCs));
+        stats = planCache.getStats();
+        ASSERT_EQUALS(stats.hits, 2);
+        ASSERT_EQUALS(stats.misses, 2);
+    }
+
+    // Shapes are spread over several partitions; the cache as a whole must still see all of them.
+    TEST(PlanCacheTest, ManyShapes) {
+        PlanCache planCache;
+        QuerySolution qs;
+        qs.cacheData.reset(new SolutionCacheData());
+        qs.cacheData->tree.reset(new PlanCacheIndexTree());
+        std::vector<QuerySolution*> solns;
+        solns.push_back(&qs);
+
+        const size_t numShapes = 100;
+        OwnedPointerVector<CanonicalQuery> queries;
+        for (size_t i = 0; i < numShapes; ++i) {
+            BSONObjBuilder bob;
+            bob.append(std::string(mongoutils::str::stream() << "a" << i), 1);
+            queries.push_back(canonicalize(bob.obj()));
+            ASSERT_OK(planCache.add(*queries[i], solns, createDecision(1U)));
+        }
+        ASSERT_EQUALS(planCache.size(), numShapes);
+
+        std::vector<PlanCacheEntry*> entries = planCache.getAllEntries();
+        ASSERT_EQUALS(entries.size(), numShapes);
+        for (size_t i = 0; i < entries.size(); ++i) {
+            delete entries[i];
+        }
+
+        for (size_t i = 0; i < numShapes; ++i) {
+            ASSERT_TRUE(planCache.contains(*queries[i]));
+        }
+        ASSERT_OK(planCache.remove(*queries[0]));
+        ASSERT_FALSE(planCache.contains(*queries[0]));
+        ASSERT_EQUALS(planCache.size(), numShapes - 1);
+
+        planCache.clear();
+        ASSERT_EQUALS(planCache.size(), 0U);
+    }
+
     /**
      * Each test in the CachePlanSelectionTest suite goes through
      * the following flow:
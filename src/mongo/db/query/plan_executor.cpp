@@ -33,6 +33,7 @@
 #include "mongo/db/exec/plan_stats.h"
 #include "mongo/db/exec/working_set.h"
 #include "mongo/db/exec/working_set_common.h"
+#include "mongo/db/query/query_knobs.h"
 
 namespace mongo {
 
@@ -42,7 +43,9 @@ namespace mongo {
           _workingSet(ws),
           _qs(NULL),
           _root(rt),
-          _killed(false) {
+          _killed(false),
+          _batchEndState(PlanStage::NEED_TIME),
+          _batchFailureId(WorkingSet::INVALID_ID) {
         initNs();
     }
 
@@ -53,7 +56,9 @@ namespace mongo {
           _qs(NULL),
           _root(rt),
           _ns(ns),
-          _killed(false) { }
+          _killed(false),
+          _batchEndState(PlanStage::NEED_TIME),
+          _batchFailureId(WorkingSet::INVALID_ID) { }
 
     PlanExecutor::PlanExecutor(WorkingSet* ws, PlanStage* rt, CanonicalQuery* cq,
                                const Collection* collection)
@@ -62,7 +67,9 @@ namespace mongo {
           _workingSet(ws),
           _qs(NULL),
           _root(rt),
-          _killed(false) {
+          _killed(false),
+          _batchEndState(PlanStage::NEED_TIME),
+          _batchFailureId(WorkingSet::INVALID_ID) {
         initNs();
     }
 
@@ -73,7 +80,9 @@ namespace mongo {
           _workingSet(ws),
           _qs(qs),
           _root(rt),
-          _killed(false) {
+          _killed(false),
+          _batchEndState(PlanStage::NEED_TIME),
+          _batchFailureId(WorkingSet::INVALID_ID) {
         initNs();
     }
 
@@ -121,7 +130,18 @@ namespace mongo {
     }
 
     void PlanExecutor::invalidate(const DiskLoc& dl, InvalidationType type) {
-        if (!_killed) { _root->invalidate(dl, type); }
+        if (_killed) { return; }
+
+        _root->invalidate(dl, type);
+
+        // Like any stage holding results, keep the buffered ones in play by fetching them.
+        for (std::deque<WorkingSetID>::const_iterator it = _batchedResults.begin();
+             it != _batchedResults.end(); ++it) {
+            WorkingSetMember* member = _workingSet->get(*it);
+            if (member->hasLoc() && member->loc == dl) {
+                WorkingSetCommon::fetchAndInvalidateLoc(member, _collection);
+            }
+        }
     }
 
     PlanExecutor::ExecState PlanExecutor::getNext(BSONObj* objOut, DiskLoc* dlOut) {
@@ -129,7 +149,7 @@ namespace mongo {
 
         for (;;) {
             WorkingSetID id = WorkingSet::INVALID_ID;
-            PlanStage::StageState code = _root->work(&id);
+            PlanStage::StageState code = workRoot(&id);
 
             if (PlanStage::ADVANCED == code) {
                 // Fast count.
@@ -196,8 +216,52 @@ namespace mongo {
         }
     }
 
+    PlanStage::StageState PlanExecutor::workRoot(WorkingSetID* out) {
+        if (!_batchedResults.empty()) {
+            *out = _batchedResults.front();
+            _batchedResults.pop_front();
+            return PlanStage::ADVANCED;
+        }
+
+        if (PlanStage::NEED_TIME != _batchEndState) {
+            // The last batch ended the plan; now that its results are used up, say how.
+            PlanStage::StageState code = _batchEndState;
+            *out = _batchFailureId;
+            _batchEndState = PlanStage::NEED_TIME;
+            _batchFailureId = WorkingSet::INVALID_ID;
+            return code;
+        }
+
+        const int batchWorks = internalQueryExecBatchWorks;
+        if (batchWorks <= 1) {
+            return _root->work(out);
+        }
+
+        _batch.clear();
+        PlanStage::StageState code = _root->workBatch(batchWorks, &_batch);
+        if (PlanStage::FAILURE == code) {
+            _batchFailureId = _batch.back();
+            _batch.pop_back();
+        }
+        if (PlanStage::ADVANCED != code && PlanStage::NEED_TIME != code) {
+            _batchEndState = code;
+        }
+        _batchedResults.insert(_batchedResults.end(), _batch.begin(), _batch.end());
+
+        // Our caller comes straight back for the first result, or the end state.
+        return PlanStage::NEED_TIME;
+    }
+
     bool PlanExecutor::isEOF() {
-        return _killed || _root->isEOF();
+        if (_killed) {
+            return true;
+        }
+        if (!_batchedResults.empty() ||
+            PlanStage::DEAD == _batchEndState ||
+            PlanStage::FAILURE == _batchEndState) {
+            return false;
+        }
+        return _root->isEOF();
     }
 
     void PlanExecutor::registerExecInternalPlan() {
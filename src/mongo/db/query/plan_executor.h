@@ -29,8 +29,11 @@
 #pragma once
 
 #include <boost/scoped_ptr.hpp>
+#include <deque>
+#include <vector>
 
 #include "mongo/base/status.h"
+#include "mongo/db/exec/plan_stage.h"
 #include "mongo/db/invalidation_type.h"
 #include "mongo/db/query/query_solution.h"
 
@@ -236,6 +239,12 @@ namespace mongo {
          */
         void initNs();
 
+        /**
+         * Returns the next result of the root stage, as work() would.  When batching is enabled
+         * by internalQueryExecBatchWorks, results come from a buffer filled by workBatch().
+         */
+        PlanStage::StageState workRoot(WorkingSetID* out);
+
         // Collection over which this plan executor runs. Used to resolve record ids retrieved by
         // the plan stages. The collection must not be destroyed while there are active plans.
         const Collection* _collection;
@@ -253,6 +262,18 @@ namespace mongo {
         // Did somebody drop an index we care about or the namespace we're looking at?  If so,
         // we'll be killed.
         bool _killed;
+
+        // Results of the last PlanStage::workBatch() call not yet returned by getNext().  These
+        // are ours, so we must handle invalidations for them.
+        std::deque<WorkingSetID> _batchedResults;
+
+        // If the last batch ended with IS_EOF, DEAD or FAILURE, that state (and for FAILURE the
+        // failure id) to report once _batchedResults has been used up.  Otherwise NEED_TIME.
+        PlanStage::StageState _batchEndState;
+        WorkingSetID _batchFailureId;
+
+        // Scratch space for workBatch(), kept to avoid reallocating it for every batch.
+        std::vector<WorkingSetID> _batch;
     };
 
 }  // namespace mongo
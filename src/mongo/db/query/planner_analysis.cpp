@@ -28,6 +28,7 @@
 
 #include "mongo/db/query/planner_analysis.h"
 
+#include <algorithm>
 #include <vector>
 
 #include "mongo/db/jsobj.h"
@@ -232,6 +233,65 @@ namespace mongo {
             }
         }
 
+        /**
+         * Returns a covered projection of the index keys of 'solnRoot', if the results of
+         * 'query' can be projected straight from those keys before they are sorted by 'sortObj'.
+         * Otherwise returns NULL, and the caller has to fetch before sorting.
+         *
+         * The index scan must be the only stage and must not be multikey, so each result's key
+         * holds the same values as its document.  Every field of the sort must also be in the
+         * projection, so the sort can use the projected values.
+         */
+        ProjectionNode* coveredProjectionForSort(const CanonicalQuery& query,
+                                                 const QueryPlannerParams& params,
+                                                 const BSONObj& sortObj,
+                                                 QuerySolutionNode* solnRoot) {
+            const ParsedProjection* proj = query.getProj();
+            if (NULL == proj || proj->requiresDocument() || proj->wantIndexKey()) {
+                return NULL;
+            }
+
+            // The results of the projection have no DiskLoc, which the OR of the split limited
+            // sort needs to dedup them.
+            if (0 != query.getParsed().getNumToReturn()
+                && (params.options & QueryPlannerParams::SPLIT_LIMITED_SORT)) {
+                return NULL;
+            }
+
+            if (STAGE_IXSCAN != solnRoot->getType()) {
+                return NULL;
+            }
+
+            // The projection's fields are simple top-level fields, and hasField() is false for
+            // all fields of a multikey index.
+            const vector<string>& fields = proj->getRequiredFields();
+            for (size_t i = 0; i < fields.size(); ++i) {
+                if (!solnRoot->hasField(fields[i])) {
+                    return NULL;
+                }
+            }
+
+            BSONObjIterator it(sortObj);
+            while (it.more()) {
+                BSONElement elt = it.next();
+                // $meta sorts need data from the stage below the sort.
+                if (!elt.isNumber()) {
+                    return NULL;
+                }
+                if (fields.end() == std::find(fields.begin(), fields.end(), elt.fieldName())) {
+                    return NULL;
+                }
+            }
+
+            ProjectionNode* projNode = new ProjectionNode();
+            projNode->children.push_back(solnRoot);
+            projNode->fullExpression = query.root();
+            projNode->projection = query.getParsed().getProj();
+            projNode->projType = ProjectionNode::COVERED_ONE_INDEX;
+            projNode->coveredKeyObj = static_cast<IndexScanNode*>(solnRoot)->indexKeyPattern;
+            return projNode;
+        }
+
         bool hasNode(QuerySolutionNode* root, StageType type) {
             if (type == root->getType()) {
                 return true;
@@ -418,10 +478,14 @@ namespace mongo {
             return NULL;
         }
 
-        // Add a fetch stage so we have the full object when we hit the sort stage.  TODO: Can we
-        // pull the values that we sort by out of the key and if so in what cases?  Perhaps we can
-        // avoid a fetch.
-        if (!solnRoot->fetched()) {
+        // The sort stage needs an object to sort.  If the index key holds every field the
+        // projection and sort need, project it before sorting, otherwise fetch the full object.
+        ProjectionNode* coveredProj = coveredProjectionForSort(query, params, sortObj, solnRoot);
+        if (NULL != coveredProj) {
+            QLOG() << "Projecting covered index keys before the blocking sort" << endl;
+            solnRoot = coveredProj;
+        }
+        else if (!solnRoot->fetched()) {
             FetchNode* fetch = new FetchNode();
             fetch->children.push_back(solnRoot);
             solnRoot = fetch;
@@ -431,6 +495,7 @@ namespace mongo {
         SortNode* sort = new SortNode();
         sort->pattern = sortObj;
         sort->query = query.getParsed().getFilter();
+        sort->allowDiskUse = query.getParsed().allowDiskUse();
         sort->children.push_back(solnRoot);
         solnRoot = sort;
         // When setting the limit on the sort, we need to consider both
@@ -570,8 +635,8 @@ namespace mongo {
             }
         }
 
-        // Project the results.
-        if (NULL != query.getProj()) {
+        // Project the results, unless that was done before a blocking sort.
+        if (NULL != query.getProj() && !hasNode(solnRoot, STAGE_PROJECTION)) {
             QLOG() << "PROJECTION: fetched status: " << solnRoot->fetched() << endl;
             QLOG() << "PROJECTION: Current plan is:\n" << solnRoot->toString() << endl;
 
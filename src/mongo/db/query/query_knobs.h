@@ -69,6 +69,11 @@ namespace mongo {
     // How many write ops should we allow in a collection before tossing all cache entries?
     extern int internalQueryCacheWriteOpsBetweenFlush;
 
+    // Do we remember how queries of each shape normalize, so that later queries of the same
+    // shape skip sorting and re-encoding their trees in CanonicalQuery?  Off by default, since
+    // the lookup costs an extra encoding of the tree for every query.
+    extern bool internalQueryCacheShapeTemplates;
+
     //
     // Planning and enumeration.
     //
@@ -89,4 +94,13 @@ namespace mongo {
     // during explodeForSort?
     extern int internalQueryMaxScansToExplode;
 
+    //
+    // Query execution.
+    //
+
+    // How many units of work does PlanExecutor::getNext ask of the root stage at a time?  Above
+    // 1, results are passed up the stage tree in batches (see PlanStage::workBatch), which saves
+    // per-result overhead in long scans but does up to this much work ahead of the caller.
+    extern int internalQueryExecBatchWorks;
+
 }  // namespace mongo
@@ -1165,6 +1165,9 @@ namespace {
                                 "{cscan: {dir: 1, filter: {x:{$gt:1}}}}}}");
     }
 
+    // Even a non-multikey index can't cover a dotted field.  A one-element array on the path
+    // generates a single key, so the index isn't marked multikey, but the key doesn't tell
+    // {a: {b: 5}} from {a: [{b: 5}]} apart.
     TEST_F(QueryPlannerTest, DottedFieldCovering) {
         addIndex(BSON("a.b" << 1));
         runQuerySortProj(fromjson("{'a.b': 5}"), BSONObj(), fromjson("{_id: 0, 'a.b': 1}"));
@@ -1172,8 +1175,19 @@ namespace {
         ASSERT_EQUALS(getNumSolutions(), 2U);
         assertSolutionExists("{proj: {spec: {_id: 0, 'a.b': 1}, node: "
                                 "{cscan: {dir: 1, filter: {'a.b': 5}}}}}");
-        // SERVER-2104
-        //assertSolutionExists("{proj: {spec: {_id: 0, 'a.b': 1}, node: {'a.b': 1}}}");
+        assertSolutionExists("{proj: {spec: {_id: 0, 'a.b': 1}, node: {fetch: {filter: null, "
+                                "node: {ixscan: {filter: null, pattern: {'a.b': 1}}}}}}}");
+    }
+
+    TEST_F(QueryPlannerTest, DottedFieldsCoveringCompound) {
+        addIndex(BSON("a.b" << 1 << "a.c" << 1 << "d" << 1));
+        runQuerySortProj(fromjson("{'a.b': 5}"), BSONObj(),
+                         fromjson("{_id: 0, 'a.c': 1, d: 1, 'a.b': 1}"));
+
+        ASSERT_EQUALS(getNumSolutions(), 2U);
+        assertSolutionExists("{proj: {spec: {_id: 0, 'a.c': 1, d: 1, 'a.b': 1}, node: "
+                                "{fetch: {filter: null, node: {ixscan: {filter: null, "
+                                "pattern: {'a.b': 1, 'a.c': 1, d: 1}}}}}}}");
     }
 
     TEST_F(QueryPlannerTest, IdCovering) {
@@ -1197,6 +1211,69 @@ namespace {
                                 "{ixscan: {filter: null, pattern: {x: 1}}}}}}}");
     }
 
+    // A blocking sort by fields of a covering index sorts the projected index keys instead of
+    // fetching the documents.
+    TEST_F(QueryPlannerTest, CoveredBlockingSort) {
+        addIndex(BSON("a" << 1 << "b" << 1));
+        runQuerySortProj(fromjson("{a: {$gt: 1}}"), fromjson("{b: 1}"),
+                         fromjson("{_id: 0, a: 1, b: 1}"));
+
+        ASSERT_EQUALS(getNumSolutions(), 2U);
+        assertSolutionExists("{sort: {pattern: {b: 1}, limit: 0, node: "
+                                "{proj: {spec: {_id: 0, a: 1, b: 1}, node: "
+                                "{ixscan: {filter: null, pattern: {a: 1, b: 1}}}}}}}");
+        assertSolutionExists("{proj: {spec: {_id: 0, a: 1, b: 1}, node: "
+                                "{sort: {pattern: {b: 1}, limit: 0, node: "
+                                "{cscan: {dir: 1, filter: {a: {$gt: 1}}}}}}}}");
+    }
+
+    TEST_F(QueryPlannerTest, CoveredBlockingSortCompound) {
+        addIndex(BSON("a" << 1 << "b" << 1 << "c" << 1));
+        runQuerySortProj(fromjson("{a: 1}"), fromjson("{c: -1, b: 1}"),
+                         fromjson("{_id: 0, c: 1, b: 1}"));
+
+        assertSolutionExists("{sort: {pattern: {c: -1, b: 1}, limit: 0, node: "
+                                "{proj: {spec: {_id: 0, c: 1, b: 1}, node: "
+                                "{ixscan: {filter: null, pattern: {a: 1, b: 1, c: 1}}}}}}}");
+    }
+
+    // The key of a multikey index holds a single array element, not the value to sort by.
+    TEST_F(QueryPlannerTest, MultikeyBlockingSortNotCovered) {
+        // true means multikey
+        addIndex(BSON("a" << 1 << "b" << 1), true);
+        runQuerySortProj(fromjson("{a: {$gt: 1}}"), fromjson("{b: 1}"),
+                         fromjson("{_id: 0, a: 1, b: 1}"));
+
+        assertSolutionExists("{proj: {spec: {_id: 0, a: 1, b: 1}, node: "
+                                "{sort: {pattern: {b: 1}, limit: 0, node: {fetch: {filter: null, "
+                                "node: {ixscan: {filter: null, pattern: {a: 1, b: 1}}}}}}}}}");
+    }
+
+    // The sort needs every field it sorts by in the projected object.
+    TEST_F(QueryPlannerTest, BlockingSortByUnprojectedFieldNotCovered) {
+        addIndex(BSON("a" << 1 << "b" << 1));
+        runQuerySortProj(fromjson("{a: {$gt: 1}}"), fromjson("{b: 1}"),
+                         fromjson("{_id: 0, a: 1}"));
+
+        assertSolutionExists("{proj: {spec: {_id: 0, a: 1}, node: "
+                                "{sort: {pattern: {b: 1}, limit: 0, node: {fetch: {filter: null, "
+                                "node: {ixscan: {filter: null, pattern: {a: 1, b: 1}}}}}}}}}");
+    }
+
+    // The OR of a split limited sort dedups by DiskLoc, which projected keys don't have.
+    TEST_F(QueryPlannerTest, SplitLimitedBlockingSortNotCovered) {
+        params.options |= QueryPlannerParams::SPLIT_LIMITED_SORT;
+        addIndex(BSON("a" << 1 << "b" << 1));
+        runQuerySortProjSkipLimit(fromjson("{a: {$gt: 1}}"), fromjson("{b: 1}"),
+                                  fromjson("{_id: 0, a: 1, b: 1}"), 0, 3);
+
+        assertSolutionExists("{proj: {spec: {_id: 0, a: 1, b: 1}, node: {or: {nodes: ["
+                                "{sort: {pattern: {b: 1}, limit: 3, node: {fetch: {node: "
+                                "{ixscan: {filter: null, pattern: {a: 1, b: 1}}}}}}}, "
+                                "{sort: {pattern: {b: 1}, limit: 0, node: {fetch: {node: "
+                                "{ixscan: {filter: null, pattern: {a: 1, b: 1}}}}}}}]}}}}");
+    }
+
     //
     // Basic sort
     //
@@ -107,6 +107,7 @@ namespace mongo {
             params.pattern = sn->pattern;
             params.query = sn->query;
             params.limit = sn->limit;
+            params.allowDiskUse = sn->allowDiskUse;
             return new SortStage(params, ws, childStage);
         }
         else if (STAGE_PROJECTION == root->getType()) {
@@ -116,6 +117,7 @@ namespace mongo {
 
             ProjectionStageParams params(WhereCallbackReal(txn, collection->ns().db()));
             params.projObj = pn->projection;
+            params.covered = !pn->children[0]->fetched();
 
             // Stuff the right data into the params depending on what proj impl we use.
             if (ProjectionNode::DEFAULT == pn->projType) {
@@ -272,7 +274,8 @@ namespace mongo {
             const ShardingFilterNode* fn = static_cast<const ShardingFilterNode*>(root);
             PlanStage* childStage = buildStages(txn, collection, qsol, fn->children[0], ws);
             if (NULL == childStage) { return NULL; }
-            return new ShardFilterStage(shardingState.getCollectionMetadata(collection->ns()),
+            return new ShardFilterStage(collection->ns().ns(),
+                                        shardingState.getCollectionMetadata(collection->ns()),
                                         ws, childStage);
         }
         else if (STAGE_KEEP_MUTATIONS == root->getType()) {
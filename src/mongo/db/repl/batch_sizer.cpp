@@ -0,0 +1,171 @@
+/**
+ *    Copyright (C) 2014 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/repl/batch_sizer.h"
+
+#include <algorithm>
+
+#include "mongo/util/assert_util.h"
+
+namespace mongo {
+namespace repl {
+
+    const double BatchSizer::kGrowFactor = 1.25;
+    const double BatchSizer::kShrinkFactor = 0.8;
+    const double BatchSizer::kThroughputTolerance = 0.05;
+    const double BatchSizer::kStalledIdleFraction = 0.75;
+
+    BatchSizer::BatchSizer(unsigned minOps, unsigned maxOps, unsigned initialOps) :
+        _minOps(minOps),
+        _maxOps(maxOps),
+        _initialOps(initialOps),
+        _opsLimit(initialOps),
+        _mutex("BatchSizer"),
+        _adaptive(true),
+        _lastThroughput(0),
+        _direction(1),
+        _grown(0),
+        _shrunk(0),
+        _shrunkForStall(0),
+        _writerBusyMicros(0),
+        _writerCapacityMicros(0) {
+        verify(minOps > 0 && minOps <= initialOps && initialOps <= maxOps);
+    }
+
+    unsigned BatchSizer::getOpsLimit() const {
+        return _opsLimit.load();
+    }
+
+    void BatchSizer::setAdaptive(bool adaptive) {
+        scoped_lock lk(_mutex);
+        _adaptive = adaptive;
+        _lastThroughput = 0;
+        _direction = 1;
+        _opsLimit.store(_initialOps);
+    }
+
+    bool BatchSizer::isAdaptive() const {
+        scoped_lock lk(_mutex);
+        return _adaptive;
+    }
+
+    void BatchSizer::_setLimit_inlock(double limit) {
+        limit = std::max(limit, static_cast<double>(_minOps));
+        limit = std::min(limit, static_cast<double>(_maxOps));
+        _opsLimit.store(static_cast<unsigned>(limit));
+    }
+
+    void BatchSizer::recordBatch(size_t ops,
+                                 size_t bytes,
+                                 long long applyMicros,
+                                 const std::vector<long long>& writerBusyMicros) {
+        _batchOps.record(ops);
+        _batchBytes.record(bytes);
+        _applyMicros.record(applyMicros);
+
+        long long busy = 0;
+        for (size_t i = 0; i < writerBusyMicros.size(); i++) {
+            busy += writerBusyMicros[i];
+        }
+        const long long capacity = applyMicros * writerBusyMicros.size();
+
+        scoped_lock lk(_mutex);
+        _writerBusyMicros += busy;
+        _writerCapacityMicros += capacity;
+
+        // Batches cut short by the time limit, the byte limit or an empty network queue say
+        // more about the primary's write rate than about what size applies fastest.
+        if (!_adaptive || ops < _opsLimit.load() || applyMicros <= 0)
+            return;
+
+        const double limit = _opsLimit.load();
+        const double idleFraction = capacity > 0 ? 1.0 - double(busy) / capacity : 0;
+        if (idleFraction > kStalledIdleFraction) {
+            // Most writers are waiting on the few that got the hot namespaces, and a bigger
+            // batch only makes them wait longer.
+            _setLimit_inlock(limit * kShrinkFactor);
+            _lastThroughput = 0;
+            _direction = -1;
+            _shrunkForStall++;
+            _shrunk++;
+            return;
+        }
+
+        const double throughput = ops * 1000000.0 / applyMicros;
+        if (_lastThroughput > 0 &&
+            throughput < _lastThroughput * (1.0 - kThroughputTolerance)) {
+            _direction = -_direction;
+        }
+        else if (_lastThroughput > 0 &&
+                 throughput < _lastThroughput * (1.0 + kThroughputTolerance)) {
+            // no measurable change; stay where we are
+            _lastThroughput = throughput;
+            return;
+        }
+        _lastThroughput = throughput;
+
+        if (_direction > 0) {
+            _setLimit_inlock(limit * kGrowFactor);
+            _grown++;
+        }
+        else {
+            _setLimit_inlock(limit * kShrinkFactor);
+            _shrunk++;
+        }
+    }
+
+    void BatchSizer::append(BSONObjBuilder& b) const {
+        {
+            scoped_lock lk(_mutex);
+            b.append("adaptive", _adaptive);
+            b.append("opsLimit", static_cast<long long>(_opsLimit.load()));
+            b.append("grown", _grown);
+            b.append("shrunk", _shrunk);
+            b.append("shrunkForStall", _shrunkForStall);
+            const double idle = _writerCapacityMicros > 0 ?
+                100.0 * (1.0 - double(_writerBusyMicros) / _writerCapacityMicros) : 0;
+            b.append("writerIdlePercent", idle);
+        }
+
+        BSONObjBuilder ops(b.subobjStart("batchOps"));
+        _batchOps.append(ops);
+        ops.doneFast();
+
+        BSONObjBuilder bytes(b.subobjStart("batchBytes"));
+        _batchBytes.append(bytes);
+        bytes.doneFast();
+
+        BSONObjBuilder micros(b.subobjStart("applyMicros"));
+        _applyMicros.append(micros);
+        micros.doneFast();
+    }
+
+} // namespace repl
+} // namespace mongo
@@ -0,0 +1,121 @@
+/**
+ *    Copyright (C) 2014 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <boost/noncopyable.hpp>
+#include <vector>
+
+#include "mongo/db/jsobj.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/util/concurrency/mutex.h"
+#include "mongo/util/histogram.h"
+
+namespace mongo {
+namespace repl {
+
+    /**
+     * Chooses the operation count limit for secondary apply batches.
+     *
+     * The sizer hill-climbs on apply throughput: after every batch that was cut by the
+     * operation limit it compares ops/second with the previous such batch and keeps moving
+     * the limit in the same direction while throughput improves, reversing when it gets
+     * worse.  When the writer pool is mostly idle during a batch, i.e. a few writers are
+     * serialised on a hot collection while the rest wait, the limit is shrunk regardless.
+     *
+     * recordBatch() must only be called from the sync thread; getOpsLimit() and append() may
+     * be called from any thread.
+     */
+    class BatchSizer : boost::noncopyable {
+    public:
+        /**
+         * @param minOps, maxOps bounds on the limit
+         * @param initialOps the starting limit, and the fixed limit while adaptation is off
+         */
+        BatchSizer(unsigned minOps, unsigned maxOps, unsigned initialOps);
+
+        /** @return the operation count at which the next batch should be cut */
+        unsigned getOpsLimit() const;
+
+        /**
+         * Feeds back the result of applying one batch.
+         *
+         * @param ops number of operations in the batch
+         * @param bytes total BSON size of the batch
+         * @param applyMicros wall time the writer pool spent on the batch
+         * @param writerBusyMicros time each writer thread spent applying, one entry per writer
+         *                         in the pool including the ones that got no work
+         */
+        void recordBatch(size_t ops,
+                         size_t bytes,
+                         long long applyMicros,
+                         const std::vector<long long>& writerBusyMicros);
+
+        /** Turning adaptation off resets the limit to its initial value. */
+        void setAdaptive(bool adaptive);
+        bool isAdaptive() const;
+
+        void append(BSONObjBuilder& b) const;
+
+        // Multiplicative step applied to the limit on each adjustment.
+        static const double kGrowFactor;
+        static const double kShrinkFactor;
+
+        // Throughput changes smaller than this fraction are treated as noise.
+        static const double kThroughputTolerance;
+
+        // Writer pool idle fraction above which the limit is shrunk.
+        static const double kStalledIdleFraction;
+
+    private:
+        void _setLimit_inlock(double limit);
+
+        const unsigned _minOps;
+        const unsigned _maxOps;
+        const unsigned _initialOps;
+
+        AtomicUInt32 _opsLimit;
+
+        // protects the fields below
+        mutable mongo::mutex _mutex;
+        bool _adaptive;
+        double _lastThroughput;     // ops/sec of the last limit-bound batch, 0 if none yet
+        int _direction;             // +1 growing, -1 shrinking
+        long long _grown;
+        long long _shrunk;
+        long long _shrunkForStall;
+        long long _writerBusyMicros;
+        long long _writerCapacityMicros;
+
+        Histogram _batchOps;
+        Histogram _batchBytes;
+        Histogram _applyMicros;
+    };
+
+} // namespace repl
+} // namespace mongo
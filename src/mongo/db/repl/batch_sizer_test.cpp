@@ -0,0 +1,145 @@
+/**
+ *    Copyright (C) 2014 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include <vector>
+
+#include "mongo/db/jsobj.h"
+#include "mongo/db/repl/batch_sizer.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace repl {
+namespace {
+
+    // Every writer busy for the whole batch.
+    std::vector<long long> busyWriters(long long applyMicros) {
+        return std::vector<long long>(4, applyMicros);
+    }
+
+    TEST(BatchSizer, StartsAtInitialLimit) {
+        BatchSizer sizer(100, 50000, 5000);
+        ASSERT_EQUALS(5000U, sizer.getOpsLimit());
+        ASSERT_TRUE(sizer.isAdaptive());
+    }
+
+    TEST(BatchSizer, GrowsWhileThroughputImproves) {
+        BatchSizer sizer(100, 50000, 5000);
+        sizer.recordBatch(5001, 1000, 100000, busyWriters(100000));
+        const unsigned first = sizer.getOpsLimit();
+        ASSERT_GREATER_THAN(first, 5000U);
+
+        // more ops in the same time
+        sizer.recordBatch(first + 1, 1000, 100000, busyWriters(100000));
+        ASSERT_GREATER_THAN(sizer.getOpsLimit(), first);
+    }
+
+    TEST(BatchSizer, ReversesWhenThroughputDrops) {
+        BatchSizer sizer(100, 50000, 5000);
+        sizer.recordBatch(5001, 1000, 100000, busyWriters(100000));
+        const unsigned grown = sizer.getOpsLimit();
+
+        // more ops, but ten times longer to apply them
+        sizer.recordBatch(grown + 1, 1000, 1000000, busyWriters(1000000));
+        ASSERT_LESS_THAN(sizer.getOpsLimit(), grown);
+    }
+
+    TEST(BatchSizer, HoldsWithinTolerance) {
+        BatchSizer sizer(100, 50000, 5000);
+        sizer.recordBatch(5001, 1000, 100000, busyWriters(100000));
+        const unsigned grown = sizer.getOpsLimit();
+
+        // throughput within a couple of percent of the last batch
+        const long long micros = (grown + 1) * 100000LL / 5001 + 1000;
+        sizer.recordBatch(grown + 1, 1000, micros, busyWriters(micros));
+        ASSERT_EQUALS(grown, sizer.getOpsLimit());
+    }
+
+    TEST(BatchSizer, ShrinksWhenWritersStall) {
+        BatchSizer sizer(100, 50000, 5000);
+        std::vector<long long> stalled(16, 0);
+        stalled[3] = 100000;
+        sizer.recordBatch(5001, 1000, 100000, stalled);
+        ASSERT_LESS_THAN(sizer.getOpsLimit(), 5000U);
+    }
+
+    TEST(BatchSizer, IgnoresBatchesBelowLimit) {
+        BatchSizer sizer(100, 50000, 5000);
+        sizer.recordBatch(10, 1000, 100, busyWriters(100));
+        std::vector<long long> stalled(16, 0);
+        sizer.recordBatch(4000, 1000, 100000, stalled);
+        ASSERT_EQUALS(5000U, sizer.getOpsLimit());
+    }
+
+    TEST(BatchSizer, StaysWithinBounds) {
+        BatchSizer sizer(100, 6000, 5000);
+        for (int i = 0; i < 20; i++) {
+            const unsigned limit = sizer.getOpsLimit();
+            // throughput keeps doubling
+            sizer.recordBatch(limit + 1, 1000, 100000 >> i, busyWriters(100000 >> i));
+        }
+        ASSERT_EQUALS(6000U, sizer.getOpsLimit());
+
+        std::vector<long long> stalled(16, 0);
+        for (int i = 0; i < 50; i++) {
+            sizer.recordBatch(sizer.getOpsLimit() + 1, 1000, 100000, stalled);
+        }
+        ASSERT_EQUALS(100U, sizer.getOpsLimit());
+    }
+
+    TEST(BatchSizer, DisablingRestoresInitialLimit) {
+        BatchSizer sizer(100, 50000, 5000);
+        sizer.recordBatch(5001, 1000, 100000, busyWriters(100000));
+        ASSERT_NOT_EQUALS(5000U, sizer.getOpsLimit());
+
+        sizer.setAdaptive(false);
+        ASSERT_EQUALS(5000U, sizer.getOpsLimit());
+        sizer.recordBatch(5001, 1000, 100000, busyWriters(100000));
+        ASSERT_EQUALS(5000U, sizer.getOpsLimit());
+    }
+
+    TEST(BatchSizer, ReportsStats) {
+        BatchSizer sizer(100, 50000, 5000);
+        std::vector<long long> halfIdle(4, 0);
+        halfIdle[0] = 1000;
+        halfIdle[1] = 1000;
+        sizer.recordBatch(10, 2048, 1000, halfIdle);
+
+        BSONObjBuilder b;
+        sizer.append(b);
+        BSONObj stats = b.obj();
+        ASSERT_EQUALS(5000, stats["opsLimit"].numberLong());
+        ASSERT_EQUALS(50.0, stats["writerIdlePercent"].numberDouble());
+        ASSERT_EQUALS(1, stats["batchOps"]["count"].numberLong());
+        ASSERT_EQUALS(10, stats["batchOps"]["sum"].numberLong());
+        ASSERT_EQUALS(2048, stats["batchBytes"]["sum"].numberLong());
+        ASSERT_EQUALS(1000, stats["applyMicros"]["sum"].numberLong());
+    }
+
+} // namespace
+} // namespace repl
+} // namespace mongo
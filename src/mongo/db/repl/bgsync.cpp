@@ -41,6 +41,7 @@
 #include "mongo/db/repl/rs.h"
 #include "mongo/util/fail_point_service.h"
 #include "mongo/util/log.h"
+#include "mongo/util/scopeguard.h"
 #include "mongo/base/counter.h"
 #include "mongo/db/stats/timer_stats.h"
 
@@ -51,7 +52,17 @@ namespace repl {
     int SleepToAllowBatchingMillis = 2;
     const int BatchIsSmallish = 40000; // bytes
 
+    // Upper bounds on a single hand-off from the producer to the applier.  A fetched batch
+    // normally ends with the cursor batch it was read from.
+    const size_t FetchedBatchMaxOps = 5000;
+    const size_t FetchedBatchMaxBytes = 16 * 1024 * 1024;
+
+    // Maximum number of fetched batches queued for the applier, independent of their size
+    const size_t FetchedBatchQueueCapacity = 1024;
+
     MONGO_FP_DECLARE(rsBgSyncProduce);
+    // Throws from the fetch loop after an op was read, leaving a partly filled batch staged
+    MONGO_FP_DECLARE(rsBgSyncFetchThrow);
 
     BackgroundSync* BackgroundSync::s_instance = 0;
     boost::mutex BackgroundSync::s_mutex;
@@ -91,7 +102,15 @@ namespace repl {
         return static_cast<size_t>(o.objsize());
     }
 
-    BackgroundSync::BackgroundSync() : _buffer(bufferMaxSizeGauge, &getSize),
+    size_t BackgroundSync::getBatchSize(const FetchedBatchPtr& batch) {
+        return batch ? batch->bytes : 0;
+    }
+
+    BackgroundSync::BackgroundSync() : _buffer(FetchedBatchQueueCapacity,
+                                               bufferMaxSizeGauge,
+                                               &getBatchSize),
+                                       _fetching(new FetchedBatch()),
+                                       _applyingPos(0),
                                        _lastOpTimeFetched(0, 0),
                                        _lastH(0),
                                        _pause(true),
@@ -122,7 +141,7 @@ namespace repl {
             boost::unique_lock<boost::mutex> lock(s_instance->_mutex);
 
             // If all ops in the buffer have been applied, unblock waitForRepl (if it's waiting)
-            if (s_instance->_buffer.empty()) {
+            if (s_instance->bufferEmpty()) {
                 s_instance->_appliedBuffer = true;
                 s_instance->_condvar.notify_all();
             }
@@ -196,6 +215,11 @@ namespace repl {
         // find a target to sync from the last op time written
         getOplogReader(txn, r);
 
+        // Ops staged in _fetching are already counted in _bufferedOps and past
+        // _lastOpTimeFetched, so they must reach the applier however we leave, exceptions
+        // from the cursor included.
+        ON_BLOCK_EXIT_OBJ(*this, &BackgroundSync::flushFetched);
+
         // no server found
         {
             boost::unique_lock<boost::mutex> lock(_mutex);
@@ -226,6 +250,10 @@ namespace repl {
 
         while (!inShutdown()) {
             if (!r.moreInCurrentBatch()) {
+                // Hand everything read from this cursor batch to the applier before we
+                // possibly block on the network or leave the loop.
+                flushFetched();
+
                 // Check some things periodically
                 // (whenever we run out of items in the
                 // current cursor batch)
@@ -303,10 +331,12 @@ namespace repl {
             OCCASIONALLY {
                 LOG(2) << "bgsync buffer has " << _buffer.size() << " bytes" << rsLog;
             }
-            // the blocking queue will wait (forever) until there's room for us to push
-            _buffer.push(o);
+            const size_t size = getSize(o);
+            _fetching->ops.push_back(o);
+            _fetching->bytes += size;
+            _bufferedOps.addAndFetch(1);
             bufferCountGauge.increment();
-            bufferSizeGauge.increment(getSize(o));
+            bufferSizeGauge.increment(size);
 
             {
                 boost::unique_lock<boost::mutex> lock(_mutex);
@@ -315,7 +345,30 @@ namespace repl {
                 LOG(3) << "replSet lastOpTimeFetched: "
                        << _lastOpTimeFetched.toStringPretty() << rsLog;
             }
+
+            if (MONGO_FAIL_POINT(rsBgSyncFetchThrow)) {
+                uasserted(18658, "rsBgSyncFetchThrow fail point enabled");
+            }
+
+            if (_fetching->ops.size() >= FetchedBatchMaxOps ||
+                    _fetching->bytes >= FetchedBatchMaxBytes) {
+                flushFetched();
+            }
+        }
+    }
+
+    void BackgroundSync::flushFetched() {
+        if (_fetching->ops.empty()) {
+            return;
         }
+
+        // the queue will wait (forever) until there's room for us to push
+        _buffer.push(_fetching);
+        _fetching.reset(new FetchedBatch());
+    }
+
+    bool BackgroundSync::bufferEmpty() const {
+        return _bufferedOps.load() == 0;
     }
 
     bool BackgroundSync::shouldChangeSyncTarget() {
@@ -333,20 +386,39 @@ namespace repl {
 
 
     bool BackgroundSync::peek(BSONObj* op) {
-        return _buffer.peek(*op);
+        if (!_applying || _applyingPos == _applying->ops.size()) {
+            FetchedBatchPtr next;
+            if (!_buffer.tryPop(&next)) {
+                return false;
+            }
+            _applying = next;
+            _applyingPos = 0;
+        }
+
+        *op = _applying->ops[_applyingPos];
+        return true;
     }
 
     void BackgroundSync::waitForMore() {
-        BSONObj op;
+        if (_applying && _applyingPos < _applying->ops.size()) {
+            return;
+        }
         // Block for one second before timing out.
-        // Ignore the value of the op we peeked at.
-        _buffer.blockingPeek(op, 1);
+        _buffer.waitForData(1000);
     }
 
     void BackgroundSync::consume() {
         // this is just to get the op off the queue, it's been peeked at
         // and queued for application already
-        BSONObj op = _buffer.blockingPop();
+        BSONObj op;
+        verify(peek(&op));
+        ++_applyingPos;
+        if (_applyingPos == _applying->ops.size()) {
+            // drop our reference so the batch is freed as soon as it has been applied
+            _applying.reset();
+        }
+
+        _bufferedOps.subtractAndFetch(1);
         bufferCountGauge.decrement(1);
         bufferSizeGauge.decrement(getSize(op));
     }
@@ -492,7 +564,7 @@ namespace repl {
     }
 
     void BackgroundSync::start() {
-        massert(16235, "going to start syncing, but buffer is not empty", _buffer.empty());
+        massert(16235, "going to start syncing, but buffer is not empty", bufferEmpty());
 
         boost::unique_lock<boost::mutex> lock(_mutex);
         _pause = false;
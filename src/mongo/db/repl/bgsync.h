@@ -28,9 +28,11 @@
 
 #pragma once
 
+#include <boost/shared_ptr.hpp>
 #include <boost/thread/mutex.hpp>
+#include <vector>
 
-#include "mongo/util/queue.h"
+#include "mongo/util/concurrency/spsc_queue.h"
 #include "mongo/db/repl/oplogreader.h"
 #include "mongo/db/repl/rs.h"
 #include "mongo/db/jsobj.h"
@@ -75,11 +77,31 @@ namespace repl {
         // protects creation of s_instance
         static boost::mutex s_mutex;
 
-        // _mutex protects all of the class variables
+        // A run of consecutive ops, fetched from one cursor batch, that the producer hands to
+        // the applier in a single queue operation.
+        struct FetchedBatch {
+            FetchedBatch() : bytes(0) {}
+            std::vector<BSONObj> ops;
+            size_t bytes;
+        };
+        typedef boost::shared_ptr<FetchedBatch> FetchedBatchPtr;
+
+        static size_t getBatchSize(const FetchedBatchPtr& batch);
+
+        // _mutex protects all of the class variables except the buffer fields below
         boost::mutex _mutex;
 
-        // Production thread
-        BlockingQueue<BSONObj> _buffer;
+        // Batches of fetched ops, bounded by total bytes.  The producer thread is the only
+        // pusher and the sync thread (peek/consume) the only popper, so the hand-off is
+        // lock-free.
+        SPSCQueue<FetchedBatchPtr> _buffer;
+        // Producer thread only: ops read from the cursor but not yet pushed to _buffer
+        FetchedBatchPtr _fetching;
+        // Sync thread only: the batch peek() and consume() are working through
+        FetchedBatchPtr _applying;
+        size_t _applyingPos;
+        // Ops fetched and not yet consumed, wherever they are; the buffer is empty when 0
+        AtomicInt64 _bufferedOps;
 
         OpTime _lastOpTimeFetched;
         long long _lastH;
@@ -99,6 +121,10 @@ namespace repl {
         void _producerThread();
         // Adds elements to the list, up to maxSize.
         void produce(OperationContext* txn);
+        // Pushes _fetching, if it holds any ops, to the applier
+        void flushFetched();
+        // true if every op fetched so far has been consumed
+        bool bufferEmpty() const;
         // Check if rollback is necessary
         bool isRollbackRequired(OperationContext* txn, OplogReader& r);
         void getOplogReader(OperationContext* txn, OplogReader& r);
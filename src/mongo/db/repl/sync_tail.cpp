@@ -36,11 +36,18 @@
 
 #include "mongo/base/counter.h"
 #include "mongo/db/commands/fsync.h"
+#include "mongo/db/catalog/collection.h"
+#include "mongo/db/catalog/database.h"
+#include "mongo/db/catalog/database_holder.h"
+#include "mongo/db/catalog/index_catalog.h"
 #include "mongo/db/commands/server_status_metric.h"
 #include "mongo/db/curop.h"
+#include "mongo/db/index/index_descriptor.h"
 #include "mongo/db/prefetch.h"
+#include "mongo/db/repl/batch_sizer.h"
 #include "mongo/db/repl/bgsync.h"
 #include "mongo/db/repl/oplog.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/stats/timer_stats.h"
 #include "mongo/db/operation_context_impl.h"
 #include "mongo/util/fail_point_service.h"
@@ -63,6 +70,75 @@ namespace repl {
     static ServerStatusMetricField<TimerStats> displayOpBatchesApplied(
                                                     "repl.apply.batches",
                                                     &applyBatchStats );
+
+    // Adapts the operation limit of each batch to the apply throughput
+    MONGO_EXPORT_SERVER_PARAMETER(replAdaptiveBatchSize, bool, true);
+    static BatchSizer batchSizer(SyncTail::replBatchMinOperations,
+                                 SyncTail::replBatchMaxOperations,
+                                 SyncTail::replBatchLimitOperations);
+
+    // How ops were assigned to writer threads
+    static Counter64 opsPartitionedByIdStats;
+    static ServerStatusMetricField<Counter64> displayOpsPartitionedById(
+                                                    "repl.apply.partition.byId",
+                                                    &opsPartitionedByIdStats );
+    static Counter64 opsPartitionedByNsStats;
+    static ServerStatusMetricField<Counter64> displayOpsPartitionedByNs(
+                                                    "repl.apply.partition.byNs",
+                                                    &opsPartitionedByNsStats );
+    static Counter64 opsSerialStats;
+    static ServerStatusMetricField<Counter64> displayOpsSerial( "repl.apply.partition.serial",
+                                                                &opsSerialStats );
+
+    /**
+     * Number of ops handed to each writer thread, in the last batch and in total.
+     */
+    class WriterQueueStats : public ServerStatusMetric {
+    public:
+        WriterQueueStats() :
+            ServerStatusMetric("repl.apply.writers"),
+            _mutex("WriterQueueStats") {
+        }
+
+        void record(const std::vector< std::vector<BSONObj> >& writerVectors) {
+            SimpleMutex::scoped_lock lk(_mutex);
+            _lastDepth.resize(writerVectors.size(), 0);
+            _totalOps.resize(writerVectors.size(), 0);
+            for (size_t i = 0; i < writerVectors.size(); i++) {
+                _lastDepth[i] = writerVectors[i].size();
+                _totalOps[i] += writerVectors[i].size();
+            }
+        }
+
+        virtual void appendAtLeaf(BSONObjBuilder& b) const {
+            SimpleMutex::scoped_lock lk(_mutex);
+            BSONArrayBuilder writers(b.subarrayStart(_leafName));
+            for (size_t i = 0; i < _lastDepth.size(); i++) {
+                BSONObjBuilder writer(writers.subobjStart());
+                writer.append("queueDepth", _lastDepth[i]);
+                writer.append("totalOps", _totalOps[i]);
+                writer.doneFast();
+            }
+            writers.doneFast();
+        }
+
+    private:
+        mutable SimpleMutex _mutex;
+        std::vector<long long> _lastDepth;
+        std::vector<long long> _totalOps;
+    } writerQueueStats;
+
+    class BatchSizerMetric : public ServerStatusMetric {
+    public:
+        BatchSizerMetric() : ServerStatusMetric("repl.apply.batchSizer") {}
+
+        virtual void appendAtLeaf(BSONObjBuilder& b) const {
+            BSONObjBuilder sizer(b.subobjStart(_leafName));
+            batchSizer.append(sizer);
+            sizer.doneFast();
+        }
+    } batchSizerMetric;
+
     void initializePrefetchThread() {
         if (!ClientBasic::getCurrent()) {
             Client::initThread("repl prefetch worker");
@@ -160,16 +236,27 @@ namespace repl {
         prefetcherPool.join();
     }
     
+    // Runs applyFunc on a writer thread and records how long it kept the thread busy
+    static void timedApply(SyncTail::MultiSyncApplyFunc applyFunc,
+                           const std::vector<BSONObj>* ops,
+                           SyncTail* st,
+                           long long* busyMicros) {
+        Timer t;
+        applyFunc(*ops, st);
+        *busyMicros = t.micros();
+    }
+
     // Doles out all the work to the writer pool threads and waits for them to complete
     void SyncTail::applyOps(const std::vector< std::vector<BSONObj> >& writerVectors, 
-                                     MultiSyncApplyFunc applyFunc) {
+                                     MultiSyncApplyFunc applyFunc,
+                                     std::vector<long long>* writerBusyMicros) {
         ThreadPool& writerPool = theReplSet->getWriterPool();
         TimerHolder timer(&applyBatchStats);
-        for (std::vector< std::vector<BSONObj> >::const_iterator it = writerVectors.begin();
-             it != writerVectors.end();
-             ++it) {
-            if (!it->empty()) {
-                writerPool.schedule(applyFunc, boost::cref(*it), this);
+        writerBusyMicros->assign(writerVectors.size(), 0);
+        for (size_t i = 0; i < writerVectors.size(); i++) {
+            if (!writerVectors[i].empty()) {
+                writerPool.schedule(timedApply, applyFunc, &writerVectors[i], this,
+                                    &(*writerBusyMicros)[i]);
             }
         }
         writerPool.join();
@@ -184,6 +271,11 @@ namespace repl {
         std::vector< std::vector<BSONObj> > writerVectors(theReplSet->replWriterThreadCount);
         fillWriterVectors(ops, &writerVectors);
         LOG(2) << "replication batch size is " << ops.size() << endl;
+
+        size_t bytes = 0;
+        for (std::deque<BSONObj>::const_iterator it = ops.begin(); it != ops.end(); ++it) {
+            bytes += it->objsize();
+        }
         // We must grab this because we're going to grab write locks later.
         // We hold this mutex the entire time we're writing; it doesn't matter
         // because all readers are blocked anyway.
@@ -192,12 +284,104 @@ namespace repl {
         // stop all readers until we're done
         Lock::ParallelBatchWriterMode pbwm;
 
-        applyOps(writerVectors, applyFunc);
+        std::vector<long long> writerBusyMicros;
+        Timer applyTimer;
+        applyOps(writerVectors, applyFunc, &writerBusyMicros);
+        batchSizer.recordBatch(ops.size(), bytes, applyTimer.micros(), writerBusyMicros);
+    }
+
+    unsigned int SyncTail::getBatchLimitOperations() {
+        if (batchSizer.isAdaptive() != replAdaptiveBatchSize) {
+            batchSizer.setAdaptive(replAdaptiveBatchSize);
+        }
+        return batchSizer.getOpsLimit();
     }
 
 
+    /**
+     * Ops on different documents of a collection may be applied out of order, and so by
+     * different writers, if the collection already has an _id index, and it is not capped
+     * (insertion order is the natural order) and has no unique secondary index (a delete and a
+     * later insert of the same key by another document would conflict).  A collection that
+     * does not exist yet is created implicitly by its first op, so its ops are kept together.
+     *
+     * @param exists set to whether the collection exists
+     */
+    static bool canPartitionById(OperationContext* txn, const std::string& ns, bool* exists) {
+        *exists = false;
+        Lock::DBRead lk(txn->lockState(), ns);
+        Database* db = dbHolder().get(txn, ns);
+        if (!db)
+            return false;
+        Collection* collection = db->getCollection(txn, ns);
+        if (!collection)
+            return false;
+        *exists = true;
+        if (collection->isCapped())
+            return false;
+        if (!collection->getIndexCatalog()->findIdIndex())
+            return false;
+
+        IndexCatalog::IndexIterator ii =
+            collection->getIndexCatalog()->getIndexIterator(true);
+        while (ii.more()) {
+            const IndexDescriptor* desc = ii.next();
+            if (desc->unique() && !desc->isIdIndex())
+                return false;
+        }
+        return true;
+    }
+
+    /**
+     * @return the _id of the document a CRUD op touches, or EOO for any other op
+     */
+    static BSONElement getIdElement(const BSONObj& op) {
+        switch (op["op"].valuestrsafe()[0]) {
+        case 'i':
+        case 'd':
+            return op["o"]["_id"];
+        case 'u':
+            return op["o2"]["_id"];
+        default:
+            return BSONElement();
+        }
+    }
+
+    bool SyncTail::_canPartitionById(OperationContext* txn, const std::string& ns) {
+        std::map<std::string, bool>::const_iterator cached = _partitionByIdCache.find(ns);
+        if (cached != _partitionByIdCache.end())
+            return cached->second;
+
+        bool exists;
+        const bool partition = canPartitionById(txn, ns, &exists);
+        if (exists)
+            _partitionByIdCache[ns] = partition;
+        return partition;
+    }
+
     void SyncTail::fillWriterVectors(const std::deque<BSONObj>& ops, 
                                               std::vector< std::vector<BSONObj> >* writerVectors) {
+        OperationContextImpl txn;
+        // whether each namespace in this batch can be partitioned by _id
+        std::map<std::string, bool> partitionById;
+
+        for (std::deque<BSONObj>::const_iterator it = ops.begin(); it != ops.end(); ++it) {
+            const char opType = it->getField("op").valuestrsafe()[0];
+            const char* ns = it->getField("ns").valuestrsafe();
+
+            // A command or index build may change what the collections look like, so what is
+            // known about them is looked up again once it has been applied.
+            if (opType == 'c' || nsToCollectionSubstring(ns) == "system.indexes") {
+                _partitionByIdCache.clear();
+            }
+
+            // A CRUD op without an _id can only be ordered with the rest of its namespace by
+            // keeping the whole namespace on one writer.
+            if ((opType == 'i' || opType == 'u' || opType == 'd') && getIdElement(*it).eoo()) {
+                partitionById[ns] = false;
+            }
+        }
+
         for (std::deque<BSONObj>::const_iterator it = ops.begin();
              it != ops.end();
              ++it) {
@@ -208,8 +392,43 @@ namespace repl {
             uint32_t hash = 0;
             MurmurHash3_x86_32( ns, len, 0, &hash);
 
+            // Commands and index builds always arrive in a batch of their own (see
+            // tryPopAndWaitForMore); keep them on one writer regardless.
+            const bool isCommand = (it->getField("op").valuestrsafe()[0] == 'c');
+            if (isCommand || nsToCollectionSubstring(ns) == "system.indexes") {
+                (*writerVectors)[0].push_back(*it);
+                opsSerialStats.increment();
+                continue;
+            }
+
+            const BSONElement id = getIdElement(*it);
+            if (!id.eoo()) {
+                std::map<std::string, bool>::iterator cached = partitionById.find(ns);
+                if (cached == partitionById.end()) {
+                    cached = partitionById.insert(
+                        std::make_pair(std::string(ns), _canPartitionById(&txn, ns))).first;
+                }
+
+                if (cached->second) {
+                    // _id values that compare equal must hash equal, whatever their numeric type
+                    if (id.isNumber()) {
+                        const double d = id.numberDouble();
+                        MurmurHash3_x86_32(&d, sizeof(d), hash, &hash);
+                    }
+                    else {
+                        MurmurHash3_x86_32(id.value(), id.valuesize(), hash, &hash);
+                    }
+                    (*writerVectors)[hash % writerVectors->size()].push_back(*it);
+                    opsPartitionedByIdStats.increment();
+                    continue;
+                }
+            }
+
             (*writerVectors)[hash % writerVectors->size()].push_back(*it);
+            opsPartitionedByNsStats.increment();
         }
+
+        writerQueueStats.record(*writerVectors);
     }
 
 
@@ -231,6 +450,7 @@ namespace repl {
 
         while( ts < minValid ) {
             OpQueue ops;
+            const unsigned int batchLimitOperations = getBatchLimitOperations();
 
             while (ops.getSize() < replBatchLimitBytes) {
                 if (tryPopAndWaitForMore(&ops)) {
@@ -242,7 +462,7 @@ namespace repl {
                 if (!ops.empty()) {
                     if (now > replBatchLimitSeconds)
                         break;
-                    if (ops.getDeque().size() > replBatchLimitOperations)
+                    if (ops.getDeque().size() > batchLimitOperations)
                         break;
                 }
             }
@@ -302,6 +522,7 @@ namespace repl {
 
             Timer batchTimer;
             int lastTimeChecked = 0;
+            const unsigned int batchLimitOperations = getBatchLimitOperations();
 
             do {
                 if (theReplSet->isPrimary()) {
@@ -315,7 +536,7 @@ namespace repl {
                 if (!ops.empty()) {
                     if (now > replBatchLimitSeconds)
                         break;
-                    if (ops.getDeque().size() > replBatchLimitOperations)
+                    if (ops.getDeque().size() > batchLimitOperations)
                         break;
                 }
                 // occasionally check some things
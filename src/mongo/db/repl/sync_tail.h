@@ -29,6 +29,8 @@
 #pragma once
 
 #include <deque>
+#include <map>
+#include <string>
 
 #include "mongo/db/storage/mmap_v1/dur.h"
 #include "mongo/db/repl/sync.h"
@@ -45,8 +47,9 @@ namespace repl {
      * "Normal" replica set syncing
      */
     class SyncTail : public Sync {
-        typedef void (*MultiSyncApplyFunc)(const std::vector<BSONObj>& ops, SyncTail* st);
     public:
+        typedef void (*MultiSyncApplyFunc)(const std::vector<BSONObj>& ops, SyncTail* st);
+
         SyncTail(BackgroundSyncInterface *q);
         virtual ~SyncTail();
         virtual bool syncApply(OperationContext* txn,
@@ -109,17 +112,31 @@ namespace repl {
         // Ops are removed from the deque.
         void applyOpsToOplog(std::deque<BSONObj>* ops);
 
+        // The operation count limit starts at replBatchLimitOperations and is adapted within
+        // [replBatchMinOperations, replBatchMaxOperations] by a BatchSizer unless the
+        // replAdaptiveBatchSize server parameter is off.
+        static const unsigned int replBatchLimitOperations = 5000;
+        static const unsigned int replBatchMinOperations = 100;
+        static const unsigned int replBatchMaxOperations = 50000;
+
     protected:
         // Cap the batches using the limit on journal commits.
         // This works out to be 100 MB (64 bit) or 50 MB (32 bit)
         static const unsigned int replBatchLimitBytes = dur::UncommittedBytesLimit;
         static const int replBatchLimitSeconds = 1;
-        static const unsigned int replBatchLimitOperations = 5000;
+
+        // The operation count at which to end the next batch
+        static unsigned int getBatchLimitOperations();
 
         // Prefetch and write a deque of operations, using the supplied function.
         // Initial Sync and Sync Tail each use a different function.
         void multiApply(std::deque<BSONObj>& ops, MultiSyncApplyFunc applyFunc);
 
+        // Splits a batch between the writers.  Ops on the same document always go to the same
+        // writer, in order.
+        void fillWriterVectors(const std::deque<BSONObj>& ops,
+                               std::vector< std::vector<BSONObj> >* writerVectors);
+
         // The version of the last op to be read
         int oplogVersion;
 
@@ -132,11 +149,18 @@ namespace repl {
         static void prefetchOp(const BSONObj& op);
 
         // Doles out all the work to the writer pool threads and waits for them to complete
+        // Fills writerBusyMicros with the time each writer spent applying its vector
         void applyOps(const std::vector< std::vector<BSONObj> >& writerVectors, 
-                      MultiSyncApplyFunc applyFunc);
+                      MultiSyncApplyFunc applyFunc,
+                      std::vector<long long>* writerBusyMicros);
+
+        // Whether the ops on 'ns' can be split between the writers by _id.  Looked up once per
+        // existing collection, and again after a batch which may have changed it.
+        bool _canPartitionById(OperationContext* txn, const std::string& ns);
+
+        // What _canPartitionById found for the collections which exist
+        std::map<std::string, bool> _partitionByIdCache;
 
-        void fillWriterVectors(const std::deque<BSONObj>& ops, 
-                               std::vector< std::vector<BSONObj> >* writerVectors);
         void handleSlaveDelay(const BSONObj& op);
         void setOplogVersion(const BSONObj& op);
     };
@@ -42,7 +42,7 @@ namespace mongo {
             configsvr(false), cpu(false), objcheck(true), defaultProfile(0),
             slowMS(100), defaultLocalThresholdMillis(15), moveParanoia(true),
             noUnixSocket(false), doFork(0), socket("/tmp"), maxConns(DEFAULT_MAX_CONN), 
-            unixSocketPermissions(DEFAULT_UNIX_PERMS), logAppend(false), logRenameOnRotate(true),
+            reactorWorkerThreads(0), unixSocketPermissions(DEFAULT_UNIX_PERMS), logAppend(false), logRenameOnRotate(true),
             logWithSyslog(false), isHttpInterfaceEnabled(false)
         {
             started = time(0);
@@ -84,6 +84,10 @@ namespace mongo {
 
         int maxConns;          // Maximum number of simultaneous open connections.
 
+        // Number of network reactor worker threads kept running, more are started while
+        // requests block; 0 means one thread per connection.
+        int reactorWorkerThreads;
+
         int unixSocketPermissions; // permissions for the UNIX domain socket
 
         std::string keyFile;   // Path to keyfile, or empty if none.
@@ -195,6 +195,10 @@ namespace {
         options->addOptionChaining("net.maxIncomingConnections", "maxConns", moe::Int,
                 maxConnInfoBuilder.str().c_str());
 
+        options->addOptionChaining("net.reactorWorkerThreads", "reactorWorkerThreads", moe::Int,
+                "serve connections from an epoll reactor with this many worker threads, "
+                "more while requests block, instead of one thread per connection (linux only)");
+
         options->addOptionChaining("logpath", "logpath", moe::String,
                 "log file to send write to instead of stdout - has to be a file, not directory")
                                   .setSources(moe::SourceAllLegacy)
@@ -748,6 +752,16 @@ namespace {
             }
         }
 
+        if (params.count("net.reactorWorkerThreads")) {
+            serverGlobalParams.reactorWorkerThreads =
+                params["net.reactorWorkerThreads"].as<int>();
+
+            if (serverGlobalParams.reactorWorkerThreads < 0) {
+                return Status(ErrorCodes::BadValue,
+                              "reactorWorkerThreads must be greater than or equal to 0");
+            }
+        }
+
         if (params.count("net.wireObjectCheck")) {
             serverGlobalParams.objcheck = params["net.wireObjectCheck"].as<bool>();
         }
@@ -48,6 +48,8 @@
 #include "mongo/db/sorter/sorter.h"
 
 #include <boost/filesystem/operations.hpp>
+#include <boost/thread/condition.hpp>
+#include <boost/thread/mutex.hpp>
 #include <snappy.h>
 
 #include "mongo/base/string_data.h"
@@ -56,6 +58,7 @@
 #include "mongo/platform/atomic_word.h"
 #include "mongo/util/assert_util.h"
 #include "mongo/util/bufreader.h"
+#include "mongo/util/concurrency/thread_pool.h"
 #include "mongo/util/goodies.h"
 #include "mongo/util/mongoutils/str.h"
 
@@ -162,16 +165,22 @@ namespace mongo {
                 , _done(false)
                 , _fileName(fileName)
                 , _fileDeleter(fileDeleter)
-                , _file(_fileName.c_str(), std::ios::in | std::ios::binary)
+                , _readAheadBytes(0)
             {
-                massert(16814, str::stream() << "error opening file \"" << _fileName << "\": "
-                                             << myErrnoWithDescription(),
-                        _file.good());
-
                 massert(16815, str::stream() << "unexpected empty file: " << _fileName,
                         boost::filesystem::file_size(_fileName) != 0);
             }
 
+            /**
+             * Reads the file through a buffer of this size rather than the default stream
+             * buffer, so that a merge over many runs makes large sequential reads instead of
+             * seeking between files every few KB. Ignored once reading has started.
+             */
+            void setReadAheadBytes(size_t bytes) {
+                if (!_file.is_open())
+                    _readAheadBytes = bytes;
+            }
+
             bool more() {
                 if (!_done)
                     fillIfNeeded(); // may change _done
@@ -197,6 +206,20 @@ namespace mongo {
                     fill();
             }
 
+            // The file is opened on first use since a filebuf can only be given a buffer
+            // before it is opened.
+            void open() {
+                if (_readAheadBytes) {
+                    _readAheadBuffer.reset(new char[_readAheadBytes]);
+                    _file.rdbuf()->pubsetbuf(_readAheadBuffer.get(), _readAheadBytes);
+                }
+
+                _file.open(_fileName.c_str(), std::ios::in | std::ios::binary);
+                massert(16814, str::stream() << "error opening file \"" << _fileName << "\": "
+                                             << myErrnoWithDescription(),
+                        _file.good());
+            }
+
             void fill() {
                 int32_t rawSize;
                 read(&rawSize, sizeof(rawSize));
@@ -234,6 +257,9 @@ namespace mongo {
 
             // sets _done to true on EOF - asserts on any other error
             void read(void* out, size_t size) {
+                if (!_file.is_open())
+                    open();
+
                 _file.read(reinterpret_cast<char*>(out), size);
                 if (!_file.good()) {
                     if (_file.eof()) {
@@ -254,16 +280,27 @@ namespace mongo {
             boost::scoped_ptr<BufReader> _reader;
             string _fileName;
             boost::shared_ptr<FileDeleter> _fileDeleter; // Must outlive _file
+            size_t _readAheadBytes;
+            boost::scoped_array<char> _readAheadBuffer; // Must outlive _file
             std::ifstream _file;
         };
 
-        /** Merge-sorts results from 0 or more FileIterators */
+        /**
+         * Merge-sorts results from 0 or more FileIterators.
+         *
+         * The inputs are kept in a loser tree: each internal node remembers the stream that
+         * lost the comparison there and _tree[0] holds the overall winner. Advancing the
+         * winner only replays the comparisons on its path to the root, which is log2(N)
+         * comparisons against a binary heap's 2*log2(N).
+         */
         template <typename Key, typename Value, typename Comparator>
         class MergeIterator : public SortIteratorInterface<Key, Value> {
         public:
             typedef SortIteratorInterface<Key, Value> Input;
             typedef std::pair<Key, Value> Data;
 
+            // Below this the per-run buffer is no better than the stream's default.
+            static const size_t kMinReadAheadBytes = 64*1024;
 
             MergeIterator(const std::vector<boost::shared_ptr<Input> >& iters,
                           const SortOptions& opts,
@@ -271,34 +308,46 @@ namespace mongo {
                 : _opts(opts)
                 , _remaining(opts.limit ? opts.limit : numeric_limits<unsigned long long>::max())
                 , _first(true)
-                , _greater(comp)
+                , _live(0)
+                , _comp(comp)
             {
+                const size_t readAheadBytes = iters.empty()
+                                            ? 0
+                                            : opts.mergeReadAheadBytes / iters.size();
+
                 for (size_t i = 0; i < iters.size(); i++) {
+                    if (readAheadBytes >= kMinReadAheadBytes) {
+                        FileIterator<Key, Value>* file =
+                            dynamic_cast<FileIterator<Key, Value>*>(iters[i].get());
+                        if (file)
+                            file->setReadAheadBytes(readAheadBytes);
+                    }
+
                     if (iters[i]->more()) {
-                        _heap.push_back(
+                        _streams.push_back(
                             boost::make_shared<Stream>(i, iters[i]->next(), iters[i]));
                     }
                 }
 
-                if (_heap.empty()) {
+                if (_streams.empty()) {
                     _remaining = 0;
                     return;
                 }
 
-                std::make_heap(_heap.begin(), _heap.end(), _greater);
-                std::pop_heap(_heap.begin(), _heap.end(), _greater);
-                _current = _heap.back();
-                _heap.pop_back();
+                _live = _streams.size();
+                _tree.resize(_streams.size());
+                _tree[0] = build(1);
             }
 
             bool more() {
-                if (_remaining > 0 && (_first || !_heap.empty() || _current->more()))
+                if (_remaining > 0 && (_first || _live > 1 || winner()->more()))
                     return true;
 
                 // We are done so clean up resources.
                 // Can't do this in next() due to lifetime guarantees of unowned Data.
-                _heap.clear();
-                _current.reset();
+                _streams.clear();
+                _tree.clear();
+                _live = 0;
                 _remaining = 0;
 
                 return false;
@@ -311,25 +360,18 @@ namespace mongo {
 
                 if (_first) {
                     _first = false;
-                    return _current->current();
+                    return winner()->current();
                 }
 
-                if (!_current->advance()) {
-                    verify(!_heap.empty());
-
-                    std::pop_heap(_heap.begin(), _heap.end(), _greater);
-                    _current = _heap.back();
-                    _heap.pop_back();
-                } else if (!_heap.empty() && _greater(_current, _heap.front())) {
-                    std::pop_heap(_heap.begin(), _heap.end(), _greater);
-                    std::swap(_current, _heap.back());
-                    std::push_heap(_heap.begin(), _heap.end(), _greater);
+                if (!winner()->advance()) {
+                    verify(_live > 1);
+                    _live--;
                 }
 
-                return _current->current();
+                replay(_tree[0]);
+                return winner()->current();
             }
 
-
         private:
             class Stream { // Data + Iterator
             public:
@@ -337,47 +379,86 @@ namespace mongo {
                     : fileNum(fileNum)
                     , _current(first)
                     , _rest(rest)
+                    , _exhausted(false)
                 {}
 
                 const Data& current() const { return _current; }
                 bool more() { return _rest->more(); }
                 bool advance() {
-                    if (!_rest->more())
+                    if (!_rest->more()) {
+                        _exhausted = true;
                         return false;
+                    }
 
                     _current = _rest->next();
                     return true;
                 }
 
+                /// An exhausted stream loses every comparison, so it never becomes the winner
+                /// while any other stream has data.
+                bool exhausted() const { return _exhausted; }
+
                 const size_t fileNum;
             private:
                 Data _current;
                 boost::shared_ptr<Input> _rest;
+                bool _exhausted;
             };
 
-            class STLComparator { // uses greater rather than less-than to maintain a MinHeap
-            public:
-                explicit STLComparator(const Comparator& comp) : _comp(comp) {}
-                bool operator () (ptr<const Stream> lhs, ptr<const Stream> rhs) const {
-                    // first compare data
-                    dassertCompIsSane(_comp, lhs->current(), rhs->current());
-                    int ret = _comp(lhs->current(), rhs->current());
-                    if (ret)
-                        return ret > 0;
+            // Streams are leaves _streams.size() to 2*_streams.size()-1 of an implicit tree
+            // whose internal nodes are 1 to _streams.size()-1, with the children of node n
+            // at 2n and 2n+1.
 
-                    // then compare fileNums to ensure stability
-                    return lhs->fileNum > rhs->fileNum;
+            const boost::shared_ptr<Stream>& winner() const { return _streams[_tree[0]]; }
+
+            /// Returns true if stream 'lhs' should be returned before stream 'rhs'.
+            bool beats(size_t lhs, size_t rhs) const {
+                const Stream& l = *_streams[lhs];
+                const Stream& r = *_streams[rhs];
+                if (l.exhausted() || r.exhausted())
+                    return !l.exhausted();
+
+                // first compare data
+                dassertCompIsSane(_comp, l.current(), r.current());
+                int ret = _comp(l.current(), r.current());
+                if (ret)
+                    return ret < 0;
+
+                // then compare fileNums to ensure stability
+                return l.fileNum < r.fileNum;
+            }
+
+            /// Fills in the losers below 'node' and returns the winner.
+            size_t build(size_t node) {
+                if (node >= _streams.size())
+                    return node - _streams.size();
+
+                const size_t left = build(2 * node);
+                const size_t right = build(2 * node + 1);
+                if (beats(left, right)) {
+                    _tree[node] = right;
+                    return left;
                 }
-            private:
-                const Comparator _comp;
-            };
+                _tree[node] = left;
+                return right;
+            }
+
+            /// Restores the tree after the current data of stream 'stream' changed.
+            void replay(size_t stream) {
+                for (size_t node = (stream + _streams.size()) / 2; node > 0; node /= 2) {
+                    if (beats(_tree[node], stream))
+                        std::swap(_tree[node], stream);
+                }
+                _tree[0] = stream;
+            }
 
             SortOptions _opts;
             unsigned long long _remaining;
             bool _first;
-            boost::shared_ptr<Stream> _current;
-            std::vector<boost::shared_ptr<Stream> > _heap; // MinHeap
-            STLComparator _greater; // named so calls make sense
+            size_t _live; // streams that are not exhausted
+            const Comparator _comp;
+            std::vector<boost::shared_ptr<Stream> > _streams;
+            std::vector<size_t> _tree; // indexes into _streams; see above
         };
 
         template <typename Key, typename Value, typename Comparator>
@@ -396,6 +477,7 @@ namespace mongo {
                 , _settings(settings)
                 , _opts(opts)
                 , _memUsed(0)
+                , _spillsInFlight(0)
             { verify(_opts.limit == 0); }
 
             void add(const Key& key, const Value& val) {
@@ -409,20 +491,28 @@ namespace mongo {
             }
 
             Iterator* done() {
-                if (_iters.empty()) {
+                if (_iters.empty() && _pendingRuns.empty()) {
                     sort();
                     return new InMemIterator<Key, Value>(_data);
                 }
 
                 spill();
+                waitForSpills();
                 return Iterator::merge(_iters, _opts, _comp);
             }
 
             // TEMP these are here for compatibility. Will be replaced with a general stats API
-            int numFiles() const { return _iters.size(); }
+            int numFiles() const { return _iters.size() + _pendingRuns.size(); }
             size_t memUsed() const { return _memUsed; }
 
         private:
+            /// A run handed to _spillPool. 'iter' and 'error' are written by the worker.
+            struct PendingRun {
+                std::deque<Data> data;
+                boost::shared_ptr<Iterator> iter;
+                std::string error;
+            };
+
             class STLComparator {
             public:
                 explicit STLComparator(const Comparator& comp) : _comp(comp) {}
@@ -459,6 +549,12 @@ namespace mongo {
                         );
                 }
 
+                if (_opts.spillThreads) {
+                    spillInBackground();
+                    _memUsed = 0;
+                    return;
+                }
+
                 sort();
 
                 SortedFileWriter<Key, Value> writer(_opts, _settings);
@@ -471,12 +567,101 @@ namespace mongo {
                 _memUsed = 0;
             }
 
+            /**
+             * Hands _data to _spillPool to be sorted and written, first waiting for a worker
+             * if opts.spillThreads runs are already in flight.
+             */
+            void spillInBackground() {
+                {
+                    boost::unique_lock<boost::mutex> lk(_spillMutex);
+                    while (_spillsInFlight >= _opts.spillThreads)
+                        _spillDone.wait(lk);
+                    _spillsInFlight++;
+                }
+
+                boost::shared_ptr<PendingRun> run = boost::make_shared<PendingRun>();
+                run->data.swap(_data);
+                _pendingRuns.push_back(run);
+
+                if (!_spillPool)
+                    _spillPool.reset(new ThreadPool(_opts.spillThreads));
+                _spillPool->schedule(&NoLimitSorter::writeRun, this, run);
+
+                throwIfSpillFailed();
+            }
+
+            /// Runs on a _spillPool thread.
+            void writeRun(boost::shared_ptr<PendingRun> run) {
+                std::string error;
+                try {
+                    STLComparator less(_comp);
+                    std::stable_sort(run->data.begin(), run->data.end(), less);
+
+                    SortedFileWriter<Key, Value> writer(_opts, _settings);
+                    for ( ; !run->data.empty(); run->data.pop_front()) {
+                        writer.addAlreadySorted(run->data.front().first,
+                                                run->data.front().second);
+                    }
+
+                    run->iter.reset(writer.done());
+                }
+                catch (const DBException& e) {
+                    error = e.toString();
+                }
+                catch (const std::exception& e) {
+                    error = e.what();
+                }
+
+                // release the data now rather than when the run is merged
+                std::deque<Data>().swap(run->data);
+
+                boost::lock_guard<boost::mutex> lk(_spillMutex);
+                run->error = error;
+                _spillsInFlight--;
+                _spillDone.notify_all();
+            }
+
+            void throwIfSpillFailed() const {
+                std::string error;
+                {
+                    boost::lock_guard<boost::mutex> lk(_spillMutex);
+                    for (size_t i = 0; i < _pendingRuns.size() && error.empty(); i++)
+                        error = _pendingRuns[i]->error;
+                }
+                if (!error.empty())
+                    msgasserted(18653, str::stream() << "failed to spill sorted run: " << error);
+            }
+
+            /// Waits for background spills and moves their runs to _iters in spill order.
+            void waitForSpills() {
+                if (_pendingRuns.empty())
+                    return;
+
+                {
+                    boost::unique_lock<boost::mutex> lk(_spillMutex);
+                    while (_spillsInFlight)
+                        _spillDone.wait(lk);
+                }
+                throwIfSpillFailed();
+
+                for (size_t i = 0; i < _pendingRuns.size(); i++)
+                    _iters.push_back(_pendingRuns[i]->iter);
+                _pendingRuns.clear();
+            }
+
             const Comparator _comp;
             const Settings _settings;
             SortOptions _opts;
             size_t _memUsed;
             std::deque<Data> _data; // the "current" data
             std::vector<boost::shared_ptr<Iterator> > _iters; // data that has already been spilled
+
+            // Background spilling, only used if _opts.spillThreads > 0.
+            std::vector<boost::shared_ptr<PendingRun> > _pendingRuns; // in spill order
+            mutable boost::mutex _spillMutex; // guards _spillsInFlight and PendingRun::error
+            boost::condition _spillDone;
+            size_t _spillsInFlight;
+            boost::scoped_ptr<ThreadPool> _spillPool; // declared last so it is joined first
         };
 
         template <typename Key, typename Value, typename Comparator>
@@ -778,6 +963,7 @@ namespace mongo {
     SortedFileWriter<Key, Value>::SortedFileWriter(const SortOptions& opts,
                                                    const Settings& settings)
         : _settings(settings)
+        , _compress(opts.compressRuns)
     {
         namespace str = mongoutils::str;
 
@@ -824,11 +1010,13 @@ namespace mongo {
             return;
 
         std::string compressed;
-        snappy::Compress(_buffer.buf(), _buffer.len(), &compressed);
-        verify(compressed.size() <= size_t(std::numeric_limits<int32_t>::max()));
+        if (_compress) {
+            snappy::Compress(_buffer.buf(), _buffer.len(), &compressed);
+            verify(compressed.size() <= size_t(std::numeric_limits<int32_t>::max()));
+        }
 
         try {
-            if (compressed.size() < size_t(_buffer.len()/10*9)) {
+            if (_compress && compressed.size() < size_t(_buffer.len()/10*9)) {
                 const int32_t size = -int32_t(compressed.size()); // negative means compressed
                 _file.write(reinterpret_cast<const char*>(&size), sizeof(size));
                 _file.write(compressed.data(), compressed.size());
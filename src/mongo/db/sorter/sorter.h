@@ -98,11 +98,21 @@ namespace mongo {
         bool extSortAllowed; /// If false, uassert if more mem needed than allowed.
         std::string tempDir; /// Directory to directly place files in.
                              /// Must be explicitly set if extSortAllowed is true.
+        size_t spillThreads; /// Threads that sort and write spilled runs in the background.
+                             /// 0 spills synchronously from add(). Each in-flight run holds
+                             /// up to maxMemoryUsageBytes, so the sorter may use up to
+                             /// (spillThreads + 1) * maxMemoryUsageBytes. Only for limit 0.
+        bool compressRuns; /// Snappy compress blocks of spilled runs when it saves space.
+        size_t mergeReadAheadBytes; /// Total read buffer shared by the runs being merged.
+                                    /// 0 uses the default stream buffer for each run.
 
         SortOptions()
             : limit(0)
             , maxMemoryUsageBytes(64*1024*1024)
             , extSortAllowed(false)
+            , spillThreads(0)
+            , compressRuns(true)
+            , mergeReadAheadBytes(0)
         {}
 
         /// Fluent API to support expressions like SortOptions().Limit(1000).ExtSortAllowed(true)
@@ -126,6 +136,21 @@ namespace mongo {
             tempDir = newTempDir;
             return *this;
         }
+
+        SortOptions& SpillThreads(size_t newSpillThreads) {
+            spillThreads = newSpillThreads;
+            return *this;
+        }
+
+        SortOptions& CompressRuns(bool newCompressRuns=true) {
+            compressRuns = newCompressRuns;
+            return *this;
+        }
+
+        SortOptions& MergeReadAheadBytes(size_t newMergeReadAheadBytes) {
+            mergeReadAheadBytes = newMergeReadAheadBytes;
+            return *this;
+        }
     };
 
     /// This is the output from the sorting framework
@@ -201,6 +226,7 @@ namespace mongo {
         void spill();
 
         const Settings _settings;
+        const bool _compress;
         std::string _fileName;
         boost::shared_ptr<sorter::FileDeleter> _fileDeleter; // Must outlive _file
         std::ofstream _file;
@@ -241,6 +241,20 @@ namespace mongo {
                 ASSERT_ITERATORS_EQUIVALENT(boost::shared_ptr<IWIterator>(sorter.done()),
                                             make_shared<IntIterator>(0,10*1000*1000));
             }
+            { // uncompressed, merged with read-ahead buffers
+                const SortOptions rawOpts = SortOptions(opts).CompressRuns(false)
+                                                             .MergeReadAheadBytes(1024*1024);
+                boost::shared_ptr<IWIterator> iterators[3];
+                for (int i=0; i<3; i++) {
+                    SortedFileWriter<IntWrapper, IntWrapper> sorter(rawOpts);
+                    for (int j=i; j< 300*1000; j+=3)
+                        sorter.addAlreadySorted(j,-j);
+                    iterators[i].reset(sorter.done());
+                }
+
+                ASSERT_ITERATORS_EQUIVALENT(mergeIterators(iterators, ASC, rawOpts),
+                                            make_shared<IntIterator>(0,300*1000));
+            }
 
             ASSERT(boost::filesystem::is_empty(tempDir.path()));
         }
@@ -301,6 +315,51 @@ namespace mongo {
                         mergeIterators(iterators, ASC, SortOptions().Limit(10)),
                         make_shared<LimitIterator>(10, make_shared<IntIterator>(0,20,1)));
             }
+            { // test many sources of different lengths, including empty ones
+                boost::shared_ptr<IWIterator> iterators[13];
+                for (int i=0; i<13; i++) {
+                    if (i % 4 == 3)
+                        iterators[i] = make_shared<EmptyIterator>();
+                    else
+                        iterators[i] = make_shared<IntIterator>(i, 100 + i*i, 13);
+                }
+
+                std::vector<IWPair> expected;
+                for (int i=0; i<13; i++) {
+                    if (i % 4 == 3)
+                        continue;
+                    for (int j=i; j<100 + i*i; j+=13)
+                        expected.push_back(IWPair(j, -j));
+                }
+                std::sort(expected.begin(), expected.end());
+
+                boost::shared_ptr<IWIterator> correct =
+                    make_shared<sorter::InMemIterator<IntWrapper, IntWrapper> >(expected);
+                ASSERT_ITERATORS_EQUIVALENT(mergeIterators(iterators, ASC), correct);
+            }
+            { // test that equal keys come out in the order of their sources
+                boost::shared_ptr<IWIterator> iterators[5];
+                std::vector<IWPair> expected;
+                for (int key=0; key<4; key++) {
+                    for (int i=0; i<5; i++) {
+                        if (key != i)
+                            expected.push_back(IWPair(key, i));
+                    }
+                }
+                for (int i=0; i<5; i++) {
+                    std::vector<IWPair> source;
+                    for (int key=0; key<4; key++) {
+                        if (key != i)
+                            source.push_back(IWPair(key, i));
+                    }
+                    iterators[i] =
+                        make_shared<sorter::InMemIterator<IntWrapper, IntWrapper> >(source);
+                }
+
+                boost::shared_ptr<IWIterator> correct =
+                    make_shared<sorter::InMemIterator<IntWrapper, IntWrapper> >(expected);
+                ASSERT_ITERATORS_EQUIVALENT(mergeIterators(iterators, ASC), correct);
+            }
         }
     };
 
@@ -498,6 +557,16 @@ namespace mongo {
         };
 
 
+        template <bool Random=true>
+        class LotsOfDataParallelSpill : public LotsOfDataLittleMemory<Random> {
+            typedef LotsOfDataLittleMemory<Random> Parent;
+            SortOptions adjustSortOptions(SortOptions opts) {
+                return Parent::adjustSortOptions(opts).SpillThreads(2)
+                                                      .CompressRuns(false)
+                                                      .MergeReadAheadBytes(32*1024*1024);
+            }
+        };
+
         template <long long Limit, bool Random=true>
         class LotsOfDataWithLimit : public LotsOfDataLittleMemory<Random> {
             typedef LotsOfDataLittleMemory<Random> Parent;
@@ -538,6 +607,8 @@ namespace mongo {
             add<SorterTests::Dupes>();
             add<SorterTests::LotsOfDataLittleMemory</*random=*/false> >();
             add<SorterTests::LotsOfDataLittleMemory</*random=*/true> >();
+            add<SorterTests::LotsOfDataParallelSpill</*random=*/false> >();
+            add<SorterTests::LotsOfDataParallelSpill</*random=*/true> >();
             add<SorterTests::LotsOfDataWithLimit<1,/*random=*/false> >(); // limit=1 is special case
             add<SorterTests::LotsOfDataWithLimit<1,/*random=*/true> >();  // limit=1 is special case
             add<SorterTests::LotsOfDataWithLimit<100,/*random=*/false> >(); // fits in mem
@@ -66,6 +66,16 @@
    every Nth groupCommit, at the end, we REMAPPRIVATEVIEW() at the end of the work. because of
    that we are in W lock for that groupCommit, which is nonideal of course.
 
+   incremental remap (journalIncrementalRemap, posix only): instead, after every groupCommit
+   with limited locks the durThread remaps a slice of the files, one file at a time, holding
+   only the write lock of the database that file belongs to.  writers of other databases are
+   not blocked, and readers of other databases can not see the window as remapping a view in
+   place is atomic on these platforms.  a file with write intents that have not been committed
+   yet is skipped until a later pass, and so is one whose database lock can't be had within
+   the time left for the pass: a long operation on one database must not hold up group
+   commits and j:true waiters.  the W lock path above is still used when the private
+   views grow past UncommittedBytesLimit, with DurAlwaysRemap, and for commits in W lock.
+
    @see https://docs.google.com/drawings/edit?id=1TklsmZzm7ohIZkwgeK6rMvsdaR13KjtJYMsfLr175Zc
 */
 
@@ -79,12 +89,14 @@
 #include "mongo/db/commands/fsync.h"
 #include "mongo/db/commands/server_status.h"
 #include "mongo/db/operation_context_impl.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/storage/storage_engine.h"
 #include "mongo/db/storage/mmap_v1/dur.h"
 #include "mongo/db/storage/mmap_v1/dur_commitjob.h"
 #include "mongo/db/storage/mmap_v1/dur_journal.h"
 #include "mongo/db/storage/mmap_v1/dur_recover.h"
 #include "mongo/db/storage/mmap_v1/dur_stats.h"
+#include "mongo/db/storage/mmap_v1/durable_mapped_file.h"
 #include "mongo/db/storage_options.h"
 #include "mongo/server.h"
 #include "mongo/util/log.h"
@@ -108,6 +120,13 @@ namespace mongo {
 
         CommitJob& commitJob = *(new CommitJob()); // don't destroy
 
+#if defined(_WIN32) || defined(__sunos__)
+        // remapping is not atomic here, see _REMAPPRIVATEVIEW
+        static const bool journalIncrementalRemap = false;
+#else
+        MONGO_EXPORT_SERVER_PARAMETER(journalIncrementalRemap, bool, true);
+#endif
+
         Stats stats;
 
         void Stats::S::reset() {
@@ -127,7 +146,7 @@ namespace mongo {
         string _CSVHeader();
 
         string Stats::S::_CSVHeader() { 
-            return "cmts  jrnMB\twrDFMB\tcIWLk\tearly\tprpLgB  wrToJ\twrToDF\trmpPrVw";
+            return "cmts  jrnMB\twrDFMB\tcIWLk\tearly\tprpLgB  wrToJ\twrToDF\trmpPrVw\trmpChk";
         }
 
         string Stats::S::_asCSV() { 
@@ -142,7 +161,8 @@ namespace mongo {
                 (unsigned) (_prepLogBufferMicros/1000) << '\t' << 
                 (unsigned) (_writeToJournalMicros/1000) << '\t' << 
                 (unsigned) (_writeToDataFilesMicros/1000) << '\t' << 
-                (unsigned) (_remapPrivateViewMicros/1000);
+                (unsigned) (_remapPrivateViewMicros/1000) << '\t' <<
+                (unsigned) (_remapChunkMicros/1000);
             return ss.str();
         }
 
@@ -154,14 +174,20 @@ namespace mongo {
                        "journaledMB" << _journaledBytes / 1000000.0 <<
                        "writeToDataFilesMB" << _writeToDataFilesBytes / 1000000.0 <<
                        "compression" << _journaledBytes / (_uncompressedBytes+1.0) <<
+                       "uncompressedSections" << _uncompressedSections <<
                        "commitsInWriteLock" << _commitsInWriteLock <<
                        "earlyCommits" << _earlyCommits << 
+                       "remapChunks" << _remapChunks <<
+                       "remapChunksDeferred" << _remapChunksDeferred <<
+                       "remapChunksLockBusy" << _remapChunksLockBusy <<
                        "timeMs" <<
                        BSON( "dt" << _dtMillis <<
                              "prepLogBuffer" << (unsigned) (_prepLogBufferMicros/1000) <<
                              "writeToJournal" << (unsigned) (_writeToJournalMicros/1000) <<
                              "writeToDataFiles" << (unsigned) (_writeToDataFilesMicros/1000) <<
-                             "remapPrivateView" << (unsigned) (_remapPrivateViewMicros/1000)
+                             "remapPrivateView" << (unsigned) (_remapPrivateViewMicros/1000) <<
+                             "remapChunks" << (unsigned) (_remapChunkMicros/1000) <<
+                             "remapChunkMax" << (unsigned) (_remapChunkMaxMicros/1000)
                            );
             if (storageGlobalParams.journalCommitInterval != 0)
                 b << "journalCommitIntervalMs" << storageGlobalParams.journalCommitInterval;
@@ -554,6 +580,116 @@ namespace mongo {
             stats.curr->_remapPrivateViewMicros += t.micros();
         }
 
+        RemapFileResult remapFileIncrementally(OperationContext* txn,
+                                               const std::string& filename,
+                                               int maxWaitMillis) {
+            invariant(!txn->lockState()->isLocked());
+
+            Timer t;
+            {
+                // database files are named <db>.<n> and <db>.ns
+                const std::string dbname = boost::filesystem::path(filename).stem().string();
+                dbwritelocktry lk(txn->lockState(), dbname, maxWaitMillis);
+                if( !lk.got() ) {
+                    stats.curr->_remapChunksLockBusy++;
+                    return RemapFileLockBusy;
+                }
+
+                // nothing can write to this file now, but it may have been closed meanwhile
+                MongoFileFinder finder;
+                MongoFile* f = finder.findByPath(filename);
+                if( f == 0 || !f->isDurableMappedFile() )
+                    return RemapFileDone;
+                DurableMappedFile* mmf = (DurableMappedFile*) f;
+                if( !mmf->willNeedRemap() )
+                    return RemapFileDone;
+
+                // writes made since the last commit only exist in the private view
+                if( commitJob.hasIntentsWithin(mmf->getView(), mmf->length()) ) {
+                    stats.curr->_remapChunksDeferred++;
+                    return RemapFileHasIntents;
+                }
+
+                mmf->remapThePrivateView();
+            }
+
+            const long long micros = t.micros();
+            stats.curr->_remapChunks++;
+            stats.curr->_remapChunkMicros += micros;
+            if( micros > stats.curr->_remapChunkMaxMicros )
+                stats.curr->_remapChunkMaxMicros = micros;
+            return RemapFileDone;
+        }
+
+        // upper bound on the time the durThread spends remapping after one commit
+        static const int IncrementalRemapBudgetMillis = 20;
+
+        /** Incremental counterpart of _REMAPPRIVATEVIEW for the durThread.  Called without any
+            lock; see top of file.
+        */
+        static void REMAPPRIVATEVIEWINCREMENTAL(OperationContext* txn) {
+            static unsigned startAt;
+            static unsigned long long lastRemap;
+            static unsigned visitedSinceReset;
+            static bool deferredSinceReset;
+
+            invariant(!txn->lockState()->isLocked());
+
+            // same pace as _REMAPPRIVATEVIEW: every file about every 2 seconds
+            unsigned long long now = curTimeMicros64();
+            double fraction = (now-lastRemap)/2000000.0;
+            lastRemap = now;
+
+            std::vector<std::string> todo; // empty names hold the place of other MongoFiles
+            unsigned sz;
+            {
+                LockMongoFilesShared lk;
+                set<MongoFile*>& files = MongoFile::getAllFiles();
+                sz = files.size();
+                if( sz == 0 )
+                    return;
+
+                unsigned ntodo = (unsigned) (sz * fraction);
+                if( ntodo < 1 ) ntodo = 1;
+                if( ntodo > sz ) ntodo = sz;
+
+                set<MongoFile*>::iterator i = files.begin();
+                for( unsigned x = 0; x < startAt % sz; x++ )
+                    i++;
+                for( unsigned x = 0; x < ntodo; x++ ) {
+                    todo.push_back((*i)->isDurableMappedFile() ? (*i)->filename() : std::string());
+                    i++;
+                    if( i == files.end() ) i = files.begin();
+                }
+            }
+
+            // a file waits for its database lock no longer than the budget has left, so a long
+            // operation holding that lock can't stall the pass; the file is skipped until the next
+            // round.  what is left over goes first next time
+            Timer t;
+            unsigned done = 0;
+            int left;
+            while( done < todo.size() && (left = IncrementalRemapBudgetMillis - t.millis()) > 0 ) {
+                if( !todo[done].empty() &&
+                        remapFileIncrementally(txn, todo[done], left) != RemapFileDone )
+                    deferredSinceReset = true;
+                done++;
+            }
+            startAt = (startAt + done) % sz;
+            visitedSinceReset += done;
+
+            if( visitedSinceReset >= sz ) {
+                // every file has had its turn.  unless some had to be skipped, the private views
+                // are about as small as the W lock remap would leave them
+                if( !deferredSinceReset ) {
+                    SimpleMutex::scoped_lock lk(commitJob.groupCommitMutex);
+                    privateMapBytes = 0;
+                }
+                visitedSinceReset = 0;
+                deferredSinceReset = false;
+            }
+        }
+
         // this is a pseudo-local variable in the groupcommit functions 
         // below.  however we don't truly do that so that we don't have to 
         // reallocate, and more importantly regrow it, on every single commit.
@@ -755,14 +891,19 @@ namespace mongo {
 
             const int N = 10;
             static int n;
-            if (privateMapBytes < UncommittedBytesLimit && ++n % N &&
+            const bool incremental = journalIncrementalRemap;
+            if (privateMapBytes < UncommittedBytesLimit && (incremental || ++n % N) &&
                 (storageGlobalParams.durOptions &
                  StorageGlobalParams::DurAlwaysRemap) == 0) {
                 // limited locks version doesn't do any remapprivateview at all, so only try this if privateMapBytes
                 // is in an acceptable range.  also every Nth commit, we do everything so we can do some remapping;
                 // remapping a lot all at once could cause jitter from a large amount of copy-on-writes all at once.
-                if( groupCommitWithLimitedLocks(&txn) )
+                // in incremental mode the remapping is done a file at a time right after the commit instead.
+                if( groupCommitWithLimitedLocks(&txn) ) {
+                    if( incremental )
+                        REMAPPRIVATEVIEWINCREMENTAL(&txn);
                     return;
+                }
             }
 
             // we get a write lock, downgrade, do work, upgrade, finish work.
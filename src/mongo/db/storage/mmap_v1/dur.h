@@ -49,6 +49,18 @@ namespace mongo {
         // a smaller limit is likely better on 32 bit
         const unsigned UncommittedBytesLimit = (sizeof(void*)==4) ? 50 * 1024 * 1024 : 100 * 1024 * 1024;
 
+        enum RemapFileResult { RemapFileDone, RemapFileHasIntents, RemapFileLockBusy };
+
+        /** Remaps one file's private view for the durThread's incremental remap, holding only the
+            write lock of its database.  Call without any lock.
+            @param maxWaitMillis how long to wait for the database lock before giving up
+            @return RemapFileDone if the view was remapped or didn't need it; otherwise the file
+                    was left for a later pass
+        */
+        RemapFileResult remapFileIncrementally(OperationContext* txn,
+                                               const std::string& filename,
+                                               int maxWaitMillis);
+
         /** Call during startup so durability module can initialize
             Throws if fatal error
             Does nothing if storageGlobalParams.dur is false
@@ -114,6 +114,18 @@ namespace mongo {
             _bytes = 0;
         }
 
+        bool CommitJob::hasIntentsWithin(void* start, unsigned long long len) {
+            SimpleMutex::scoped_lock lk(groupCommitMutex);
+            const char* lo = static_cast<char*>(start);
+            const char* hi = lo + len;
+            const std::vector<WriteIntent>& intents = _intentsAndDurOps._intents;
+            for( std::vector<WriteIntent>::const_iterator i = intents.begin(); i != intents.end(); ++i ) {
+                if( i->start() < hi && i->end() > lo )
+                    return true;
+            }
+            return false;
+        }
+
         void CommitJob::note(void* p, int len) {
             SimpleMutex::scoped_lock lk(groupCommitMutex);
             _hasWritten = true;
@@ -151,6 +151,12 @@ namespace mongo {
             */
             bool hasWritten() const { return _hasWritten; }
 
+            /** @return true if an uncommitted write intent overlaps [start, start+len).  threadsafe.
+                used by the incremental remap, which must not throw away private view pages that
+                have not reached the data files yet.
+            */
+            bool hasIntentsWithin(void* start, unsigned long long len);
+
         public:
             /** these called by the groupCommit code as it goes along */
             void commitingBegin();
@@ -40,6 +40,7 @@
 
 #include "mongo/base/init.h"
 #include "mongo/db/client.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/storage/mmap_v1/dur_journalformat.h"
 #include "mongo/db/storage/mmap_v1/dur_journalimpl.h"
 #include "mongo/db/storage/mmap_v1/dur_stats.h"
@@ -66,6 +67,30 @@ namespace mongo {
 
 
     namespace dur {
+        // Codec for journal sections: "snappy" or "none".  Sections record whether they are
+        // compressed, so this can change from one run to the next.  With "none" the journal
+        // files get a version older binaries refuse, so to downgrade after an unclean shutdown
+        // recover with this version and shut down cleanly first.
+        std::string journalCompressor = "snappy";
+
+        class ExportedJournalCompressorParameter : public ExportedServerParameter<std::string> {
+        public:
+            ExportedJournalCompressorParameter() :
+                ExportedServerParameter<std::string>(ServerParameterSet::getGlobal(),
+                                                     "journalCompressor",
+                                                     &journalCompressor,
+                                                     true,
+                                                     false) {}
+
+            virtual Status validate(const std::string& potentialNewValue) {
+                if (potentialNewValue != "snappy" && potentialNewValue != "none") {
+                    return Status(ErrorCodes::BadValue,
+                                  "journalCompressor must be \"snappy\" or \"none\"");
+                }
+                return Status::OK();
+            }
+        } exportedJournalCompressorParam;
+
         // Rotate after reaching this data size in a journal (j._<n>) file
         // We use a smaller size for 32 bit as the journal is mmapped during recovery (only)
         // Note if you take a set of datafiles, including journal files, from 32->64 or vice-versa, it must 
@@ -164,7 +189,7 @@ namespace mongo {
 
         JHeader::JHeader(string fname) {
             magic[0] = 'j'; magic[1] = '\n';
-            _version = CurrentVersion;
+            _version = journalCompressor == "none" ? UncompressedSectionsVersion : CurrentVersion;
             memset(ts, 0, sizeof(ts));
             time_t t = time(0);
             strncpy(ts, time_t_to_String_short(t).c_str(), sizeof(ts)-1);
@@ -730,7 +755,7 @@ namespace mongo {
             static AlignedBuilder b(32*1024*1024);
             /* buffer to journal will be
                JSectHeader
-               compressed operations
+               compressed (or, flagged in the header, uncompressed) operations
                JSectFooter
             */
             const unsigned headTailSize = sizeof(JSectHeader) + sizeof(JSectFooter);
@@ -738,14 +763,22 @@ namespace mongo {
             b.reset(max);
 
             {
-                dassert( h.sectionLen() == (unsigned) 0xffffffff ); // we will backfill later
+                dassert( h.sectionLen() == (unsigned) JSectHeader::MaxSectionLen ); // we will backfill later
                 b.appendStruct(h);
             }
 
+            // sections are always compressed in files older versions can read, see JHeader
+            bool compressed = journalCompressor != "none";
             size_t compressedLength = 0;
-            rawCompress(uncompressed.buf(), uncompressed.len(), b.cur(), &compressedLength);
-            verify( compressedLength < 0xffffffff );
-            verify( compressedLength < max );
+            if( compressed ) {
+                rawCompress(uncompressed.buf(), uncompressed.len(), b.cur(), &compressedLength);
+                verify( compressedLength < 0xffffffff );
+                verify( compressedLength < max );
+            }
+            else {
+                memcpy(b.cur(), uncompressed.buf(), uncompressed.len());
+                compressedLength = uncompressed.len();
+            }
             b.skip(compressedLength);
 
             // footer
@@ -757,7 +790,7 @@ namespace mongo {
                 L = (lenUnpadded + Alignment-1) & (~(Alignment-1));
                 dassert( L >= lenUnpadded );
 
-                ((JSectHeader*)b.atOfs(0))->setSectionLen(lenUnpadded);
+                ((JSectHeader*)b.atOfs(0))->setSectionLen(lenUnpadded, compressed);
 
                 JSectFooter f(b.buf(), b.len()); // computes checksum
                 b.appendStruct(f);
@@ -774,6 +807,8 @@ namespace mongo {
                 verify( _curLogFile );
 
                 stats.curr->_uncompressedBytes += uncompressed.len();
+                if( !compressed )
+                    stats.curr->_uncompressedSections++;
                 unsigned w = b.len();
                 _written += w;
                 verify( w <= L );
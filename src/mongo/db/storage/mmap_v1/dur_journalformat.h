@@ -58,6 +58,9 @@ namespace mongo {
 #else
             enum { CurrentVersion = 0x4149 };
 #endif
+            // files of this version may have sections written without compression.  older
+            // versions refuse them, so they are only written with journalCompressor=none
+            enum { UncompressedSectionsVersion = 0x414A };
             unsigned short _version;
 
             // these are just for diagnostic ease (make header more useful as plain text)
@@ -72,25 +75,37 @@ namespace mongo {
             char reserved3[8026]; // 8KB total for the file header
             char txt2[2];         // "\n\n" at the end
 
-            bool versionOk() const { return _version == CurrentVersion; }
+            bool versionOk() const {
+                return _version == CurrentVersion || _version == UncompressedSectionsVersion;
+            }
             bool valid() const { return magic[0] == 'j' && txt2[1] == '\n' && fileId; }
         };
 
         /** "Section" header.  A section corresponds to a group commit.
             len is length of the entire section including header and footer.
-            header and footer are not compressed, just the stuff in between.
+            header and footer are not compressed, just the stuff in between.  that is compressed
+            unless the header is flagged uncompressed (journal version 0x414A and up).
         */
         struct JSectHeader {
+            enum {
+                UncompressedFlag = 0x80000000, // high bit of _sectionLen
+                MaxSectionLen    = 0x7fffffff
+            };
         private:
-            unsigned _sectionLen;          // unpadded length in bytes of the whole section
+            unsigned _sectionLen;          // unpadded length in bytes of the whole section, and UncompressedFlag
         public:
             unsigned long long seqNumber;  // sequence number that can be used on recovery to not do too much work
             unsigned long long fileId;     // matches JHeader::fileId
-            unsigned sectionLen() const { return _sectionLen; }
+            unsigned sectionLen() const { return _sectionLen & MaxSectionLen; }
 
             // we store the unpadded length so we can use that when we uncompress. to 
             // get the true total size this must be rounded up to the Alignment.
-            void setSectionLen(unsigned lenUnpadded) { _sectionLen = lenUnpadded; }
+            void setSectionLen(unsigned lenUnpadded, bool compressed = true) {
+                verify( lenUnpadded <= MaxSectionLen );
+                _sectionLen = compressed ? lenUnpadded : (lenUnpadded | UncompressedFlag);
+            }
+
+            bool isCompressed() const { return (_sectionLen & UncompressedFlag) == 0; }
 
             unsigned sectionLenWithPadding() const { 
                 unsigned x = (sectionLen() + (Alignment-1)) & (~(Alignment-1));
@@ -164,7 +164,7 @@ namespace mongo {
         static void resetLogBuffer(/*out*/JSectHeader& h, AlignedBuilder& bb) {
             bb.reset();
 
-            h.setSectionLen(0xffffffff);  // total length, will fill in later
+            h.setSectionLen(JSectHeader::MaxSectionLen);  // total length, will fill in later
             h.seqNumber = getLastDataFileFlushTime();
             h.fileId = j.curFileId();
         }
@@ -35,6 +35,7 @@
 #include "mongo/db/storage/mmap_v1/dur_recover.h"
 
 #include <boost/filesystem/operations.hpp>
+#include <boost/thread/thread.hpp>
 #include <fcntl.h>
 #include <sys/stat.h>
 
@@ -50,12 +51,15 @@
 #include "mongo/db/storage/mmap_v1/dur_stats.h"
 #include "mongo/db/storage/mmap_v1/durop.h"
 #include "mongo/db/storage/mmap_v1/durable_mapped_file.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/storage_options.h"
 #include "mongo/util/bufreader.h"
 #include "mongo/util/checksum.h"
 #include "mongo/util/compress.h"
+#include "mongo/util/concurrency/thread_pool.h"
 #include "mongo/util/log.h"
 #include "mongo/util/mongoutils/str.h"
+#include "mongo/util/progress_meter.h"
 #include "mongo/util/startup_test.h"
 
 using namespace mongoutils;
@@ -78,6 +82,16 @@ namespace mongo {
             shared_ptr<DurOp> op;
         };
 
+        /** Number of threads that decode sections and apply writes during recovery.  0 picks one
+            per core, up to 8; 1 recovers serially, one section at a time, as older versions did.
+        */
+        MONGO_EXPORT_STARTUP_SERVER_PARAMETER(journalRecoveryThreads, int, 0);
+
+        // Upper bound on the uncompressed bytes of the sections decoded at once by a parallel
+        // recovery, as they are held in memory until they have been applied.  A single section
+        // larger than this is still decoded on its own.
+        static const unsigned ParallelRecoveryWindowBytes = 64 * 1024 * 1024;
+
         void removeJournalFiles();
         boost::filesystem::path getJournalDir();
 
@@ -123,6 +137,12 @@ namespace mongo {
                 , _doDurOps(doDurOpsRecovering)
             {
                 verify( doDurOpsRecovering );
+                verify( compressedLen == _h.sectionLen() - sizeof(JSectFooter) - sizeof(JSectHeader) );
+                if( !_h.isCompressed() ) {
+                    // written as is; read straight from the journal file
+                    _entries = auto_ptr<BufReader>( new BufReader((const char *) compressed, compressedLen) );
+                    return;
+                }
                 bool ok = uncompress((const char *)compressed, compressedLen, &_uncompressed);
                 if( !ok ) { 
                     // it should always be ok (i think?) as there is a previous check to see that the JSectFooter is ok
@@ -130,7 +150,6 @@ namespace mongo {
                     msgasserted(15874, "couldn't uncompress journal section");
                 }
                 const char *p = _uncompressed.c_str();
-                verify( compressedLen == _h.sectionLen() - sizeof(JSectFooter) - sizeof(JSectHeader) );
                 _entries = auto_ptr<BufReader>( new BufReader(p, _uncompressed.size()) );
             }
 
@@ -368,6 +387,221 @@ namespace mongo {
                 log() << "END section" << endl;
         }
 
+        /** a section of a journal file, decoded by a worker during parallel recovery */
+        struct DecodedSection {
+            DecodedSection(const JSectHeader* h_, const char* data_, unsigned len_,
+                           const JSectFooter* f_) :
+                h(h_), data(data_), len(len_), f(f_), eof(false), errCode(0) {
+            }
+
+            const JSectHeader* h;
+            const char* data;
+            unsigned len;
+            const JSectFooter* f;
+
+            shared_ptr<JournalSectionIterator> it; // owns the uncompressed data entries point into
+            vector<ParsedJournalEntry> entries;
+
+            // set if decoding failed.  sections before this one are still applied, as the serial
+            // recovery would have done.
+            bool eof;       // premature end of the section: an abrupt end of the journal
+            int errCode;
+            string errMsg;
+        };
+
+        /** runs on a worker: the same parsing and checks as processSection() */
+        static void decodeSection(DecodedSection* s) {
+            try {
+                s->it.reset(new JournalSectionIterator(*s->h, s->data, s->len, true));
+                while( !s->it->atEof() ) {
+                    ParsedJournalEntry e;
+                    s->it->next(e);
+                    s->entries.push_back(e);
+                }
+                if( !s->f->checkHash(s->h, s->len + sizeof(JSectHeader)) ) {
+                    msgasserted(13594, "journal checksum doesn't match");
+                }
+            }
+            catch( BufReader::eof& ) {
+                s->eof = true;
+            }
+            catch( DBException& e ) {
+                s->errCode = e.getCode();
+                s->errMsg = e.what();
+            }
+            catch( std::exception& e ) {
+                s->errCode = 18652;
+                s->errMsg = e.what();
+            }
+        }
+
+        /** runs on a worker: applies writes which all go to the same file, in order */
+        static void applyWritesToFile(DurableMappedFile* mmf,
+                                      const vector<const ParsedJournalEntry*>* writes) {
+            char* view = (char*) mmf->view_write();
+            for( vector<const ParsedJournalEntry*>::const_iterator i = writes->begin(); i != writes->end(); ++i ) {
+                const JEntry* e = (*i)->e;
+                // as in write(), writes past the end of the file are skipped while recovering
+                if( (e->ofs + e->len) <= mmf->length() ) {
+                    memcpy(view + e->ofs, e->srcData(), e->len);
+                }
+            }
+        }
+
+        /** Applies basic writes, each data file's writes by one worker in journal order. */
+        void RecoveryJob::applyWritesInParallel(vector<const ParsedJournalEntry*>& writes) {
+            if( writes.empty() )
+                return;
+
+            // files are opened here rather than on the workers, as that updates _mmfs
+            typedef map<DurableMappedFile*, vector<const ParsedJournalEntry*> > ByFile;
+            ByFile byFile;
+            DurableMappedFile* lastFile = NULL;
+            const char* lastDbName = NULL;
+            int lastFileNo = -1;
+            for( vector<const ParsedJournalEntry*>::const_iterator i = writes.begin(); i != writes.end(); ++i ) {
+                const ParsedJournalEntry& entry = **i;
+                verify(entry.dbName);
+                const int fileNo = entry.e->getFileNo();
+                if( lastFile == NULL || fileNo != lastFileNo || strcmp(entry.dbName, lastDbName) != 0 ) {
+                    lastFile = getDurableMappedFile(entry);
+                    verify(lastFile->view_write());
+                    lastDbName = entry.dbName;
+                    lastFileNo = fileNo;
+                }
+                byFile[lastFile].push_back(&entry);
+                stats.curr->_writeToDataFilesBytes += entry.e->len;
+            }
+
+            for( ByFile::const_iterator i = byFile.begin(); i != byFile.end(); ++i ) {
+                _workers->schedule(applyWritesToFile, i->first, &i->second);
+            }
+            _workers->join();
+            writes.clear();
+        }
+
+        /** Applies a run of decoded sections in order.  DurOps are barriers: the writes before
+            one are all applied before it is replayed.
+            @return true if the journal ends abruptly within these sections
+        */
+        bool RecoveryJob::applyDecodedSections(vector<DecodedSection>& sections) {
+            const bool apply = (storageGlobalParams.durOptions &
+                                StorageGlobalParams::DurScanOnly) == 0;
+
+            LockMongoFilesShared lkFiles; // for RecoveryJob::Last, as in processSection()
+            scoped_lock lk(_mx);
+            Last last;
+            vector<const ParsedJournalEntry*> writes;
+            for( vector<DecodedSection>::iterator s = sections.begin(); s != sections.end(); ++s ) {
+                if( s->eof || s->errCode ) {
+                    if( apply )
+                        applyWritesInParallel(writes);
+                    if( s->eof )
+                        return true;
+                    log() << "recover error in section seq:" << s->h->seqNumber << " " << s->errMsg << endl;
+                    msgasserted(s->errCode, s->errMsg);
+                }
+                if( !apply )
+                    continue;
+
+                for( vector<ParsedJournalEntry>::const_iterator e = s->entries.begin(); e != s->entries.end(); ++e ) {
+                    if( e->e ) {
+                        writes.push_back(&*e);
+                    }
+                    else if( e->op ) {
+                        applyWritesInParallel(writes);
+                        applyEntry(last, *e, apply, false);
+                    }
+                }
+            }
+            if( apply )
+                applyWritesInParallel(writes);
+            return false;
+        }
+
+        /** Parallel counterpart of the section loop in processFileBuffer().  Sections are
+            decoded and checked by the workers a window at a time, then applied in order.
+            @return true if the journal ends abruptly in this file
+        */
+        bool RecoveryJob::processSectionsInParallel(BufReader& br, unsigned long long fileId,
+                                                    unsigned len, const string& name) {
+            ProgressMeter pm(len, 10, 1, "bytes", "recover " + name);
+            ProgressMeterHolder pmh(pm);
+
+            bool abruptEnd = false;
+            bool otherFile = false;
+            while( !br.atEof() && !abruptEnd && !otherFile ) {
+                vector<DecodedSection> window;
+                size_t windowBytes = 0;
+                unsigned windowPadded = 0;
+                try {
+                    while( !br.atEof() && windowBytes < ParallelRecoveryWindowBytes ) {
+                        JSectHeader h;
+                        br.peek(h);
+                        if( h.fileId != fileId ) {
+                            if (debug || (storageGlobalParams.durOptions &
+                                          StorageGlobalParams::DurDumpJournal)) {
+                                log() << "Ending processFileBuffer at differing fileId want:" << fileId << " got:" << h.fileId << endl;
+                                log() << "  sect len:" << h.sectionLen() << " seqnum:" << h.seqNumber << endl;
+                            }
+                            otherFile = true;
+                            break;
+                        }
+                        unsigned slen = h.sectionLen();
+                        unsigned dataLen = slen - sizeof(JSectHeader) - sizeof(JSectFooter);
+                        const char *hdr = (const char *) br.skip(h.sectionLenWithPadding());
+                        const char *data = hdr + sizeof(JSectHeader);
+                        const char *footer = data + dataLen;
+
+                        if( _lastDataSyncedFromLastRun > h.seqNumber + ExtraKeepTimeMs ) {
+                            // already in the data files, as in processSection()
+                            windowPadded += h.sectionLenWithPadding();
+                            continue;
+                        }
+
+                        // budget on what decoding will hold in memory, not on the journal bytes
+                        size_t decodedLen = dataLen;
+                        if( h.isCompressed() && !uncompressedLength(data, dataLen, &decodedLen) ) {
+                            // corrupt; decodeSection() reports it
+                            decodedLen = dataLen;
+                        }
+                        if( !window.empty() &&
+                                windowBytes + decodedLen > ParallelRecoveryWindowBytes ) {
+                            // left for the next window
+                            br.rewind(h.sectionLenWithPadding());
+                            break;
+                        }
+
+                        window.push_back(DecodedSection((const JSectHeader*) hdr, data, dataLen,
+                                                        (const JSectFooter*) footer));
+                        windowBytes += decodedLen;
+                        windowPadded += h.sectionLenWithPadding();
+                    }
+                }
+                catch( BufReader::eof& ) {
+                    // the sections read so far are still applied
+                    abruptEnd = true;
+                }
+
+                for( unsigned i = 0; i < window.size(); i++ ) {
+                    _workers->schedule(decodeSection, &window[i]);
+                }
+                _workers->join();
+
+                if( applyDecodedSections(window) )
+                    abruptEnd = true;
+
+                pm.hit(windowPadded);
+
+                // ctrl c check
+                uassert(ErrorCodes::Interrupted, "interrupted during journal recovery", !inShutdown());
+            }
+
+            if( abruptEnd && (storageGlobalParams.durOptions & StorageGlobalParams::DurDumpJournal) )
+                log() << "ABRUPT END" << endl;
+            return abruptEnd || otherFile;
+        }
+
         void RecoveryJob::processSection(const JSectHeader *h, const void *p, unsigned len, const JSectFooter *f) {
             LockMongoFilesShared lkFiles; // for RecoveryJob::Last
             scoped_lock lk(_mx);
@@ -434,7 +668,7 @@ namespace mongo {
             @param p start of the memory mapped file
             @return true if this is detected to be the last file (ends abruptly)
         */
-        bool RecoveryJob::processFileBuffer(const void *p, unsigned len) {
+        bool RecoveryJob::processFileBuffer(const void *p, unsigned len, const string& name) {
             try {
                 unsigned long long fileId;
                 BufReader br(p,len);
@@ -455,8 +689,9 @@ namespace mongo {
 
                     if( !h.versionOk() ) {
                         log() << "journal file version number mismatch got:" << hex << h._version                             
-                            << " expected:" << hex << (unsigned) JHeader::CurrentVersion 
-                            << ". if you have just upgraded, recover with old version of mongod, terminate cleanly, then upgrade." 
+                            << " expected:" << hex << (unsigned) JHeader::CurrentVersion
+                            << " or " << hex << (unsigned) JHeader::UncompressedSectionsVersion
+                            << ". if you have just upgraded, recover with old version of mongod, terminate cleanly, then upgrade."
                             << endl;
                         uasserted(13536, str::stream() << "journal version number mismatch " << h._version);
                     }
@@ -467,6 +702,9 @@ namespace mongo {
                     }
                 }
 
+                if( _workers )
+                    return processSectionsInParallel(br, fileId, len, name);
+
                 // read sections
                 while ( !br.atEof() ) {
                     JSectHeader h;
@@ -516,7 +754,7 @@ namespace mongo {
             MemoryMappedFile f;
             void *p = f.mapWithOptions(journalfile.string().c_str(), MongoFile::READONLY | MongoFile::SEQUENTIAL);
             massert(13544, str::stream() << "recover error couldn't open " << journalfile.string(), p);
-            return processFileBuffer(p, (unsigned) f.length());
+            return processFileBuffer(p, (unsigned) f.length(), journalfile.leaf().string());
         }
 
         /** @param files all the j._0 style files we need to apply for recovery */
@@ -529,14 +767,35 @@ namespace mongo {
             _lastDataSyncedFromLastRun = journalReadLSN();
             log() << "recover lsn: " << _lastDataSyncedFromLastRun << endl;
 
-            for( unsigned i = 0; i != files.size(); ++i ) {
-                bool abruptEnd = processFile(files[i]);
-                if( abruptEnd && i+1 < files.size() ) {
-                    log() << "recover error: abrupt end to file " << files[i].string() << ", yet it isn't the last journal file" << endl;
-                    close();
-                    uasserted(13535, "recover abrupt journal file end");
+            int nThreads = journalRecoveryThreads;
+            if( nThreads == 0 )
+                nThreads = std::min(8u, std::max(1u, boost::thread::hardware_concurrency()));
+            // the journal dump has to come out in order
+            if( storageGlobalParams.durOptions & StorageGlobalParams::DurDumpJournal )
+                nThreads = 1;
+
+            scoped_ptr<threadpool::ThreadPool> workers;
+            if( nThreads > 1 ) {
+                log() << "recover using " << nThreads << " threads" << endl;
+                workers.reset(new threadpool::ThreadPool(nThreads));
+            }
+            _workers = workers.get();
+
+            try {
+                for( unsigned i = 0; i != files.size(); ++i ) {
+                    bool abruptEnd = processFile(files[i]);
+                    if( abruptEnd && i+1 < files.size() ) {
+                        log() << "recover error: abrupt end to file " << files[i].string() << ", yet it isn't the last journal file" << endl;
+                        close();
+                        uasserted(13535, "recover abrupt journal file end");
+                    }
                 }
             }
+            catch(...) {
+                _workers = NULL;
+                throw;
+            }
+            _workers = NULL;
 
             close();
 
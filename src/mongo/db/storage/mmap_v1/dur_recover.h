@@ -38,10 +38,16 @@
 #include "mongo/util/file.h"
 
 namespace mongo {
+    class BufReader;
     class DurableMappedFile;
 
+    namespace threadpool {
+        class ThreadPool;
+    }
+
     namespace dur {
         struct ParsedJournalEntry;
+        struct DecodedSection;
 
         /** call go() to execute a recovery from existing journal files.
          */
@@ -57,7 +63,7 @@ namespace mongo {
             } last;        
         public:
             RecoveryJob() : _lastDataSyncedFromLastRun(0), 
-                _mx("recovery"), _recovering(false) { _lastSeqMentionedInConsoleLog = 1; }
+                _mx("recovery"), _recovering(false), _workers(NULL) { _lastSeqMentionedInConsoleLog = 1; }
             void go(std::vector<boost::filesystem::path>& files);
             ~RecoveryJob();
 
@@ -71,8 +77,14 @@ namespace mongo {
             void write(Last& last, const ParsedJournalEntry& entry); // actually writes to the file
             void applyEntry(Last& last, const ParsedJournalEntry& entry, bool apply, bool dump);
             void applyEntries(const std::vector<ParsedJournalEntry> &entries);
-            bool processFileBuffer(const void *, unsigned len);
+            bool processFileBuffer(const void *, unsigned len, const std::string& name);
             bool processFile(boost::filesystem::path journalfile);
+
+            // parallel recovery, see journalRecoveryThreads
+            bool processSectionsInParallel(BufReader& br, unsigned long long fileId,
+                                           unsigned len, const std::string& name);
+            bool applyDecodedSections(std::vector<DecodedSection>& sections);
+            void applyWritesInParallel(std::vector<const ParsedJournalEntry*>& writes);
             void _close(); // doesn't lock
             DurableMappedFile* getDurableMappedFile(const ParsedJournalEntry& entry);
 
@@ -84,6 +96,7 @@ namespace mongo {
             mongo::mutex _mx; // protects _mmfs
         private:
             bool _recovering; // are we in recovery or WRITETODATAFILES
+            threadpool::ThreadPool* _workers; // set while recovering in parallel
 
             static RecoveryJob &_instance;
         };
@@ -49,6 +49,7 @@ namespace mongo {
                 unsigned _earlyCommits; // count of early commits from commitIfNeeded() or from getDur().commitNow()
                 unsigned long long _journaledBytes;
                 unsigned long long _uncompressedBytes;
+                unsigned _uncompressedSections; // sections journaled without compression
                 unsigned long long _writeToDataFilesBytes;
 
                 long long _prepLogBufferMicros;
@@ -56,6 +57,14 @@ namespace mongo {
                 long long _writeToDataFilesMicros;
                 long long _remapPrivateViewMicros;
 
+                // incremental remap: each file is remapped in its own chunk under its database's
+                // write lock rather than the global one
+                long long _remapChunkMicros;     // total time in chunks, including lock waits
+                long long _remapChunkMaxMicros;  // longest single chunk
+                unsigned _remapChunks;           // files remapped incrementally
+                unsigned _remapChunksDeferred;   // files skipped because they had uncommitted writes
+                unsigned _remapChunksLockBusy;   // files skipped because their database lock was busy
+
                 // undesirable to be in write lock for the group commit (it can be done in a read lock), so good if we
                 // have visibility when this happens.  can happen for a couple reasons
                 // - read lock starvation
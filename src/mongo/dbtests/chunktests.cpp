@@ -40,10 +40,12 @@ namespace mongo {
     public:
         void setShardKey( const BSONObj &keyPattern ) {
             const_cast<ShardKeyPattern&>(_key) = ShardKeyPattern( keyPattern );
+            const_cast<ShardKeyPattern&>(_state->key) = ShardKeyPattern( keyPattern );
         }
-        void setSingleChunkForShards( const vector<BSONObj> &splitPoints ) {
-            ChunkMap &chunkMap = const_cast<ChunkMap&>( _chunkMap );
-            ChunkRangeManager &chunkRanges = const_cast<ChunkRangeManager&>( _chunkRanges );
+        void setSingleChunkForShards( const vector<BSONObj> &splitPoints,
+                                      unsigned chunksPerShard = 1 ) {
+            ChunkMap chunkMap;
+            ChunkRoutingTable &routingTable = const_cast<ChunkRoutingTable&>( _routingTable );
             set<Shard> &shards = const_cast<set<Shard>&>( _shards );
             
             vector<BSONObj> mySplitPoints( splitPoints );
@@ -51,7 +53,7 @@ namespace mongo {
             mySplitPoints.push_back( _key.globalMax() );
             
             for( unsigned i = 1; i < mySplitPoints.size(); ++i ) {
-                string name = str::stream() << (i-1);
+                string name = str::stream() << (i-1) / chunksPerShard;
                 Shard shard( name, name );
                 shards.insert( shard );
                 
@@ -60,7 +62,7 @@ namespace mongo {
                 chunkMap[ mySplitPoints[ i ] ] = chunk;
             }
             
-            chunkRanges.reloadAll( chunkMap );
+            verify( routingTable.reloadFrom( ChunkRoutingTable(), chunkMap ) );
         }
     };
     
@@ -247,6 +249,262 @@ namespace ChunkTests {
             }
         };
 
+        /**
+         * Every key is routed to the chunk that contains it, whichever way the routing table looks
+         * it up.
+         */
+        class FindIntersectingChunkBase {
+        public:
+            virtual ~FindIntersectingChunkBase() {}
+            void run() {
+                ChunkManager chunkManager;
+                chunkManager.setShardKey( BSON( "a" << 1 ) );
+                const vector<BSONObj> splits = splitPoints();
+                chunkManager.setSingleChunkForShards( splits );
+
+                const vector<BSONObj> keys = points();
+                for( unsigned i = 0; i < keys.size(); ++i ) {
+                    unsigned expected = 0;
+                    while( expected < splits.size() && splits[ expected ].woCompare( keys[ i ] ) <= 0 ) {
+                        ++expected;
+                    }
+
+                    ChunkPtr chunk = chunkManager.findIntersectingChunk( keys[ i ] );
+                    ASSERT( chunk->containsPoint( keys[ i ] ) );
+                    ASSERT_EQUALS( string( str::stream() << expected ), chunk->getShard().getName() );
+                }
+            }
+        protected:
+            virtual vector<BSONObj> splitPoints() const = 0;
+            virtual vector<BSONObj> points() const = 0;
+        };
+
+        class FindIntersectingChunkIntegral : public FindIntersectingChunkBase {
+            virtual vector<BSONObj> splitPoints() const {
+                vector<BSONObj> ret;
+                for( int i = -5000; i < 5000; i += 10 ) {
+                    ret.push_back( BSON( "a" << i ) );
+                }
+                return ret;
+            }
+            virtual vector<BSONObj> points() const {
+                vector<BSONObj> ret;
+                for( int i = -5020; i < 5020; ++i ) {
+                    ret.push_back( BSON( "a" << i ) );
+                    ret.push_back( BSON( "a" << static_cast<long long>( i ) ) );
+                }
+                // These aren't integers, so take the slow path.
+                ret.push_back( BSON( "a" << 9.5 ) );
+                ret.push_back( BSON( "a" << 10.0 ) );
+                ret.push_back( BSON( "a" << -1e100 ) );
+                ret.push_back( BSON( "a" << "x" ) );
+                ret.push_back( BSON( "a" << MINKEY ) );
+                ret.push_back( BSON( "a" << MAXKEY ) );
+                return ret;
+            }
+        };
+
+        class FindIntersectingChunkHashed : public FindIntersectingChunkBase {
+            virtual vector<BSONObj> splitPoints() const {
+                vector<BSONObj> ret;
+                for( long long i = -4; i < 4; ++i ) {
+                    ret.push_back( BSON( "a" << i * ( 1LL << 61 ) ) );
+                }
+                return ret;
+            }
+            virtual vector<BSONObj> points() const {
+                vector<BSONObj> ret;
+                for( long long i = -4; i < 4; ++i ) {
+                    ret.push_back( BSON( "a" << i * ( 1LL << 61 ) - 1 ) );
+                    ret.push_back( BSON( "a" << i * ( 1LL << 61 ) ) );
+                    ret.push_back( BSON( "a" << i * ( 1LL << 61 ) + 1 ) );
+                }
+                ret.push_back( BSON( "a" << std::numeric_limits<long long>::min() ) );
+                ret.push_back( BSON( "a" << std::numeric_limits<long long>::max() ) );
+                return ret;
+            }
+        };
+
+        class FindIntersectingChunkMixed : public FindIntersectingChunkBase {
+            virtual vector<BSONObj> splitPoints() const {
+                vector<BSONObj> ret;
+                ret.push_back( BSON( "a" << 0 ) );
+                ret.push_back( BSON( "a" << 2.5 ) );
+                ret.push_back( BSON( "a" << "m" ) );
+                return ret;
+            }
+            virtual vector<BSONObj> points() const {
+                vector<BSONObj> ret;
+                ret.push_back( BSON( "a" << -1 ) );
+                ret.push_back( BSON( "a" << 0 ) );
+                ret.push_back( BSON( "a" << 2 ) );
+                ret.push_back( BSON( "a" << 3 ) );
+                ret.push_back( BSON( "a" << "a" ) );
+                ret.push_back( BSON( "a" << "z" ) );
+                return ret;
+            }
+        };
+
+        /** Consecutive chunks on the same shard are only reported once. */
+        class RangeOverChunksOnSameShard {
+        public:
+            void run() {
+                ChunkManager chunkManager;
+                chunkManager.setShardKey( BSON( "a" << 1 ) );
+                vector<BSONObj> splitPoints;
+                for( int i = 1; i < 12; ++i ) {
+                    splitPoints.push_back( BSON( "a" << i ) );
+                }
+                chunkManager.setSingleChunkForShards( splitPoints, 3 );
+
+                set<Shard> shards;
+                chunkManager.getShardsForRange( shards, BSON( "a" << 2 ), BSON( "a" << 7 ) );
+                BSONArrayBuilder b;
+                for( set<Shard>::const_iterator i = shards.begin(); i != shards.end(); ++i ) {
+                    b << i->getName();
+                }
+                ASSERT_EQUALS( BSON_ARRAY( "0" << "1" << "2" ), b.arr() );
+            }
+        };
+
+        /**
+         * Refreshing the routing table with a few changed chunks shares the blocks of the old
+         * table which none of the changes overlap.
+         */
+        class RefreshBase {
+        public:
+            virtual ~RefreshBase() {}
+            void run() {
+                _chunkManager.setShardKey( BSON( "a" << 1 ) );
+                vector<BSONObj> splitPoints;
+                for( int i = 0; i < 1000; ++i ) {
+                    splitPoints.push_back( BSON( "a" << i * 10 ) );
+                }
+                _chunkManager.setSingleChunkForShards( splitPoints, 100 );
+                const ChunkRoutingTable& base = _chunkManager.getChunks();
+
+                ChunkMap changed;
+                changes( &changed );
+                ChunkRoutingTable refreshed;
+                ASSERT( refreshed.reloadFrom( base, changed ) );
+                refreshed.assertValid();
+
+                // The old table is left as it was.
+                ASSERT_EQUALS( 1001U, base.size() );
+                check( base, refreshed );
+            }
+        protected:
+            virtual void changes( ChunkMap* changed ) = 0;
+            virtual void check( const ChunkRoutingTable& base,
+                                const ChunkRoutingTable& refreshed ) = 0;
+
+            void addChunk( ChunkMap* chunks, int min, int max, const string& shard,
+                           ChunkVersion lastmod = ChunkVersion( 2, 0, OID() ) ) {
+                ChunkPtr chunk( new Chunk( &_chunkManager, BSON( "a" << min ),
+                                           BSON( "a" << max ), Shard( shard, shard ), lastmod ) );
+                (*chunks)[ chunk->getMax() ] = chunk;
+            }
+
+            static ChunkPtr find( const ChunkRoutingTable& chunks, int key ) {
+                ChunkRoutingTable::const_iterator it = chunks.upperBound( BSON( "a" << key ) );
+                ASSERT( it != chunks.end() );
+                return it->second;
+            }
+
+            static size_t numBlocks( const ChunkRoutingTable& chunks ) {
+                return chunks.numSharedBlocks( chunks );
+            }
+
+            ChunkManager _chunkManager;
+        };
+
+        class RefreshSplitChunk : public RefreshBase {
+            virtual void changes( ChunkMap* changed ) {
+                addChunk( changed, 5000, 5005, "5" );
+                addChunk( changed, 5005, 5010, "5" );
+            }
+            virtual void check( const ChunkRoutingTable& base,
+                                const ChunkRoutingTable& refreshed ) {
+                ASSERT_EQUALS( 1002U, refreshed.size() );
+                ASSERT_EQUALS( numBlocks( base ) - 1, refreshed.numSharedBlocks( base ) );
+                ASSERT_EQUALS( BSON( "a" << 5005 ), find( refreshed, 5007 )->getMin() );
+                ASSERT_EQUALS( BSON( "a" << 5005 ), find( refreshed, 5004 )->getMax() );
+                // Chunks that didn't change aren't copied, even in the rebuilt block.
+                ASSERT( find( base, 5010 ) == find( refreshed, 5010 ) );
+                ASSERT( find( base, 12 ) == find( refreshed, 12 ) );
+            }
+        };
+
+        class RefreshMovedChunk : public RefreshBase {
+            virtual void changes( ChunkMap* changed ) {
+                addChunk( changed, 5000, 5010, "other" );
+            }
+            virtual void check( const ChunkRoutingTable& base,
+                                const ChunkRoutingTable& refreshed ) {
+                ASSERT_EQUALS( 1001U, refreshed.size() );
+                ASSERT_EQUALS( numBlocks( base ) - 1, refreshed.numSharedBlocks( base ) );
+                ASSERT_EQUALS( "other", find( refreshed, 5000 )->getShard().getName() );
+                ASSERT_EQUALS( "5", find( base, 5000 )->getShard().getName() );
+
+                set<Shard> shards;
+                ASSERT( refreshed.getShardsForRange( &shards, BSON( "a" << 4990 ),
+                                                     BSON( "a" << 5010 ), 100 ) );
+                ASSERT_EQUALS( 2U, shards.size() );
+            }
+        };
+
+        /** Chunks returned again by the config servers without changes are ignored. */
+        class RefreshUnchangedChunk : public RefreshBase {
+            virtual void changes( ChunkMap* changed ) {
+                addChunk( changed, 5000, 5010, "5", ChunkVersion() );
+            }
+            virtual void check( const ChunkRoutingTable& base,
+                                const ChunkRoutingTable& refreshed ) {
+                ASSERT_EQUALS( 1001U, refreshed.size() );
+                ASSERT_EQUALS( numBlocks( base ), refreshed.numSharedBlocks( base ) );
+                ASSERT( find( base, 5000 ) == find( refreshed, 5000 ) );
+            }
+        };
+
+        /** A change overlapping several blocks rebuilds all of them. */
+        class RefreshMergedChunks : public RefreshBase {
+            virtual void changes( ChunkMap* changed ) {
+                addChunk( changed, 1000, 3000, "1" );
+            }
+            virtual void check( const ChunkRoutingTable& base,
+                                const ChunkRoutingTable& refreshed ) {
+                ASSERT_EQUALS( 802U, refreshed.size() );
+                ASSERT_LESS_THAN( refreshed.numSharedBlocks( base ), numBlocks( base ) - 1 );
+                ASSERT_EQUALS( BSON( "a" << 1000 ), find( refreshed, 2999 )->getMin() );
+                ASSERT_EQUALS( BSON( "a" << 1000 ), find( refreshed, 995 )->getMax() );
+                ASSERT_EQUALS( BSON( "a" << 3000 ), find( refreshed, 3000 )->getMin() );
+            }
+        };
+
+        /** Changes which leave a gap, as read while chunks were being split, are rejected. */
+        class RefreshWithGap {
+        public:
+            void run() {
+                ChunkManager chunkManager;
+                chunkManager.setShardKey( BSON( "a" << 1 ) );
+                vector<BSONObj> splitPoints;
+                for( int i = 0; i < 1000; ++i ) {
+                    splitPoints.push_back( BSON( "a" << i * 10 ) );
+                }
+                chunkManager.setSingleChunkForShards( splitPoints );
+
+                ChunkMap changed;
+                ChunkPtr chunk( new Chunk( &chunkManager, BSON( "a" << 5000 ),
+                                           BSON( "a" << 5005 ), Shard( "501", "501" ),
+                                           ChunkVersion( 2, 0, OID() ) ) );
+                changed[ chunk->getMax() ] = chunk;
+
+                ChunkRoutingTable refreshed;
+                ASSERT( !refreshed.reloadFrom( chunkManager.getChunks(), changed ) );
+                ASSERT( refreshed.empty() );
+            }
+        };
+
     } // namespace ChunkManagerTests
     
     class All : public Suite {
@@ -275,6 +533,15 @@ namespace ChunkTests {
             add<ChunkManagerTests::InequalityThenUnsatisfiable>();
             add<ChunkManagerTests::OrEqualityUnsatisfiableInequality>();
             add<ChunkManagerTests::InMultiShard>();
+            add<ChunkManagerTests::FindIntersectingChunkIntegral>();
+            add<ChunkManagerTests::FindIntersectingChunkHashed>();
+            add<ChunkManagerTests::FindIntersectingChunkMixed>();
+            add<ChunkManagerTests::RangeOverChunksOnSameShard>();
+            add<ChunkManagerTests::RefreshSplitChunk>();
+            add<ChunkManagerTests::RefreshMovedChunk>();
+            add<ChunkManagerTests::RefreshUnchangedChunk>();
+            add<ChunkManagerTests::RefreshMergedChunks>();
+            add<ChunkManagerTests::RefreshWithGap>();
         }
     } myall;
     
@@ -848,6 +848,105 @@ namespace DocumentSourceTests {
             }
         };
 
+        /** Base for groups over synthetic input that has been through a $sort. */
+        class SortedInputBase : public CheckResultsBase {
+        protected:
+            void createSortedInput( const char* documents, const BSONObj& sortKey ) {
+                _data = fromjson( string( "{'':" ) + documents + "}" );
+                _array = DocumentSourceBsonArray::create( _data.firstElement().Obj(), ctx() );
+                BSONObj spec = BSON( "$sort" << sortKey );
+                _sort = mongo::DocumentSourceSort::createFromBson( spec.firstElement(), ctx() );
+                _sort->setSource( _array.get() );
+            }
+            DocumentSourceGroup* sortedGroup( const BSONObj& spec ) {
+                BSONObj namedSpec = BSON( "$group" << spec );
+                _group = DocumentSourceGroup::createFromBson( namedSpec.firstElement(), ctx() );
+                _group->setSource( _sort.get() );
+                return dynamic_cast<DocumentSourceGroup*>( _group.get() );
+            }
+            intrusive_ptr<DocumentSource> sortedGroupSource() { return _group; }
+        private:
+            BSONObj _data;
+            intrusive_ptr<DocumentSourceBsonArray> _array;
+            intrusive_ptr<DocumentSource> _sort;
+            intrusive_ptr<DocumentSource> _group;
+        };
+
+        /**
+         * Groups are returned as they complete when the input is sorted on the _id, except for
+         * nullish and array _ids which are returned at the end.
+         */
+        class StreamSortedInput : public SortedInputBase {
+        public:
+            void run() {
+                createSortedInput( "[{a:2,b:1},{a:1,b:2},{a:2,b:3},{a:null,b:4},{b:5},"
+                                   "{a:[1],b:6},{a:1,b:7},{a:1.0,b:8}]",
+                                   BSON( "a" << -1 ) );
+                DocumentSourceGroup* streamed = sortedGroup(
+                        fromjson( "{_id:'$a',s:{$sum:'$b'},f:{$first:'$b'},n:{$max:'$b'}}" ) );
+                ASSERT( streamed->isStreaming() );
+
+                // The streamed groups come first, in the order of the input.
+                boost::optional<Document> first = streamed->getNext();
+                ASSERT( first );
+                ASSERT_EQUALS( Value( 2 ), first->getField( "_id" ) );
+                ASSERT_EQUALS( Value( 4 ), first->getField( "s" ) );
+                boost::optional<Document> second = streamed->getNext();
+                ASSERT( second );
+                ASSERT_EQUALS( Value( 1 ), second->getField( "_id" ) );
+                ASSERT_EQUALS( Value( 17 ), second->getField( "s" ) );
+
+                checkResultSet( sortedGroupSource() );
+            }
+        private:
+            string expectedResultSetString() {
+                return "[{_id:null,s:9,f:4,n:5},{_id:[1],s:6,f:6,n:6}]";
+            }
+        };
+
+        /** The input's sort order must lead with exactly the fields of the _id. */
+        class StreamOnlyOnIdFields : public SortedInputBase {
+        public:
+            void run() {
+                createSortedInput( "[{a:1,b:1}]", BSON( "a" << 1 << "b" << -1 ) );
+                ASSERT( sortedGroup( fromjson( "{_id:'$a'}" ) )->isStreaming() );
+                ASSERT( sortedGroup( fromjson( "{_id:{y:'$b',x:'$a'}}" ) )->isStreaming() );
+                ASSERT( !sortedGroup( fromjson( "{_id:'$b'}" ) )->isStreaming() );
+                ASSERT( !sortedGroup( fromjson( "{_id:{x:'$a',y:'$c'}}" ) )->isStreaming() );
+                ASSERT( !sortedGroup( fromjson( "{_id:{$add:['$a',1]}}" ) )->isStreaming() );
+                ASSERT( !sortedGroup( fromjson( "{_id:'$$ROOT'}" ) )->isStreaming() );
+                ASSERT( !sortedGroup( fromjson( "{_id:null}" ) )->isStreaming() );
+
+                createSortedInput( "[{a:1,b:1}]", BSON( "a.b" << 1 ) );
+                ASSERT( sortedGroup( fromjson( "{_id:'$a.b'}" ) )->isStreaming() );
+                ASSERT( !sortedGroup( fromjson( "{_id:'$a'}" ) )->isStreaming() );
+
+                // A collection scan has no order.
+                createSource();
+                createGroup( fromjson( "{_id:'$a'}" ) );
+                ASSERT( !dynamic_cast<DocumentSourceGroup*>( group() )->isStreaming() );
+            }
+        };
+
+        /** Streaming with a compound _id, with a nullish part in some of the documents. */
+        class StreamCompoundId : public SortedInputBase {
+        public:
+            void run() {
+                createSortedInput( "[{a:1,b:1,c:1},{a:1,c:2},{a:1,b:1,c:3},{a:2,b:1,c:4},"
+                                   "{a:1,b:null,c:5},{a:1,b:2,c:6}]",
+                                   BSON( "a" << 1 << "b" << 1 ) );
+                ASSERT( sortedGroup( fromjson( "{_id:{x:'$a',y:'$b'},c:{$push:'$c'},"
+                                               "v:{$avg:'$c'}}" ) )->isStreaming() );
+                checkResultSet( sortedGroupSource() );
+            }
+        private:
+            string expectedResultSetString() {
+                return "[{_id:{x:1},c:[2],v:2.0},{_id:{x:1,y:null},c:[5],v:5.0},"
+                       "{_id:{x:1,y:1},c:[1,3],v:2.0},{_id:{x:1,y:2},c:[6],v:6.0},"
+                       "{_id:{x:2,y:1},c:[4],v:4.0}]";
+            }
+        };
+
         /** Dependant field paths. */
         class Dependencies : public Base {
         public:
@@ -1929,6 +2028,9 @@ namespace DocumentSourceTests {
             add<DocumentSourceGroup::ComplexId>();
             add<DocumentSourceGroup::UndefinedAccumulatorValue>();
             add<DocumentSourceGroup::RouterMerger>();
+            add<DocumentSourceGroup::StreamSortedInput>();
+            add<DocumentSourceGroup::StreamOnlyOnIdFields>();
+            add<DocumentSourceGroup::StreamCompoundId>();
             add<DocumentSourceGroup::Dependencies>();
             add<DocumentSourceGroup::StringConstantIdAndAccumulatorExpressions>();
             add<DocumentSourceGroup::ArrayConstantAccumulatorExpression>();
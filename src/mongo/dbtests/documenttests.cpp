@@ -344,6 +344,57 @@ namespace DocumentTests {
             }
         };
 
+        /** A lazily decoded Document has the same fields and metadata as a converted one. */
+        class Lazy {
+        public:
+            void run() {
+                const BSONObj obj = fromjson( "{a:1,b:{c:'x',d:[1,{e:2}]},f:null,$textScore:3.5}" );
+                const Document lazy = Document::fromBsonWithMetaDataLazily( obj );
+                ASSERT( lazy.hasTextScore() );
+                ASSERT_EQUALS( 3.5, lazy.getTextScore() );
+
+                // Look up a late and a nested field before the others are decoded.
+                ASSERT_EQUALS( Value(BSONNULL), lazy["f"] );
+                ASSERT_EQUALS( Value(2), lazy.getNestedField( FieldPath( "b.d" ) )[1]["e"] );
+                ASSERT( lazy["$textScore"].missing() );
+                ASSERT( lazy["g"].missing() );
+
+                ASSERT_EQUALS( Document::fromBsonWithMetaData( obj ), lazy );
+                ASSERT_EQUALS( fromjson( "{a:1,b:{c:'x',d:[1,{e:2}]},f:null}" ), lazy.toBson() );
+                ASSERT_EQUALS( obj, lazy.toBsonWithMetaData() );
+
+                // Field order is the BSON order, not the order fields were decoded in.
+                ASSERT_EQUALS( "a", getNthField( lazy, 0 ).first.toString() );
+                ASSERT_EQUALS( "f", getNthField( lazy, 2 ).first.toString() );
+                ASSERT_EQUALS( 3U, lazy.size() );
+            }
+        };
+
+        /** Modifying a lazily decoded Document leaves the original unchanged. */
+        class LazyModify {
+        public:
+            void run() {
+                const Document lazy =
+                        Document::fromBsonWithMetaDataLazily( fromjson( "{a:1,b:{c:2},d:3}" ) );
+                vector<Position> path;
+                ASSERT_EQUALS( Value(2), lazy.getNestedField( FieldPath( "b.c" ), &path ) );
+
+                MutableDocument md (lazy);
+                md.setNestedField( path, Value(4) );
+                md.addField( "e", Value(5) );
+                const Document modified = md.freeze();
+
+                ASSERT_EQUALS( fromjson( "{a:1,b:{c:4},d:3,e:5}" ), modified.toBson() );
+                ASSERT_EQUALS( fromjson( "{a:1,b:{c:2},d:3}" ), lazy.toBson() );
+
+                // A lazy sub-document modified in place, rather than through a clone.
+                MutableDocument inPlace (Document::fromBsonWithMetaDataLazily(
+                        fromjson( "{a:{b:1,c:2}}" ) ));
+                inPlace["a"]["d"] = Value(3);
+                ASSERT_EQUALS( fromjson( "{a:{b:1,c:2,d:3}}" ), inPlace.freeze().toBson() );
+            }
+        };
+
         class AllTypesDoc {
         public:
             void run() {
@@ -1427,6 +1478,8 @@ namespace DocumentTests {
             add<Document::FieldIteratorEmpty>();
             add<Document::FieldIteratorSingle>();
             add<Document::FieldIteratorMultiple>();
+            add<Document::Lazy>();
+            add<Document::LazyModify>();
             add<Document::AllTypesDoc>();
 
             add<Value::BSONArrayTest>();
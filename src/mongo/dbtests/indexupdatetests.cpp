@@ -41,6 +41,11 @@
 
 #include "mongo/dbtests/dbtests.h"
 
+namespace mongo {
+    // Defined in db/catalog/index_create.cpp
+    extern int internalIndexBuildKeyGenThreads;
+}
+
 namespace IndexUpdateTests {
 
     static const char* const _ns = "unittests.indexupdate";
@@ -437,6 +442,62 @@ namespace IndexUpdateTests {
         }
     };
 
+    /** Several indexes built in the foreground with keys generated on worker threads. */
+    class InsertBuildParallelKeyGeneration : public IndexBuildBase {
+    public:
+        void run() {
+            // Create a new collection.
+            Database* db = _ctx.ctx().db();
+            db->dropCollection( &_txn, _ns );
+            Collection* coll = db->createCollection( &_txn, _ns );
+
+            // More documents than fit in one batch handed to the workers.
+            int32_t nDocs = 5000;
+            for( int32_t i = 0; i < nDocs; ++i ) {
+                coll->insertDocument( &_txn,
+                                      BSON( "_id" << i << "a" << i << "b" << BSON_ARRAY( i << -i ) ),
+                                      true );
+            }
+
+            std::vector<BSONObj> specs;
+            specs.push_back( BSON( "key" << BSON( "a" << 1 ) << "ns" << _ns << "name" << "a_1" ) );
+            specs.push_back( BSON( "key" << BSON( "b" << 1 ) << "ns" << _ns << "name" << "b_1" ) );
+            specs.push_back( BSON( "key" << BSON( "a" << -1 << "b" << 1 )
+                                   << "ns" << _ns << "name" << "a_-1_b_1" ) );
+
+            const int oldKeyGenThreads = internalIndexBuildKeyGenThreads;
+            internalIndexBuildKeyGenThreads = 2;
+            try {
+                MultiIndexBlock indexer(&_txn, coll);
+                ASSERT_OK(indexer.init(specs));
+                ASSERT_OK(indexer.insertAllDocumentsInCollection());
+                WriteUnitOfWork wunit(&_txn);
+                indexer.commit();
+                wunit.commit();
+            }
+            catch (...) {
+                internalIndexBuildKeyGenThreads = oldKeyGenThreads;
+                throw;
+            }
+            internalIndexBuildKeyGenThreads = oldKeyGenThreads;
+
+            ASSERT_EQUALS( nDocs, numKeys( coll, "a_1" ) );
+            ASSERT_EQUALS( 2 * nDocs, numKeys( coll, "b_1" ) );
+            ASSERT_EQUALS( 2 * nDocs, numKeys( coll, "a_-1_b_1" ) );
+            ASSERT( coll->getIndexCatalog()->findIndexByName( "b_1" )->isMultikey() );
+        }
+
+    private:
+        int64_t numKeys( Collection* coll, const std::string& name ) {
+            IndexCatalog* catalog = coll->getIndexCatalog();
+            const IndexDescriptor* desc = catalog->findIndexByName( name );
+            ASSERT( desc );
+            int64_t n = 0;
+            ASSERT_OK( catalog->getIndex( desc )->validate( &_txn, &n ) );
+            return n;
+        }
+    };
+
     /** Index creation is killed if mayInterrupt is true. */
     class InsertBuildIndexInterrupt : public IndexBuildBase {
     public:
@@ -835,6 +896,7 @@ namespace IndexUpdateTests {
             add<InsertBuildEnforceUnique<false> >();
             add<InsertBuildFillDups<true> >();
             add<InsertBuildFillDups<false> >();
+            add<InsertBuildParallelKeyGeneration>();
             add<InsertBuildIndexInterrupt>();
             add<InsertBuildIndexInterruptDisallowed>();
             add<InsertBuildIdIndexInterrupt>();
@@ -31,8 +31,13 @@
 #include "mongo/pch.h"
 
 #include <boost/filesystem/operations.hpp>
+#include <boost/thread/thread.hpp>
 
+#include "mongo/db/operation_context_impl.h"
+#include "mongo/db/storage/mmap_v1/dur.h"
 #include "mongo/db/storage/mmap_v1/durable_mapped_file.h"
+#include "mongo/stdx/functional.h"
+#include "mongo/util/concurrency/synchronization.h"
 #include "mongo/util/timer.h"
 #include "mongo/dbtests/dbtests.h"
 
@@ -119,11 +124,66 @@ namespace MMapTests {
         }
     };
 
+    /** the durThread's incremental remap skips a file whose database lock is busy rather than
+        waiting for it */
+    class IncrementalRemapSkipsBusyDatabase {
+        const string fn;
+
+        static void holdWrite(Notification* locked, Notification* release) {
+            Client::initThread("remapholder");
+            {
+                LockState lockState;
+                Lock::DBWrite lk(&lockState, "remaptest");
+                locked->notifyOne();
+                release->waitToBeNotified();
+            }
+            cc().shutdown();
+        }
+
+    public:
+        IncrementalRemapSkipsBusyDatabase() :
+            fn((boost::filesystem::path(storageGlobalParams.dbpath) / "remaptest.0").string()) {
+        }
+        ~IncrementalRemapSkipsBusyDatabase() {
+            try { boost::filesystem::remove(fn); }
+            catch(...) { }
+        }
+        void run() {
+            OperationContextImpl txn;
+            scoped_ptr<DurableMappedFile> f(new DurableMappedFile());
+            {
+                Lock::GlobalWrite lk(txn.lockState());
+                unsigned long long len = 1024 * 1024;
+                verify( f->create(fn, len, /*sequential*/false) );
+            }
+
+            Notification locked;
+            Notification release;
+            boost::thread holder(stdx::bind(holdWrite, &locked, &release));
+            locked.waitToBeNotified();
+
+            Timer t;
+            ASSERT_EQUALS( dur::RemapFileLockBusy, dur::remapFileIncrementally(&txn, fn, 20) );
+            ASSERT( t.millis() >= 15 );
+            ASSERT( t.millis() < 1000 );
+            ASSERT( !txn.lockState()->isLocked() );
+
+            release.notifyOne();
+            holder.join();
+
+            ASSERT_EQUALS( dur::RemapFileDone, dur::remapFileIncrementally(&txn, fn, 20) );
+
+            Lock::GlobalWrite lk(txn.lockState());
+            f.reset();
+        }
+    };
+
     class All : public Suite {
     public:
         All() : Suite( "mmap" ) {}
         void setupTests() {
             add< LeakTest >();
+            add< IncrementalRemapSkipsBusyDatabase >();
         }
     } myall;
 
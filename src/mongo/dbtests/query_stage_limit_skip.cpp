@@ -73,6 +73,17 @@ namespace {
         return count;
     }
 
+    int countBatchResults(PlanStage* stage, size_t maxWorks) {
+        int count = 0;
+        std::vector<WorkingSetID> out;
+        while (!stage->isEOF()) {
+            out.clear();
+            stage->workBatch(maxWorks, &out);
+            count += out.size();
+        }
+        return count;
+    }
+
     //
     // Insert 50 objects.  Filter/skip 0, 1, 2, ..., 100 objects and expect the right # of results.
     //
@@ -91,12 +102,44 @@ namespace {
         }
     };
 
+    //
+    // Same as above, but pulling results through workBatch() with a few different batch sizes.
+    // Batching must not change the results.  A batch may go on to find EOF where the caller above
+    // checks isEOF() instead, so only compare the stats that don't count that.
+    //
+    class QueryStageLimitSkipBatchTest {
+    public:
+        void run() {
+            const size_t batchSizes[] = { 1, 2, 7, 1000 };
+            for (size_t j = 0; j < sizeof(batchSizes) / sizeof(batchSizes[0]); ++j) {
+                for (int i = 0; i < 2 * N; ++i) {
+                    WorkingSet ws;
+
+                    scoped_ptr<PlanStage> skip(new SkipStage(i, &ws, getMS(&ws)));
+                    ASSERT_EQUALS(max(0, N - i), countBatchResults(skip.get(), batchSizes[j]));
+
+                    scoped_ptr<PlanStage> limit(new LimitStage(i, &ws, getMS(&ws)));
+                    ASSERT_EQUALS(min(N, i), countBatchResults(limit.get(), batchSizes[j]));
+
+                    WorkingSet ws2;
+                    scoped_ptr<PlanStage> unbatched(new SkipStage(i, &ws2, getMS(&ws2)));
+                    countResults(unbatched.get());
+                    ASSERT_EQUALS(unbatched->getCommonStats()->needTime,
+                                  skip->getCommonStats()->needTime);
+                    ASSERT_EQUALS(unbatched->getCommonStats()->advanced,
+                                  skip->getCommonStats()->advanced);
+                }
+            }
+        }
+    };
+
     class All : public Suite {
     public:
         All() : Suite( "query_stage_limit_skip" ) { }
 
         void setupTests() {
             add<QueryStageLimitSkipBasicTest>();
+            add<QueryStageLimitSkipBatchTest>();
         }
     }  queryStageLimitSkipAll;
 
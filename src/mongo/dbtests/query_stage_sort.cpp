@@ -337,6 +337,86 @@ namespace QueryStageSortTests {
         }
     };
 
+    // Results read back from disk after a spill keep their DiskLoc, unless it was invalidated.
+    class QueryStageSortSpillKeepsDiskLoc : public QueryStageSortTestBase {
+    public:
+        // Enough 128KB documents to go over the 32MB buffer limit.
+        virtual int numObj() { return 300; }
+
+        void run() {
+            Client::WriteContext ctx(&_txn, ns());
+
+            Database* db = ctx.ctx().db();
+            Collection* coll = db->getCollection(&_txn, ns());
+            if (!coll) {
+                coll = db->createCollection(&_txn, ns());
+            }
+
+            const string big(128 * 1024, 'x');
+            for (int i = 0; i < numObj(); ++i) {
+                insert(BSON("foo" << i << "big" << big));
+            }
+
+            set<DiskLoc> locs;
+            getLocs(&locs, coll);
+
+            WorkingSet ws;
+            auto_ptr<MockStage> ms(new MockStage(&ws));
+            insertVarietyOfObjects(ms.get(), coll);
+
+            SortStageParams params;
+            params.collection = coll;
+            params.pattern = BSON("foo" << -1);
+            params.allowDiskUse = true;
+            auto_ptr<SortStage> ss(new SortStage(params, &ws, ms.release()));
+
+            // Read in and spill everything, then invalidate one of the spilled documents.
+            WorkingSetID id = WorkingSet::INVALID_ID;
+            PlanStage::StageState status = PlanStage::NEED_TIME;
+            while (PlanStage::NEED_TIME == status) {
+                status = ss->work(&id);
+            }
+            ASSERT_EQUALS(PlanStage::ADVANCED, status);
+
+            const SortStats* stats = static_cast<const SortStats*>(ss->getSpecificStats());
+            ASSERT_GREATER_THAN(stats->spills, 1U);
+
+            const DiskLoc invalidated = *locs.begin();
+            const int invalidatedFoo = coll->docFor(invalidated)["foo"].numberInt();
+            ss->saveState();
+            ss->invalidate(invalidated, INVALIDATION_DELETION);
+            ss->restoreState(&_txn);
+
+            int count = 0;
+            int lastFoo = numObj();
+            while (true) {
+                if (PlanStage::ADVANCED == status) {
+                    WorkingSetMember* member = ws.get(id);
+                    ASSERT(member->hasObj());
+                    const int foo = member->obj["foo"].numberInt();
+                    ASSERT_LESS_THAN(foo, lastFoo);
+                    lastFoo = foo;
+
+                    if (foo == invalidatedFoo) {
+                        ASSERT(!member->hasLoc());
+                    }
+                    else {
+                        ASSERT(member->hasLoc());
+                        ASSERT_EQUALS(foo, coll->docFor(member->loc)["foo"].numberInt());
+                    }
+                    ++count;
+                }
+                if (ss->isEOF()) {
+                    break;
+                }
+                status = ss->work(&id);
+            }
+            ctx.commit();
+
+            ASSERT_EQUALS(numObj(), count);
+        }
+    };
+
     // Should error out if we sort with parallel arrays.
     class QueryStageSortParallelArrays : public QueryStageSortTestBase {
     public:
@@ -394,6 +474,7 @@ namespace QueryStageSortTests {
             add<QueryStageSortInvalidation>();
             add<QueryStageSortInvalidationWithLimit<10> >();
             add<QueryStageSortInvalidationWithLimit<1> >();
+            add<QueryStageSortSpillKeepsDiskLoc>();
             add<QueryStageSortParallelArrays>();
         }
     }  queryStageSortTest;
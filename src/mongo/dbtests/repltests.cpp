@@ -41,6 +41,7 @@
 #include "mongo/db/repl/repl_coordinator_global.h"
 #include "mongo/db/repl/repl_coordinator_mock.h"
 #include "mongo/db/repl/rs.h"
+#include "mongo/db/repl/sync_tail.h"
 #include "mongo/db/ops/update.h"
 #include "mongo/db/catalog/collection.h"
 #include "mongo/db/operation_context_impl.h"
@@ -1359,6 +1360,111 @@ namespace ReplTests {
         }
     };
 
+    namespace FillWriterVectors {
+
+        class SyncTailForTest : public SyncTail {
+        public:
+            SyncTailForTest() : SyncTail(NULL) {}
+            using SyncTail::fillWriterVectors;
+        };
+
+        class Base : public ReplTests::Base {
+        public:
+            Base() { _client.dropCollection( partitionedNs() ); }
+            ~Base() { _client.dropCollection( partitionedNs() ); }
+
+        protected:
+            static const char* partitionedNs() { return "unittests.repltests_partition"; }
+
+            static deque<BSONObj> inserts( int n ) {
+                deque<BSONObj> ops;
+                for ( int i = 0; i < n; i++ ) {
+                    ops.push_back( BSON( "op" << "i" << "ns" << partitionedNs()
+                                         << "o" << BSON( "_id" << i ) ) );
+                }
+                return ops;
+            }
+
+            /**
+             * @return how many writers 'ops' are split between, checking that the ops on each
+             * _id stay together
+             */
+            int numWriters( SyncTailForTest& tail, const deque<BSONObj>& ops ) {
+                vector< vector<BSONObj> > writers( 4 );
+                tail.fillWriterVectors( ops, &writers );
+
+                int used = 0;
+                map<int, size_t> writerById;
+                for ( size_t w = 0; w < writers.size(); w++ ) {
+                    if ( writers[w].empty() )
+                        continue;
+                    used++;
+                    for ( size_t i = 0; i < writers[w].size(); i++ ) {
+                        const BSONObj& op = writers[w][i];
+                        const BSONObj doc = op.hasField( "o2" ) ? op["o2"].Obj() : op["o"].Obj();
+                        const int id = doc["_id"].numberInt();
+                        ASSERT( !writerById.count( id ) || writerById[id] == w );
+                        writerById[id] = w;
+                    }
+                }
+                return used;
+            }
+        };
+
+        /** Ops on a collection which doesn't exist yet stay on one writer. */
+        class NewCollection : public Base {
+        public:
+            void run() {
+                SyncTailForTest tail;
+                deque<BSONObj> ops = inserts( 100 );
+                ops.push_back( BSON( "op" << "u" << "ns" << partitionedNs()
+                                     << "o2" << BSON( "_id" << 5 )
+                                     << "o" << BSON( "$set" << BSON( "x" << 1 ) ) ) );
+                ASSERT_EQUALS( 1, numWriters( tail, ops ) );
+
+                // once the collection exists, with its _id index, they are split by _id
+                _client.insert( partitionedNs(), BSON( "_id" << -1 ) );
+                ASSERT_GREATER_THAN( numWriters( tail, ops ), 1 );
+            }
+        };
+
+        /** Ops on a collection without an _id index stay on one writer. */
+        class NoIdIndex : public Base {
+        public:
+            void run() {
+                BSONObj info;
+                ASSERT( _client.runCommand( "unittests",
+                                            BSON( "create" << "repltests_partition"
+                                                  << "autoIndexId" << false ),
+                                            info ) );
+                SyncTailForTest tail;
+                ASSERT_EQUALS( 1, numWriters( tail, inserts( 100 ) ) );
+            }
+        };
+
+        /** What is known about a collection is looked up again after an index build. */
+        class IndexBuildInvalidates : public Base {
+        public:
+            void run() {
+                _client.insert( partitionedNs(), BSON( "_id" << -1 ) );
+                SyncTailForTest tail;
+                ASSERT_GREATER_THAN( numWriters( tail, inserts( 100 ) ), 1 );
+
+                BSONObj spec = BSON( "ns" << partitionedNs() << "key" << BSON( "a" << 1 )
+                                     << "name" << "a_1" << "unique" << true );
+                deque<BSONObj> indexBuild;
+                indexBuild.push_back( BSON( "op" << "i" << "ns" << "unittests.system.indexes"
+                                            << "o" << spec ) );
+                vector< vector<BSONObj> > writers( 4 );
+                tail.fillWriterVectors( indexBuild, &writers );
+                _client.insert( "unittests.system.indexes", spec );
+
+                ASSERT_EQUALS( 1, numWriters( tail, inserts( 100 ) ) );
+            }
+        };
+
+    } // namespace FillWriterVectors
+
     class DatabaseIgnorerBasic {
     public:
         void run() {
@@ -1521,6 +1627,9 @@ namespace ReplTests {
             add< Idempotence::ReplaySetPreexistingNoOpPull >();
             add< Idempotence::ReplayArrayFieldNotAppended >();
             add< DeleteOpIsIdBased >();
+            add< FillWriterVectors::NewCollection >();
+            add< FillWriterVectors::NoIdIndex >();
+            add< FillWriterVectors::IndexBuildInvalidates >();
             add< DatabaseIgnorerBasic >();
             add< DatabaseIgnorerUpdate >();
             add< ReplSetMemberCfgEquality >();
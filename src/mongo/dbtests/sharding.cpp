@@ -266,7 +266,7 @@ namespace ShardingTests {
 
             ASSERT( manager->getVersion().epoch() == version.epoch() );
             ASSERT( manager->getVersion().minorVersion() == ( numChunks - 1 ) );
-            ASSERT( static_cast<int>( manager->getChunkMap().size() ) == numChunks );
+            ASSERT( static_cast<int>( manager->numChunks() ) == numChunks );
 
             // Modify chunks collection
             BSONObjBuilder b;
@@ -281,7 +281,17 @@ namespace ShardingTests {
 
             ASSERT( newManager.getVersion().toLong() == laterVersion.toLong() );
             ASSERT( newManager.getVersion().epoch() == laterVersion.epoch() );
-            ASSERT( static_cast<int>( newManager.getChunkMap().size() ) == numChunks );
+            ASSERT( static_cast<int>( newManager.numChunks() ) == numChunks );
+
+            // Only the updated chunk is new, the others are shared with the old manager
+            const ChunkRoutingTable& oldChunks = manager->getChunks();
+            const ChunkRoutingTable& newChunks = newManager.getChunks();
+            int numShared = 0;
+            for ( ChunkRoutingTable::const_iterator it = newChunks.begin(); it != newChunks.end(); ++it ) {
+                ChunkRoutingTable::const_iterator old = oldChunks.upperBound( it->second->getMin() );
+                if ( old != oldChunks.end() && old->second == it->second ) numShared++;
+            }
+            ASSERT_EQUALS( numChunks - 1, numShared );
         }
 
     };
@@ -395,6 +395,61 @@ namespace ThreadedTests {
         }
     };
 
+    /** dbwritelocktry gives up on a busy database lock and leaves nothing locked behind */
+    class DBWriteLockTry {
+        static void holdRead(const string& db, Notification* locked, Notification* release) {
+            Client::initThread("dbwritelocktry");
+            {
+                LockState lockState;
+                Lock::DBRead lk(&lockState, db);
+                locked->notifyOne();
+                release->waitToBeNotified();
+            }
+            cc().shutdown();
+        }
+
+        void tryWhileHeld(const string& db) {
+            Notification locked;
+            Notification release;
+            boost::thread holder(stdx::bind(holdRead, db, &locked, &release));
+            locked.waitToBeNotified();
+
+            LockState lockState;
+            {
+                Timer t;
+                dbwritelocktry lk(&lockState, db, 50);
+                ASSERT( !lk.got() );
+                ASSERT( t.millis() >= 40 );
+            }
+            ASSERT_EQUALS( 0, lockState.threadState() );
+            ASSERT_EQUALS( 0, lockState.otherCount() );
+            ASSERT_EQUALS( 0, lockState.nestableCount() );
+
+            {
+                // other databases are not held up
+                dbwritelocktry lk(&lockState, "dbwritelocktry_other", 1000);
+                ASSERT( lk.got() );
+            }
+
+            release.notifyOne();
+            holder.join();
+
+            {
+                dbwritelocktry lk(&lockState, db, 1000);
+                ASSERT( lk.got() );
+                ASSERT( lockState.threadState() != 0 );
+            }
+            ASSERT_EQUALS( 0, lockState.threadState() );
+        }
+
+    public:
+        void run() {
+            tryWhileHeld("dbwritelocktry");
+            tryWhileHeld("local");
+            tryWhileHeld("admin");
+        }
+    };
+
     class RWLockTest1 { 
     public:
         void run() { 
@@ -1008,6 +1063,7 @@ namespace ThreadedTests {
             add< MVarTest >();
             add< ThreadPoolTest >();
             add< LockTest >();
+            add< DBWriteLockTry >();
 
 
             add< RWLockTest1 >();
@@ -69,7 +69,8 @@ namespace mongo {
 
     int Balancer::_moveChunks(const vector<CandidateChunkPtr>* candidateChunks,
                               const WriteConcernOptions* writeConcern,
-                              bool waitForDelete)
+                              bool waitForDelete,
+                              bool balanceLoad)
     {
         int movedCount = 0;
 
@@ -109,6 +110,13 @@ namespace mongo {
                                      waitForDelete,
                                      0, /* maxTimeMS */
                                      res)) {
+                    // only rounds balancing the load use, and expire, the recent moves
+                    if ( balanceLoad ) {
+                        RecentMove& move =
+                            _recentMoves[chunkInfo.ns][chunkInfo.chunk.min.getOwned()];
+                        move.load = chunkInfo.load;
+                        move.movedAt = time(0);
+                    }
                     movedCount++;
                     continue;
                 }
@@ -299,7 +307,92 @@ namespace mongo {
         }        
     }
 
-    void Balancer::_doBalanceRound( DBClientBase& conn, vector<CandidateChunkPtr>* candidateChunks ) {
+    /**
+     * Adds the reads and writes per second to the chunks of 'ns' to 'status', as reported by the
+     * shards owning them.  If a shard can't report them none are added, so that its chunks don't
+     * look cold.
+     */
+    static void addChunkLoads( const string& ns,
+                               const ShardToChunksMap& shardToChunksMap,
+                               DistributionStatus* status ) {
+        vector<pair<BSONObj, double> > chunkLoads;
+
+        for ( ShardToChunksMap::const_iterator it = shardToChunksMap.begin();
+              it != shardToChunksMap.end();
+              ++it ) {
+            if ( it->second->empty() )
+                continue;
+
+            BSONObj res;
+            try {
+                res = Shard::make( it->first ).runCommand( "admin", BSON( "getChunkLoad" << ns ) );
+            }
+            catch ( const DBException& ex ) {
+                warning() << "could not get the load of the chunks of " << ns << " from "
+                          << it->first << ", only balancing the number of chunks"
+                          << causedBy( ex ) << endl;
+                return;
+            }
+
+            BSONForEach( chunkElem, res["chunks"].Obj() ) {
+                BSONObj chunk = chunkElem.Obj();
+                chunkLoads.push_back( make_pair( chunk[ChunkType::min()].Obj().getOwned(),
+                                                 chunk["reads"].numberDouble() +
+                                                     chunk["writes"].numberDouble() ) );
+            }
+        }
+
+        for ( vector<pair<BSONObj, double> >::const_iterator it = chunkLoads.begin();
+              it != chunkLoads.end();
+              ++it ) {
+            status->addChunkLoad( it->first, it->second );
+        }
+    }
+
+    // How long a moved chunk is kept where it is when balancing the load, so that the shard which
+    // received it counts its operations for a few half lives before it can look cold.
+    static const int kRecentMoveSecs = 5 * 60;
+
+    void Balancer::_expireRecentMoves( bool balanceLoad ) {
+        // the recent moves are only recorded and used by rounds balancing the load
+        if ( !balanceLoad ) {
+            _recentMoves.clear();
+            return;
+        }
+
+        const time_t now = time(0);
+        for ( map<string, map<BSONObj, RecentMove> >::iterator nsMoves = _recentMoves.begin();
+              nsMoves != _recentMoves.end(); ) {
+            map<BSONObj, RecentMove>& moves = nsMoves->second;
+            for ( map<BSONObj, RecentMove>::iterator it = moves.begin(); it != moves.end(); ) {
+                if ( now - it->second.movedAt >= kRecentMoveSecs )
+                    moves.erase( it++ );
+                else
+                    ++it;
+            }
+
+            if ( moves.empty() )
+                _recentMoves.erase( nsMoves++ );
+            else
+                ++nsMoves;
+        }
+    }
+
+    void Balancer::_addRecentMoves( const string& ns, DistributionStatus* status ) {
+        map<string, map<BSONObj, RecentMove> >::iterator nsMoves = _recentMoves.find( ns );
+        if ( nsMoves == _recentMoves.end() )
+            return;
+
+        const map<BSONObj, RecentMove>& moves = nsMoves->second;
+        for ( map<BSONObj, RecentMove>::const_iterator it = moves.begin(); it != moves.end();
+              ++it ) {
+            status->addRecentlyMovedChunk( it->first, it->second.load );
+        }
+    }
+
+    void Balancer::_doBalanceRound( DBClientBase& conn,
+                                    bool balanceLoad,
+                                    vector<CandidateChunkPtr>* candidateChunks ) {
         verify( candidateChunks );
 
         //
@@ -411,6 +504,11 @@ namespace mongo {
 
             DistributionStatus status(shardInfo, shardToChunksMap.map());
 
+            if ( balanceLoad ) {
+                addChunkLoads( ns, shardToChunksMap.map(), &status );
+                _addRecentMoves( ns, &status );
+            }
+
             // load tags
             Status result = clusterCreateIndex(TagsType::ConfigNS,
                                                BSON(TagsType::ns() << 1 << TagsType::min() << 1),
@@ -491,7 +589,25 @@ namespace mongo {
             }
 
             CandidateChunk* p = _policy->balance( ns, status, _balancedLastTime );
-            if ( p ) candidateChunks->push_back( CandidateChunkPtr( p ) );
+            if ( p ) {
+                candidateChunks->push_back( CandidateChunkPtr( p ) );
+                continue;
+            }
+
+            scoped_ptr<ChunkInfo> hotChunk( _policy->findHotChunkToSplit( ns, status ) );
+            if ( hotChunk ) {
+                ChunkPtr c = cm->findIntersectingChunk( hotChunk->min );
+                if ( c->getMin().woCompare( hotChunk->min ) ||
+                     c->getMax().woCompare( hotChunk->max ) ) {
+                    log() << "chunk mismatch, not splitting hot chunk " << hotChunk->toString()
+                          << endl;
+                    continue;
+                }
+
+                // The halves can be moved apart once the shard reports their load
+                Status splitStatus = c->split(true /* atMedian */, NULL, NULL);
+                log() << "hot chunk split results: " << splitStatus << endl;
+            }
         }
     }
 
@@ -633,14 +749,20 @@ namespace mongo {
                         }
                     }
 
+                    const bool balanceLoad = (balancerConfig.isBalanceLoadSet() ?
+                            balancerConfig.getBalanceLoad() : false);
+
                     LOG(1) << "*** start balancing round. "
                            << "waitForDelete: " << waitForDelete
+                           << ", balanceLoad: " << balanceLoad
                            << ", secondaryThrottle: "
                            << (writeConcern.get() ? writeConcern->toBSON().toString() : "default")
                            << endl;
 
+                    _expireRecentMoves( balanceLoad );
+
                     vector<CandidateChunkPtr> candidateChunks;
-                    _doBalanceRound( conn.conn() , &candidateChunks );
+                    _doBalanceRound( conn.conn() , balanceLoad, &candidateChunks );
                     if ( candidateChunks.size() == 0 ) {
                         LOG(1) << "no need to move any chunk" << endl;
                         _balancedLastTime = 0;
@@ -648,7 +770,8 @@ namespace mongo {
                     else {
                         _balancedLastTime = _moveChunks(&candidateChunks,
                                                         writeConcern.get(),
-                                                        waitForDelete );
+                                                        waitForDelete,
+                                                        balanceLoad );
                     }
 
                     actionLog.setDetails( _buildDetails( false, balanceRoundTimer.millis(),
@@ -75,6 +75,15 @@ namespace mongo {
 
         // decide which chunks to move; owned here.
         scoped_ptr<BalancerPolicy> _policy;
+
+        struct RecentMove {
+            double load; // reads and writes per second to the chunk when it was moved
+            time_t movedAt;
+        };
+
+        // chunks moved by this balancer, by namespace and chunk min, for the rounds which balance
+        // the load of the chunks; see DistributionStatus::addRecentlyMovedChunk
+        std::map<std::string, std::map<BSONObj, RecentMove> > _recentMoves;
         
         /**
          * Checks that the balancer can connect to all servers it needs to do its job.
@@ -90,9 +99,12 @@ namespace mongo {
          * be moved.
          *
          * @param conn is the connection with the config server(s)
+         * @param balanceLoad also balance the reads and writes to the chunks, as reported by the shards
          * @param candidateChunks (IN/OUT) filled with candidate chunks, one per collection, that could possibly be moved
          */
-        void _doBalanceRound( DBClientBase& conn, std::vector<CandidateChunkPtr>* candidateChunks );
+        void _doBalanceRound( DBClientBase& conn,
+                              bool balanceLoad,
+                              std::vector<CandidateChunkPtr>* candidateChunks );
 
         /**
          * Issues chunk migration request, one at a time.
@@ -100,11 +112,25 @@ namespace mongo {
          * @param candidateChunks possible chunks to move
          * @param writeConcern detailed write concern. NULL means the default write concern.
          * @param waitForDelete wait for deletes to complete after each chunk move
+         * @param balanceLoad the round balanced the load, so remember the moved chunks for the
+         *        next rounds
          * @return number of chunks effectively moved
          */
         int _moveChunks(const std::vector<CandidateChunkPtr>* candidateChunks,
                         const WriteConcernOptions* writeConcern,
-                        bool waitForDelete);
+                        bool waitForDelete,
+                        bool balanceLoad);
+
+        /**
+         * Forgets the chunks moved too long ago to count as recent, for every namespace, or all
+         * of them if this round doesn't balance the load.
+         */
+        void _expireRecentMoves( bool balanceLoad );
+
+        /**
+         * Adds the chunks of 'ns' moved in the last few rounds to 'status'.
+         */
+        void _addRecentMoves( const std::string& ns, DistributionStatus* status );
 
         /**
          * Marks this balancer as being live on the config server(s).
@@ -32,6 +32,7 @@
 #include "mongo/platform/basic.h"
 
 #include <algorithm>
+#include <cmath>
 
 #include "mongo/s/balancer_policy.h"
 #include "mongo/s/chunk.h"
@@ -100,30 +101,38 @@ namespace mongo {
         return total;
     }
 
+    /** @return true if 'shard' may receive a chunk with the given tag */
+    static bool canReceiveChunk( const string& shard, const ShardInfo& info, const string& tag ) {
+        if ( info.isSizeMaxed() ) {
+            LOG(1) << shard << " has already reached the maximum total chunk size." << endl;
+            return false;
+        }
+
+        if ( info.isDraining() ) {
+            LOG(1) << shard << " is currently draining." << endl;
+            return false;
+        }
+
+        if ( info.hasOpsQueued() ) {
+            LOG(1) << shard << " has writebacks queued." << endl;
+            return false;
+        }
+
+        if ( ! info.hasTag( tag ) ) {
+            LOG(1) << shard << " doesn't have right tag" << endl;
+            return false;
+        }
+
+        return true;
+    }
+
     string DistributionStatus::getBestReceieverShard( const string& tag ) const {
         string best;
         unsigned minChunks = numeric_limits<unsigned>::max();
 
         for ( ShardInfoMap::const_iterator i = _shardInfo.begin(); i != _shardInfo.end(); ++i ) {
-            if ( i->second.isSizeMaxed() ) {
-                LOG(1) << i->first << " has already reached the maximum total chunk size." << endl;
+            if ( ! canReceiveChunk( i->first, i->second, tag ) )
                 continue;
-            }
-
-            if ( i->second.isDraining() ) {
-                LOG(1) << i->first << " is currently draining." << endl;
-                continue;
-            }
-
-            if ( i->second.hasOpsQueued() ) {
-                LOG(1) << i->first << " has writebacks queued." << endl;
-                continue;
-            }
-
-            if ( ! i->second.hasTag( tag ) ) {
-                LOG(1) << i->first << " doesn't have right tag" << endl;
-                continue;
-            }
 
             unsigned myChunks = numberOfChunksInShard( i->first );
             if ( myChunks >= minChunks ) {
@@ -160,6 +169,87 @@ namespace mongo {
         return worst;
     }
 
+    string DistributionStatus::getLeastLoadedReceiverShard( const string& tag ) const {
+        string best;
+        double minLoad = 0;
+
+        for ( ShardInfoMap::const_iterator i = _shardInfo.begin(); i != _shardInfo.end(); ++i ) {
+            if ( ! canReceiveChunk( i->first, i->second, tag ) )
+                continue;
+
+            double myLoad = getShardLoadWithTag( i->first, tag );
+            if ( best.size() && myLoad >= minLoad )
+                continue;
+
+            best = i->first;
+            minLoad = myLoad;
+        }
+
+        return best;
+    }
+
+    string DistributionStatus::getMostLoadedShard( const string& tag ) const {
+        string worst;
+        double maxLoad = 0;
+
+        for ( ShardInfoMap::const_iterator i = _shardInfo.begin(); i != _shardInfo.end(); ++i ) {
+
+            if ( i->second.hasOpsQueued() ) {
+                // we can't move stuff off anyway
+                continue;
+            }
+
+            double myLoad = getShardLoadWithTag( i->first, tag );
+            if ( myLoad <= maxLoad )
+                continue;
+
+            worst = i->first;
+            maxLoad = myLoad;
+        }
+
+        return worst;
+    }
+
+    double DistributionStatus::getChunkLoad( const ChunkType& chunk ) const {
+        double load = 0;
+        map<BSONObj,double>::const_iterator i = _chunkLoads.find( chunk.getMin() );
+        if ( i != _chunkLoads.end() )
+            load = i->second;
+
+        // the receiving shard's count may still be catching up with the load the chunk brought
+        map<BSONObj,double>::const_iterator moved = _recentlyMovedLoads.find( chunk.getMin() );
+        if ( moved != _recentlyMovedLoads.end() && moved->second > load )
+            load = moved->second;
+
+        return load;
+    }
+
+    bool DistributionStatus::hasChunkLoad( const ChunkType& chunk ) const {
+        return _chunkLoads.count( chunk.getMin() ) || _recentlyMovedLoads.count( chunk.getMin() );
+    }
+
+    bool DistributionStatus::isRecentlyMoved( const ChunkType& chunk ) const {
+        return _recentlyMovedLoads.count( chunk.getMin() ) > 0;
+    }
+
+    double DistributionStatus::getShardLoadWithTag( const string& shard,
+                                                    const string& tag ) const {
+        ShardToChunksMap::const_iterator i = _shardChunks.find(shard);
+        if (i == _shardChunks.end()) {
+            return 0;
+        }
+
+        double total = 0;
+        const vector<ChunkType*>& chunkList = i->second->vector();
+        for (unsigned j = 0; j < chunkList.size(); j++) {
+            if (tag == getTagForChunk(*chunkList[j])) {
+                total += getChunkLoad(*chunkList[j]);
+            }
+        }
+
+        return total;
+    }
+
     const vector<ChunkType*>& DistributionStatus::getChunks(
             const string& shard) const {
         ShardToChunksMap::const_iterator i = _shardChunks.find(shard);
@@ -202,6 +292,14 @@ namespace mongo {
         return true;
     }
 
+    void DistributionStatus::addChunkLoad( const BSONObj& chunkMin, double load ) {
+        _chunkLoads[chunkMin.getOwned()] = load;
+    }
+
+    void DistributionStatus::addRecentlyMovedChunk( const BSONObj& chunkMin, double load ) {
+        _recentlyMovedLoads[chunkMin.getOwned()] = load;
+    }
+
     string DistributionStatus::getTagForChunk( const ChunkType& chunk ) const {
         if ( _tagRanges.size() == 0 )
             return "";
@@ -274,8 +372,8 @@ namespace mongo {
             }
         }
 
-        const ChunkMap& chunkMap = chunkMgr.getChunkMap();
-        for (ChunkMap::const_iterator it = chunkMap.begin(); it != chunkMap.end(); ++it) {
+        const ChunkRoutingTable& chunks = chunkMgr.getChunks();
+        for (ChunkRoutingTable::const_iterator it = chunks.begin(); it != chunks.end(); ++it) {
             const ChunkPtr chunkPtr = it->second;
 
             auto_ptr<ChunkType> chunk(new ChunkType());
@@ -321,6 +419,76 @@ namespace mongo {
         return StatusWith<string>(tagRange.getTag());
     }
 
+    // The load of the chunks is only balanced when a shard has at least this many reads and
+    // writes per second to them, so that idle collections are not balanced on noise...
+    static const double kMinLoadToBalance = 10;
+
+    // ...and when the most and least loaded shards differ by more than this fraction of the
+    // average load of the shards.
+    static const double kLoadImbalanceThreshold = 0.5;
+
+    /**
+     * Finds the most and least loaded shards for the chunks with the given tag.
+     * @return how much more load 'from' has than 'to', or 0 if the load is even enough
+     */
+    static double findLoadImbalance( const DistributionStatus& distribution,
+                                     const string& tag,
+                                     string* from,
+                                     string* to ) {
+        *from = distribution.getMostLoadedShard( tag );
+        *to = distribution.getLeastLoadedReceiverShard( tag );
+        if ( from->size() == 0 || to->size() == 0 || *from == *to )
+            return 0;
+
+        const double max = distribution.getShardLoadWithTag( *from, tag );
+        const double min = distribution.getShardLoadWithTag( *to, tag );
+        if ( max < kMinLoadToBalance )
+            return 0;
+
+        double total = 0;
+        unsigned numShards = 0;
+        const set<string>& shards = distribution.shards();
+        for ( set<string>::const_iterator i = shards.begin(); i != shards.end(); ++i ) {
+            const ShardInfo& info = distribution.shardInfo( *i );
+            if ( info.isDraining() || ! info.hasTag( tag ) )
+                continue;
+
+            total += distribution.getShardLoadWithTag( *i, tag );
+            numShards++;
+        }
+
+        LOG(1) << "most loaded  : " << *from << " load " << max << endl;
+        LOG(1) << "least loaded : " << *to << " load " << min << endl;
+        LOG(1) << "average      : " << ( numShards ? total / numShards : 0 ) << endl;
+
+        if ( numShards == 0 || max - min <= kLoadImbalanceThreshold * total / numShards )
+            return 0;
+
+        return max - min;
+    }
+
+    /**
+     * @return the average load of the chunks with the given tag on 'shard' whose load is known,
+     *         or 0 if there are none
+     */
+    static double averageKnownChunkLoad( const DistributionStatus& distribution,
+                                         const string& shard,
+                                         const string& tag ) {
+        double total = 0;
+        unsigned numChunks = 0;
+        const vector<ChunkType *>& chunks = distribution.getChunks( shard );
+        for ( unsigned i = 0; i < chunks.size(); i++ ) {
+            const ChunkType& chunk = *chunks[i];
+            if ( distribution.getTagForChunk( chunk ) != tag ||
+                    ! distribution.hasChunkLoad( chunk ) )
+                continue;
+
+            total += distribution.getChunkLoad( chunk );
+            numChunks++;
+        }
+        return numChunks ? total / numChunks : 0;
+    }
+
     MigrateInfo* BalancerPolicy::balance( const string& ns,
                                           const DistributionStatus& distribution,
                                           int balancedLastTime ) {
@@ -330,6 +498,7 @@ namespace mongo {
         //    draining only
         // 2) check tag policy violations
         // 3) then we make sure chunks are balanced for each tag
+        // 4) and if the load of the chunks is known, that it is balanced for each tag
 
         // ----
 
@@ -381,7 +550,8 @@ namespace mongo {
                           << "(" << tag << ")"
                           << " to " << to << endl;
 
-                    return new MigrateInfo(ns, to, shard, chunkToMove.toBSON());
+                    return new MigrateInfo(ns, to, shard, chunkToMove.toBSON(),
+                                           distribution.getChunkLoad(chunkToMove));
                 }
 
                 warning() << "can't find any chunk to move from: " << shard
@@ -424,7 +594,8 @@ namespace mongo {
                     }
                     verify( to != shard );
                     log() << " going to move to: " << to << endl;
-                    return new MigrateInfo(ns, to, shard, chunk.toBSON());
+                    return new MigrateInfo(ns, to, shard, chunk.toBSON(),
+                                           distribution.getChunkLoad(chunk));
                 }
             }
         }
@@ -478,7 +649,15 @@ namespace mongo {
             if ( imbalance < threshold )
                 continue;
 
+            // If the load of the chunks is known, move the coldest one, so that evening out the
+            // number of chunks doesn't undo the balancing of the load.  A chunk whose load is not
+            // known may just have arrived, so it is taken to be an average one of the shard.
+            // Recently moved chunks stay where they are unless nothing else can move.
+            const double unknownLoad = distribution.hasChunkLoads() ?
+                    averageKnownChunkLoad( distribution, from, tag ) : 0;
             const vector<ChunkType *>& chunks = distribution.getChunks(from);
+            const ChunkType* chunkToMove = NULL;
+            double chunkToMoveLoad = 0;
             unsigned numJumboChunks = 0;
             for ( unsigned j = 0; j < chunks.size(); j++ ) {
                 const ChunkType& chunk = *chunks[j];
@@ -490,10 +669,28 @@ namespace mongo {
                     continue;
                 }
 
-                log() << " ns: " << ns << " going to move " << chunk
+                const double load = distribution.hasChunkLoad(chunk) ?
+                        distribution.getChunkLoad(chunk) : unknownLoad;
+                if (chunkToMove == NULL ||
+                        (distribution.isRecentlyMoved(*chunkToMove) &&
+                             !distribution.isRecentlyMoved(chunk)) ||
+                        (distribution.isRecentlyMoved(*chunkToMove) ==
+                             distribution.isRecentlyMoved(chunk) &&
+                             load < chunkToMoveLoad)) {
+                    chunkToMove = &chunk;
+                    chunkToMoveLoad = load;
+                }
+
+                if (!distribution.hasChunkLoads() && !distribution.isRecentlyMoved(*chunkToMove))
+                    break;
+            }
+
+            if ( chunkToMove ) {
+                log() << " ns: " << ns << " going to move " << *chunkToMove
                       << " from: " << from << " to: " << to << " tag [" << tag << "]"
                       << endl;
-                return new MigrateInfo(ns, to, from, chunk.toBSON());
+                return new MigrateInfo(ns, to, from, chunkToMove->toBSON(),
+                                       distribution.getChunkLoad(*chunkToMove));
             }
 
             if ( numJumboChunks ) {
@@ -507,10 +704,116 @@ namespace mongo {
             verify( false ); // should be impossible
         }
 
+        // 4) for each tag balance the load
+
+        if ( ! distribution.hasChunkLoads() ) {
+            // Everything is balanced here!
+            return NULL;
+        }
+
+        for ( unsigned i=0; i<tags.size(); i++ ) {
+            string tag = tags[i];
+
+            string from;
+            string to;
+            const double imbalance = findLoadImbalance( distribution, tag, &from, &to );
+            if ( imbalance == 0 )
+                continue;
+
+            // Moving a chunk with load L leaves the two shards |imbalance - 2L| apart, so the best
+            // chunk to move has half of the imbalance, and one with more than all of it would just
+            // make 'to' the most loaded shard.
+            const vector<ChunkType *>& chunks = distribution.getChunks(from);
+            const ChunkType* chunkToMove = NULL;
+            double bestImbalance = imbalance;
+            for ( unsigned j = 0; j < chunks.size(); j++ ) {
+                const ChunkType& chunk = *chunks[j];
+                if (distribution.getTagForChunk(chunk) != tag)
+                    continue;
+
+                if (chunk.isJumboSet() && chunk.getJumbo())
+                    continue;
+
+                // give the receiving shard time to count the chunk's operations before it can
+                // look cold enough to take it back
+                if (distribution.isRecentlyMoved(chunk))
+                    continue;
+
+                const double load = distribution.getChunkLoad(chunk);
+                if ( load <= 0 || load >= imbalance )
+                    continue;
+
+                const double newImbalance = std::fabs( imbalance - 2 * load );
+                if ( newImbalance < bestImbalance ) {
+                    chunkToMove = &chunk;
+                    bestImbalance = newImbalance;
+                }
+            }
+
+            if ( ! chunkToMove ) {
+                LOG(1) << "no chunk of " << from << " can be moved to balance the load of tag ["
+                       << tag << "]" << endl;
+                continue;
+            }
+
+            log() << " ns: " << ns << " going to move " << *chunkToMove
+                  << " from: " << from << " to: " << to << " tag [" << tag << "]"
+                  << " to balance load, load: " << distribution.getChunkLoad(*chunkToMove)
+                  << " shard load imbalance: " << imbalance << endl;
+            return new MigrateInfo(ns, to, from, chunkToMove->toBSON(),
+                                   distribution.getChunkLoad(*chunkToMove));
+        }
+
         // Everything is balanced here!
         return NULL;
     }
 
+    ChunkInfo* BalancerPolicy::findHotChunkToSplit( const string& ns,
+                                                    const DistributionStatus& distribution ) {
+        if ( ! distribution.hasChunkLoads() )
+            return NULL;
+
+        vector<string> tags( distribution.tags().begin(), distribution.tags().end() );
+        tags.push_back( "" );
+
+        for ( unsigned i=0; i<tags.size(); i++ ) {
+            string tag = tags[i];
+
+            string from;
+            string to;
+            const double imbalance = findLoadImbalance( distribution, tag, &from, &to );
+            if ( imbalance == 0 )
+                continue;
+
+            const vector<ChunkType *>& chunks = distribution.getChunks(from);
+            const ChunkType* hottest = NULL;
+            for ( unsigned j = 0; j < chunks.size(); j++ ) {
+                const ChunkType& chunk = *chunks[j];
+                if (distribution.getTagForChunk(chunk) != tag)
+                    continue;
+
+                if (chunk.isJumboSet() && chunk.getJumbo())
+                    continue;
+
+                if (hottest == NULL ||
+                        distribution.getChunkLoad(chunk) > distribution.getChunkLoad(*hottest)) {
+                    hottest = &chunk;
+                }
+            }
+
+            if ( ! hottest || distribution.getChunkLoad(*hottest) < imbalance )
+                continue;
+
+            log() << " ns: " << ns << " going to split " << *hottest << " on " << from
+                  << " tag [" << tag << "] to balance load, load: "
+                  << distribution.getChunkLoad(*hottest)
+                  << " shard load imbalance: " << imbalance << endl;
+            return new ChunkInfo(hottest->getMin(), hottest->getMax());
+        }
+
+        return NULL;
+    }
+
 
     ShardInfo::ShardInfo( long long maxSize, long long currSize,
                           bool draining, bool opsQueued,
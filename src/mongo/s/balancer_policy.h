@@ -121,9 +121,11 @@ namespace mongo {
         const std::string to;
         const std::string from;
         const ChunkInfo chunk;
+        const double load; // reads and writes per second to the chunk, 0 if unknown
 
-        MigrateInfo( const std::string& a_ns , const std::string& a_to , const std::string& a_from , const BSONObj& a_chunk )
-            : ns( a_ns ) , to( a_to ) , from( a_from ), chunk( a_chunk ) {}
+        MigrateInfo( const std::string& a_ns , const std::string& a_to , const std::string& a_from , const BSONObj& a_chunk ,
+                     double a_load = 0 )
+            : ns( a_ns ) , to( a_to ) , from( a_from ), chunk( a_chunk ), load( a_load ) {}
 
 
     };
@@ -143,6 +145,20 @@ namespace mongo {
          */
         bool addTagRange( const TagRange& range );
 
+        /**
+         * Sets the reads and writes per second to the chunk starting at 'chunkMin', as reported by
+         * the shard owning it.  Chunks without a load set are taken to have none.
+         */
+        void addChunkLoad( const BSONObj& chunkMin, double load );
+
+        /**
+         * Notes that the chunk starting at 'chunkMin' was moved recently, when it had 'load' reads
+         * and writes per second.  The shard which received it has not counted its operations for
+         * long, so the chunk is taken to have at least that load, and it is not moved again
+         * until it is no longer recent.
+         */
+        void addRecentlyMovedChunk( const BSONObj& chunkMin, double load );
+
         // ---- these methods might be better suiting in BalancerPolicy
         
         /**
@@ -157,6 +173,18 @@ namespace mongo {
          */
         std::string getMostOverloadedShard( const std::string& forTag ) const;
 
+        /**
+         * @param forTag "" if you don't care, or a tag
+         * @return the shard with the least load on its chunks with the given tag which is able to
+         *         receive a chunk
+         */
+        std::string getLeastLoadedReceiverShard( const std::string& forTag ) const;
+
+        /**
+         * @return the shard with the most load on its chunks with the given tag
+         */
+        std::string getMostLoadedShard( const std::string& forTag ) const;
+
 
         // ---- basic accessors, counters, etc...
 
@@ -172,6 +200,21 @@ namespace mongo {
         /** @return chunks for the shard */
         const std::vector<ChunkType*>& getChunks(const std::string& shard) const;
 
+        /** @return true if the load of any chunk is known */
+        bool hasChunkLoads() const { return !_chunkLoads.empty(); }
+
+        /** @return the reads and writes per second to the chunk, 0 if unknown */
+        double getChunkLoad( const ChunkType& chunk ) const;
+
+        /** @return true if the load of the chunk is known */
+        bool hasChunkLoad( const ChunkType& chunk ) const;
+
+        /** @return true if the chunk was moved recently, see addRecentlyMovedChunk */
+        bool isRecentlyMoved( const ChunkType& chunk ) const;
+
+        /** @return the reads and writes per second to this shard's chunks with the given tag */
+        double getShardLoadWithTag( const std::string& shard, const std::string& tag ) const;
+
         /** @return all tags we know about, not include "" */
         const std::set<std::string>& tags() const { return _allTags; }
 
@@ -210,6 +253,8 @@ namespace mongo {
         const ShardInfoMap& _shardInfo;
         const ShardToChunksMap& _shardChunks;
         std::map<BSONObj,TagRange> _tagRanges;
+        std::map<BSONObj,double> _chunkLoads;
+        std::map<BSONObj,double> _recentlyMovedLoads;
         std::set<std::string> _allTags;
         std::set<std::string> _shards;
     };
@@ -219,8 +264,8 @@ namespace mongo {
 
         /**
          * Returns a suggested chunk to move whithin a collection's shards, given information about
-         * space usage and number of chunks for that collection. If the policy doesn't recommend
-         * moving, it returns NULL.
+         * space usage and number of chunks for that collection, and the load of its chunks if
+         * known. If the policy doesn't recommend moving, it returns NULL.
          *
          * @param ns is the collections namepace.
          * @param DistributionStatus holds all the info about the current state of the cluster/namespace
@@ -231,6 +276,18 @@ namespace mongo {
         static MigrateInfo* balance( const std::string& ns,
                                      const DistributionStatus& distribution,
                                      int balancedLastTime );
+
+        /**
+         * Returns a chunk to split because it alone carries more of the reads and writes of its
+         * shard than moving whole chunks can even out with the other shards.  If there is none,
+         * or the load of the chunks is unknown, it returns NULL.
+         *
+         * Only meaningful when balance() recommends no move.
+         *
+         * @returns NULL or ChunkInfo of the chunk to split. caller owns the ChunkInfo instance
+         */
+        static ChunkInfo* findHotChunkToSplit( const std::string& ns,
+                                               const DistributionStatus& distribution );
     };
 
 
@@ -445,6 +445,280 @@ namespace mongo {
             ASSERT( !m );
         }
 
+        void setChunkLoad( DistributionStatus& d, OwnedShardToChunksMap& map,
+                           const string& shard, unsigned chunk, double load ) {
+            d.addChunkLoad( map.mutableMap()[shard]->vector()[chunk]->getMin(), load );
+        }
+
+        TEST( BalancerPolicyTests, LoadMovesBestChunk ) {
+            OwnedShardToChunksMap chunks;
+            addShard( chunks, 4 , false );
+            addShard( chunks, 4 , true );
+
+            ShardInfoMap shards;
+            shards["shard0"] = ShardInfo( 0, 4, false, false );
+            shards["shard1"] = ShardInfo( 0, 4, false, false );
+
+            // Moving the chunk with 100 of the 150 leaves the shards the closest
+            DistributionStatus d(shards, chunks.map());
+            setChunkLoad( d, chunks, "shard0", 0, 10 );
+            setChunkLoad( d, chunks, "shard0", 1, 100 );
+            setChunkLoad( d, chunks, "shard0", 2, 40 );
+
+            MigrateInfo* m = BalancerPolicy::balance( "ns", d, 0 );
+            ASSERT( m );
+            ASSERT_EQUALS( "shard0" , m->from );
+            ASSERT_EQUALS( "shard1" , m->to );
+            ASSERT_EQUALS( chunks.mutableMap()["shard0"]->vector()[1]->getMin(), m->chunk.min );
+            ASSERT( ! BalancerPolicy::findHotChunkToSplit( "ns", d ) );
+        }
+
+        TEST( BalancerPolicyTests, LoadTooLowToBalance ) {
+            OwnedShardToChunksMap chunks;
+            addShard( chunks, 4 , false );
+            addShard( chunks, 4 , true );
+
+            ShardInfoMap shards;
+            shards["shard0"] = ShardInfo( 0, 4, false, false );
+            shards["shard1"] = ShardInfo( 0, 4, false, false );
+
+            DistributionStatus d(shards, chunks.map());
+            setChunkLoad( d, chunks, "shard0", 0, 2 );
+            setChunkLoad( d, chunks, "shard0", 1, 3 );
+
+            ASSERT( ! BalancerPolicy::balance( "ns", d, 0 ) );
+            ASSERT( ! BalancerPolicy::findHotChunkToSplit( "ns", d ) );
+        }
+
+        TEST( BalancerPolicyTests, LoadEvenEnough ) {
+            OwnedShardToChunksMap chunks;
+            addShard( chunks, 4 , false );
+            addShard( chunks, 4 , true );
+
+            ShardInfoMap shards;
+            shards["shard0"] = ShardInfo( 0, 4, false, false );
+            shards["shard1"] = ShardInfo( 0, 4, false, false );
+
+            DistributionStatus d(shards, chunks.map());
+            setChunkLoad( d, chunks, "shard0", 0, 60 );
+            setChunkLoad( d, chunks, "shard1", 0, 40 );
+
+            ASSERT( ! BalancerPolicy::balance( "ns", d, 0 ) );
+        }
+
+        TEST( BalancerPolicyTests, LoadOfSingleHotChunkSplits ) {
+            OwnedShardToChunksMap chunks;
+            addShard( chunks, 4 , false );
+            addShard( chunks, 4 , true );
+
+            ShardInfoMap shards;
+            shards["shard0"] = ShardInfo( 0, 4, false, false );
+            shards["shard1"] = ShardInfo( 0, 4, false, false );
+
+            // Moving the hot chunk would only make shard1 the hot shard
+            DistributionStatus d(shards, chunks.map());
+            setChunkLoad( d, chunks, "shard1", 3, 100 );
+
+            ASSERT( ! BalancerPolicy::balance( "ns", d, 0 ) );
+
+            ChunkInfo* hot = BalancerPolicy::findHotChunkToSplit( "ns", d );
+            ASSERT( hot );
+            ASSERT_EQUALS( chunks.mutableMap()["shard1"]->vector()[3]->getMin(), hot->min );
+        }
+
+        TEST( BalancerPolicyTests, LoadRespectsTags ) {
+            OwnedShardToChunksMap chunks;
+            addShard( chunks, 4 , false );
+            addShard( chunks, 4 , false );
+            addShard( chunks, 4 , true );
+
+            ShardInfoMap shards;
+            shards["shard0"] = ShardInfo( 0, 4, false, false );
+            shards["shard1"] = ShardInfo( 0, 4, false, false );
+            shards["shard2"] = ShardInfo( 0, 4, false, false );
+            shards["shard0"].addTag( "a" );
+            shards["shard1"].addTag( "b" );
+            shards["shard2"].addTag( "a" );
+
+            DistributionStatus d(shards, chunks.map());
+            d.addTagRange( TagRange( BSON( "x" << 1 ), BSON( "x" << 4 ), "a" ) );
+            d.addTagRange( TagRange( BSON( "x" << 4 ), BSON( "x" << 8 ), "b" ) );
+            d.addTagRange( TagRange( BSON( "x" << 8 ), BSON( "x" << 1000 ), "a" ) );
+            setChunkLoad( d, chunks, "shard0", 1, 50 );
+            setChunkLoad( d, chunks, "shard0", 2, 50 );
+
+            // shard1 has no load, but can't take chunks tagged a
+            MigrateInfo* m = BalancerPolicy::balance( "ns", d, 0 );
+            ASSERT( m );
+            ASSERT_EQUALS( "shard0" , m->from );
+            ASSERT_EQUALS( "shard2" , m->to );
+        }
+
+        TEST( BalancerPolicyTests, ChunkCountMovesColdestChunk ) {
+            OwnedShardToChunksMap chunks;
+            addShard( chunks, 10 , false );
+            addShard( chunks, 0 , true );
+
+            ShardInfoMap shards;
+            shards["shard0"] = ShardInfo( 0, 10, false, false );
+            shards["shard1"] = ShardInfo( 0, 0, false, false );
+
+            DistributionStatus d(shards, chunks.map());
+            for ( unsigned i = 0; i < 10; i++ ) {
+                setChunkLoad( d, chunks, "shard0", i, i == 7 ? 0 : 20 );
+            }
+
+            MigrateInfo* m = BalancerPolicy::balance( "ns", d, 0 );
+            ASSERT( m );
+            ASSERT_EQUALS( "shard1" , m->to );
+            ASSERT_EQUALS( chunks.mutableMap()["shard0"]->vector()[7]->getMin(), m->chunk.min );
+        }
+
+        TEST( BalancerPolicyTests, ChunkCountSkipsRecentAndUnknownChunks ) {
+            OwnedShardToChunksMap chunks;
+            addShard( chunks, 10 , false );
+            addShard( chunks, 0 , true );
+
+            ShardInfoMap shards;
+            shards["shard0"] = ShardInfo( 0, 10, false, false );
+            shards["shard1"] = ShardInfo( 0, 0, false, false );
+
+            // chunk 0 has no load reported yet, and chunk 1 has just arrived and looks cold
+            DistributionStatus d(shards, chunks.map());
+            for ( unsigned i = 2; i < 10; i++ ) {
+                setChunkLoad( d, chunks, "shard0", i, i == 7 ? 5 : 20 );
+            }
+            setChunkLoad( d, chunks, "shard0", 1, 0 );
+            d.addRecentlyMovedChunk( chunks.mutableMap()["shard0"]->vector()[1]->getMin(), 0 );
+
+            MigrateInfo* m = BalancerPolicy::balance( "ns", d, 0 );
+            ASSERT( m );
+            ASSERT_EQUALS( "shard1" , m->to );
+            ASSERT_EQUALS( chunks.mutableMap()["shard0"]->vector()[7]->getMin(), m->chunk.min );
+            ASSERT_EQUALS( 5, m->load );
+
+            // the number of chunks is still balanced if all of them were moved recently
+            DistributionStatus recent(shards, chunks.map());
+            for ( unsigned i = 0; i < 10; i++ ) {
+                recent.addRecentlyMovedChunk(
+                        chunks.mutableMap()["shard0"]->vector()[i]->getMin(), 20 );
+            }
+            m = BalancerPolicy::balance( "ns", recent, 0 );
+            ASSERT( m );
+            ASSERT_EQUALS( "shard1" , m->to );
+        }
+
+        TEST( BalancerPolicyTests, LoadOfRecentlyMovedChunkCounts ) {
+            OwnedShardToChunksMap chunks;
+            addShard( chunks, 4 , false );
+            addShard( chunks, 4 , true );
+
+            ShardInfoMap shards;
+            shards["shard0"] = ShardInfo( 0, 4, false, false );
+            shards["shard1"] = ShardInfo( 0, 4, false, false );
+
+            // shard1 has not counted the operations to the chunk it just received yet
+            DistributionStatus d(shards, chunks.map());
+            setChunkLoad( d, chunks, "shard0", 0, 30 );
+            setChunkLoad( d, chunks, "shard0", 1, 30 );
+            setChunkLoad( d, chunks, "shard1", 0, 2 );
+            d.addRecentlyMovedChunk( chunks.mutableMap()["shard1"]->vector()[0]->getMin(), 50 );
+
+            ASSERT_EQUALS( 50, d.getShardLoadWithTag( "shard1", "" ) );
+            ASSERT( ! BalancerPolicy::balance( "ns", d, 0 ) );
+        }
+
+        TEST( BalancerPolicyTests, LoadSkipsRecentlyMovedChunk ) {
+            OwnedShardToChunksMap chunks;
+            addShard( chunks, 4 , false );
+            addShard( chunks, 4 , true );
+
+            ShardInfoMap shards;
+            shards["shard0"] = ShardInfo( 0, 4, false, false );
+            shards["shard1"] = ShardInfo( 0, 4, false, false );
+
+            // Moving chunk 0 would leave the shards the closest, but it was just moved here
+            DistributionStatus d(shards, chunks.map());
+            setChunkLoad( d, chunks, "shard0", 0, 100 );
+            setChunkLoad( d, chunks, "shard0", 1, 50 );
+            setChunkLoad( d, chunks, "shard0", 2, 20 );
+            d.addRecentlyMovedChunk( chunks.mutableMap()["shard0"]->vector()[0]->getMin(), 100 );
+
+            MigrateInfo* m = BalancerPolicy::balance( "ns", d, 0 );
+            ASSERT( m );
+            ASSERT_EQUALS( "shard0" , m->from );
+            ASSERT_EQUALS( "shard1" , m->to );
+            ASSERT_EQUALS( chunks.mutableMap()["shard0"]->vector()[1]->getMin(), m->chunk.min );
+            ASSERT_EQUALS( 50, m->load );
+        }
+
+        /**
+         * Sets up shards with as many chunks each, but with most of the load on the first one, and
+         * moves chunks as recommended until there is no more migration to run.  The load should
+         * then be even, and the number of chunks still balanced.
+         */
+        TEST( BalancerPolicyTests, LoadSimulation ) {
+            int64_t seed = 1337;
+            PseudoRandom rng(seed);
+
+            for (int test = 0; test < 10; test++) {
+                const int numShards = 4;
+                const int chunksPerShard = 20;
+
+                OwnedShardToChunksMap chunks;
+                ShardInfoMap shards;
+                map<BSONObj, double> loads;
+
+                for (int i = 0; i < numShards; i++) {
+                    addShard(chunks, chunksPerShard, i == numShards - 1);
+                    const string name = str::stream() << "shard" << i;
+                    shards[name] = ShardInfo(0, chunksPerShard, false, false);
+
+                    const vector<ChunkType*>& shardChunks = chunks.mutableMap()[name]->vector();
+                    for (unsigned j = 0; j < shardChunks.size(); j++) {
+                        loads[shardChunks[j]->getMin()] = rng.nextInt32(i == 0 ? 100 : 10);
+                    }
+                }
+
+                int numMoves = 0;
+                for (; numMoves < 200; numMoves++) {
+                    DistributionStatus d(shards, chunks.map());
+                    for (map<BSONObj, double>::iterator it = loads.begin(); it != loads.end(); ++it)
+                        d.addChunkLoad(it->first, it->second);
+
+                    MigrateInfo* m = BalancerPolicy::balance( "ns", d, numMoves != 0 );
+                    if (!m)
+                        break;
+
+                    moveChunk(chunks, m);
+                }
+                ASSERT_LESS_THAN( numMoves, 200 );
+
+                DistributionStatus d(shards, chunks.map());
+                for (map<BSONObj, double>::iterator it = loads.begin(); it != loads.end(); ++it)
+                    d.addChunkLoad(it->first, it->second);
+
+                double total = 0;
+                double minLoad = numeric_limits<double>::max();
+                double maxLoad = 0;
+                unsigned minChunks = numeric_limits<unsigned>::max();
+                unsigned maxChunks = 0;
+                for (ShardInfoMap::iterator it = shards.begin(); it != shards.end(); ++it) {
+                    const double load = d.getShardLoadWithTag(it->first, "");
+                    total += load;
+                    minLoad = std::min(minLoad, load);
+                    maxLoad = std::max(maxLoad, load);
+                    minChunks = std::min(minChunks, d.numberOfChunksInShard(it->first));
+                    maxChunks = std::max(maxChunks, d.numberOfChunksInShard(it->first));
+                    log() << it->first << " load: " << load << " chunks: "
+                          << d.numberOfChunksInShard(it->first) << endl;
+                }
+
+                ASSERT_LESS_THAN_OR_EQUALS( maxLoad - minLoad, 0.5 * total / numShards );
+                ASSERT_LESS_THAN( maxChunks - minChunks, 2u );
+            }
+        }
+
         /**
          * Idea behind this test is that we set up several shards, the first two of which are
          * draining and the second two of which have a data size limit.  We also simulate a random
@@ -83,14 +83,45 @@ namespace mongo {
     bool Chunk::ShouldAutoSplit = true;
 
     /**
-     * Attempts to move the given chunk to another shard.
+     * Reloads the chunk manager of the collection 'ns'. Chunks use this rather than a
+     * ChunkManager, as they are shared by the managers reloaded from the one that loaded them.
+     */
+    static ChunkManagerPtr reloadManager(const string& ns, bool force = true) {
+        return grid.getDBConfig(ns)->getChunkManager(ns, force);
+    }
+
+    /** @return the size chunks of a collection with 'nc' chunks should be split at. */
+    static int desiredChunkSize( int nc ) {
+        // split faster in early chunks helps spread out an initial load better
+        const int minChunkSize = 1 << 20;  // 1 MBytes
+
+        int splitThreshold = Chunk::MaxChunkSize;
+
+        if ( nc <= 1 ) {
+            return 1024;
+        }
+        else if ( nc < 3 ) {
+            return minChunkSize / 2;
+        }
+        else if ( nc < 10 ) {
+            splitThreshold = max( splitThreshold / 4 , minChunkSize );
+        }
+        else if ( nc < 20 ) {
+            splitThreshold = max( splitThreshold / 2 , minChunkSize );
+        }
+
+        return splitThreshold;
+    }
+
+    /**
+     * Attempts to move the given chunk of the collection 'ns' to another shard.
      *
      * Returns true if the chunk was actually moved.
      */
-    static bool tryMoveToOtherShard(const ChunkManager& manager, const ChunkType& chunk) {
+    static bool tryMoveToOtherShard(const string& ns, const ChunkType& chunk) {
         // reload sharding metadata before starting migration
         Shard::reloadShardInfo();
-        ChunkManagerPtr chunkMgr = manager.reload(false /* just reloaded in mulitsplit */);
+        ChunkManagerPtr chunkMgr = reloadManager(ns, false /* just reloaded in mulitsplit */);
 
         vector<Shard> allShards;
         Shard::getAllShards(allShards);
@@ -112,7 +143,7 @@ namespace mongo {
         const string configServerStr = configServer.getConnectionString().toString();
         StatusWith<string> tagStatus =
                 DistributionStatus::getTagForSingleChunk(configServerStr,
-                                                         manager.getns(),
+                                                         ns,
                                                          chunk);
         if (!tagStatus.isOK()) {
             warning() << "Not auto-moving chunk because of an error encountered while "
@@ -153,13 +184,13 @@ namespace mongo {
                                       res));
 
         // update our config
-        manager.reload();
+        reloadManager(ns);
 
         return true;
     }
 
     Chunk::Chunk(const ChunkManager * manager, BSONObj from)
-        : _manager(manager), _lastmod(0, 0, OID()), _dataWritten(mkDataWritten())
+        : _state(manager->_state), _lastmod(0, 0, OID()), _dataWritten(mkDataWritten())
     {
         string ns = from.getStringField(ChunkType::ns().c_str());
         _shard.reset(from.getStringField(ChunkType::shard().c_str()));
@@ -173,7 +204,7 @@ namespace mongo {
         _jumbo = from[ChunkType::jumbo()].trueValue();
 
         uassert( 10170 ,  "Chunk needs a ns" , ! ns.empty() );
-        uassert( 13327 ,  "Chunk ns must match server ns" , ns == _manager->getns() );
+        uassert( 13327 ,  "Chunk ns must match server ns" , ns == _state->ns );
 
         uassert( 10171 ,  "Chunk needs a server" , _shard.ok() );
 
@@ -182,46 +213,41 @@ namespace mongo {
     }
 
     Chunk::Chunk(const ChunkManager * info , const BSONObj& min, const BSONObj& max, const Shard& shard, ChunkVersion lastmod)
-        : _manager(info), _min(min), _max(max), _shard(shard), _lastmod(lastmod), _jumbo(false), _dataWritten(mkDataWritten())
+        : _state(info->_state), _min(min), _max(max), _shard(shard), _lastmod(lastmod), _jumbo(false), _dataWritten(mkDataWritten())
     {}
 
     int Chunk::mkDataWritten() {
         PseudoRandom r(static_cast<int64_t>(time(0)));
-        return r.nextInt32( MaxChunkSize / ChunkManager::SplitHeuristics::splitTestFactor );
+        return r.nextInt32( MaxChunkSize / ChunkManagerState::SplitHeuristics::splitTestFactor );
     }
 
     string Chunk::getns() const {
-        verify( _manager );
-        return _manager->getns();
+        verify( _state );
+        return _state->ns;
     }
 
     bool Chunk::containsPoint( const BSONObj& point ) const {
         return getMin().woCompare( point ) <= 0 && point.woCompare( getMax() ) < 0;
     }
 
-    bool ChunkRange::containsPoint( const BSONObj& point ) const {
-        // same as Chunk method
-        return getMin().woCompare( point ) <= 0 && point.woCompare( getMax() ) < 0;
-    }
-
     bool Chunk::minIsInf() const {
-        return _manager->getShardKey().globalMin().woCompare( getMin() ) == 0;
+        return _state->key.globalMin().woCompare( getMin() ) == 0;
     }
 
     bool Chunk::maxIsInf() const {
-        return _manager->getShardKey().globalMax().woCompare( getMax() ) == 0;
+        return _state->key.globalMax().woCompare( getMax() ) == 0;
     }
 
     BSONObj Chunk::_getExtremeKey( int sort ) const {
         Query q;
         if ( sort == 1 ) {
-            q.sort( _manager->getShardKey().key() );
+            q.sort( _state->key.key() );
         }
         else {
             // need to invert shard key pattern to sort backwards
             // TODO: make a helper in ShardKeyPattern?
 
-            BSONObj k = _manager->getShardKey().key();
+            BSONObj k = _state->key.key();
             BSONObjBuilder r;
 
             BSONObjIterator i(k);
@@ -235,11 +261,11 @@ namespace mongo {
         }
         // find the extreme key
         ScopedDbConnection conn(getShard().getConnString());
-        BSONObj end = conn->findOne(_manager->getns(), q);
+        BSONObj end = conn->findOne(_state->ns, q);
         conn.done();
         if ( end.isEmpty() )
             return BSONObj();
-        return _manager->getShardKey().extractKey( end );
+        return _state->key.extractKey( end );
     }
 
     void Chunk::pickMedianKey( BSONObj& medianKey ) const {
@@ -247,8 +273,8 @@ namespace mongo {
         ScopedDbConnection conn(getShard().getConnString());
         BSONObj result;
         BSONObjBuilder cmd;
-        cmd.append( "splitVector" , _manager->getns() );
-        cmd.append( "keyPattern" , _manager->getShardKey().key() );
+        cmd.append( "splitVector" , _state->ns );
+        cmd.append( "keyPattern" , _state->key.key() );
         cmd.append( "min" , getMin() );
         cmd.append( "max" , getMax() );
         cmd.appendBool( "force" , true );
@@ -274,8 +300,8 @@ namespace mongo {
         ScopedDbConnection conn(getShard().getConnString());
         BSONObj result;
         BSONObjBuilder cmd;
-        cmd.append( "splitVector" , _manager->getns() );
-        cmd.append( "keyPattern" , _manager->getShardKey().key() );
+        cmd.append( "splitVector" , _state->ns );
+        cmd.append( "keyPattern" , _state->key.key() );
         cmd.append( "min" , getMin() );
         cmd.append( "max" , getMax() );
         cmd.append( "maxChunkSizeBytes" , chunkSize );
@@ -394,7 +420,7 @@ namespace mongo {
     Status Chunk::multiSplit(const vector<BSONObj>& m, BSONObj* res) const {
         const size_t maxSplitPoints = 8192;
 
-        uassert( 10165 , "can't split as shard doesn't have a manager" , _manager );
+        uassert( 10165 , "can't split as shard doesn't have a manager" , _state );
         uassert( 13332 , "need a split key to split chunk" , !m.empty() );
         uassert( 13333 , "can't split a chunk in that many parts", m.size() < maxSplitPoints );
         uassert( 13003 , "can't split a chunk with only one distinct value" , _min.woCompare(_max) );
@@ -402,8 +428,8 @@ namespace mongo {
         ScopedDbConnection conn(getShard().getConnString());
 
         BSONObjBuilder cmd;
-        cmd.append( "splitChunk" , _manager->getns() );
-        cmd.append( "keyPattern" , _manager->getShardKey().key() );
+        cmd.append( "splitChunk" , _state->ns );
+        cmd.append( "keyPattern" , _state->key.key() );
         cmd.append( "min" , getMin() );
         cmd.append( "max" , getMax() );
         cmd.append( "from" , getShard().getName() );
@@ -424,7 +450,7 @@ namespace mongo {
             conn.done();
 
             // Mark the minor version for *eventual* reload
-            _manager->markMinorForReload( this->_lastmod );
+            _state->splitHeuristics.markMinorForReload( _state->ns, this->_lastmod );
 
             return Status(ErrorCodes::SplitFailed, msg);
         }
@@ -432,7 +458,7 @@ namespace mongo {
         conn.done();
         
         // force reload of config
-        _manager->reload();
+        reloadManager( _state->ns );
 
         return Status::OK();
     }
@@ -445,14 +471,14 @@ namespace mongo {
                               BSONObj& res) const {
         uassert( 10167 ,  "can't move shard to its current location!" , getShard() != to );
 
-        log() << "moving chunk ns: " << _manager->getns() << " moving ( " << toString() << ") "
+        log() << "moving chunk ns: " << _state->ns << " moving ( " << toString() << ") "
               << _shard.toString() << " -> " << to.toString() << endl;
 
         Shard from = _shard;
         ScopedDbConnection fromconn(from.getConnString());
 
         BSONObjBuilder builder;
-        builder.append("moveChunk", _manager->getns());
+        builder.append("moveChunk", _state->ns);
         builder.append("from", from.getAddress().toString());
         builder.append("to", to.getAddress().toString());
         // NEEDED FOR 2.0 COMPATIBILITY
@@ -490,7 +516,7 @@ namespace mongo {
         // if succeeded, needs to reload to pick up the new location
         // if failed, mongos may be stale
         // reload is excessive here as the failure could be simply because collection metadata is taken
-        _manager->reload();
+        reloadManager( _state->ns );
 
         return worked;
     }
@@ -501,19 +527,19 @@ namespace mongo {
 
         try {
             _dataWritten += dataWritten;
-            int splitThreshold = getManager()->getCurrentDesiredChunkSize();
+            int splitThreshold = desiredChunkSize( _state->numChunks.load() );
             if ( minIsInf() || maxIsInf() ) {
                 splitThreshold = (int) ((double)splitThreshold * .9);
             }
 
-            if ( _dataWritten < splitThreshold / ChunkManager::SplitHeuristics::splitTestFactor )
+            if ( _dataWritten < splitThreshold / ChunkManagerState::SplitHeuristics::splitTestFactor )
                 return false;
             
-            if ( ! getManager()->_splitHeuristics._splitTickets.tryAcquire() ) {
-                LOG(1) << "won't auto split because not enough tickets: " << getManager()->getns() << endl;
+            if ( ! _state->splitHeuristics._splitTickets.tryAcquire() ) {
+                LOG(1) << "won't auto split because not enough tickets: " << _state->ns << endl;
                 return false;
             }
-            TicketHolderReleaser releaser( &(getManager()->_splitHeuristics._splitTickets) );
+            TicketHolderReleaser releaser( &(_state->splitHeuristics._splitTickets) );
 
             // this is a bit ugly
             // we need it so that mongos blocks for the writes to actually be committed
@@ -549,9 +575,9 @@ namespace mongo {
             }
 
             const bool shouldBalance = grid.getConfigShouldBalance() &&
-                    grid.getCollShouldBalance(_manager->getns());
+                    grid.getCollShouldBalance(_state->ns);
 
-            log() << "autosplitted " << _manager->getns()
+            log() << "autosplitted " << _state->ns
                   << " shard: " << toString()
                   << " into " << (splitCount + 1)
                   << " (splitThreshold " << splitThreshold << ")"
@@ -573,7 +599,7 @@ namespace mongo {
                 chunkToMove.setMin(range["min"].embeddedObject());
                 chunkToMove.setMax(range["max"].embeddedObject());
 
-                tryMoveToOtherShard(*_manager, chunkToMove);
+                tryMoveToOtherShard(_state->ns, chunkToMove);
             }
 
             return true;
@@ -586,7 +612,7 @@ namespace mongo {
             _dataWritten = mkDataWritten();
 
             // if the collection lock is taken (e.g. we're migrating), it is fine for the split to fail.
-            warning() << "could not autosplit collection " << _manager->getns() << causedBy( e ) << endl;
+            warning() << "could not autosplit collection " << _state->ns << causedBy( e ) << endl;
             return false;
         }
     }
@@ -596,8 +622,8 @@ namespace mongo {
 
         BSONObj result;
         uassert( 10169 ,  "datasize failed!" , conn->runCommand( "admin" ,
-                 BSON( "datasize" << _manager->getns()
-                       << "keyPattern" << _manager->getShardKey().key()
+                 BSON( "datasize" << _state->ns
+                       << "keyPattern" << _state->key.key()
                        << "min" << getMin()
                        << "max" << getMax()
                        << "maxSize" << ( MaxChunkSize + 1 )
@@ -621,7 +647,7 @@ namespace mongo {
 
     void Chunk::serialize(BSONObjBuilder& to,ChunkVersion myLastMod) {
 
-        to.append( "_id" , genID( _manager->getns() , _min ) );
+        to.append( "_id" , genID( _state->ns , _min ) );
 
         if ( myLastMod.isSet() ) {
             myLastMod.addToBSON(to, ChunkType::DEPRECATED_lastmod());
@@ -633,7 +659,7 @@ namespace mongo {
             verify(0);
         }
 
-        to << ChunkType::ns(_manager->getns());
+        to << ChunkType::ns(_state->ns);
         to << ChunkType::min(_min);
         to << ChunkType::max(_max);
         to << ChunkType::shard(_shard.getName());
@@ -654,7 +680,7 @@ namespace mongo {
 
     string Chunk::toString() const {
         stringstream ss;
-        ss << ChunkType::ns()                 << ": " << _manager->getns()   << ", "
+        ss << ChunkType::ns()                 << ": " << _state->ns   << ", "
            << ChunkType::shard()              << ": " << _shard.toString()   << ", "
            << ChunkType::DEPRECATED_lastmod() << ": " << _lastmod.toString() << ", "
            << ChunkType::min()                << ": " << _min                << ", "
@@ -663,7 +689,7 @@ namespace mongo {
     }
 
     ShardKeyPattern Chunk::skey() const {
-        return _manager->getShardKey();
+        return _state->key;
     }
 
     void Chunk::markAsJumbo() const {
@@ -731,7 +757,8 @@ namespace mongo {
         _ns( ns ),
         _key( pattern ),
         _unique( unique ),
-        _chunkRanges(),
+        _state( new ChunkManagerState( ns, pattern ) ),
+        _routingTable(),
         _mutex("ChunkManager"),
         _sequenceNumber(NextSequenceNumber.addAndFetch(1))
     {
@@ -750,7 +777,8 @@ namespace mongo {
                                                         collDoc[CollectionType::keyPattern()].Obj().getOwned() :
                                                         BSONObj()),
         _unique(collDoc[CollectionType::unique()].trueValue()),
-        _chunkRanges(),
+        _state( new ChunkManagerState( _ns, _key ) ),
+        _routingTable(),
         _mutex("ChunkManager"),
         // The shard versioning mechanism hinges on keeping track of the number of times we reloaded ChunkManager's.
         // Increasing this number here will prompt checkShardVersion() to refresh the connection-level versions to
@@ -772,7 +800,8 @@ namespace mongo {
         _ns( oldManager->getns() ),
         _key( oldManager->getShardKey() ),
         _unique( oldManager->isUnique() ),
-        _chunkRanges(),
+        _state( oldManager->_state ),
+        _routingTable(),
         _mutex("ChunkManager"),
         _sequenceNumber(NextSequenceNumber.addAndFetch(1))
     {
@@ -787,12 +816,12 @@ namespace mongo {
 
         int tries = 3;
         while (tries--) {
-            ChunkMap chunkMap;
+            ChunkRoutingTable chunks;
             set<Shard> shards;
             ShardVersionMap shardVersions;
             Timer t;
 
-            bool success = _load( config, chunkMap, shards, shardVersions, _oldManager );
+            bool success = _load( config, chunks, shards, shardVersions, _oldManager );
 
             if( success ){
                 {
@@ -805,24 +834,22 @@ namespace mongo {
                           << endl;
                 }
 
-                // TODO: Merge into diff code above, so we validate in one place
-                if (_isValid(chunkMap)) {
-                    // These variables are const for thread-safety. Since the
-                    // constructor can only be called from one thread, we don't have
-                    // to worry about that here.
-                    const_cast<ChunkMap&>(_chunkMap).swap(chunkMap);
-                    const_cast<set<Shard>&>(_shards).swap(shards);
-                    const_cast<ShardVersionMap&>(_shardVersions).swap(shardVersions);
-                    const_cast<ChunkRangeManager&>(_chunkRanges).reloadAll(_chunkMap);
+                // These variables are const for thread-safety. Since the
+                // constructor can only be called from one thread, we don't have
+                // to worry about that here.
+                const_cast<ChunkRoutingTable&>(_routingTable).swap(chunks);
+                const_cast<set<Shard>&>(_shards).swap(shards);
+                const_cast<ShardVersionMap&>(_shardVersions).swap(shardVersions);
 
-                    // Once we load data, clear reference to old manager
-                    _oldManager.reset();
+                _state->numChunks.store(_routingTable.size());
 
-                    return;
-                }
+                // Once we load data, clear reference to old manager
+                _oldManager.reset();
+
+                return;
             }
 
-            if (_chunkMap.size() < 10) {
+            if (_routingTable.size() < 10) {
                 _printChunks();
             }
             
@@ -876,7 +903,7 @@ namespace mongo {
     };
 
     bool ChunkManager::_load( const string& config,
-                              ChunkMap& chunkMap,
+                              ChunkRoutingTable& chunks,
                               set<Shard>& shards,
                               ShardVersionMap& shardVersions,
                               ChunkManagerPtr oldManager)
@@ -886,6 +913,9 @@ namespace mongo {
         _version = ChunkVersion( 0, 0, _version.epoch() );
         set<ChunkVersion> minorVersions;
 
+        // The chunks the changes are applied to
+        ChunkRoutingTable oldChunks;
+
         // If we have a previous version of the ChunkManager to work from, use that info to reduce
         // our config query
         if( oldManager && oldManager->getVersion().isSet() ){
@@ -895,36 +925,23 @@ namespace mongo {
             // Load a copy of the old versions
             shardVersions = oldManager->_shardVersions;
 
-            // Load a copy of the chunk map, replacing the chunk manager with our own
-            const ChunkMap& oldChunkMap = oldManager->getChunkMap();
-
-            // Could be v.expensive
-            // TODO: If chunks were immutable and didn't reference the manager, we could do more
-            // interesting things here
-            for( ChunkMap::const_iterator it = oldChunkMap.begin(); it != oldChunkMap.end(); it++ ){
-
-                ChunkPtr oldC = it->second;
-                ChunkPtr c( new Chunk( this, oldC->getMin(),
-                                             oldC->getMax(),
-                                             oldC->getShard(),
-                                             oldC->getLastmod() ) );
-
-                c->setBytesWritten( oldC->getBytesWritten() );
-
-                chunkMap.insert( make_pair( oldC->getMax(), c ) );
-            }
+            // Chunks don't reference the manager, so this only copies the old table's blocks,
+            // not the chunks in them
+            oldChunks = oldManager->_routingTable;
 
             // Also get any minor versions stored for reload
             oldManager->getMarkedMinorVersions( minorVersions );
 
             LOG(2) << "loading chunk manager for collection " << _ns
                    << " using old chunk manager w/ version " << _version.toString()
-                   << " and " << oldChunkMap.size() << " chunks" << endl;
+                   << " and " << oldChunks.size() << " chunks" << endl;
         }
 
-        // Attach a diff tracker for the versioned chunk data
+        // Attach a diff tracker for the versioned chunk data. It only collects the chunks which
+        // changed since the old version, they are applied to the old chunks below.
+        ChunkMap changedChunks;
         CMConfigDiffTracker differ( this );
-        differ.attach( _ns, chunkMap, _version, shardVersions );
+        differ.attach( _ns, changedChunks, _version, shardVersions );
 
         // Diff tracker should *always* find at least one chunk if collection exists
         int diffsApplied = differ.calculateConfigDiff( config, minorVersions );
@@ -933,6 +950,15 @@ namespace mongo {
             LOG(2) << "loaded " << diffsApplied << " chunks into new chunk manager for " << _ns
                    << " with version " << _version << endl;
 
+            // Only the blocks of old chunks around the changed chunks are rebuilt
+            if ( !chunks.reloadFrom( oldChunks, changedChunks ) ) {
+                warning() << "chunks loaded for " << _ns << " at version " << _version
+                          << " have gaps or overlaps" << endl;
+
+                shardVersions.clear();
+                return false;
+            }
+
             // Add all the shards we find to the shards set
             for( ShardVersionMap::iterator it = shardVersions.begin(); it != shardVersions.end(); it++ ){
                 shards.insert( it->first );
@@ -947,7 +973,7 @@ namespace mongo {
                       << ", previous version was " << _version << endl;
 
             // Set all our data to empty
-            chunkMap.clear();
+            chunks.clear();
             shardVersions.clear();
             _version = ChunkVersion( 0, 0, OID() );
 
@@ -971,7 +997,7 @@ namespace mongo {
             }
 
             // Set all our data to empty to be extra safe
-            chunkMap.clear();
+            chunks.clear();
             shardVersions.clear();
             _version = ChunkVersion( 0, 0, OID() );
 
@@ -981,18 +1007,18 @@ namespace mongo {
     }
 
     ChunkManagerPtr ChunkManager::reload(bool force) const {
-        return grid.getDBConfig(getns())->getChunkManager(getns(), force);
+        return reloadManager(getns(), force);
     }
 
     void ChunkManager::markMinorForReload( ChunkVersion majorVersion ) const {
-        _splitHeuristics.markMinorForReload( getns(), majorVersion );
+        _state->splitHeuristics.markMinorForReload( getns(), majorVersion );
     }
 
     void ChunkManager::getMarkedMinorVersions( set<ChunkVersion>& minorVersions ) const {
-        _splitHeuristics.getMarkedMinorVersions( minorVersions );
+        _state->splitHeuristics.getMarkedMinorVersions( minorVersions );
     }
 
-    void ChunkManager::SplitHeuristics::markMinorForReload( const string& ns, ChunkVersion majorVersion ) {
+    void ChunkManagerState::SplitHeuristics::markMinorForReload( const string& ns, ChunkVersion majorVersion ) {
 
         // When we get a stale minor version, it means that some *other* mongos has just split a
         // chunk into a number of smaller parts, so we shouldn't need reload the data needed to
@@ -1030,43 +1056,15 @@ namespace mongo {
             grid.getDBConfig( ns )->getChunkManagerIfExists( ns, true, true );
     }
 
-    void ChunkManager::SplitHeuristics::getMarkedMinorVersions( set<ChunkVersion>& minorVersions ) {
+    void ChunkManagerState::SplitHeuristics::getMarkedMinorVersions( set<ChunkVersion>& minorVersions ) {
         scoped_lock lk( _staleMinorSetMutex );
         for( set<ChunkVersion>::iterator it = _staleMinorSet.begin(); it != _staleMinorSet.end(); it++ ){
             minorVersions.insert( *it );
         }
     }
 
-    bool ChunkManager::_isValid(const ChunkMap& chunkMap) {
-#define ENSURE(x) do { if(!(x)) { log() << "ChunkManager::_isValid failed: " #x << endl; return false; } } while(0)
-
-        if (chunkMap.empty())
-            return true;
-
-        // Check endpoints
-        ENSURE(allOfType(MinKey, chunkMap.begin()->second->getMin()));
-        ENSURE(allOfType(MaxKey, boost::prior(chunkMap.end())->second->getMax()));
-
-        // Make sure there are no gaps or overlaps
-        for (ChunkMap::const_iterator it=boost::next(chunkMap.begin()), end=chunkMap.end(); it != end; ++it) {
-            ChunkMap::const_iterator last = boost::prior(it);
-
-            if (!(it->second->getMin() == last->second->getMax())) {
-                PRINT(last->second->toString());
-                PRINT(it->second->toString());
-                PRINT(it->second->getMin());
-                PRINT(last->second->getMax());
-            }
-            ENSURE(it->second->getMin() == last->second->getMax());
-        }
-
-        return true;
-
-#undef ENSURE
-    }
-
     void ChunkManager::_printChunks() const {
-        for (ChunkMap::const_iterator it=_chunkMap.begin(), end=_chunkMap.end(); it != end; ++it) {
+        for (ChunkRoutingTable::const_iterator it=_routingTable.begin(), end=_routingTable.end(); it != end; ++it) {
             log() << *it->second << endl;
         }
     }
@@ -1085,7 +1083,7 @@ namespace mongo {
                                                 vector<BSONObj>* splitPoints,
                                                 vector<Shard>* shards ) const
     {
-        verify( _chunkMap.size() == 0 );
+        verify( _routingTable.empty() );
 
         unsigned long long numObjects = 0;
         Chunk c(this, _key.globalMin(), _key.globalMax(), primary);
@@ -1195,8 +1193,8 @@ namespace mongo {
             BSONObj foo;
             ChunkPtr c;
             {
-                ChunkMap::const_iterator it = _chunkMap.upper_bound( point );
-                if (it != _chunkMap.end()) {
+                ChunkRoutingTable::const_iterator it = _routingTable.upperBound( point );
+                if (it != _routingTable.end()) {
                     foo = it->first;
                     c = it->second;
                 }
@@ -1221,7 +1219,7 @@ namespace mongo {
                      str::stream() << "couldn't find a chunk intersecting: " << point
                                    << " for ns: " << _ns
                                    << " at version: " << _version.toString()
-                                   << ", number of chunks: " << _chunkMap.size() );
+                                   << ", number of chunks: " << _routingTable.size() );
     }
 
     ChunkPtr ChunkManager::findChunkForDoc( const BSONObj& doc ) const {
@@ -1230,7 +1228,7 @@ namespace mongo {
     }
 
     ChunkPtr ChunkManager::findChunkOnServer( const Shard& shard ) const {
-        for ( ChunkMap::const_iterator i=_chunkMap.begin(); i!=_chunkMap.end(); ++i ) {
+        for ( ChunkRoutingTable::const_iterator i=_routingTable.begin(); i!=_routingTable.end(); ++i ) {
             ChunkPtr c = i->second;
             if ( c->getShard() == shard )
                 return c;
@@ -1282,8 +1280,8 @@ namespace mongo {
         // returned.  For now, we satisfy that assumption by adding a shard with no matches rather
         // than return an empty set of shards.
         if ( shards.empty() ) {
-            massert( 16068, "no chunk ranges available", !_chunkRanges.ranges().empty() );
-            shards.insert( _chunkRanges.ranges().begin()->second->getShard() );
+            massert( 16068, "no chunk ranges available", !_routingTable.empty() );
+            shards.insert( _routingTable.begin()->second->getShard() );
         }
     }
 
@@ -1291,19 +1289,10 @@ namespace mongo {
                                           const BSONObj& min,
                                           const BSONObj& max ) const {
 
-        ChunkRangeMap::const_iterator it = _chunkRanges.upper_bound(min);
-        ChunkRangeMap::const_iterator end = _chunkRanges.upper_bound(max);
-
-        massert( 13507 , str::stream() << "no chunks found between bounds " << min << " and " << max , it != _chunkRanges.ranges().end() );
-
-        if( end != _chunkRanges.ranges().end() ) ++end;
+        // once we know we need to visit all shards no need to keep looping
+        const bool found = _routingTable.getShardsForRange(&shards, min, max, _shards.size());
 
-        for( ; it != end; ++it ){
-            shards.insert(it->second->getShard());
-
-            // once we know we need to visit all shards no need to keep looping
-            if (shards.size() == _shards.size()) break;
-        }
+        massert( 13507 , str::stream() << "no chunks found between bounds " << min << " and " << max , found );
     }
 
     void ChunkManager::getAllShards( set<Shard>& all ) const {
@@ -1457,7 +1446,7 @@ namespace mongo {
         LOG(1) << "ChunkManager::drop : " << _ns << endl;
 
         // lock all shards so no one can do a split/migrate
-        for ( ChunkMap::const_iterator i=_chunkMap.begin(); i!=_chunkMap.end(); ++i ) {
+        for ( ChunkRoutingTable::const_iterator i=_routingTable.begin(); i!=_routingTable.end(); ++i ) {
             ChunkPtr c = i->second;
             seen.insert( c->getShard() );
         }
@@ -1559,112 +1548,335 @@ namespace mongo {
     string ChunkManager::toString() const {
         stringstream ss;
         ss << "ChunkManager: " << _ns << " key:" << _key.toString() << '\n';
-        for ( ChunkMap::const_iterator i=_chunkMap.begin(); i!=_chunkMap.end(); ++i ) {
+        for ( ChunkRoutingTable::const_iterator i=_routingTable.begin(); i!=_routingTable.end(); ++i ) {
             const ChunkPtr c = i->second;
             ss << "\t" << c->toString() << '\n';
         }
         return ss.str();
     }
 
-    void ChunkRangeManager::assertValid() const {
-        if (_ranges.empty())
-            return;
+    // Most chunks in a block of a ChunkRoutingTable. Changing a chunk rebuilds its block, so this
+    // is what bounds the cost of a refresh, as long as the table of blocks stays small.
+    static const size_t kMaxRoutingBlockSize = 128;
 
-        try {
-            // No Nulls
-            for (ChunkRangeMap::const_iterator it=_ranges.begin(), end=_ranges.end(); it != end; ++it) {
-                verify(it->second);
+    /** @return true, setting 'value', if 'key' is made of a single integer. */
+    static bool isIntegralKey(const BSONObj& key, long long* value) {
+        const BSONElement e = key.firstElement();
+        if ((e.type() != NumberInt && e.type() != NumberLong) || key.objsize() != 4 + e.size() + 1)
+            return false;
+        *value = e.numberLong();
+        return true;
+    }
+
+    static bool isSameChunk(const Chunk& a, const Chunk& b) {
+        return a.getMin() == b.getMin() && a.getMax() == b.getMax()
+            && a.getShard() == b.getShard() && a.getLastmod().equals(b.getLastmod());
+    }
+
+    bool ChunkRoutingTable::reloadFrom(const ChunkRoutingTable& base, const ChunkMap& changed) {
+        // The config servers return the chunks of the old version again, don't rebuild their
+        // blocks for them.
+        vector<value_type> changes;
+        changes.reserve(changed.size());
+        for (ChunkMap::const_iterator it = changed.begin(); it != changed.end(); ++it) {
+            const_iterator old = base.upperBound(it->second->getMin());
+            if (old != base.end() && isSameChunk(*old->second, *it->second))
+                continue;
+            changes.push_back(*it);
+        }
+
+        ChunkRoutingTable result;
+        vector<value_type> rebuilt;     // chunks of the blocks being rebuilt, in key order
+        BSONObj changedUntil;           // max of the last change added to 'rebuilt'
+        vector<value_type>::const_iterator next = changes.begin();
+
+        for (size_t b = 0; b < base._blocks.size(); b++) {
+            const BlockPtr& block = base._blocks[b];
+            const bool changedInBlock = next != changes.end()
+                    && next->second->getMin().woCompare(base._blockMaxes[b]) < 0;
+            const bool changedFromBefore = !changedUntil.isEmpty()
+                    && changedUntil.woCompare(block->entries.front().second->getMin()) > 0;
+
+            if (!changedInBlock && !changedFromBefore) {
+                if (!result.appendChunks(&rebuilt) || !result.appendBlock(block))
+                    return false;
+                continue;
             }
 
-            // Check endpoints
-            verify(allOfType(MinKey, _ranges.begin()->second->getMin()));
-            verify(allOfType(MaxKey, boost::prior(_ranges.end())->second->getMax()));
+            for (size_t i = 0; i < block->entries.size(); i++) {
+                const value_type& entry = block->entries[i];
+                for (; next != changes.end() && next->second->getMin().woCompare(entry.first) < 0;
+                     ++next) {
+                    rebuilt.push_back(*next);
+                    changedUntil = next->first;
+                }
 
-            // Make sure there are no gaps or overlaps
-            for (ChunkRangeMap::const_iterator it=boost::next(_ranges.begin()), end=_ranges.end(); it != end; ++it) {
-                ChunkRangeMap::const_iterator last = boost::prior(it);
-                verify(it->second->getMin() == last->second->getMax());
+                // The changes added so far start before this chunk ends, so this chunk is
+                // replaced if the last of them ends after it starts.
+                if (changedUntil.isEmpty() || changedUntil.woCompare(entry.second->getMin()) <= 0)
+                    rebuilt.push_back(entry);
             }
+        }
 
-            // Check Map keys
-            for (ChunkRangeMap::const_iterator it=_ranges.begin(), end=_ranges.end(); it != end; ++it) {
-                verify(it->first == it->second->getMax());
+        // Past the end of the old chunks, which is all of them if there are none.
+        rebuilt.insert(rebuilt.end(), next, vector<value_type>::const_iterator(changes.end()));
+        if (!result.appendChunks(&rebuilt))
+            return false;
+
+        if (!result.empty() && !allOfType(MaxKey, result._blockMaxes.back())) {
+            log() << "ChunkRoutingTable::reloadFrom failed: chunks end at "
+                  << result._blockMaxes.back() << endl;
+            return false;
+        }
+
+        swap(result);
+
+        DEV assertValid();
+
+        return true;
+    }
+
+    ChunkRoutingTable::BlockPtr ChunkRoutingTable::makeBlock(
+            vector<value_type>::const_iterator begin,
+            vector<value_type>::const_iterator end) {
+        Block* block = new Block();
+        BlockPtr blockPtr(block);
+
+        block->entries.assign(begin, end);
+        const size_t size = block->entries.size();
+
+        block->runEnds.resize(size);
+        for (size_t i = size; i-- > 0; ) {
+            const bool runContinues = i + 1 < size
+                    && block->entries[i + 1].second->getShard()
+                        == block->entries[i].second->getShard();
+            block->runEnds[i] = runContinues ? block->runEnds[i + 1] : i + 1;
+        }
+
+        block->integral = true;
+        for (size_t i = 0; i < size && block->integral; i++) {
+            long long max;
+            if (isIntegralKey(block->entries[i].first, &max)) {
+                block->integralMaxes.push_back(max);
             }
+            else if (!(i + 1 == size && block->entries[i].first.nFields() == 1
+                       && block->entries[i].first.firstElement().type() == MaxKey)) {
+                block->integral = false;
+            }
+        }
+        if (!block->integral)
+            block->integralMaxes.clear();
 
-            // Make sure we match the original chunks
-            const ChunkMap chunks = _ranges.begin()->second->getManager()->_chunkMap;
-            for ( ChunkMap::const_iterator i=chunks.begin(); i!=chunks.end(); ++i ) {
-                const ChunkPtr chunk = i->second;
+        return blockPtr;
+    }
 
-                ChunkRangeMap::const_iterator min = _ranges.upper_bound(chunk->getMin());
-                ChunkRangeMap::const_iterator max = _ranges.lower_bound(chunk->getMax());
+    bool ChunkRoutingTable::appendBlock(const BlockPtr& block) {
+        const BSONObj& min = block->entries.front().second->getMin();
+        if (_blocks.empty() ? !allOfType(MinKey, min) : !(min == _blockMaxes.back())) {
+            log() << "ChunkRoutingTable::appendBlock failed: chunk " << *block->entries.front().second
+                  << " doesn't start at " << (_blocks.empty() ? BSONObj() : _blockMaxes.back())
+                  << endl;
+            return false;
+        }
 
-                verify(min != _ranges.end());
-                verify(max != _ranges.end());
-                verify(min == max);
-                verify(min->second->getShard() == chunk->getShard());
-                verify(min->second->containsPoint( chunk->getMin() ));
-                verify(min->second->containsPoint( chunk->getMax() ) || (min->second->getMax() == chunk->getMax()));
+        _integralBounds = block->integral && (_blocks.empty() || _integralBounds);
+        if (_integralBounds) {
+            long long max;
+            if (isIntegralKey(block->entries.back().first, &max))
+                _blockIntegralMaxes.push_back(max);
+        }
+        else {
+            _blockIntegralMaxes.clear();
+        }
+
+        _blocks.push_back(block);
+        _blockMaxes.push_back(block->entries.back().first);
+        _size += block->entries.size();
+        return true;
+    }
+
+    bool ChunkRoutingTable::appendChunks(vector<value_type>* chunks) {
+        if (chunks->empty())
+            return true;
+
+        for (size_t i = 1; i < chunks->size(); i++) {
+            if (!((*chunks)[i].second->getMin() == (*chunks)[i - 1].first)) {
+                log() << "ChunkRoutingTable::appendChunks failed: chunk " << *(*chunks)[i].second
+                      << " doesn't start at " << (*chunks)[i - 1].first << endl;
+                return false;
             }
+        }
 
+        // Split evenly, so that a change next to a block boundary doesn't leave a tiny block.
+        const size_t numBlocks = (chunks->size() + kMaxRoutingBlockSize - 1) / kMaxRoutingBlockSize;
+        vector<value_type>::const_iterator begin = chunks->begin();
+        for (size_t b = 0; b < numBlocks; b++) {
+            vector<value_type>::const_iterator end =
+                    chunks->begin() + chunks->size() * (b + 1) / numBlocks;
+            if (!appendBlock(makeBlock(begin, end)))
+                return false;
+            begin = end;
         }
-        catch (...) {
-            error() << "\t invalid ChunkRangeMap! printing ranges:" << endl;
 
-            for (ChunkRangeMap::const_iterator it=_ranges.begin(), end=_ranges.end(); it != end; ++it)
-                cout << it->first << ": " << *it->second << endl;
+        chunks->clear();
+        return true;
+    }
 
-            throw;
+    void ChunkRoutingTable::clear() {
+        _blocks.clear();
+        _blockMaxes.clear();
+        _size = 0;
+        _integralBounds = false;
+        _blockIntegralMaxes.clear();
+    }
+
+    void ChunkRoutingTable::swap(ChunkRoutingTable& other) {
+        _blocks.swap(other._blocks);
+        _blockMaxes.swap(other._blockMaxes);
+        std::swap(_size, other._size);
+        std::swap(_integralBounds, other._integralBounds);
+        _blockIntegralMaxes.swap(other._blockIntegralMaxes);
+    }
+
+    ChunkRoutingTable::const_iterator ChunkRoutingTable::upperBound(const BSONObj& point) const {
+        long long key;
+        if (_integralBounds && isIntegralKey(point, &key)) {
+            const size_t b = std::upper_bound(_blockIntegralMaxes.begin(),
+                                              _blockIntegralMaxes.end(),
+                                              key)
+                           - _blockIntegralMaxes.begin();
+            if (b == _blocks.size())
+                return end();
+
+            // If the block ends with MaxKey, the key may be past its integer maxes.
+            const vector<long long>& maxes = _blocks[b]->integralMaxes;
+            return const_iterator(this, b,
+                                  std::upper_bound(maxes.begin(), maxes.end(), key)
+                                  - maxes.begin());
+        }
+
+        size_t low = 0;
+        size_t high = _blockMaxes.size();
+        while (low < high) {
+            const size_t middle = low + (high - low) / 2;
+            if (point.woCompare(_blockMaxes[middle]) < 0) {
+                high = middle;
+            }
+            else {
+                low = middle + 1;
+            }
         }
+        if (low == _blocks.size())
+            return end();
+
+        const size_t b = low;
+        const vector<value_type>& entries = _blocks[b]->entries;
+        low = 0;
+        high = entries.size();
+        while (low < high) {
+            const size_t middle = low + (high - low) / 2;
+            if (point.woCompare(entries[middle].first) < 0) {
+                high = middle;
+            }
+            else {
+                low = middle + 1;
+            }
+        }
+        return const_iterator(this, b, low);
     }
 
-    void ChunkRangeManager::reloadAll(const ChunkMap& chunks) {
-        _ranges.clear();
-        _insertRange(chunks.begin(), chunks.end());
+    bool ChunkRoutingTable::getShardsForRange(set<Shard>* shards,
+                                              const BSONObj& min,
+                                              const BSONObj& max,
+                                              size_t maxShards) const {
+        const_iterator it = upperBound(min);
+        if (it == end())
+            return false;
 
-        DEV assertValid();
+        // The chunk containing max is included, see SERVER-4791.
+        const_iterator last = upperBound(max);
+        if (last != end())
+            ++last;
+
+        // Consecutive chunks on the same shard are skipped over at once.
+        while (it.isBefore(last)) {
+            shards->insert(it->second->getShard());
+            if (shards->size() == maxShards)
+                break;
+
+            const Block& block = *_blocks[it._block];
+            it._pos = block.runEnds[it._pos];
+            if (it._pos == block.entries.size()) {
+                it._block++;
+                it._pos = 0;
+            }
+        }
+        return true;
     }
 
-    void ChunkRangeManager::_insertRange(ChunkMap::const_iterator begin, const ChunkMap::const_iterator end) {
-        while (begin != end) {
-            ChunkMap::const_iterator first = begin;
-            Shard shard = first->second->getShard();
-            while (begin != end && (begin->second->getShard() == shard))
-                ++begin;
+    size_t ChunkRoutingTable::numSharedBlocks(const ChunkRoutingTable& other) const {
+        set<const Block*> otherBlocks;
+        for (size_t b = 0; b < other._blocks.size(); b++)
+            otherBlocks.insert(other._blocks[b].get());
 
-            shared_ptr<ChunkRange> cr (new ChunkRange(first, begin));
-            _ranges[cr->getMax()] = cr;
-        }
+        size_t shared = 0;
+        for (size_t b = 0; b < _blocks.size(); b++)
+            shared += otherBlocks.count(_blocks[b].get());
+        return shared;
     }
 
-    int ChunkManager::getCurrentDesiredChunkSize() const {
-        // split faster in early chunks helps spread out an initial load better
-        const int minChunkSize = 1 << 20;  // 1 MBytes
+    void ChunkRoutingTable::assertValid() const {
+        if (empty()) {
+            verify(_blocks.empty());
+            return;
+        }
 
-        int splitThreshold = Chunk::MaxChunkSize;
+        try {
+            verify(_blockMaxes.size() == _blocks.size());
 
-        int nc = numChunks();
+            // Check endpoints
+            verify(allOfType(MinKey, begin()->second->getMin()));
+            verify(allOfType(MaxKey, _blockMaxes.back()));
 
-        if ( nc <= 1 ) {
-            return 1024;
-        }
-        else if ( nc < 3 ) {
-            return minChunkSize / 2;
-        }
-        else if ( nc < 10 ) {
-            splitThreshold = max( splitThreshold / 4 , minChunkSize );
+            size_t size = 0;
+            BSONObj lastMax;
+            for (const_iterator it = begin(); it != end(); ++it, ++size) {
+                const Block& block = *_blocks[it._block];
+                verify(!block.entries.empty() && block.entries.size() <= kMaxRoutingBlockSize);
+                verify(_blockMaxes[it._block] == block.entries.back().first);
+
+                // Make sure we have no gaps or overlaps
+                verify(it->first == it->second->getMax());
+                if (size > 0)
+                    verify(it->second->getMin() == lastMax);
+                lastMax = it->first;
+
+                verify(upperBound(it->second->getMin()) == it);
+                const unsigned runEnd = block.runEnds[it._pos];
+                verify(runEnd > it._pos && runEnd <= block.entries.size());
+                verify(block.entries[runEnd - 1].second->getShard() == it->second->getShard());
+            }
+            verify(size == _size);
         }
-        else if ( nc < 20 ) {
-            splitThreshold = max( splitThreshold / 2 , minChunkSize );
+        catch (...) {
+            error() << "\t invalid ChunkRoutingTable! printing chunks:" << endl;
+
+            for (const_iterator it = begin(); it != end(); ++it)
+                cout << it->first << ": " << *it->second << endl;
+
+            throw;
         }
+    }
 
-        return splitThreshold;
+    int ChunkManager::getCurrentDesiredChunkSize() const {
+        return desiredChunkSize( numChunks() );
     }
     
     /** This is for testing only, just setting up minimal basic defaults. */
     ChunkManager::ChunkManager() :
     _unique(),
-    _chunkRanges(),
+    _state( new ChunkManagerState( "", ShardKeyPattern() ) ),
+    _routingTable(),
     _mutex( "ChunkManager" ),
     _sequenceNumber()
     {}
@@ -43,19 +43,80 @@ namespace mongo {
 
     class DBConfig;
     class Chunk;
-    class ChunkRange;
     class ChunkManager;
     class ChunkObjUnitTest;
     struct WriteConcernOptions;
 
     typedef shared_ptr<const Chunk> ChunkPtr;
 
-    // key is max for each Chunk or ChunkRange
+    // key is max for each Chunk
     typedef std::map<BSONObj,ChunkPtr,BSONObjCmp> ChunkMap;
-    typedef std::map<BSONObj,shared_ptr<ChunkRange>,BSONObjCmp> ChunkRangeMap;
 
     typedef shared_ptr<const ChunkManager> ChunkManagerPtr;
 
+    /**
+     * What the chunks of a sharded collection need to know about it, which doesn't change when
+     * its ChunkManager is reloaded. A ChunkManager reloaded from an older one shares this, and
+     * the chunks that haven't changed, with the older one.
+     */
+    class ChunkManagerState : boost::noncopyable {
+    public:
+        ChunkManagerState( const std::string& ns, const ShardKeyPattern& key )
+            : ns( ns ), key( key ) {}
+
+        //
+        // Split Heuristic info
+        //
+
+        class SplitHeuristics {
+        public:
+
+            SplitHeuristics() :
+                _splitTickets( maxParallelSplits ),
+                _staleMinorSetMutex( "SplitHeuristics::staleMinorSet" ),
+                _staleMinorCount( 0 ) {}
+
+            void markMinorForReload( const std::string& ns, ChunkVersion majorVersion );
+            void getMarkedMinorVersions( std::set<ChunkVersion>& minorVersions );
+
+            TicketHolder _splitTickets;
+
+            mutex _staleMinorSetMutex;
+
+            // mutex protects below
+            int _staleMinorCount;
+            std::set<ChunkVersion> _staleMinorSet;
+
+            // Test whether we should split once data * splitTestFactor > chunkSize (approximately)
+            static const int splitTestFactor = 5;
+            // Maximum number of parallel threads requesting a split
+            static const int maxParallelSplits = 5;
+
+            // The idea here is that we're over-aggressive on split testing by a factor of
+            // splitTestFactor, so we can safely wait until we get to splitTestFactor invalid splits
+            // before changing.  Unfortunately, we also potentially over-request the splits by a
+            // factor of maxParallelSplits, but since the factors are identical it works out
+            // (for now) for parallel or sequential oversplitting.
+            // TODO: Make splitting a separate thread with notifications?
+            static const int staleMinorReloadThreshold = maxParallelSplits;
+
+        };
+
+        //
+        // End split heuristics
+        //
+
+        const std::string ns;
+        const ShardKeyPattern key;
+
+        // Number of chunks of the most recently loaded ChunkManager, to size splits by
+        AtomicUInt32 numChunks;
+
+        SplitHeuristics splitHeuristics;
+    };
+
+    typedef shared_ptr<ChunkManagerState> ChunkManagerStatePtr;
+
     /**
        config.chunks
        { ns : "alleyinsider.fs.chunks" , min : {} , max : {} , server : "localhost:30001" }
@@ -234,14 +295,12 @@ namespace mongo {
 
         std::string getns() const;
         Shard getShard() const { return _shard; }
-        const ChunkManager* getManager() const { return _manager; }
-        
 
     private:
 
         // main shard info
         
-        const ChunkManager * _manager;
+        const ChunkManagerStatePtr _state;
 
         BSONObj _min;
         BSONObj _max;
@@ -280,78 +339,149 @@ namespace mongo {
         ShardKeyPattern skey() const;
     };
 
-    class ChunkRange {
+    /**
+     * Immutable, flat copy of a collection's chunks for routing lookups.
+     *
+     * The chunks are kept in key order in blocks of contiguous arrays, so that finding the chunk
+     * for a key is a binary search over the blocks' max bounds and then over the chunks' max
+     * bounds in one block, rather than a walk down a tree. When the shard key has a single field
+     * and all the bounds are integers, as with hashed shard keys, the bounds are also kept as
+     * plain integers and integer keys are found without comparing BSON.
+     *
+     * Blocks are never modified once built. A table rebuilt from another one and a few changed
+     * chunks shares every block that none of the changes overlap, so refreshing the chunks after
+     * a split or a migration only copies the blocks around the changed chunks.
+     */
+    class ChunkRoutingTable {
+        struct Block;
+        typedef shared_ptr<const Block> BlockPtr;
+
     public:
-        const ChunkManager* getManager() const { return _manager; }
-        Shard getShard() const { return _shard; }
+        // max and chunk, as in a ChunkMap
+        typedef std::pair<BSONObj, ChunkPtr> value_type;
 
-        const BSONObj& getMin() const { return _min; }
-        const BSONObj& getMax() const { return _max; }
+        /** Iterates over the chunks in key order. */
+        class const_iterator {
+        public:
+            const_iterator() : _table(NULL), _block(0), _pos(0) {}
 
-        // clones of Chunk methods
-        // Returns true if this ChunkRange contains the given point, and false otherwise
-        //
-        // Note: this function takes an extracted *key*, not an original document
-        // (the point may be computed by, say, hashing a given field or projecting
-        //  to a subset of fields).
-        bool containsPoint( const BSONObj& point ) const;
+            const value_type& operator*() const { return _table->_blocks[_block]->entries[_pos]; }
+            const value_type* operator->() const { return &**this; }
 
-        ChunkRange(ChunkMap::const_iterator begin, const ChunkMap::const_iterator end)
-            : _manager(begin->second->getManager())
-            , _shard(begin->second->getShard())
-            , _min(begin->second->getMin())
-            , _max(boost::prior(end)->second->getMax()) {
-            verify( begin != end );
-
-            DEV while (begin != end) {
-                verify(begin->second->getManager() == _manager);
-                verify(begin->second->getShard() == _shard);
-                ++begin;
+            const_iterator& operator++() {
+                if (++_pos == _table->_blocks[_block]->entries.size()) {
+                    _block++;
+                    _pos = 0;
+                }
+                return *this;
+            }
+            const_iterator operator++(int) {
+                const_iterator old = *this;
+                ++*this;
+                return old;
             }
-        }
 
-        // Merge min and max (must be adjacent ranges)
-        ChunkRange(const ChunkRange& min, const ChunkRange& max)
-            : _manager(min.getManager())
-            , _shard(min.getShard())
-            , _min(min.getMin())
-            , _max(max.getMax()) {
-            verify(min.getShard() == max.getShard());
-            verify(min.getManager() == max.getManager());
-            verify(min.getMax() == max.getMin());
-        }
+            bool operator==(const const_iterator& other) const {
+                return _block == other._block && _pos == other._pos;
+            }
+            bool operator!=(const const_iterator& other) const { return !(*this == other); }
 
-        friend std::ostream& operator<<(std::ostream& out, const ChunkRange& cr) {
-            return (out << "ChunkRange(min=" << cr._min << ", max=" << cr._max << ", shard=" << cr._shard <<")");
-        }
+        private:
+            friend class ChunkRoutingTable;
 
-    private:
-        const ChunkManager* _manager;
-        const Shard _shard;
-        const BSONObj _min;
-        const BSONObj _max;
-    };
+            const_iterator(const ChunkRoutingTable* table, size_t block, size_t pos)
+                : _table(table), _block(block), _pos(pos) {}
 
+            bool isBefore(const const_iterator& other) const {
+                return _block < other._block || (_block == other._block && _pos < other._pos);
+            }
 
-    class ChunkRangeManager {
-    public:
-        const ChunkRangeMap& ranges() const { return _ranges; }
+            const ChunkRoutingTable* _table;
+            size_t _block;
+            size_t _pos;
+        };
 
-        void clear() { _ranges.clear(); }
+        ChunkRoutingTable() : _size(0), _integralBounds(false) {}
 
-        void reloadAll(const ChunkMap& chunks);
+        /**
+         * Rebuilds the table as 'base' with the chunks of 'base' overlapped by any of the
+         * 'changed' chunks replaced by them. 'base' may be empty, 'changed' then holds all the
+         * chunks.
+         *
+         * The blocks of 'base' which none of the changes overlap are shared with it, and changed
+         * chunks identical to the chunk of 'base' at their place are ignored.
+         *
+         * @return false, leaving the table empty, if the chunks don't cover the whole key space
+         *         without gaps or overlaps.
+         */
+        bool reloadFrom(const ChunkRoutingTable& base, const ChunkMap& changed);
+
+        void clear();
+        void swap(ChunkRoutingTable& other);
+
+        size_t size() const { return _size; }
+        bool empty() const { return _size == 0; }
+
+        const_iterator begin() const { return const_iterator(this, 0, 0); }
+        const_iterator end() const { return const_iterator(this, _blocks.size(), 0); }
+
+        /**
+         * @return the first chunk whose max is greater than 'point', which is the chunk containing
+         *         'point' if there is one, or end() if there is none.
+         *
+         * Note: this function takes an extracted *key*, not an original document.
+         */
+        const_iterator upperBound(const BSONObj& point) const;
+
+        /**
+         * Adds the shards owning any part of [min, max] to 'shards', stopping early once it
+         * holds 'maxShards' shards.
+         * @return false if there is no chunk at or after 'min'.
+         */
+        bool getShardsForRange(std::set<Shard>* shards,
+                               const BSONObj& min,
+                               const BSONObj& max,
+                               size_t maxShards) const;
+
+        /** @return how many of the blocks of this table are shared with 'other'. */
+        size_t numSharedBlocks(const ChunkRoutingTable& other) const;
 
         // Slow operation -- wrap with DEV
         void assertValid() const;
 
-        ChunkRangeMap::const_iterator upper_bound(const BSONObj& o) const { return _ranges.upper_bound(o); }
-        ChunkRangeMap::const_iterator lower_bound(const BSONObj& o) const { return _ranges.lower_bound(o); }
-
     private:
-        // assumes nothing in this range exists in _ranges
-        void _insertRange(ChunkMap::const_iterator begin, const ChunkMap::const_iterator end);
+        struct Block {
+            std::vector<value_type> entries;    // in key order
+            std::vector<unsigned> runEnds;      // index after the last of the consecutive
+                                                // chunks of the block on the same shard as each
+                                                // chunk
+
+            // Set if every chunk's max has a single field which is an integer, or is MaxKey for
+            // the last chunk. integralMaxes then holds the integer maxes.
+            bool integral;
+            std::vector<long long> integralMaxes;
+        };
+
+        static BlockPtr makeBlock(std::vector<value_type>::const_iterator begin,
+                                  std::vector<value_type>::const_iterator end);
+
+        /** @return false, without appending it, if 'block' doesn't start where the table ends. */
+        bool appendBlock(const BlockPtr& block);
 
-        ChunkRangeMap _ranges;
+        /**
+         * Appends 'chunks' in new blocks, and clears 'chunks'.
+         * @return false if they aren't contiguous, or don't start where the table ends.
+         */
+        bool appendChunks(std::vector<value_type>* chunks);
+
+        std::vector<BlockPtr> _blocks;
+        std::vector<BSONObj> _blockMaxes;   // max of the last chunk of each block
+        size_t _size;
+
+        // Set if every block is integral. _blockIntegralMaxes then holds the integer maxes of the
+        // blocks, so without the last block's if it is MaxKey.
+        bool _integralBounds;
+        std::vector<long long> _blockIntegralMaxes;
     };
 
     /* config.sharding
@@ -414,7 +544,7 @@ namespace mongo {
         // Methods to use once loaded / created
         //
 
-        int numChunks() const { return _chunkMap.size(); }
+        int numChunks() const { return _routingTable.size(); }
 
         /** Given a document, returns the chunk which contains that document.
          *  This works by extracting the shard key part of the given document, then
@@ -460,7 +590,7 @@ namespace mongo {
         //   =>  { a: (0, 1), (2, 3), b: (0, 1), (2, 3) }
         static IndexBounds collapseQuerySolution( const QuerySolutionNode* node );
 
-        const ChunkMap& getChunkMap() const { return _chunkMap; }
+        const ChunkRoutingTable& getChunks() const { return _routingTable; }
 
         /**
          * Returns true if, for this shard, the chunks are identical in both chunk managers
@@ -498,9 +628,8 @@ namespace mongo {
         // helpers for loading
 
         // returns true if load was consistent
-        bool _load( const std::string& config, ChunkMap& chunks, std::set<Shard>& shards,
+        bool _load( const std::string& config, ChunkRoutingTable& chunks, std::set<Shard>& shards,
                                     ShardVersionMap& shardVersions, ChunkManagerPtr oldManager);
-        static bool _isValid(const ChunkMap& chunks);
 
         // end helpers
 
@@ -509,8 +638,10 @@ namespace mongo {
         const ShardKeyPattern _key;
         const bool _unique;
 
-        const ChunkMap _chunkMap;
-        const ChunkRangeManager _chunkRanges;
+        // shared with the managers reloaded from this one
+        const ChunkManagerStatePtr _state;
+
+        const ChunkRoutingTable _routingTable;
 
         const std::set<Shard> _shards;
 
@@ -527,53 +658,7 @@ namespace mongo {
 
         const unsigned long long _sequenceNumber;
 
-        //
-        // Split Heuristic info
-        //
-
-
-        class SplitHeuristics {
-        public:
-
-            SplitHeuristics() :
-                _splitTickets( maxParallelSplits ),
-                _staleMinorSetMutex( "SplitHeuristics::staleMinorSet" ),
-                _staleMinorCount( 0 ) {}
-
-            void markMinorForReload( const std::string& ns, ChunkVersion majorVersion );
-            void getMarkedMinorVersions( std::set<ChunkVersion>& minorVersions );
-
-            TicketHolder _splitTickets;
-
-            mutex _staleMinorSetMutex;
-
-            // mutex protects below
-            int _staleMinorCount;
-            std::set<ChunkVersion> _staleMinorSet;
-
-            // Test whether we should split once data * splitTestFactor > chunkSize (approximately)
-            static const int splitTestFactor = 5;
-            // Maximum number of parallel threads requesting a split
-            static const int maxParallelSplits = 5;
-
-            // The idea here is that we're over-aggressive on split testing by a factor of
-            // splitTestFactor, so we can safely wait until we get to splitTestFactor invalid splits
-            // before changing.  Unfortunately, we also potentially over-request the splits by a
-            // factor of maxParallelSplits, but since the factors are identical it works out
-            // (for now) for parallel or sequential oversplitting.
-            // TODO: Make splitting a separate thread with notifications?
-            static const int staleMinorReloadThreshold = maxParallelSplits;
-
-        };
-
-        mutable SplitHeuristics _splitHeuristics;
-
-        //
-        // End split heuristics
-        //
-
         friend class Chunk;
-        friend class ChunkRangeManager; // only needed for CRM::assertValid()
         static AtomicUInt32 NextSequenceNumber;
         
         /** Just for testing */
@@ -592,14 +677,6 @@ namespace mongo {
         bool operator()( const ptr<Chunk> l, const ptr<Chunk> r ) const {
             return operator()(*l, *r);
         }
-
-        // Also support ChunkRanges
-        bool operator()( const ChunkRange &l, const ChunkRange &r ) const {
-            return _cmp(l.getMin(), r.getMin());
-        }
-        bool operator()( const shared_ptr<ChunkRange> l, const shared_ptr<ChunkRange> r ) const {
-            return operator()(*l, *r);
-        }
     private:
         BSONObjCmp _cmp;
     };
@@ -613,7 +690,7 @@ namespace mongo {
         Chunk _c;
     };
     */
-    inline std::string Chunk::genID() const { return genID(_manager->getns(), _min); }
+    inline std::string Chunk::genID() const { return genID(_state->ns, _min); }
 
     bool setShardVersion( DBClientBase & conn,
                           const std::string& ns,
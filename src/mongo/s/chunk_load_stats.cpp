@@ -0,0 +1,199 @@
+/**
+ *    Copyright (C) 2014 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/s/chunk_load_stats.h"
+
+#include <cmath>
+
+#include "mongo/db/server_parameters.h"
+#include "mongo/s/collection_metadata.h"
+#include "mongo/s/type_chunk.h"
+#include "mongo/util/time_support.h"
+
+namespace mongo {
+
+    // Whether mongod counts the operations on each chunk even when the balancer doesn't ask for
+    // the rates.
+    MONGO_EXPORT_SERVER_PARAMETER(chunkLoadTracking, bool, false);
+
+    ChunkLoadStats chunkLoadStats;
+
+    ChunkLoadStats::ChunkLoadStats( int halfLifeSecs )
+        : _halfLifeMillis( halfLifeSecs * 1000.0 ) {
+    }
+
+    bool ChunkLoadStats::isTracking() const {
+        if ( chunkLoadTracking ) return true;
+
+        const unsigned long long lastRequestMillis = _lastRequestMillis.load();
+        return lastRequestMillis != 0 &&
+               curTimeMillis64() < lastRequestMillis + kTrackingIdleSecs * 1000ULL;
+    }
+
+    void ChunkLoadStats::noteRequested( unsigned long long nowMillis ) {
+        _lastRequestMillis.store( nowMillis );
+    }
+
+    ChunkLoadStats::Partition& ChunkLoadStats::_partitionFor( const string& ns,
+                                                              const BSONObj& chunkMin ) {
+        const size_t hash = StringData::Hasher()( ns ) ^ static_cast<size_t>( chunkMin.hash() );
+        return _partitions[hash % kNumPartitions];
+    }
+
+    void ChunkLoadStats::noteOps( const string& ns,
+                                  const BSONObj& chunkMin,
+                                  const BSONObj& chunkMax,
+                                  long long reads,
+                                  long long writes,
+                                  unsigned long long nowMillis ) {
+        Partition& partition = _partitionFor( ns, chunkMin );
+        SimpleMutex::scoped_lock lk( partition.mutex );
+
+        ChunkCountsMap& chunks = partition.counts[ns];
+        ChunkCountsMap::iterator it = chunks.find( chunkMin );
+        if ( it == chunks.end() ) {
+            it = chunks.insert( make_pair( chunkMin.getOwned(), ChunkCounts() ) ).first;
+            it->second.max = chunkMax.getOwned();
+        }
+        else if ( it->second.max.woCompare( chunkMax ) != 0 ) {
+            // The chunk was split or merged, its old counts say little about the new chunk
+            it->second = ChunkCounts();
+            it->second.max = chunkMax.getOwned();
+        }
+
+        if ( reads ) _add( &it->second.reads, reads, nowMillis );
+        if ( writes ) _add( &it->second.writes, writes, nowMillis );
+    }
+
+    void ChunkLoadStats::noteWrite( const string& ns,
+                                    const CollectionMetadata& metadata,
+                                    const BSONObj& shardKey ) {
+        ChunkType chunk;
+        if ( !metadata.getChunkContaining( shardKey, &chunk ) ) return;
+
+        noteOps( ns, chunk.getMin(), chunk.getMax(), 0, 1, curTimeMillis64() );
+    }
+
+    void ChunkLoadStats::appendChunkLoads( const string& ns,
+                                           const CollectionMetadata& metadata,
+                                           unsigned long long nowMillis,
+                                           BSONArrayBuilder* chunks ) {
+        // chunk min to its max, reads and writes per second, so that they come out in order
+        typedef std::map<BSONObj, BSONObj> ChunkLoadMap;
+        ChunkLoadMap loads;
+
+        for ( int i = 0; i < kNumPartitions; i++ ) {
+            Partition& partition = _partitions[i];
+            SimpleMutex::scoped_lock lk( partition.mutex );
+
+            CollectionCountsMap::iterator collIt = partition.counts.find( ns );
+            if ( collIt == partition.counts.end() ) continue;
+
+            _prune( &collIt->second, &metadata );
+
+            const ChunkCountsMap& counts = collIt->second;
+            for ( ChunkCountsMap::const_iterator it = counts.begin(); it != counts.end(); ++it ) {
+                BSONObjBuilder chunkB;
+                chunkB.append( ChunkType::min(), it->first );
+                chunkB.append( ChunkType::max(), it->second.max );
+                chunkB.append( "reads", _rate( it->second.reads, nowMillis ) );
+                chunkB.append( "writes", _rate( it->second.writes, nowMillis ) );
+                loads[it->first] = chunkB.obj();
+            }
+
+            if ( counts.empty() ) {
+                partition.counts.erase( collIt );
+            }
+        }
+
+        for ( ChunkLoadMap::const_iterator it = loads.begin(); it != loads.end(); ++it ) {
+            chunks->append( it->second );
+        }
+    }
+
+    void ChunkLoadStats::forgetChunksNotIn( const string& ns, const CollectionMetadata* metadata ) {
+        for ( int i = 0; i < kNumPartitions; i++ ) {
+            Partition& partition = _partitions[i];
+            SimpleMutex::scoped_lock lk( partition.mutex );
+
+            CollectionCountsMap::iterator collIt = partition.counts.find( ns );
+            if ( collIt == partition.counts.end() ) continue;
+
+            _prune( &collIt->second, metadata );
+            if ( collIt->second.empty() ) {
+                partition.counts.erase( collIt );
+            }
+        }
+    }
+
+    void ChunkLoadStats::clear() {
+        for ( int i = 0; i < kNumPartitions; i++ ) {
+            SimpleMutex::scoped_lock lk( _partitions[i].mutex );
+            _partitions[i].counts.clear();
+        }
+    }
+
+    void ChunkLoadStats::_prune( ChunkCountsMap* counts, const CollectionMetadata* metadata ) {
+        for ( ChunkCountsMap::iterator it = counts->begin(); it != counts->end(); ) {
+            ChunkType chunk;
+            if ( !metadata
+                    || !metadata->getChunkContaining( it->first, &chunk )
+                    || chunk.getMin().woCompare( it->first ) != 0
+                    || chunk.getMax().woCompare( it->second.max ) != 0 ) {
+                // The chunk moved away, or was split or merged since it was last accessed
+                counts->erase( it++ );
+                continue;
+            }
+            ++it;
+        }
+    }
+
+    void ChunkLoadStats::_add( DecayedCount* counter,
+                               long long ops,
+                               unsigned long long nowMillis ) const {
+        if ( nowMillis > counter->lastMillis ) {
+            counter->count *= std::pow( 0.5, ( nowMillis - counter->lastMillis ) / _halfLifeMillis );
+            counter->lastMillis = nowMillis;
+        }
+        counter->count += ops;
+    }
+
+    double ChunkLoadStats::_rate( const DecayedCount& counter,
+                                  unsigned long long nowMillis ) const {
+        double count = counter.count;
+        if ( nowMillis > counter.lastMillis ) {
+            count *= std::pow( 0.5, ( nowMillis - counter.lastMillis ) / _halfLifeMillis );
+        }
+
+        // A steady rate of r operations per second decays to a count of r * halfLife / ln(2)
+        return count * std::log( 2.0 ) * 1000 / _halfLifeMillis;
+    }
+
+}  // namespace mongo
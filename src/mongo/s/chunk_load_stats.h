@@ -0,0 +1,173 @@
+/**
+ *    Copyright (C) 2014 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#pragma once
+
+#include <map>
+#include <string>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/db/jsobj.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/util/concurrency/mutex.h"
+
+namespace mongo {
+
+    class CollectionMetadata;
+
+    /**
+     * Tracks the rate of reads and writes to each chunk of the sharded collections on this shard,
+     * so that the balancer can even out the load of the shards and not only their number of
+     * chunks.
+     *
+     * Operations are counted against the chunk containing their shard key.  The counts decay
+     * exponentially with the given half life, so that the rates follow the recent traffic.  A
+     * chunk which is split or merged starts counting from zero, and the counts of chunks which no
+     * longer belong to this shard are dropped when the shard's metadata changes.
+     *
+     * Counting is only worth its cost while the balancer uses the rates, so it is off until
+     * they are asked for (see noteRequested), or always on with the chunkLoadTracking server
+     * parameter.  The counts are split over several mutexes by chunk, so that writes to
+     * different chunks don't wait for each other.
+     *
+     * Thread safe.
+     */
+    class ChunkLoadStats {
+        MONGO_DISALLOW_COPYING(ChunkLoadStats);
+    public:
+        static const int kDefaultHalfLifeSecs = 60;
+
+        // How long operations are counted after the rates were last asked for
+        static const int kTrackingIdleSecs = 10 * 60;
+
+        explicit ChunkLoadStats( int halfLifeSecs = kDefaultHalfLifeSecs );
+
+        /**
+         * Whether operations should be counted now.  Cheap enough to call per operation, but
+         * callers which count many operations should only check once.
+         */
+        bool isTracking() const;
+
+        /** Notes that the rates were asked for at 'nowMillis', which turns tracking on. */
+        void noteRequested( unsigned long long nowMillis );
+
+        /**
+         * Counts 'reads' documents read and 'writes' writes in the chunk [chunkMin, chunkMax) of
+         * 'ns', at time 'nowMillis'.
+         */
+        void noteOps( const std::string& ns,
+                      const BSONObj& chunkMin,
+                      const BSONObj& chunkMax,
+                      long long reads,
+                      long long writes,
+                      unsigned long long nowMillis );
+
+        /**
+         * Counts a write of the document with shard key 'shardKey', if it belongs to a chunk in
+         * 'metadata'.
+         */
+        void noteWrite( const std::string& ns,
+                        const CollectionMetadata& metadata,
+                        const BSONObj& shardKey );
+
+        /**
+         * Appends a { min, max, reads, writes } object for each chunk of 'metadata' which was
+         * accessed, in chunk order, with its reads and writes per second at time 'nowMillis', and
+         * forgets about the chunks of 'ns' not in 'metadata'.
+         */
+        void appendChunkLoads( const std::string& ns,
+                               const CollectionMetadata& metadata,
+                               unsigned long long nowMillis,
+                               BSONArrayBuilder* chunks );
+
+        /**
+         * Forgets about the chunks of 'ns' which are not chunks of 'metadata', or about all of
+         * 'ns' if 'metadata' is NULL.  Called when the shard's metadata for 'ns' changes.
+         */
+        void forgetChunksNotIn( const std::string& ns, const CollectionMetadata* metadata );
+
+        /** Forgets about every collection. */
+        void clear();
+
+    private:
+        // Exponentially decayed count of operations, as of 'lastMillis'
+        struct DecayedCount {
+            DecayedCount() : count( 0 ), lastMillis( 0 ) {}
+
+            double count;
+            unsigned long long lastMillis;
+        };
+
+        struct ChunkCounts {
+            BSONObj max;
+            DecayedCount reads;
+            DecayedCount writes;
+        };
+
+        // chunk min to its counts
+        typedef std::map<BSONObj, ChunkCounts> ChunkCountsMap;
+        typedef std::map<std::string, ChunkCountsMap> CollectionCountsMap;
+
+        // Each partition holds the counts of some of the chunks, chosen by _partitionFor
+        struct Partition {
+            Partition() : mutex( "ChunkLoadStats" ) {}
+
+            // Guards counts
+            SimpleMutex mutex;
+            CollectionCountsMap counts;
+        };
+
+        static const int kNumPartitions = 16;
+
+        Partition& _partitionFor( const std::string& ns, const BSONObj& chunkMin );
+
+        /**
+         * Removes the chunks of 'counts' which are not chunks of 'metadata', or all of them if
+         * 'metadata' is NULL.  Call with the partition's mutex held.
+         */
+        static void _prune( ChunkCountsMap* counts, const CollectionMetadata* metadata );
+
+        /** Decays 'counter' to 'nowMillis' and adds 'ops' to it. */
+        void _add( DecayedCount* counter, long long ops, unsigned long long nowMillis ) const;
+
+        /** @return the rate per second of the operations counted in 'counter', at 'nowMillis'. */
+        double _rate( const DecayedCount& counter, unsigned long long nowMillis ) const;
+
+        const double _halfLifeMillis;
+
+        // 0 until the rates are first asked for
+        AtomicUInt64 _lastRequestMillis;
+
+        Partition _partitions[kNumPartitions];
+    };
+
+    extern bool chunkLoadTracking;
+
+    extern ChunkLoadStats chunkLoadStats;
+
+}  // namespace mongo
@@ -0,0 +1,254 @@
+/**
+ *    Copyright (C) 2014 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#include <boost/scoped_ptr.hpp>
+#include <cmath>
+#include <string>
+
+#include "mongo/db/jsobj.h"
+#include "mongo/dbtests/mock/mock_conn_registry.h"
+#include "mongo/dbtests/mock/mock_remote_db_server.h"
+#include "mongo/s/chunk_load_stats.h"
+#include "mongo/s/chunk_version.h"
+#include "mongo/s/collection_metadata.h"
+#include "mongo/s/metadata_loader.h"
+#include "mongo/s/type_chunk.h"
+#include "mongo/s/type_collection.h"
+#include "mongo/unittest/unittest.h"
+#include "mongo/util/net/hostandport.h"
+#include "mongo/util/time_support.h"
+
+namespace {
+
+    using boost::scoped_ptr;
+    using mongo::BSONArrayBuilder;
+    using mongo::BSONObj;
+    using mongo::BSONObjIterator;
+    using mongo::ChunkLoadStats;
+    using mongo::ChunkType;
+    using mongo::ChunkVersion;
+    using mongo::CollectionMetadata;
+    using mongo::CollectionType;
+    using mongo::ConnectionString;
+    using mongo::HostAndPort;
+    using mongo::MAXKEY;
+    using mongo::MetadataLoader;
+    using mongo::MINKEY;
+    using mongo::MockConnRegistry;
+    using mongo::MockRemoteDBServer;
+    using mongo::OID;
+    using mongo::Status;
+    using std::string;
+
+    const std::string CONFIG_HOST_PORT = "$dummy_config:27017";
+
+    /**
+     * Chunks [MinKey, 10) and [10, 20) are on this shard, [20, MaxKey) is on another one.
+     */
+    class ChunkLoadStatsFixture : public mongo::unittest::Test {
+    protected:
+        void setUp() {
+            _dummyConfig.reset( new MockRemoteDBServer( CONFIG_HOST_PORT ) );
+            mongo::ConnectionString::setConnectionHook( MockConnRegistry::get()->getConnStrHook() );
+            MockConnRegistry::get()->addServer( _dummyConfig.get() );
+
+            OID epoch = OID::gen();
+
+            _dummyConfig->insert( CollectionType::ConfigNS, BSON(CollectionType::ns("test.foo") <<
+                    CollectionType::keyPattern(BSON("a" << 1)) <<
+                    CollectionType::unique(false) <<
+                    CollectionType::updatedAt(1ULL) <<
+                    CollectionType::epoch(epoch)) );
+
+            insertChunk( BSON("a" << MINKEY), BSON("a" << 10), ChunkVersion( 1, 0, epoch ),
+                         "shard0000" );
+            insertChunk( BSON("a" << 10), BSON("a" << 20), ChunkVersion( 1, 1, epoch ),
+                         "shard0000" );
+            insertChunk( BSON("a" << 20), BSON("a" << MAXKEY), ChunkVersion( 1, 2, epoch ),
+                         "shard0001" );
+
+            ConnectionString configLoc( (HostAndPort(CONFIG_HOST_PORT)) );
+            MetadataLoader loader( configLoc );
+
+            Status status = loader.makeCollectionMetadata( "test.foo",
+                                                           "shard0000",
+                                                           NULL,
+                                                           &_metadata );
+            ASSERT( status.isOK() );
+        }
+
+        void tearDown() {
+            MockConnRegistry::get()->clear();
+        }
+
+        const CollectionMetadata& getCollMetadata() const {
+            return _metadata;
+        }
+
+        /** @return the chunk loads reported by 'stats' for test.foo at 'nowMillis'. */
+        BSONObj getChunkLoads( ChunkLoadStats* stats, unsigned long long nowMillis ) {
+            BSONArrayBuilder chunks;
+            stats->appendChunkLoads( "test.foo", getCollMetadata(), nowMillis, &chunks );
+            return chunks.arr();
+        }
+
+    private:
+        void insertChunk( const BSONObj& min,
+                          const BSONObj& max,
+                          const ChunkVersion& version,
+                          const string& shard ) {
+            _dummyConfig->insert( ChunkType::ConfigNS, BSON(ChunkType::name("test.foo-" +
+                                                                            min.toString()) <<
+                    ChunkType::ns("test.foo") <<
+                    ChunkType::min(min) <<
+                    ChunkType::max(max) <<
+                    ChunkType::DEPRECATED_lastmod(version.toLong()) <<
+                    ChunkType::DEPRECATED_epoch(version.epoch()) <<
+                    ChunkType::shard(shard)) );
+        }
+
+        scoped_ptr<MockRemoteDBServer> _dummyConfig;
+        CollectionMetadata _metadata;
+    };
+
+    TEST_F(ChunkLoadStatsFixture, NoOps) {
+        ChunkLoadStats stats( 60 );
+        ASSERT_EQUALS( 0, getChunkLoads( &stats, 1000 ).nFields() );
+    }
+
+    TEST_F(ChunkLoadStatsFixture, SteadyRate) {
+        ChunkLoadStats stats( 60 );
+
+        // 10 reads and 1 write per second for 10 minutes
+        for ( unsigned long long secs = 1; secs <= 600; secs++ ) {
+            stats.noteOps( "test.foo", BSON("a" << 10), BSON("a" << 20), 10, 1, secs * 1000 );
+        }
+
+        BSONObj loads = getChunkLoads( &stats, 600 * 1000 );
+        ASSERT_EQUALS( 1, loads.nFields() );
+
+        BSONObj chunk = loads.firstElement().Obj();
+        ASSERT_EQUALS( BSON("a" << 10), chunk[ChunkType::min()].Obj() );
+        ASSERT_EQUALS( BSON("a" << 20), chunk[ChunkType::max()].Obj() );
+        ASSERT_LESS_THAN( std::fabs( chunk["reads"].Number() - 10 ), 0.5 );
+        ASSERT_LESS_THAN( std::fabs( chunk["writes"].Number() - 1 ), 0.05 );
+    }
+
+    TEST_F(ChunkLoadStatsFixture, RateDecays) {
+        ChunkLoadStats stats( 60 );
+        stats.noteOps( "test.foo", BSON("a" << MINKEY), BSON("a" << 10), 0, 600, 1000 );
+
+        double before = getChunkLoads( &stats, 1000 ).firstElement().Obj()["writes"].Number();
+        double after = getChunkLoads( &stats, 61000 ).firstElement().Obj()["writes"].Number();
+
+        ASSERT_GREATER_THAN( before, 0 );
+        ASSERT_LESS_THAN( std::fabs( after - before / 2 ), 0.001 );
+    }
+
+    TEST_F(ChunkLoadStatsFixture, NoteWriteFindsChunk) {
+        ChunkLoadStats stats( 60 );
+        stats.noteWrite( "test.foo", getCollMetadata(), BSON("a" << 15) );
+        stats.noteWrite( "test.foo", getCollMetadata(), BSON("a" << 15) );
+        stats.noteWrite( "test.foo", getCollMetadata(), BSON("a" << 5) );
+
+        // Not on this shard
+        stats.noteWrite( "test.foo", getCollMetadata(), BSON("a" << 25) );
+
+        BSONObj loads = getChunkLoads( &stats, mongo::curTimeMillis64() );
+        ASSERT_EQUALS( 2, loads.nFields() );
+
+        BSONObjIterator it( loads );
+        BSONObj first = it.next().Obj();
+        BSONObj second = it.next().Obj();
+        ASSERT_EQUALS( BSON("a" << MINKEY), first[ChunkType::min()].Obj() );
+        ASSERT_EQUALS( BSON("a" << 10), second[ChunkType::min()].Obj() );
+        ASSERT_GREATER_THAN( second["writes"].Number(), first["writes"].Number() );
+        ASSERT_EQUALS( 0, first["reads"].Number() );
+    }
+
+    TEST_F(ChunkLoadStatsFixture, ForgetsChunksNoLongerOwned) {
+        ChunkLoadStats stats( 60 );
+
+        // Moved away, merged into the chunk at MinKey, and since split at 20
+        stats.noteOps( "test.foo", BSON("a" << 20), BSON("a" << MAXKEY), 10, 10, 1000 );
+        stats.noteOps( "test.foo", BSON("a" << 5), BSON("a" << 10), 10, 10, 1000 );
+        stats.noteOps( "test.foo", BSON("a" << 10), BSON("a" << 30), 10, 10, 1000 );
+        ASSERT_EQUALS( 0, getChunkLoads( &stats, 1000 ).nFields() );
+
+        stats.noteOps( "test.foo", BSON("a" << 10), BSON("a" << 20), 10, 10, 1000 );
+        ASSERT_EQUALS( 1, getChunkLoads( &stats, 1000 ).nFields() );
+    }
+
+    TEST_F(ChunkLoadStatsFixture, SplitChunkStartsOver) {
+        ChunkLoadStats stats( 60 );
+        stats.noteOps( "test.foo", BSON("a" << 10), BSON("a" << 30), 100, 100, 1000 );
+        stats.noteOps( "test.foo", BSON("a" << 10), BSON("a" << 20), 1, 0, 1000 );
+
+        BSONObj loads = getChunkLoads( &stats, 1000 );
+        BSONObj chunk = loads.firstElement().Obj();
+        ASSERT_LESS_THAN( chunk["reads"].Number(), 0.1 );
+        ASSERT_EQUALS( 0, chunk["writes"].Number() );
+    }
+
+    TEST_F(ChunkLoadStatsFixture, TrackingFollowsRequests) {
+        ChunkLoadStats stats( 60 );
+        ASSERT_FALSE( stats.isTracking() );
+
+        const unsigned long long now = mongo::curTimeMillis64();
+        stats.noteRequested( now );
+        ASSERT_TRUE( stats.isTracking() );
+
+        stats.noteRequested( now - ( ChunkLoadStats::kTrackingIdleSecs + 1 ) * 1000ULL );
+        ASSERT_FALSE( stats.isTracking() );
+    }
+
+    TEST_F(ChunkLoadStatsFixture, ForgetChunksNotIn) {
+        ChunkLoadStats stats( 60 );
+        stats.noteOps( "test.foo", BSON("a" << MINKEY), BSON("a" << 10), 10, 10, 1000 );
+        stats.noteOps( "test.foo", BSON("a" << 10), BSON("a" << 20), 10, 10, 1000 );
+        stats.noteOps( "test.foo", BSON("a" << 20), BSON("a" << MAXKEY), 10, 10, 1000 );
+        stats.noteOps( "test.bar", BSON("a" << 10), BSON("a" << 20), 10, 10, 1000 );
+
+        stats.forgetChunksNotIn( "test.foo", &getCollMetadata() );
+        ASSERT_EQUALS( 2, getChunkLoads( &stats, 1000 ).nFields() );
+
+        stats.forgetChunksNotIn( "test.foo", NULL );
+        ASSERT_EQUALS( 0, getChunkLoads( &stats, 1000 ).nFields() );
+
+        // Other collections are left alone
+        BSONArrayBuilder chunks;
+        stats.appendChunkLoads( "test.bar", getCollMetadata(), 1000, &chunks );
+        ASSERT_EQUALS( 1, chunks.arr().nFields() );
+
+        stats.clear();
+        BSONArrayBuilder none;
+        stats.appendChunkLoads( "test.bar", getCollMetadata(), 1000, &none );
+        ASSERT_EQUALS( 0, none.arr().nFields() );
+    }
+
+}  // unnamed namespace
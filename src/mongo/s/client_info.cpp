@@ -135,6 +135,14 @@ namespace mongo {
         return _tlInfo.get();
     }
 
+    ClientInfo* ClientInfo::release() {
+        return _tlInfo.release();
+    }
+
+    void ClientInfo::attach(ClientInfo* info) {
+        _tlInfo.reset(info);
+    }
+
     ClientBasic* ClientBasic::getCurrent() {
         return ClientInfo::get();
     }
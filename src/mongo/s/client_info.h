@@ -126,6 +126,11 @@ namespace mongo {
         static ClientInfo * get(AbstractMessagingPort* messagingPort = NULL);
         // Creates a ClientInfo and stores it in _tlInfo
         static ClientInfo* create(AbstractMessagingPort* messagingPort);
+        // Removes this thread's ClientInfo from _tlInfo without deleting it; the caller takes
+        // ownership.
+        static ClientInfo* release();
+        // Stores a ClientInfo previously returned by release() in _tlInfo.
+        static void attach(ClientInfo* info);
 
     private:
 
@@ -35,6 +35,8 @@
 
 #include "mongo/base/init.h"
 #include "mongo/base/status.h"
+#include "mongo/db/commands/server_status_metric.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/s/chunk_manager_targeter.h"
 #include "mongo/s/config.h"
 #include "mongo/s/dbclient_multi_command.h"
@@ -42,6 +44,8 @@
 #include "mongo/s/grid.h"
 #include "mongo/s/write_ops/batch_write_exec.h"
 #include "mongo/s/write_ops/config_coordinator.h"
+#include "mongo/util/concurrency/mutex.h"
+#include "mongo/util/histogram.h"
 #include "mongo/util/log.h"
 #include "mongo/util/mongoutils/str.h"
 #include "mongo/util/net/hostandport.h"
@@ -53,6 +57,63 @@ namespace mongo {
 
     const int ConfigOpTimeoutMillis = 30 * 1000;
 
+    // How many child batches of an unordered write may be in flight to each shard at once, see
+    // BatchWriteExec::setPipelineDepth().  0 sends them in rounds.
+    MONGO_EXPORT_SERVER_PARAMETER( internalBatchWritePipelineDepth, int, 0 );
+
+    namespace {
+
+        /**
+         * Histograms of the round trip times of the child batches of writes sent to each shard
+         * host, reported in serverStatus metrics.shardWrites.roundTripMicros.
+         */
+        class ShardWriteRoundTrips : public ServerStatusMetric {
+        public:
+            ShardWriteRoundTrips() : ServerStatusMetric( "shardWrites.roundTripMicros" ),
+                                     _mutex( "ShardWriteRoundTrips" ) {
+            }
+
+            void record( const BatchWriteExecStats& stats ) {
+                const HostRoundTripMap& roundTrips = stats.getRoundTrips();
+                for ( HostRoundTripMap::const_iterator it = roundTrips.begin();
+                    it != roundTrips.end(); ++it ) {
+
+                    Histogram* histogram = histogramFor( it->first.toString() );
+                    for ( size_t i = 0; i < it->second.size(); ++i )
+                        histogram->record( it->second[i] );
+                }
+            }
+
+            virtual void appendAtLeaf( BSONObjBuilder& b ) const {
+                SimpleMutex::scoped_lock lk( _mutex );
+                BSONObjBuilder hosts( b.subobjStart( _leafName ) );
+                for ( HistogramMap::const_iterator it = _histograms.begin();
+                    it != _histograms.end(); ++it ) {
+
+                    BSONObjBuilder host( hosts.subobjStart( it->first ) );
+                    it->second->append( host );
+                    host.doneFast();
+                }
+                hosts.doneFast();
+            }
+
+        private:
+            // Histograms are never removed, there is one per shard host ever written to
+            typedef std::map<string, Histogram*> HistogramMap;
+
+            Histogram* histogramFor( const string& host ) {
+                SimpleMutex::scoped_lock lk( _mutex );
+                Histogram*& histogram = _histograms[host];
+                if ( !histogram )
+                    histogram = new Histogram();
+                return histogram;
+            }
+
+            mutable SimpleMutex _mutex;
+            HistogramMap _histograms;
+        } shardWriteRoundTrips;
+    }
+
     namespace {
         // TODO: consider writing a type for index instead
         /**
@@ -420,8 +481,11 @@ namespace mongo {
         DBClientShardResolver resolver;
         DBClientMultiCommand dispatcher;
         BatchWriteExec exec( &targeter, &resolver, &dispatcher );
+        exec.setPipelineDepth( internalBatchWritePipelineDepth );
         exec.executeBatch( request, response );
 
+        shardWriteRoundTrips.record( exec.getStats() );
+
         if ( _autoSplit )
             splitIfNeeded( request.getNS(), *targeter.getStats() );
 
@@ -510,6 +510,20 @@ namespace mongo {
         return false;
     }
 
+    bool CollectionMetadata::getChunkContaining( const BSONObj& lookupKey,
+                                                 ChunkType* chunk ) const {
+
+        RangeMap::const_iterator it = _chunksMap.upper_bound( lookupKey );
+        if ( it == _chunksMap.begin() ) return false;
+        --it;
+
+        if ( !rangeContains( it->first, it->second, lookupKey ) ) return false;
+
+        chunk->setMin( it->first );
+        chunk->setMax( it->second );
+        return true;
+    }
+
     BSONObj CollectionMetadata::toBSON() const {
         BSONObjBuilder bb;
         toBSON( bb );
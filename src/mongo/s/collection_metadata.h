@@ -160,6 +160,15 @@ namespace mongo {
          */
         bool getNextChunk( const BSONObj& lookupKey, ChunkType* chunk ) const;
 
+        /**
+         * Given a key 'lookupKey' in the shard key range, get the chunk of this shard which
+         * contains it.  Returns true if there is one, false otherwise.  Unlike keyBelongsToMe, the
+         * chunk is one of the chunks as split, not the range of contiguous chunks around the key.
+         *
+         * Passing a key that is not a valid shard key for this range results in undefined behavior.
+         */
+        bool getChunkContaining( const BSONObj& lookupKey, ChunkType* chunk ) const;
+
         /**
          * Given a key in the shard key range, get the next range which overlaps or is greater than
          * this key.
@@ -1240,6 +1240,27 @@ namespace {
         ASSERT( getCollMetadata().getNextChunk(BSON("a" << 30), &nextChunk) );
     }
 
+    TEST_F(ThreeChunkWithRangeGapFixture, GetChunkContaining) {
+        ChunkType chunk;
+        ASSERT( getCollMetadata().getChunkContaining(BSON("a" << 10), &chunk) );
+        ASSERT_EQUALS( 0, chunk.getMin().woCompare(BSON("a" << 10)) );
+        ASSERT_EQUALS( 0, chunk.getMax().woCompare(BSON("a" << 20)) );
+
+        ASSERT( getCollMetadata().getChunkContaining(BSON("a" << 5), &chunk) );
+        ASSERT_EQUALS( 0, chunk.getMin().woCompare(BSON("a" << MINKEY)) );
+        ASSERT_EQUALS( 0, chunk.getMax().woCompare(BSON("a" << 10)) );
+
+        ASSERT( getCollMetadata().getChunkContaining(BSON("a" << 40), &chunk) );
+        ASSERT_EQUALS( 0, chunk.getMin().woCompare(BSON("a" << 30)) );
+    }
+
+    TEST_F(ThreeChunkWithRangeGapFixture, GetChunkContainingInGap) {
+        ChunkType chunk;
+        ASSERT_FALSE( getCollMetadata().getChunkContaining(BSON("a" << 20), &chunk) );
+        ASSERT_FALSE( getCollMetadata().getChunkContaining(BSON("a" << 25), &chunk) );
+        ASSERT_FALSE( getCollMetadata().getChunkContaining(BSON("a" << MAXKEY), &chunk) );
+    }
+
     TEST_F(ThreeChunkWithRangeGapFixture, MergeChunkHoleInRange) {
 
         string errMsg;
@@ -761,10 +761,10 @@ namespace mongo {
                     // Reload the new config info.  If we created more than one initial chunk, then
                     // we need to move them around to balance.
                     ChunkManagerPtr chunkManager = config->getChunkManager( ns , true );
-                    ChunkMap chunkMap = chunkManager->getChunkMap();
+                    ChunkRoutingTable chunks = chunkManager->getChunks();
                     // 2. Move and commit each "big chunk" to a different shard.
                     int i = 0;
-                    for ( ChunkMap::const_iterator c = chunkMap.begin(); c != chunkMap.end(); ++c,++i ){
+                    for ( ChunkRoutingTable::const_iterator c = chunks.begin(); c != chunks.end(); ++c,++i ){
                         Shard to = shards[ i % numShards ];
                         ChunkPtr chunk = c->second;
 
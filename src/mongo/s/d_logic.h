@@ -314,6 +314,11 @@ namespace mongo {
 
         static ShardedConnectionInfo* get( bool create );
         static void reset();
+
+        /** detaches this thread's info, if any, without deleting it; caller takes ownership */
+        static ShardedConnectionInfo* release();
+        /** installs 'info', which may be NULL, as this thread's info */
+        static void attach( ShardedConnectionInfo* info );
         static void addHook();
 
         bool inForceVersionOkMode() const {
@@ -54,6 +54,7 @@
 #include "mongo/db/wire_version.h"
 #include "mongo/db/repl/repl_coordinator_global.h"
 #include "mongo/client/connpool.h"
+#include "mongo/s/chunk_load_stats.h"
 #include "mongo/s/chunk_version.h"
 #include "mongo/s/config.h"
 #include "mongo/s/d_logic.h"
@@ -63,6 +64,7 @@
 #include "mongo/util/concurrency/mutex.h"
 #include "mongo/util/concurrency/ticketholder.h"
 #include "mongo/util/log.h"
+#include "mongo/util/time_support.h"
 
 
 namespace mongo {
@@ -156,6 +158,7 @@ namespace mongo {
         _configServer.clear();
         _shardName.clear();
         _collMetadata.clear();
+        chunkLoadStats.clear();
     }
 
     // TODO we shouldn't need three ways for checking the version. Fix this.
@@ -221,6 +224,7 @@ namespace mongo {
         // TODO: a bit dangerous to have two different zero-version states - no-metadata and
         // no-version
         _collMetadata[ns] = cloned;
+        chunkLoadStats.forgetChunksNotIn( ns, cloned.get() );
     }
 
     void ShardingState::undoDonateChunk(OperationContext* txn,
@@ -350,6 +354,7 @@ namespace mongo {
         uassert( 16857, errMsg, NULL != cloned.get() );
 
         _collMetadata[ns] = cloned;
+        chunkLoadStats.forgetChunksNotIn( ns, cloned.get() );
     }
 
     void ShardingState::mergeChunks(OperationContext* txn,
@@ -374,6 +379,7 @@ namespace mongo {
         uassert( 17004, errMsg, NULL != cloned.get() );
 
         _collMetadata[ns] = cloned;
+        chunkLoadStats.forgetChunksNotIn( ns, cloned.get() );
     }
 
     void ShardingState::resetMetadata( const string& ns ) {
@@ -383,6 +389,7 @@ namespace mongo {
                   << endl;
 
         _collMetadata.erase( ns );
+        chunkLoadStats.forgetChunksNotIn( ns, NULL );
     }
 
     Status ShardingState::refreshMetadataIfNeeded( OperationContext* txn,
@@ -639,6 +646,7 @@ namespace mongo {
                     // Invariant: If CollMetadata was not found, version should be have been 0.
                     dassert( it != _collMetadata.end() );
                     it->second = remoteMetadata;
+                    chunkLoadStats.forgetChunksNotIn( ns, remoteMetadata.get() );
                 }
                 else if ( remoteCollVersion.epoch().isSet() ) {
 
@@ -648,6 +656,7 @@ namespace mongo {
                     // Invariant: If CollMetadata was not found, version should be have been 0.
                     dassert( it != _collMetadata.end() );
                     it->second = remoteMetadata;
+                    chunkLoadStats.forgetChunksNotIn( ns, NULL );
                 }
                 else {
                     dassert( !remoteCollVersion.epoch().isSet() );
@@ -655,6 +664,7 @@ namespace mongo {
                     // Drop detected
                     installType = InstallType_Drop;
                     _collMetadata.erase( it );
+                    chunkLoadStats.forgetChunksNotIn( ns, NULL );
                 }
 
                 *latestShardVersion = remoteShardVersion;
@@ -735,6 +745,12 @@ namespace mongo {
         b.append( "configServer" , _configServer );
         b.append( "shardName" , _shardName );
 
+        {
+            BSONObjBuilder bb( b.subobjStart( "configServerTickets" ) );
+            _configServerTickets.appendStats( bb );
+            bb.done();
+        }
+
         {
             BSONObjBuilder bb( b.subobjStart( "versions" ) );
 
@@ -798,6 +814,14 @@ namespace mongo {
         _tl.reset();
     }
 
+    ShardedConnectionInfo* ShardedConnectionInfo::release() {
+        return _tl.release();
+    }
+
+    void ShardedConnectionInfo::attach( ShardedConnectionInfo* info ) {
+        _tl.reset( info );
+    }
+
     const ChunkVersion ShardedConnectionInfo::getVersion( const string& ns ) const {
         NSVersionMap::const_iterator it = _versions.find( ns );
         if ( it != _versions.end() ) {
@@ -1236,6 +1260,48 @@ namespace mongo {
 
     } getShardVersion;
 
+    class GetChunkLoad : public MongodShardCommand {
+    public:
+        GetChunkLoad() : MongodShardCommand("getChunkLoad") {}
+
+        virtual void help( stringstream& help ) const {
+            help << "internal\n"
+                 << "reads and writes per second to this shard's chunks of a collection\n"
+                 << " example: { getChunkLoad : 'alleyinsider.foo' } ";
+        }
+
+        virtual bool isWriteCommandForConfigServer() const { return false; }
+
+        virtual void addRequiredPrivileges(const std::string& dbname,
+                                           const BSONObj& cmdObj,
+                                           std::vector<Privilege>* out) {
+            ActionSet actions;
+            actions.addAction(ActionType::internal);
+            out->push_back(Privilege(ResourcePattern::forClusterResource(), actions));
+        }
+
+        bool run(OperationContext* txn, const string& , BSONObj& cmdObj, int, string& errmsg, BSONObjBuilder& result, bool) {
+            string ns = cmdObj["getChunkLoad"].valuestrsafe();
+            if ( ns.size() == 0 ) {
+                errmsg = "need to specify full namespace";
+                return false;
+            }
+
+            // Being asked keeps the counting on.  Chunks which were never accessed, or whose
+            // rates were not tracked, are left out
+            chunkLoadStats.noteRequested( curTimeMillis64() );
+            BSONArrayBuilder chunks( result.subarrayStart( "chunks" ) );
+            CollectionMetadataPtr metadata = shardingState.getCollectionMetadata( ns );
+            if ( metadata ) {
+                chunkLoadStats.appendChunkLoads( ns, *metadata, curTimeMillis64(), &chunks );
+            }
+            chunks.done();
+
+            return true;
+        }
+
+    } getChunkLoad;
+
     class ShardingStateCmd : public MongodShardCommand {
     public:
         ShardingStateCmd() : MongodShardCommand( "shardingState" ) {}
@@ -28,7 +28,11 @@
 
 #include "mongo/s/dbclient_multi_command.h"
 
+#include <set>
+#include <vector>
+
 #include "mongo/bson/mutable/document.h"
+#include "mongo/client/dbclientinterface.h"
 #include "mongo/db/audit.h"
 #include "mongo/db/client_basic.h"
 #include "mongo/db/dbmessage.h"
@@ -38,6 +42,7 @@
 #include "mongo/s/write_ops/batch_downconvert.h"
 #include "mongo/s/write_ops/dbclient_safe_writer.h"
 #include "mongo/util/net/message.h"
+#include "mongo/util/net/socket_poll.h"
 
 namespace mongo {
 
@@ -156,7 +161,9 @@ namespace mongo {
             it != _pendingCommands.end(); ++it ) {
 
             PendingCommand* command = *it;
-            dassert( NULL == command->conn );
+
+            // Skip commands sent by an earlier sendAll(), or which couldn't be
+            if ( NULL != command->conn || !command->status.isOK() ) continue;
 
             try {
                 dassert( command->endpoint.type() == ConnectionString::MASTER ||
@@ -201,10 +208,63 @@ namespace mongo {
         return static_cast<int>( _pendingCommands.size() );
     }
 
+    DBClientMultiCommand::PendingQueue::iterator DBClientMultiCommand::nextReady() {
+
+        // Only the oldest command for each endpoint may be received, so that the responses from
+        // an endpoint are returned in the order its commands were added
+        vector<PendingQueue::iterator> candidates;
+        set<string> endpoints;
+        for ( PendingQueue::iterator it = _pendingCommands.begin();
+            it != _pendingCommands.end(); ++it ) {
+            if ( endpoints.insert( ( *it )->endpoint.toString() ).second ) {
+                candidates.push_back( it );
+            }
+        }
+
+        vector<pollfd> pollInfos;
+        for ( vector<PendingQueue::iterator>::iterator it = candidates.begin();
+            it != candidates.end(); ++it ) {
+
+            PendingCommand* command = **it;
+
+            // Failed commands don't need to wait for anything
+            if ( !command->status.isOK() ) return *it;
+
+            // Safe writes are only sent once we block in recvAny, and connections without a
+            // socket can't be polled, so these are received right away
+            DBClientConnection* conn = dynamic_cast<DBClientConnection*>( command->conn );
+            if ( NULL == conn || !isPollSupported()
+                 || !( hasBatchWriteFeature( conn ) || !isBatchWriteCommand( command->cmdObj ) ) ) {
+                return *it;
+            }
+
+            pollfd pollInfo;
+            pollInfo.fd = conn->port().psock->rawFD();
+            pollInfo.events = POLLIN;
+            pollInfo.revents = 0;
+            pollInfos.push_back( pollInfo );
+        }
+
+        // Wait for the first response to come back from any endpoint.  Errors and hangups count
+        // as responses, the recv reports them.
+        int timeout = _timeoutMillis > 0 ? _timeoutMillis : -1;
+        int nEvents = socketPoll( &pollInfos[0], pollInfos.size(), timeout );
+        if ( nEvents > 0 ) {
+            for ( size_t i = 0; i < pollInfos.size(); ++i ) {
+                if ( pollInfos[i].revents != 0 ) return candidates[i];
+            }
+        }
+
+        // If the poll failed or timed out, block on the oldest command, its recv will time out
+        // or fail the same way
+        return candidates.front();
+    }
+
     Status DBClientMultiCommand::recvAny( ConnectionString* endpoint, BSONSerializable* response ) {
 
-        scoped_ptr<PendingCommand> command( _pendingCommands.front() );
-        _pendingCommands.pop_front();
+        PendingQueue::iterator readyIt = nextReady();
+        scoped_ptr<PendingCommand> command( *readyIt );
+        _pendingCommands.erase( readyIt );
 
         *endpoint = command->endpoint;
         if ( !command->status.isOK() ) return command->status;
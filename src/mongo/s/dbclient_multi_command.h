@@ -82,6 +82,13 @@ namespace mongo {
         };
 
         typedef std::deque<PendingCommand*> PendingQueue;
+
+        /**
+         * Returns the pending command whose response should be received next, waiting until one
+         * of the responses is ready.  Only the oldest command for each endpoint is considered.
+         */
+        PendingQueue::iterator nextReady();
+
         PendingQueue _pendingCommands;
         int _timeoutMillis;
     };
@@ -29,6 +29,8 @@
 #pragma once
 
 #include <deque>
+#include <set>
+#include <string>
 
 #include "mongo/base/owned_pointer_vector.h"
 #include "mongo/s/multi_command_dispatch.h"
@@ -90,6 +92,10 @@ namespace mongo {
      *
      * If an endpoint isn't registered with a MockEndpoint, just returns BatchedCommandResponses
      * with ok : true.
+     *
+     * Responses from slow endpoints are only returned once no other endpoint has a response
+     * pending, but responses from the same endpoint are always returned in the order the commands
+     * were added.
      */
     class MockMultiWriteCommand : public MultiCommandDispatch {
     public:
@@ -101,6 +107,10 @@ namespace mongo {
                                                    mockEndpoints.end() );
         }
 
+        void addSlowEndpoint( const ConnectionString& endpoint ) {
+            _slowEndpoints.insert( endpoint.toString() );
+        }
+
         void addCommand( const ConnectionString& endpoint,
                          const StringData& dbName,
                          const BSONSerializable& request ) {
@@ -124,9 +134,20 @@ namespace mongo {
             BatchedCommandResponse* batchResponse = //
                 static_cast<BatchedCommandResponse*>( response );
 
-            *endpoint = _pending.front();
-            MockWriteResult* mockResponse = releaseByHost( _pending.front() );
-            _pending.pop_front();
+            // The oldest command to an endpoint which isn't slow, if there is one
+            std::deque<ConnectionString>::iterator nextIt = _pending.begin();
+            for ( std::deque<ConnectionString>::iterator it = _pending.begin();
+                it != _pending.end(); ++it ) {
+                if ( _slowEndpoints.count( it->toString() ) == 0 ) {
+                    nextIt = it;
+                    break;
+                }
+            }
+
+            *endpoint = *nextIt;
+            _recvd.push_back( *nextIt );
+            MockWriteResult* mockResponse = releaseByHost( *nextIt );
+            _pending.erase( nextIt );
 
             if ( NULL == mockResponse ) {
                 batchResponse->setOk( true );
@@ -145,6 +166,13 @@ namespace mongo {
             return _mockEndpoints.vector();
         }
 
+        /**
+         * Returns the endpoints of the responses returned so far, in the order they were returned.
+         */
+        const std::vector<ConnectionString>& getRecvdEndpoints() const {
+            return _recvd;
+        }
+
     private:
 
         // Find a MockEndpoint* by host, and release it so we don't see it again
@@ -167,6 +195,9 @@ namespace mongo {
         OwnedPointerVector<MockWriteResult> _mockEndpoints;
 
         std::deque<ConnectionString> _pending;
+        std::vector<ConnectionString> _recvd;
+
+        std::set<std::string> _slowEndpoints;
     };
 
 } // namespace mongo
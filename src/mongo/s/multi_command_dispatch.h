@@ -61,9 +61,11 @@ namespace mongo {
                                  const BSONSerializable& request ) = 0;
 
         /**
-         * Sends all the commands in this dispatch to their endpoints, in undefined order and
-         * without waiting for responses.  May block on full send queue (though this should be
-         * rare).
+         * Sends all the commands in this dispatch which weren't sent yet to their endpoints, in
+         * undefined order and without waiting for responses.  May block on full send queue
+         * (though this should be rare).
+         *
+         * More commands may be added and sent while earlier ones are still pending.
          *
          * Any error which occurs during sendAll will be reported on recvAny, *does not throw.*
          */
@@ -76,7 +78,8 @@ namespace mongo {
 
         /**
          * Blocks until a command response has come back.  Any outstanding command response may be
-         * returned with associated endpoint.
+         * returned with associated endpoint, but the responses of the commands sent to an endpoint
+         * are returned in the order the commands were added.
          *
          * Returns !OK on send/recv/parse failure, otherwise command-level errors are returned in
          * the response object itself.
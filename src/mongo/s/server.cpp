@@ -181,6 +181,37 @@ namespace mongo {
         virtual void disconnected( AbstractMessagingPort* p ) {
             // all things are thread local
         }
+
+        virtual bool canDetachSessions() const { return true; }
+
+        virtual void* detachSession( AbstractMessagingPort* p ) {
+            Session* s = new Session();
+            s->clientInfo = ClientInfo::release();
+            s->connections = ShardConnection::detachMyConnections();
+            return s;
+        }
+
+        virtual void attachSession( AbstractMessagingPort* p , void* session ) {
+            scoped_ptr<Session> s( static_cast<Session*>( session ) );
+            ClientInfo::attach( s->clientInfo );
+            ShardConnection::attachMyConnections( s->connections );
+        }
+
+        virtual void destroySession( void* session ) {
+            scoped_ptr<Session> s( static_cast<Session*>( session ) );
+            delete s->clientInfo;
+            ShardConnection::destroyConnections( s->connections );
+        }
+
+    private:
+        /**
+         * The per connection thread locals of a mongos client while it is parked in the
+         * network reactor.
+         */
+        struct Session {
+            ClientInfo* clientInfo;
+            ClientConnections* connections;
+        };
     };
 
 
@@ -36,6 +36,7 @@
 
 namespace mongo {
 
+    class ClientConnections;
     class ShardConnection;
     class ShardStatus;
 
@@ -324,6 +325,16 @@ namespace mongo {
          */
         static void forgetNS( const std::string& ns );
 
+        /**
+         * Detaches this thread's connections, and the namespaces they have been versioned for,
+         * so they can follow the client they serve to another thread.  The caller owns the
+         * result, which may be NULL, until it passes it to attachMyConnections() or
+         * destroyConnections().
+         */
+        static ClientConnections* detachMyConnections();
+        static void attachMyConnections( ClientConnections* conns );
+        static void destroyConnections( ClientConnections* conns );
+
     private:
         void _init();
         void _finishInit();
@@ -507,4 +507,16 @@ namespace mongo {
     void ShardConnection::forgetNS( const string& ns ) {
         ClientConnections::threadInstance()->forgetNS( ns );
     }
+
+    ClientConnections* ShardConnection::detachMyConnections() {
+        return ClientConnections::_perThread.release();
+    }
+
+    void ShardConnection::attachMyConnections( ClientConnections* conns ) {
+        ClientConnections::_perThread.reset( conns );
+    }
+
+    void ShardConnection::destroyConnections( ClientConnections* conns ) {
+        delete conns;
+    }
 }
@@ -47,6 +47,7 @@ namespace mongo {
     const BSONField<bool> SettingsType::deprecated_secondaryThrottle("_secondaryThrottle", true);
     const BSONField<BSONObj> SettingsType::migrationWriteConcern("_secondaryThrottle");
     const BSONField<bool> SettingsType::waitForDelete("_waitForDelete");
+    const BSONField<bool> SettingsType::balanceLoad("_balanceLoad");
 
     SettingsType::SettingsType() {
         clear();
@@ -130,6 +131,8 @@ namespace mongo {
         if (_isMigrationWriteConcernSet) {
             builder.append(migrationWriteConcern(), _migrationWriteConcern);
         }
+
+        if (_isBalanceLoadSet) builder.append(balanceLoad(), _balanceLoad);
         return builder.obj();
     }
 
@@ -175,6 +178,10 @@ namespace mongo {
         if (fieldState == FieldParser::FIELD_INVALID) return false;
         _isWaitForDeleteSet = fieldState == FieldParser::FIELD_SET;
 
+        fieldState = FieldParser::extract(source, balanceLoad, &_balanceLoad, errMsg);
+        if (fieldState == FieldParser::FIELD_INVALID) return false;
+        _isBalanceLoadSet = fieldState == FieldParser::FIELD_SET;
+
         return true;
     }
 
@@ -200,6 +207,9 @@ namespace mongo {
 
         _waitForDelete = false;
         _isWaitForDeleteSet = false;
+
+        _balanceLoad = false;
+        _isBalanceLoadSet = false;
     }
 
     void SettingsType::cloneTo(SettingsType* other) const {
@@ -225,6 +235,9 @@ namespace mongo {
 
         other->_waitForDelete = _waitForDelete;
         other->_isWaitForDeleteSet = _isWaitForDeleteSet;
+
+        other->_balanceLoad = _balanceLoad;
+        other->_isBalanceLoadSet = _isBalanceLoadSet;
     }
 
     std::string SettingsType::toString() const {
@@ -85,6 +85,7 @@ namespace mongo {
         static const BSONField<bool> deprecated_secondaryThrottle;
         static const BSONField<BSONObj> migrationWriteConcern;
         static const BSONField<bool> waitForDelete;
+        static const BSONField<bool> balanceLoad;
 
         //
         // settings type methods
@@ -278,6 +279,27 @@ namespace mongo {
             return _waitForDelete;
         }
 
+        void setBalanceLoad(bool balanceLoad) {
+            _balanceLoad = balanceLoad;
+            _isBalanceLoadSet = true;
+        }
+
+        void unsetBalanceLoad() {
+            _isBalanceLoadSet = false;
+        }
+
+        bool isBalanceLoadSet() const {
+            return _isBalanceLoadSet;
+        }
+
+        // Calling get*() methods when the member is not set and has no default results in undefined
+        // behavior
+        bool getBalanceLoad() const {
+            dassert(_key == BalancerDocKey);
+            dassert (_isBalanceLoadSet);
+            return _balanceLoad;
+        }
+
         // Helper methods
 
         /**
@@ -317,6 +339,9 @@ namespace mongo {
 
         bool _waitForDelete;             // (O)  synchronous migration cleanup.
         bool _isWaitForDeleteSet;
+
+        bool _balanceLoad;               // (O)  also balance the shards' reads and writes
+        bool _isBalanceLoadSet;          // to the chunks, not only their number of chunks.
     };
 
 } // namespace mongo
@@ -126,6 +126,20 @@ namespace {
         ASSERT(settings.getSecondaryThrottle());
     }
 
+    TEST(Validity, ValidWithBalanceLoad) {
+        SettingsType settings;
+        BSONObj objBalancer = BSON(SettingsType::key("balancer") <<
+                                   SettingsType::balanceLoad(true));
+        string errMsg;
+        ASSERT(settings.parseBSON(objBalancer, &errMsg));
+        ASSERT_EQUALS(errMsg, "");
+        ASSERT_TRUE(settings.isValid(NULL));
+        ASSERT_EQUALS(settings.getKey(), "balancer");
+        ASSERT_TRUE(settings.isBalanceLoadSet());
+        ASSERT(settings.getBalanceLoad());
+        ASSERT_EQUALS(objBalancer, settings.toBSON());
+    }
+
     TEST(Validity, BadType) {
         SettingsType settings;
         BSONObj obj = BSON(SettingsType::key() << 0);
@@ -33,13 +33,13 @@
 #include "mongo/s/write_ops/batch_write_exec.h"
 
 #include "mongo/base/error_codes.h"
-#include "mongo/base/owned_pointer_map.h"
 #include "mongo/base/status.h"
 #include "mongo/bson/util/builder.h"
 #include "mongo/client/dbclientinterface.h" // ConnectionString (header-only)
 #include "mongo/s/write_ops/batch_write_op.h"
 #include "mongo/s/write_ops/write_error_detail.h"
 #include "mongo/util/log.h"
+#include "mongo/util/timer.h"
 
 namespace mongo {
 
@@ -49,18 +49,31 @@ namespace mongo {
         _targeter( targeter ),
         _resolver( resolver ),
         _dispatcher( dispatcher ),
+        _pipelineDepth( 0 ),
         _stats( new BatchWriteExecStats ) {
     }
 
+    void BatchWriteExec::setPipelineDepth( int depth ) {
+        _pipelineDepth = depth;
+    }
+
     namespace {
 
+        // A TargetedWriteBatch out on the network, and the time since it was sent
+        struct PendingBatch {
+            explicit PendingBatch( TargetedWriteBatch* batch ) : batch( batch ) {}
+
+            TargetedWriteBatch* batch;
+            Timer timer;
+        };
+
         //
         // Map which allows associating ConnectionString hosts with TargetedWriteBatches
         // This is needed since the dispatcher only returns hosts with responses.
         //
 
         // TODO: Unordered map?
-        typedef OwnedPointerMap<ConnectionString, TargetedWriteBatch> OwnedHostBatchMap;
+        typedef map<ConnectionString, deque<PendingBatch> > HostBatchQueueMap;
     }
 
     static void buildErrorFrom( const Status& status, WriteErrorDetail* error ) {
@@ -152,30 +165,36 @@ namespace mongo {
             // Send all child batches
             //
 
-            size_t numSent = 0;
-            size_t numToSend = childBatches.size();
-            bool remoteMetadataChanging = false;
-            while ( numSent != numToSend ) {
+            // Unordered child batches may be pipelined, see setPipelineDepth()
+            const bool pipelined = _pipelineDepth > 0 && !clientRequest.getOrdered();
+            const size_t maxInFlightPerHost = pipelined ? _pipelineDepth : 1;
+            bool keepTargeting = pipelined && targetStatus.isOK();
 
-                // Collect batches out on the network, mapped by endpoint
-                OwnedHostBatchMap ownedPendingBatches;
-                OwnedHostBatchMap::MapType& pendingBatches = ownedPendingBatches.mutableMap();
+            // Collect batches out on the network, mapped by endpoint in the order they were sent
+            HostBatchQueueMap pendingBatches;
+            int numPendingBatches = 0;
+
+            // Child batches which were sent or couldn't be
+            vector<bool> batchDone( childBatches.size(), false );
+            size_t numBatchesDone = 0;
+
+            bool remoteMetadataChanging = false;
+            while ( true ) {
 
                 //
                 // Send side
                 //
 
                 // Get as many batches as we can at once
-                for ( vector<TargetedWriteBatch*>::iterator it = childBatches.begin();
-                    it != childBatches.end(); ++it ) {
+                for ( size_t i = 0; i < childBatches.size(); ++i ) {
 
                     //
                     // Collect the info needed to dispatch our targeted batch
                     //
 
-                    TargetedWriteBatch* nextBatch = *it;
-                    // If the batch is NULL, we sent it previously, so skip
-                    if ( nextBatch == NULL ) continue;
+                    // If the batch is done, we sent it previously, so skip
+                    if ( batchDone[i] ) continue;
+                    TargetedWriteBatch* nextBatch = childBatches[i];
 
                     // Figure out what host we need to dispatch our targeted batch
                     ConnectionString shardHost;
@@ -198,16 +217,15 @@ namespace mongo {
                         batchOp.noteBatchError( *nextBatch, error );
 
                         // We're done with this batch
-                        // Clean up when we can't resolve a host
-                        delete *it;
-                        *it = NULL;
-                        --numToSend;
+                        batchDone[i] = true;
+                        ++numBatchesDone;
                         continue;
                     }
 
-                    // If we already have a batch for this host, wait until the next time
-                    OwnedHostBatchMap::MapType::iterator pendingIt = pendingBatches.find( shardHost );
-                    if ( pendingIt != pendingBatches.end() ) continue;
+                    // If we already have as many batches for this host as we may have in flight,
+                    // wait until the next time
+                    deque<PendingBatch>& hostBatches = pendingBatches[shardHost];
+                    if ( hostBatches.size() >= maxInFlightPerHost ) continue;
 
                     //
                     // We now have all the info needed to dispatch the batch
@@ -226,34 +244,66 @@ namespace mongo {
 
                     _dispatcher->addCommand( shardHost, nss.db(), request );
 
-                    // Indicate we're done by setting the batch to NULL
-                    // We'll only get duplicate hostEndpoints if we have broadcast and non-broadcast
-                    // endpoints for the same host, so this should be pretty efficient without
-                    // moving stuff around.
-                    *it = NULL;
+                    // Indicate we're done with the batch.  We'll only get duplicate hostEndpoints
+                    // if we have broadcast and non-broadcast endpoints for the same host, or
+                    // pipelined batches, so this should be pretty efficient without moving stuff
+                    // around.
+                    batchDone[i] = true;
+                    ++numBatchesDone;
 
-                    // Recv-side is responsible for cleaning up the nextBatch when used
-                    pendingBatches.insert( make_pair( shardHost, nextBatch ) );
+                    // Recv-side is responsible for noting the response in the nextBatch
+                    hostBatches.push_back( PendingBatch( nextBatch ) );
+                    ++numPendingBatches;
+                }
+
+                // Pipelined batches keep going out while their hosts have room for them, so once
+                // all the targeted batches are out, target the writes which didn't fit in them
+                if ( keepTargeting && numBatchesDone == childBatches.size() ) {
+
+                    size_t numTargeted = childBatches.size();
+                    Status retargetStatus = batchOp.targetBatch( *_targeter,
+                                                                 recordTargetErrors,
+                                                                 &childBatches );
+                    if ( !retargetStatus.isOK() ) {
+                        // Don't do anything until a targeter refresh
+                        _targeter->noteCouldNotTarget();
+                        refreshedTargeter = true;
+                        ++_stats->numTargetErrors;
+                        keepTargeting = false;
+                    }
+
+                    batchDone.resize( childBatches.size(), false );
+                    if ( childBatches.size() > numTargeted ) continue;
                 }
 
                 // Send them all out
                 _dispatcher->sendAll();
-                numSent += pendingBatches.size();
+
+                // Nothing in flight means every host could be sent its batches, so we're done
+                if ( numPendingBatches == 0 )
+                    break;
 
                 //
                 // Recv side
                 //
 
-                while ( _dispatcher->numPending() > 0 ) {
+                // In rounds, all responses are received before sending more batches.  Pipelined
+                // batches are replaced as soon as any of their responses arrives.
+                do {
 
                     // Get the response
                     ConnectionString shardHost;
                     BatchedCommandResponse response;
                     Status dispatchStatus = _dispatcher->recvAny( &shardHost, &response );
 
-                    // Get the TargetedWriteBatch to find where to put the response
-                    dassert( pendingBatches.find( shardHost ) != pendingBatches.end() );
-                    TargetedWriteBatch* batch = pendingBatches.find( shardHost )->second;
+                    // The response is for the earliest batch sent to the host which is still
+                    // pending, since the dispatcher returns each host's responses in order
+                    dassert( !pendingBatches[shardHost].empty() );
+                    deque<PendingBatch>& hostBatches = pendingBatches[shardHost];
+                    TargetedWriteBatch* batch = hostBatches.front().batch;
+                    _stats->noteRoundTrip( shardHost, hostBatches.front().timer.micros() );
+                    hostBatches.pop_front();
+                    --numPendingBatches;
 
                     if ( dispatchStatus.isOK() ) {
 
@@ -273,6 +323,9 @@ namespace mongo {
                         if ( staleErrors.size() > 0 ) {
                             noteStaleResponses( staleErrors, _targeter );
                             ++_stats->numStaleBatches;
+
+                            // The stale writes are retargeted after a refresh in the next round
+                            keepTargeting = false;
                         }
 
                         // Remember if the shard is actively changing metadata right now
@@ -306,7 +359,7 @@ namespace mongo {
 
                         batchOp.noteBatchError( *batch, error );
                     }
-                }
+                } while ( !pipelined && numPendingBatches > 0 );
             }
 
             ++rounds;
@@ -388,4 +441,12 @@ namespace mongo {
     const HostOpTimeMap& BatchWriteExecStats::getWriteOpTimes() const {
         return _writeOpTimes;
     }
+
+    void BatchWriteExecStats::noteRoundTrip(const ConnectionString& host, long long micros) {
+        _roundTrips[host].push_back(micros);
+    }
+
+    const HostRoundTripMap& BatchWriteExecStats::getRoundTrips() const {
+        return _roundTrips;
+    }
 }
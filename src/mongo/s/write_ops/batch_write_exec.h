@@ -32,6 +32,7 @@
 
 #include <map>
 #include <string>
+#include <vector>
 
 #include "mongo/base/disallow_copying.h"
 #include "mongo/bson/optime.h"
@@ -68,6 +69,16 @@ namespace mongo {
                         ShardResolver* resolver,
                         MultiCommandDispatch* dispatcher );
 
+        /**
+         * Pipelines the child batches of unordered client batches: up to 'depth' child batches may
+         * be in flight to a host at once, and more writes are targeted and sent to a host as soon
+         * as one of its responses arrives, rather than once every host has responded.
+         *
+         * The default of 0 sends child batches in rounds, one per host at a time.  Ordered
+         * batches are always sent in rounds.
+         */
+        void setPipelineDepth( int depth );
+
         /**
          * Executes a client batch write request by sending child batches to several shard
          * endpoints, and returns a client batch write response.
@@ -92,6 +103,9 @@ namespace mongo {
         // Not owned here
         MultiCommandDispatch* _dispatcher;
 
+        // See setPipelineDepth()
+        int _pipelineDepth;
+
         // Stats
         std::auto_ptr<BatchWriteExecStats> _stats;
     };
@@ -105,6 +119,9 @@ namespace mongo {
 
     typedef std::map<ConnectionString, HostOpTime> HostOpTimeMap;
 
+    // Round trip times of the child batches sent to each host, in micros
+    typedef std::map<ConnectionString, std::vector<long long> > HostRoundTripMap;
+
     class BatchWriteExecStats {
     public:
 
@@ -116,6 +133,10 @@ namespace mongo {
 
         const HostOpTimeMap& getWriteOpTimes() const;
 
+        void noteRoundTrip(const ConnectionString& host, long long micros);
+
+        const HostRoundTripMap& getRoundTrips() const;
+
         // Expose via helpers if this gets more complex
 
         // Number of round trips required for the batch
@@ -130,5 +151,6 @@ namespace mongo {
     private:
 
         HostOpTimeMap _writeOpTimes;
+        HostRoundTripMap _roundTrips;
     };
 }
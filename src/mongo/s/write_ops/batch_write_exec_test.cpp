@@ -78,6 +78,52 @@ namespace {
         scoped_ptr<BatchWriteExec> exec;
     };
 
+    /**
+     * Mimics a backend with two shards for a particular collection, split at { x : 100 }.  The
+     * second shard is slow to respond.
+     */
+    class MockTwoShardBackend {
+    public:
+
+        MockTwoShardBackend( const NamespaceString& nss ) {
+
+            // Initialize targeting to two mock shards
+            ShardEndpoint fastEndpoint( "fastShard", ChunkVersion::IGNORED() );
+            ShardEndpoint slowEndpoint( "slowShard", ChunkVersion::IGNORED() );
+            vector<MockRange*> mockRanges;
+            mockRanges.push_back( new MockRange( fastEndpoint,
+                                                 nss,
+                                                 BSON( "x" << MINKEY ),
+                                                 BSON( "x" << 100 ) ) );
+            mockRanges.push_back( new MockRange( slowEndpoint,
+                                                 nss,
+                                                 BSON( "x" << 100 ),
+                                                 BSON( "x" << MAXKEY ) ) );
+            targeter.init( mockRanges );
+
+            // Get the connection strings for the mock shards
+            resolver.chooseWriteHost( fastEndpoint.shardName, &fastShardHost );
+            resolver.chooseWriteHost( slowEndpoint.shardName, &slowShardHost );
+            dispatcher.addSlowEndpoint( slowShardHost );
+
+            // Executor using the mock backend
+            exec.reset( new BatchWriteExec( &targeter, &resolver, &dispatcher ) );
+        }
+
+        void setMockResults( const vector<MockWriteResult*>& results ) {
+            dispatcher.init( results );
+        }
+
+        ConnectionString fastShardHost;
+        ConnectionString slowShardHost;
+
+        MockNSTargeter targeter;
+        MockShardResolver resolver;
+        MockMultiWriteCommand dispatcher;
+
+        scoped_ptr<BatchWriteExec> exec;
+    };
+
     //
     // Tests for the BatchWriteExec
     //
@@ -307,4 +353,182 @@ namespace {
         ASSERT_EQUALS( stats.numStaleBatches, 10 );
     }
 
+    //
+    // Test pipelined child batches
+    //
+
+    // Inserts documents big enough that only three fit in a child batch, so that five of them
+    // need two child batches to the same shard
+    static void addLargeDocuments( BatchedCommandRequest* request ) {
+        const string data( 5 * 1024 * 1024, 'x' );
+        for ( int i = 0; i < 5; i++ ) {
+            request->getInsertRequest()->addToDocuments( BSON( "x" << i << "data" << data ) );
+        }
+    }
+
+    TEST(BatchWriteExecTests, LargeBatchInRounds) {
+
+        //
+        // Without pipelining, the second child batch is sent in a second round
+        //
+
+        NamespaceString nss( "foo.bar" );
+
+        MockSingleShardBackend backend( nss );
+
+        BatchedCommandRequest request( BatchedCommandRequest::BatchType_Insert );
+        request.setNS( nss.ns() );
+        request.setOrdered( false );
+        request.setWriteConcern( BSONObj() );
+        addLargeDocuments( &request );
+
+        BatchedCommandResponse response;
+        backend.exec->executeBatch( request, &response );
+        ASSERT( response.getOk() );
+
+        const BatchWriteExecStats& stats = backend.exec->getStats();
+        ASSERT_EQUALS( stats.numRounds, 2 );
+        ASSERT_EQUALS( stats.getRoundTrips().find( backend.shardHost )->second.size(), 2u );
+    }
+
+    TEST(BatchWriteExecTests, PipelinedLargeBatch) {
+
+        //
+        // With pipelining, both child batches are sent in the first round
+        //
+
+        NamespaceString nss( "foo.bar" );
+
+        for ( int depth = 1; depth <= 2; depth++ ) {
+
+            MockSingleShardBackend backend( nss );
+            backend.exec->setPipelineDepth( depth );
+
+            BatchedCommandRequest request( BatchedCommandRequest::BatchType_Insert );
+            request.setNS( nss.ns() );
+            request.setOrdered( false );
+            request.setWriteConcern( BSONObj() );
+            addLargeDocuments( &request );
+
+            BatchedCommandResponse response;
+            backend.exec->executeBatch( request, &response );
+            ASSERT( response.getOk() );
+            ASSERT( !response.isErrDetailsSet() );
+
+            const BatchWriteExecStats& stats = backend.exec->getStats();
+            ASSERT_EQUALS( stats.numRounds, 1 );
+            ASSERT_EQUALS( stats.getRoundTrips().find( backend.shardHost )->second.size(), 2u );
+        }
+    }
+
+    TEST(BatchWriteExecTests, PipelinedOrderedBatchInRounds) {
+
+        //
+        // Ordered batches aren't pipelined
+        //
+
+        NamespaceString nss( "foo.bar" );
+
+        MockSingleShardBackend backend( nss );
+        backend.exec->setPipelineDepth( 2 );
+
+        BatchedCommandRequest request( BatchedCommandRequest::BatchType_Insert );
+        request.setNS( nss.ns() );
+        request.setOrdered( true );
+        request.setWriteConcern( BSONObj() );
+        addLargeDocuments( &request );
+
+        BatchedCommandResponse response;
+        backend.exec->executeBatch( request, &response );
+        ASSERT( response.getOk() );
+
+        const BatchWriteExecStats& stats = backend.exec->getStats();
+        ASSERT_EQUALS( stats.numRounds, 2 );
+    }
+
+    TEST(BatchWriteExecTests, PipelinedStaleOp) {
+
+        //
+        // A stale child batch stops pipelining, its writes are retried in the next round once the
+        // other child batch in flight has completed
+        //
+
+        NamespaceString nss( "foo.bar" );
+
+        MockSingleShardBackend backend( nss );
+        backend.exec->setPipelineDepth( 2 );
+
+        BatchedCommandRequest request( BatchedCommandRequest::BatchType_Insert );
+        request.setNS( nss.ns() );
+        request.setOrdered( false );
+        request.setWriteConcern( BSONObj() );
+        addLargeDocuments( &request );
+
+        vector<MockWriteResult*> mockResults;
+        WriteErrorDetail error;
+        error.setErrCode( ErrorCodes::StaleShardVersion );
+        error.setErrMessage( "mock stale error" );
+        mockResults.push_back( new MockWriteResult( backend.shardHost, error, 3 ) );
+
+        backend.setMockResults( mockResults );
+
+        BatchedCommandResponse response;
+        backend.exec->executeBatch( request, &response );
+        ASSERT( response.getOk() );
+        ASSERT( !response.isErrDetailsSet() );
+
+        const BatchWriteExecStats& stats = backend.exec->getStats();
+        ASSERT_EQUALS( stats.numStaleBatches, 1 );
+        ASSERT_EQUALS( stats.numRounds, 2 );
+        ASSERT_EQUALS( stats.getRoundTrips().find( backend.shardHost )->second.size(), 3u );
+    }
+
+    TEST(BatchWriteExecTests, PipelinedBatchesAroundSlowShard) {
+
+        //
+        // While a child batch to a slow shard is out, responses from the other shard are received
+        // and its remaining child batch is sent, and the slow shard's error is reported for the
+        // write sent there
+        //
+
+        NamespaceString nss( "foo.bar" );
+
+        MockTwoShardBackend backend( nss );
+        backend.exec->setPipelineDepth( 1 );
+
+        BatchedCommandRequest request( BatchedCommandRequest::BatchType_Insert );
+        request.setNS( nss.ns() );
+        request.setOrdered( false );
+        request.setWriteConcern( BSONObj() );
+        addLargeDocuments( &request );
+        request.getInsertRequest()->addToDocuments( BSON( "x" << 100 ) );
+
+        vector<MockWriteResult*> mockResults;
+        WriteErrorDetail error;
+        error.setErrCode( ErrorCodes::UnknownError );
+        error.setErrMessage( "mock error" );
+        mockResults.push_back( new MockWriteResult( backend.slowShardHost, error ) );
+
+        backend.setMockResults( mockResults );
+
+        BatchedCommandResponse response;
+        backend.exec->executeBatch( request, &response );
+        ASSERT( response.getOk() );
+        ASSERT_EQUALS( response.sizeErrDetails(), 1u );
+        ASSERT_EQUALS( response.getErrDetailsAt( 0 )->getIndex(), 5 );
+        ASSERT_EQUALS( response.getErrDetailsAt( 0 )->getErrCode(), ErrorCodes::UnknownError );
+
+        // Both child batches to the fast shard complete before the slow shard responds
+        const vector<ConnectionString>& recvd = backend.dispatcher.getRecvdEndpoints();
+        ASSERT_EQUALS( recvd.size(), 3u );
+        ASSERT_EQUALS( recvd[0].toString(), backend.fastShardHost.toString() );
+        ASSERT_EQUALS( recvd[1].toString(), backend.fastShardHost.toString() );
+        ASSERT_EQUALS( recvd[2].toString(), backend.slowShardHost.toString() );
+
+        const BatchWriteExecStats& stats = backend.exec->getStats();
+        ASSERT_EQUALS( stats.numRounds, 1 );
+        ASSERT_EQUALS( stats.getRoundTrips().find( backend.fastShardHost )->second.size(), 2u );
+        ASSERT_EQUALS( stats.getRoundTrips().find( backend.slowShardHost )->second.size(), 1u );
+    }
+
 } // unnamed namespace
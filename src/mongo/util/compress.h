@@ -38,6 +38,9 @@ namespace mongo {
 
     bool uncompress(const char* compressed, size_t compressed_length, std::string* uncompressed);
 
+    /** reads the length 'compressed' will have once uncompressed, without uncompressing it */
+    bool uncompressedLength(const char* compressed, size_t compressed_length, size_t* result);
+
     size_t maxCompressedLength(size_t source_len);
     void rawCompress(const char* input,
         size_t input_length,
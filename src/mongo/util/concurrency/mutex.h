@@ -135,6 +135,7 @@ namespace mongo {
         SimpleMutex( const StringData& ) { InitializeCriticalSection( &_cs ); }
         void dassertLocked() const { }
         void lock() { EnterCriticalSection( &_cs ); }
+        bool try_lock() { return TryEnterCriticalSection( &_cs ) != 0; }
         void unlock() { LeaveCriticalSection( &_cs ); }
         class scoped_lock {
             SimpleMutex& _m;
@@ -159,6 +160,7 @@ namespace mongo {
         }
 
         void lock() { verify( pthread_mutex_lock(&_lock) == 0 ); }
+        bool try_lock() { return pthread_mutex_trylock(&_lock) == 0; }
         void unlock() { verify( pthread_mutex_unlock(&_lock) == 0 ); }
     public:
         class scoped_lock : boost::noncopyable {
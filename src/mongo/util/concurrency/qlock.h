@@ -120,6 +120,7 @@ namespace mongo {
 
         void lock_r();
         void lock_w();
+        bool lock_w_try(int millis);
         void lock_R();
         bool lock_R_try(int millis);
         void lock_W();
@@ -197,6 +198,19 @@ namespace mongo {
         w.n++;
     }
 
+    inline bool QLock::lock_w_try(int millis) {
+        unsigned long long end = curTimeMillis64() + millis;
+        boost::mutex::scoped_lock lk(m);
+        while( !w_legal() && curTimeMillis64() < end ) {
+            w.c.timed_wait(m, boost::posix_time::milliseconds(millis));
+        }
+        if ( w_legal() ) {
+            w.n++;
+            return true;
+        }
+        return false;
+    }
+
     // "i will be reading. i will coordinate with no one. you better stop them if they
     // are writing."
     inline void QLock::lock_R() {
@@ -55,6 +55,20 @@ namespace mongo {
     SimpleRWLock::SimpleRWLock(const StringData& p) : name(p.toString()) {
         InitializeSRWLock(&_lock);
     }
+    // there is no timed acquire for SRW locks, so poll as RWLockBase::lock_try does
+    static bool tryAcquireSRWLockExclusive(SRWLOCK* lock, int millis) {
+        if( TryAcquireSRWLockExclusive(lock) )
+            return true;
+        if( millis == 0 )
+            return false;
+        unsigned long long end = curTimeMicros64() + millis*1000;
+        do {
+            Sleep(1);
+            if( TryAcquireSRWLockExclusive(lock) )
+                return true;
+        } while( curTimeMicros64() < end );
+        return false;
+    }
 # if defined(_DEBUG)
     // the code below in _DEBUG build will check that we don't try to recursively lock, 
     // which is not supported by this class.  also checks that you don't unlock without 
@@ -67,6 +81,16 @@ namespace mongo {
         AcquireSRWLockExclusive(&_lock);
         tid = me; // this is for use in the debugger to see who does have the lock
     }
+    bool SimpleRWLock::lock_try(int millis) {
+        unsigned me = GetCurrentThreadId();
+        int& state = s.getRef();
+        dassert( state == 0 );
+        if( !tryAcquireSRWLockExclusive(&_lock, millis) )
+            return false;
+        state--;
+        tid = me;
+        return true;
+    }
     void SimpleRWLock::unlock() { 
         int& state = s.getRef();
         dassert( state == -1 );
@@ -92,6 +116,9 @@ namespace mongo {
     void SimpleRWLock::lock() {
         AcquireSRWLockExclusive(&_lock);
     }
+    bool SimpleRWLock::lock_try(int millis) {
+        return tryAcquireSRWLockExclusive(&_lock, millis);
+    }
     void SimpleRWLock::unlock() { 
         ReleaseSRWLockExclusive(&_lock);
     }
@@ -105,6 +132,7 @@ namespace mongo {
 #else
     SimpleRWLock::SimpleRWLock(const StringData& p) : name(p.toString()) { }
     void SimpleRWLock::lock() { m.lock(); }
+    bool SimpleRWLock::lock_try(int millis) { return m.lock_try(millis); }
     void SimpleRWLock::unlock() { m.unlock(); }
     void SimpleRWLock::lock_shared() { m.lock_shared(); }
     void SimpleRWLock::unlock_shared() { m.unlock_shared(); }
@@ -51,6 +51,7 @@ namespace mongo {
         const std::string name;
         SimpleRWLock(const StringData& name = "" );
         void lock();
+        bool lock_try(int millis = 0);
         void unlock();
         void lock_shared();
         void unlock_shared();
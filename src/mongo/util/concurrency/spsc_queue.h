@@ -0,0 +1,218 @@
+// @file spsc_queue.h
+
+/*    Copyright 2014 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#pragma once
+
+#include <limits>
+#include <vector>
+
+#include <boost/noncopyable.hpp>
+#include <boost/thread/condition.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include "mongo/platform/atomic_word.h"
+#include "mongo/util/assert_util.h"
+#include "mongo/util/time_support.h"
+
+namespace mongo {
+
+    /**
+     * Bounded single-producer/single-consumer ring buffer.
+     *
+     * Exactly one thread may push and exactly one (other) thread may pop.  Pushing and popping
+     * never take a lock; the mutex and condition variable are only used to park a thread that
+     * has found the queue full (producer) or empty (consumer), so an uncontended hand-off
+     * costs a couple of atomic operations.
+     *
+     * Like BlockingQueue, the queue can additionally be bounded by a custom size function, so
+     * that a queue of batches can be capped by total bytes rather than by batch count.  A
+     * single item larger than the size bound is still accepted into an empty queue.
+     */
+    template<typename T>
+    class SPSCQueue : boost::noncopyable {
+        typedef size_t (*getSizeFunc)(const T& t);
+    public:
+        /**
+         * @param capacity maximum number of queued items; rounded up to a power of two
+         */
+        explicit SPSCQueue(size_t capacity) :
+            _maxSize(std::numeric_limits<size_t>::max()),
+            _getSize(&_countOne) {
+            _init(capacity);
+        }
+
+        SPSCQueue(size_t capacity, size_t maxSize, getSizeFunc f) :
+            _maxSize(maxSize),
+            _getSize(f) {
+            _init(capacity);
+        }
+
+        /**
+         * Producer only.  @return false, leaving the queue unchanged, if 't' does not fit.
+         */
+        bool tryPush(const T& t) {
+            const size_t tSize = _getSize(t);
+            const unsigned long long tail = _tail.loadRelaxed();
+            const unsigned long long head = _head.load();
+            if (tail - head > _mask)
+                return false;
+            if (tail != head && _currentSize.load() + tSize > _maxSize)
+                return false;
+
+            _slots[tail & _mask] = t;
+            _currentSize.fetchAndAdd(tSize);
+            // full barrier: publishes the slot, and orders it before the _consumerWaiting read
+            _tail.fetchAndAdd(1);
+
+            if (_consumerWaiting.load())
+                _wake();
+            return true;
+        }
+
+        /**
+         * Producer only.  Blocks while the queue is full.
+         */
+        void push(const T& t) {
+            for (;;) {
+                const unsigned long long head = _head.load();
+                if (tryPush(t))
+                    return;
+                _wait(&_producerWaiting, &_head, head, _kWaitMillis);
+            }
+        }
+
+        /**
+         * Consumer only.  @return false if the queue is empty.
+         */
+        bool tryPop(T* t) {
+            const unsigned long long head = _head.loadRelaxed();
+            if (head == _tail.load())
+                return false;
+
+            T& slot = _slots[head & _mask];
+            *t = slot;
+            slot = T(); // release whatever the item holds now rather than on wrap-around
+            _currentSize.fetchAndSubtract(_getSize(*t));
+            _head.fetchAndAdd(1);
+
+            if (_producerWaiting.load())
+                _wake();
+            return true;
+        }
+
+        /**
+         * Consumer only.  Waits up to 'maxMillisToWait' for an item and pops it.
+         */
+        bool blockingPop(T* t, int maxMillisToWait) {
+            const unsigned long long deadline = curTimeMillis64() + maxMillisToWait;
+            while (!tryPop(t)) {
+                const unsigned long long now = curTimeMillis64();
+                if (now >= deadline)
+                    return false;
+                _wait(&_consumerWaiting, &_tail, _head.loadRelaxed(), deadline - now);
+            }
+            return true;
+        }
+
+        /**
+         * Consumer only.  Waits up to 'maxMillisToWait' for the queue to become non-empty.
+         * @return true if there is an item to pop
+         */
+        bool waitForData(int maxMillisToWait) {
+            const unsigned long long head = _head.loadRelaxed();
+            if (_tail.load() != head)
+                return true;
+            _wait(&_consumerWaiting, &_tail, head, maxMillisToWait);
+            return !empty();
+        }
+
+        /** Safe from any thread, but only a snapshot. */
+        bool empty() const { return _head.load() == _tail.load(); }
+
+        /** The number of queued items.  Safe from any thread, but only a snapshot. */
+        size_t count() const { return static_cast<size_t>(_tail.load() - _head.load()); }
+
+        /** The size of queued items as measured by the size function. */
+        size_t size() const { return _currentSize.load(); }
+
+        size_t capacity() const { return _mask + 1; }
+
+    private:
+        static size_t _countOne(const T& t) { return 1; }
+
+        // Upper bound on a single park; a missed wake-up costs at most this much latency.
+        static const int _kWaitMillis = 100;
+
+        void _init(size_t capacity) {
+            verify(capacity > 0);
+            size_t rounded = 1;
+            while (rounded < capacity)
+                rounded <<= 1;
+            _slots.resize(rounded);
+            _mask = rounded - 1;
+        }
+
+        /**
+         * Parks the calling thread until the other side moves 'index' away from 'observed',
+         * or 'millis' elapse.
+         */
+        void _wait(AtomicUInt32* waiting,
+                   const AtomicUInt64* index,
+                   unsigned long long observed,
+                   unsigned long long millis) {
+            boost::unique_lock<boost::mutex> lk(_mutex);
+            // full barrier before re-checking, pairs with the fetchAndAdd in tryPush and tryPop
+            waiting->swap(1);
+            if (index->load() == observed) {
+                _cond.timed_wait(lk, boost::posix_time::milliseconds(millis));
+            }
+            waiting->store(0);
+        }
+
+        void _wake() {
+            boost::lock_guard<boost::mutex> lk(_mutex);
+            _cond.notify_all();
+        }
+
+        std::vector<T> _slots;
+        size_t _mask;
+        const size_t _maxSize;
+        getSizeFunc _getSize;
+
+        AtomicUInt64 _head;           // next slot to pop; written by the consumer only
+        AtomicUInt64 _tail;           // next slot to push; written by the producer only
+        AtomicUInt64 _currentSize;    // as measured by _getSize
+
+        AtomicUInt32 _producerWaiting;
+        AtomicUInt32 _consumerWaiting;
+        boost::mutex _mutex;
+        boost::condition _cond;
+    };
+
+} // namespace mongo
@@ -0,0 +1,125 @@
+/**
+ *    Copyright (C) 2014 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+
+#include <boost/thread/thread.hpp>
+
+#include "mongo/stdx/functional.h"
+#include "mongo/unittest/unittest.h"
+#include "mongo/util/concurrency/spsc_queue.h"
+
+namespace {
+
+    using mongo::SPSCQueue;
+
+    size_t valueAsSize(const int& i) {
+        return static_cast<size_t>(i);
+    }
+
+    TEST(SPSCQueue, RoundsCapacityUp) {
+        SPSCQueue<int> q(5);
+        ASSERT_EQUALS(8U, q.capacity());
+    }
+
+    TEST(SPSCQueue, FifoOrder) {
+        SPSCQueue<int> q(4);
+        ASSERT(q.empty());
+        ASSERT(q.tryPush(1));
+        ASSERT(q.tryPush(2));
+        ASSERT(q.tryPush(3));
+        ASSERT_EQUALS(3U, q.count());
+
+        int i = 0;
+        ASSERT(q.tryPop(&i));
+        ASSERT_EQUALS(1, i);
+        ASSERT(q.tryPop(&i));
+        ASSERT_EQUALS(2, i);
+        ASSERT(q.tryPop(&i));
+        ASSERT_EQUALS(3, i);
+        ASSERT_FALSE(q.tryPop(&i));
+        ASSERT(q.empty());
+    }
+
+    TEST(SPSCQueue, FullByCount) {
+        SPSCQueue<int> q(2);
+        ASSERT(q.tryPush(1));
+        ASSERT(q.tryPush(2));
+        ASSERT_FALSE(q.tryPush(3));
+
+        int i = 0;
+        ASSERT(q.tryPop(&i));
+        ASSERT(q.tryPush(3));
+    }
+
+    TEST(SPSCQueue, FullBySize) {
+        SPSCQueue<int> q(16, 10, &valueAsSize);
+        ASSERT(q.tryPush(6));
+        ASSERT_FALSE(q.tryPush(6));
+        ASSERT(q.tryPush(4));
+        ASSERT_EQUALS(10U, q.size());
+
+        int i = 0;
+        ASSERT(q.tryPop(&i));
+        ASSERT_EQUALS(4U, q.size());
+    }
+
+    TEST(SPSCQueue, OversizedItemFitsWhenEmpty) {
+        SPSCQueue<int> q(16, 10, &valueAsSize);
+        ASSERT(q.tryPush(100));
+        ASSERT_FALSE(q.tryPush(1));
+    }
+
+    TEST(SPSCQueue, BlockingPopTimesOut) {
+        SPSCQueue<int> q(4);
+        int i = 0;
+        ASSERT_FALSE(q.blockingPop(&i, 10));
+        ASSERT_FALSE(q.waitForData(10));
+    }
+
+    void produce(SPSCQueue<int>* q, int n) {
+        for (int i = 0; i < n; i++) {
+            q->push(i);
+        }
+    }
+
+    TEST(SPSCQueue, ProducerConsumer) {
+        const int n = 100000;
+        SPSCQueue<int> q(8);
+        boost::thread producer(mongo::stdx::bind(&produce, &q, n));
+
+        for (int expected = 0; expected < n; expected++) {
+            int i = -1;
+            ASSERT(q.blockingPop(&i, 10000));
+            ASSERT_EQUALS(expected, i);
+        }
+
+        producer.join();
+        ASSERT(q.empty());
+    }
+
+} // namespace
@@ -0,0 +1,196 @@
+// ticketholder.cpp
+
+/*    Copyright 2014 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/util/concurrency/ticketholder.h"
+
+#include "mongo/util/assert_util.h"
+#include "mongo/util/log.h"
+#include "mongo/util/time_support.h"
+#include "mongo/util/timer.h"
+
+namespace mongo {
+
+    /*
+     * Waking a queued thread must not be lost to a concurrent fast path, so both sides use
+     * the same pattern: a thread about to queue first increments _waiters and then looks at
+     * _available, while release() first increments _available and then looks at _waiters.
+     * Both are full barriers, so at least one of them sees the other.  The queueing thread
+     * holds _mutex from the increment until it is on the queue, and a release that sees
+     * waiters takes _mutex before dispatching, so it always finds the waiter queued.
+     */
+
+    TicketHolder::TicketHolder( int num )
+        : _available( num ),
+          _outof( num ),
+          _mutex( "TicketHolder" ),
+          _head( NULL ),
+          _tail( NULL ) {
+    }
+
+    bool TicketHolder::tryAcquire() {
+        if ( _waiters.load() == 0 && _tryTake() )
+            return true;
+        _rejected.fetchAndAdd( 1 );
+        return false;
+    }
+
+    void TicketHolder::waitForTicket() {
+        if ( _waiters.load() == 0 && _tryTake() )
+            return;
+        _wait( -1 );
+    }
+
+    bool TicketHolder::waitForTicket( int maxMillis ) {
+        if ( _waiters.load() == 0 && _tryTake() )
+            return true;
+        return _wait( maxMillis < 0 ? 0 : maxMillis );
+    }
+
+    void TicketHolder::release() {
+        if ( _waiters.load() == 0 ) {
+            _available.fetchAndAdd( 1 );
+            if ( _waiters.load() == 0 )
+                return;
+
+            // someone started queueing while we released; they may have missed our ticket
+            scoped_lock lk( _mutex );
+            _dispatch_inlock();
+            return;
+        }
+
+        scoped_lock lk( _mutex );
+        if ( _head ) {
+            // pass the ticket straight to the oldest waiter so nobody can barge in
+            Waiter* w = _head;
+            _remove_inlock( w );
+            w->granted = true;
+            w->cond.notify_one();
+        }
+        else {
+            _available.fetchAndAdd( 1 );
+        }
+    }
+
+    bool TicketHolder::resize( int newSize ) {
+        scoped_lock lk( _mutex );
+
+        const int used = outof() - available();
+        if ( used > newSize ) {
+            log() << "can't resize since we're using (" << used << ") more than newSize("
+                  << newSize << ")" << std::endl;
+            return false;
+        }
+
+        _available.fetchAndAdd( newSize - _outof.load() );
+        _outof.store( newSize );
+        _dispatch_inlock();
+        return true;
+    }
+
+    bool TicketHolder::_tryTake() {
+        for ( ;; ) {
+            const int num = _available.load();
+            if ( num <= 0 )
+                return false;
+            if ( _available.compareAndSwap( num, num - 1 ) == num )
+                return true;
+        }
+    }
+
+    bool TicketHolder::_wait( int maxMillis ) {
+        Timer timer;
+        scoped_lock lk( _mutex );
+
+        _waiters.fetchAndAdd( 1 );
+        if ( _head == NULL && _tryTake() ) {
+            _waiters.fetchAndSubtract( 1 );
+            return true;
+        }
+
+        _queued.fetchAndAdd( 1 );
+        Waiter w;
+        _enqueue_inlock( &w );
+
+        if ( maxMillis < 0 ) {
+            while ( ! w.granted )
+                w.cond.wait( lk.boost() );
+        }
+        else {
+            const boost::xtime deadline = incxtimemillis( maxMillis );
+            while ( ! w.granted ) {
+                if ( ! w.cond.timed_wait( lk.boost(), deadline ) )
+                    break;
+            }
+        }
+
+        if ( ! w.granted ) {
+            _remove_inlock( &w );
+            _timeouts.fetchAndAdd( 1 );
+            return false;
+        }
+
+        _waitMicros.record( timer.micros() );
+        return true;
+    }
+
+    void TicketHolder::_dispatch_inlock() {
+        while ( _head && _tryTake() ) {
+            Waiter* w = _head;
+            _remove_inlock( w );
+            w->granted = true;
+            w->cond.notify_one();
+        }
+    }
+
+    void TicketHolder::_enqueue_inlock( Waiter* w ) {
+        w->prev = _tail;
+        w->next = NULL;
+        if ( _tail )
+            _tail->next = w;
+        else
+            _head = w;
+        _tail = w;
+    }
+
+    void TicketHolder::_remove_inlock( Waiter* w ) {
+        if ( w->prev )
+            w->prev->next = w->next;
+        else
+            _head = w->next;
+        if ( w->next )
+            w->next->prev = w->prev;
+        else
+            _tail = w->prev;
+        w->prev = w->next = NULL;
+        _waiters.fetchAndSubtract( 1 );
+    }
+
+}  // namespace mongo
@@ -26,86 +26,121 @@
  */
 #pragma once
 
+#include <boost/noncopyable.hpp>
 #include <boost/thread/condition_variable.hpp>
-#include <iostream>
 
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/platform/atomic_word.h"
 #include "mongo/util/concurrency/mutex.h"
+#include "mongo/util/histogram.h"
 
 namespace mongo {
 
-    class TicketHolder {
+    /**
+     * Counting semaphore used for admission control.
+     *
+     * Acquiring and releasing a ticket while nobody is queued is a single compare-and-swap
+     * or atomic add.  Once a thread has to wait, tickets are handed out in arrival order:
+     * waiters are queued FIFO under the mutex, a release passes its ticket directly to the
+     * oldest waiter, and tryAcquire() does not barge past a non-empty queue.
+     *
+     * Each holder keeps its own counters (waiters, queued acquisitions, timeouts, rejected
+     * tryAcquire() calls and a histogram of queueing time) for serverStatus.
+     */
+    class TicketHolder : boost::noncopyable {
     public:
-        TicketHolder( int num ) : _mutex("TicketHolder") {
-            _outof = num;
-            _num = num;
+        explicit TicketHolder( int num );
+
+        /**
+         * @return true if a ticket was taken without waiting.  Fails while other threads
+         *         are queued, even if a ticket has just become free.
+         */
+        bool tryAcquire();
+
+        /** Blocks until a ticket is available. */
+        void waitForTicket();
+
+        /**
+         * Waits up to 'maxMillis' for a ticket.
+         * @return false if no ticket was acquired in time
+         */
+        bool waitForTicket( int maxMillis );
+
+        void release();
+
+        /**
+         * Changes the total number of tickets.  Fails, leaving the holder unchanged, when
+         * more than 'newSize' tickets are currently in use.
+         */
+        bool resize( int newSize );
+
+        int available() const { return _available.load(); }
+
+        int used() const { return outof() - available(); }
+
+        int outof() const { return _outof.load(); }
+
+        /** Number of threads currently queued for a ticket. */
+        int waiters() const { return _waiters.load(); }
+
+        /**
+         * Appends { out, available, totalTickets, waiters, queued, timeouts, rejected,
+         * waitMicros: <histogram> }.  The values are not an atomic snapshot.
+         */
+        void appendStats( BSONObjBuilder& b ) const {
+            b.append( "out" , used() );
+            b.append( "available" , available() );
+            b.append( "totalTickets" , outof() );
+            b.append( "waiters" , waiters() );
+            b.append( "queued" , _queued.load() );
+            b.append( "timeouts" , _timeouts.load() );
+            b.append( "rejected" , _rejected.load() );
+            BSONObjBuilder waitMicros( b.subobjStart( "waitMicros" ) );
+            _waitMicros.append( waitMicros );
+            waitMicros.doneFast();
         }
 
-        bool tryAcquire() {
-            scoped_lock lk( _mutex );
-            return _tryAcquire();
-        }
-
-        void waitForTicket() {
-            scoped_lock lk( _mutex );
-
-            while( ! _tryAcquire() ) {
-                _newTicket.wait( lk.boost() );
-            }
-        }
-
-        void release() {
-            {
-                scoped_lock lk( _mutex );
-                _num++;
-            }
-            _newTicket.notify_one();
-        }
-
-        void resize( int newSize ) {
-            {
-                scoped_lock lk( _mutex );
+    private:
+        /** A queued thread; lives on the waiting thread's stack. */
+        struct Waiter {
+            Waiter() : granted( false ), prev( NULL ), next( NULL ) {}
 
-                int used = _outof - _num;
-                if ( used > newSize ) {
-                    std::cout << "can't resize since we're using (" << used << ") more than newSize(" << newSize << ")" << std::endl;
-                    return;
-                }
+            boost::condition_variable_any cond;
+            bool granted;       // a ticket has been passed to this waiter
+            Waiter* prev;
+            Waiter* next;
+        };
 
-                _outof = newSize;
-                _num = _outof - used;
-            }
+        /** Takes a ticket from _available if there is one. */
+        bool _tryTake();
 
-            // Potentially wasteful, but easier to see is correct
-            _newTicket.notify_all();
-        }
+        /**
+         * @param maxMillis how long to wait, or negative to wait forever
+         */
+        bool _wait( int maxMillis );
 
-        int available() const {
-            return _num;
-        }
+        /** Hands free tickets to queued threads, oldest first. */
+        void _dispatch_inlock();
 
-        int used() const {
-            return _outof - _num;
-        }
+        void _enqueue_inlock( Waiter* w );
+        void _remove_inlock( Waiter* w );
 
-        int outof() const { return _outof; }
+        AtomicInt32 _available;
+        AtomicInt32 _outof;
 
-    private:
+        // Threads between starting to queue and getting or giving up on a ticket.  Only
+        // changed with _mutex held, but read without it on the fast paths.
+        AtomicInt32 _waiters;
 
-        bool _tryAcquire(){
-            if ( _num <= 0 ) {
-                if ( _num < 0 ) {
-                    std::cerr << "DISASTER! in TicketHolder" << std::endl;
-                }
-                return false;
-            }
-            _num--;
-            return true;
-        }
+        AtomicInt64 _queued;
+        AtomicInt64 _timeouts;
+        AtomicInt64 _rejected;
+        Histogram _waitMicros;
 
-        int _outof;
-        int _num;
+        // protects the waiter queue
         mongo::mutex _mutex;
-        boost::condition_variable_any _newTicket;
+        Waiter* _head;
+        Waiter* _tail;
     };
 
     class ScopedTicket {
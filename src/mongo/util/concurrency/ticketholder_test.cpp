@@ -0,0 +1,179 @@
+/**
+ *    Copyright (C) 2014 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+
+#include <boost/thread/thread.hpp>
+#include <vector>
+
+#include "mongo/stdx/functional.h"
+#include "mongo/unittest/unittest.h"
+#include "mongo/util/concurrency/mutex.h"
+#include "mongo/util/concurrency/ticketholder.h"
+#include "mongo/util/time_support.h"
+
+namespace {
+
+    using mongo::BSONObj;
+    using mongo::BSONObjBuilder;
+    using mongo::SimpleMutex;
+    using mongo::TicketHolder;
+
+    void waitForWaiters(const TicketHolder& holder, int n) {
+        while (holder.waiters() < n)
+            mongo::sleepmillis(1);
+    }
+
+    TEST(TicketHolder, AcquireAndRelease) {
+        TicketHolder holder(2);
+        ASSERT(holder.tryAcquire());
+        ASSERT(holder.tryAcquire());
+        ASSERT_EQUALS(0, holder.available());
+        ASSERT_EQUALS(2, holder.used());
+        ASSERT_FALSE(holder.tryAcquire());
+
+        holder.release();
+        ASSERT_EQUALS(1, holder.available());
+        ASSERT(holder.tryAcquire());
+        holder.release();
+        holder.release();
+        ASSERT_EQUALS(2, holder.available());
+        ASSERT_EQUALS(0, holder.used());
+    }
+
+    TEST(TicketHolder, TimedWaitTimesOut) {
+        TicketHolder holder(1);
+        holder.waitForTicket();
+        ASSERT_FALSE(holder.waitForTicket(10));
+        ASSERT_EQUALS(0, holder.waiters());
+
+        BSONObjBuilder b;
+        holder.appendStats(b);
+        BSONObj stats = b.obj();
+        ASSERT_EQUALS(1, stats["timeouts"].numberLong());
+        ASSERT_EQUALS(1, stats["queued"].numberLong());
+        ASSERT_EQUALS(0, stats["waitMicros"]["count"].numberLong());
+
+        holder.release();
+        ASSERT(holder.waitForTicket(10));
+    }
+
+    class Acquirer {
+    public:
+        Acquirer(TicketHolder* holder, std::vector<int>* order, SimpleMutex* mutex)
+            : _holder(holder), _order(order), _mutex(mutex) {}
+
+        void run(int id) {
+            _holder->waitForTicket();
+            {
+                SimpleMutex::scoped_lock lk(*_mutex);
+                _order->push_back(id);
+            }
+        }
+
+    private:
+        TicketHolder* _holder;
+        std::vector<int>* _order;
+        SimpleMutex* _mutex;
+    };
+
+    TEST(TicketHolder, WaitersAreServedInArrivalOrder) {
+        const int kThreads = 5;
+        TicketHolder holder(1);
+        ASSERT(holder.tryAcquire());
+
+        std::vector<int> order;
+        SimpleMutex mutex("ticketHolderTest");
+        Acquirer acquirer(&holder, &order, &mutex);
+
+        std::vector<boost::thread*> threads;
+        for (int i = 0; i < kThreads; i++) {
+            threads.push_back(new boost::thread(mongo::stdx::bind(&Acquirer::run, &acquirer, i)));
+            waitForWaiters(holder, i + 1);
+        }
+
+        // a queued ticket is not up for grabs
+        ASSERT_FALSE(holder.tryAcquire());
+
+        for (int i = 0; i < kThreads; i++) {
+            holder.release();
+            while (true) {
+                SimpleMutex::scoped_lock lk(mutex);
+                if (static_cast<int>(order.size()) == i + 1)
+                    break;
+                mongo::sleepmillis(1);
+            }
+        }
+
+        for (int i = 0; i < kThreads; i++) {
+            threads[i]->join();
+            delete threads[i];
+        }
+
+        ASSERT_EQUALS(kThreads, static_cast<int>(order.size()));
+        for (int i = 0; i < kThreads; i++)
+            ASSERT_EQUALS(i, order[i]);
+        ASSERT_EQUALS(0, holder.waiters());
+        ASSERT_EQUALS(1, holder.used());
+
+        BSONObjBuilder b;
+        holder.appendStats(b);
+        BSONObj stats = b.obj();
+        ASSERT_EQUALS(kThreads, stats["queued"].numberLong());
+        ASSERT_EQUALS(kThreads, stats["waitMicros"]["count"].numberLong());
+        ASSERT_EQUALS(1, stats["rejected"].numberLong());
+    }
+
+    TEST(TicketHolder, ResizeWakesWaiters) {
+        TicketHolder holder(1);
+        holder.waitForTicket();
+
+        std::vector<int> order;
+        SimpleMutex mutex("ticketHolderTest");
+        Acquirer acquirer(&holder, &order, &mutex);
+        boost::thread t(mongo::stdx::bind(&Acquirer::run, &acquirer, 0));
+        waitForWaiters(holder, 1);
+
+        ASSERT(holder.resize(2));
+        t.join();
+        ASSERT_EQUALS(1U, order.size());
+        ASSERT_EQUALS(2, holder.used());
+        ASSERT_EQUALS(0, holder.available());
+    }
+
+    TEST(TicketHolder, ResizeBelowUsedFails) {
+        TicketHolder holder(3);
+        ASSERT(holder.tryAcquire());
+        ASSERT(holder.tryAcquire());
+        ASSERT_FALSE(holder.resize(1));
+        ASSERT_EQUALS(3, holder.outof());
+        ASSERT(holder.resize(2));
+        ASSERT_EQUALS(0, holder.available());
+        ASSERT_EQUALS(2, holder.outof());
+    }
+
+}  // namespace
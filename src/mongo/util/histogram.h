@@ -0,0 +1,104 @@
+// histogram.h
+
+/*    Copyright 2014 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#pragma once
+
+#include <boost/noncopyable.hpp>
+
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/platform/atomic_word.h"
+
+namespace mongo {
+
+    /**
+     * Lock-free histogram with power of two buckets, for reporting distributions of latencies
+     * and sizes in serverStatus.
+     *
+     * Bucket 0 counts values <= 0 and bucket i counts values in [2^(i-1), 2^i); the last
+     * bucket also counts everything larger.  Recording is one atomic add per counter, so a
+     * Histogram can be updated from any number of threads.
+     */
+    class Histogram : boost::noncopyable {
+    public:
+        static const int kNumBuckets = 40;
+
+        void record(long long value) {
+            _buckets[bucketFor(value)].fetchAndAdd(1);
+            _count.fetchAndAdd(1);
+            _sum.fetchAndAdd(value);
+        }
+
+        long long count() const { return _count.load(); }
+        long long sum() const { return _sum.load(); }
+        long long bucketCount(int bucket) const { return _buckets[bucket].load(); }
+
+        /** @return the exclusive upper bound of values counted in 'bucket' */
+        static long long bucketUpperBound(int bucket) {
+            return 1LL << bucket;
+        }
+
+        static int bucketFor(long long value) {
+            if (value <= 0)
+                return 0;
+            int bucket = 1;
+            while ((value >>= 1) && bucket < kNumBuckets - 1)
+                bucket++;
+            return bucket;
+        }
+
+        /**
+         * Appends { count: <n>, sum: <n>, buckets: [ { lt: <bound>, count: <n> }, ... ] },
+         * listing only non-empty buckets.  The values reported are not an atomic snapshot.
+         */
+        void append(BSONObjBuilder& b) const {
+            b.append("count", count());
+            b.append("sum", sum());
+            BSONArrayBuilder buckets(b.subarrayStart("buckets"));
+            for (int i = 0; i < kNumBuckets; i++) {
+                const long long n = bucketCount(i);
+                if (n == 0)
+                    continue;
+                BSONObjBuilder bucket(buckets.subobjStart());
+                if (i == kNumBuckets - 1)
+                    bucket.append("gte", bucketUpperBound(i - 1));
+                else
+                    bucket.append("lt", bucketUpperBound(i));
+                bucket.append("count", n);
+                bucket.doneFast();
+            }
+            buckets.doneFast();
+        }
+
+    private:
+        AtomicInt64 _buckets[kNumBuckets];
+        AtomicInt64 _count;
+        AtomicInt64 _sum;
+    };
+
+} // namespace mongo
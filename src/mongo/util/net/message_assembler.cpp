@@ -0,0 +1,111 @@
+// message_assembler.cpp
+
+/*    Copyright 2014 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/util/net/message_assembler.h"
+
+#include "mongo/util/allocator.h"
+#include "mongo/util/assert_util.h"
+#include "mongo/util/net/sock.h"
+
+namespace mongo {
+
+    MessageAssembler::MessageAssembler() : _headerRead( 0 ), _data( NULL ), _len( 0 ),
+                                           _dataRead( 0 ) {
+    }
+
+    MessageAssembler::~MessageAssembler() {
+        _reset();
+    }
+
+#ifndef _WIN32
+    MessageAssembler::State MessageAssembler::readFrom( Socket* sock, Message* m ) {
+        const int headerLen = sizeof(MSGHEADER::Value);
+        if ( ! _read( sock, reinterpret_cast<char*>( &_header ) + _headerRead,
+                      headerLen - _headerRead, &_headerRead ) ) {
+            return kNeedMore;
+        }
+
+        if ( ! _data ) {
+            const int len = _header.constView().getMessageLength();
+            if ( len == 542393671 ) {
+                // an http GET
+                _reset();
+                return kHttp;
+            }
+            if ( len == -1 ) {
+                _reset();
+                return kEndianCheck;
+            }
+            if ( static_cast<size_t>(len) < sizeof(MSGHEADER::Value) ||
+                 static_cast<size_t>(len) > MaxMessageSizeBytes ) {
+                return kInvalid;
+            }
+
+            const int z = (len+1023)&0xfffffc00;
+            verify(z>=len);
+            _data = reinterpret_cast<char*>( mongoMalloc(z) );
+            memcpy( _data, &_header, headerLen );
+            _len = len;
+            _dataRead = headerLen;
+        }
+
+        if ( ! _read( sock, _data + _dataRead, _len - _dataRead, &_dataRead ) )
+            return kNeedMore;
+
+        m->setData( _data, true );
+        _data = NULL;
+        _reset();
+        return kMessage;
+    }
+
+    // static
+    bool MessageAssembler::_read( Socket* sock, char* buf, int len, int* done ) {
+        while ( len > 0 ) {
+            const int ret = sock->recvAvailable( buf, len );
+            if ( ret == 0 )
+                return false;
+            buf += ret;
+            len -= ret;
+            *done += ret;
+        }
+        return true;
+    }
+#endif
+
+    void MessageAssembler::_reset() {
+        free( _data );
+        _data = NULL;
+        _headerRead = 0;
+        _len = 0;
+        _dataRead = 0;
+    }
+
+} // namespace mongo
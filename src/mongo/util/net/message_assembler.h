@@ -0,0 +1,86 @@
+// message_assembler.h
+
+/*    Copyright 2014 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#pragma once
+
+#include "mongo/util/net/message.h"
+
+namespace mongo {
+
+    class Socket;
+
+    /**
+     * Assembles the messages arriving on a socket out of whatever bytes it has ready, without
+     * ever waiting for more, so that a connection only needs a thread once a whole message has
+     * arrived.  The framing matches MessagingPort::recv.
+     *
+     * Only the bytes of the message being assembled are read, so anything after it stays
+     * buffered in the socket.
+     */
+    class MessageAssembler : boost::noncopyable {
+    public:
+        enum State {
+            kNeedMore,      // everything ready was read, the message isn't complete yet
+            kMessage,       // a whole message was moved to 'm'
+            kEndianCheck,   // the client sent the endian check (a length of -1)
+            kHttp,          // the client sent an HTTP GET to the native port
+            kInvalid,       // the message length is out of bounds
+        };
+
+        MessageAssembler();
+        ~MessageAssembler();
+
+        /**
+         * Reads from 'sock' until it has no more bytes ready or a message is complete.
+         * @throws SocketException if the connection was closed or failed
+         */
+        State readFrom( Socket* sock, Message* m );
+
+        /** @return true if part of a message has been read */
+        bool inProgress() const { return _headerRead > 0; }
+
+    private:
+        /**
+         * Reads up to 'len' bytes into 'buf', adding the number read to '*done'.
+         * @return true if all 'len' bytes were read
+         */
+        static bool _read( Socket* sock, char* buf, int len, int* done );
+
+        void _reset();
+
+        MSGHEADER::Value _header;
+        int _headerRead;
+
+        // The message being assembled once its header is in, starting with a copy of the header.
+        char* _data;
+        int _len;
+        int _dataRead;
+    };
+
+} // namespace mongo
@@ -59,6 +59,31 @@ namespace mongo {
          * called once when a socket is disconnected
          */
         virtual void disconnected( AbstractMessagingPort* p ) = 0;
+
+        /**
+         * The reactor server multiplexes many connections over a fixed pool of worker threads,
+         * so any per connection state a handler keeps in thread locals has to be moved off the
+         * worker between messages.  Handlers that can do this return true and implement the
+         * session hooks below; all other handlers are always run thread-per-connection.
+         */
+        virtual bool canDetachSessions() const { return false; }
+
+        /**
+         * called after connected() or process() returns on a worker thread
+         * @return an opaque token owning this connection's thread local state
+         */
+        virtual void* detachSession( AbstractMessagingPort* p ) { return NULL; }
+
+        /**
+         * called before process() or disconnected() on a worker thread, with the token
+         * returned by the last detachSession() for this connection
+         */
+        virtual void attachSession( AbstractMessagingPort* p , void* session ) {}
+
+        /**
+         * called with the final detached token once disconnected() has run
+         */
+        virtual void destroySession( void* session ) {}
     };
 
     class MessageServer {
@@ -76,6 +101,18 @@ namespace mongo {
         virtual void setupSockets() = 0;
     };
 
-    // TODO use a factory here to decide between port and asio variations
+    /**
+     * Returns the thread-per-connection server, or the epoll reactor server when
+     * serverGlobalParams.reactorWorkerThreads is set and the handler and platform support it.
+     */
     MessageServer * createServer( const MessageServer::Options& opts , MessageHandler * handler );
+
+    /**
+     * @return a server that parks idle connections in an epoll set and runs handler callbacks
+     *     on a pool of at least 'workerThreads' threads, or NULL if not supported on this
+     *     platform
+     */
+    MessageServer * createReactorServer( const MessageServer::Options& opts,
+                                         MessageHandler * handler,
+                                         int workerThreads );
 }
@@ -49,6 +49,7 @@
 #include "mongo/util/net/message_port.h"
 #include "mongo/util/net/message_server.h"
 #include "mongo/util/net/ssl_manager.h"
+#include "mongo/util/net/ssl_options.h"
 
 #ifdef __linux__  // TODO: consider making this ifndef _WIN32
 # include <sys/resource.h>
@@ -259,6 +260,27 @@ namespace mongo {
 
 
     MessageServer * createServer( const MessageServer::Options& opts , MessageHandler * handler ) {
+        const int workers = serverGlobalParams.reactorWorkerThreads;
+        if ( workers > 0 ) {
+            if ( ! handler->canDetachSessions() ) {
+                warning() << "message handler does not support the network reactor, "
+                          << "using a thread per connection" << endl;
+            }
+#ifdef MONGO_SSL
+            // SSL_read can buffer decrypted bytes in user space where epoll cannot see them
+            else if ( sslGlobalParams.sslMode.load() != SSLGlobalParams::SSLMode_disabled ) {
+                warning() << "network reactor is not supported with SSL, "
+                          << "using a thread per connection" << endl;
+            }
+#endif
+            else {
+                MessageServer* server = createReactorServer( opts , handler , workers );
+                if ( server )
+                    return server;
+                warning() << "network reactor is not supported on this platform, "
+                          << "using a thread per connection" << endl;
+            }
+        }
         return new PortMessageServer( opts , handler );
     }
 
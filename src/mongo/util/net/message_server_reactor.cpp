@@ -0,0 +1,517 @@
+// message_server_reactor.cpp
+
+/*    Copyright 2014 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+/*
+  Event driven MessageServer.
+
+  Idle connections are parked in an epoll set instead of each owning a thread.  A single
+  reactor thread waits for sockets to become readable and reads whatever they have ready into a
+  per connection buffer, without ever blocking.  Only once a whole message has arrived is the
+  connection handed to a worker thread, so a slow client, or one that stops part way through a
+  message, costs no thread at all.  Sockets are registered EPOLLONESHOT, so a connection is
+  owned by either the reactor or at most one worker at a time, and is re-armed once its message
+  has been processed.
+
+  Requests may block on a worker for a long time, waiting for a lock, for data (awaitData
+  getMores), or for another connection to unblock them (fsyncLock/fsyncUnlock).  The worker
+  pool therefore starts another thread whenever a message arrives while every worker is busy,
+  and the extra threads exit again once they have been idle for a while.
+ */
+
+#define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kNetworking
+
+#include "mongo/pch.h"
+
+#include "mongo/util/net/message_port.h"
+#include "mongo/util/net/message_server.h"
+
+#ifdef __linux__
+
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+#include <deque>
+#include <sys/epoll.h>
+
+#include "mongo/db/lasterror.h"
+#include "mongo/db/server_options.h"
+#include "mongo/db/stats/counters.h"
+#include "mongo/stdx/functional.h"
+#include "mongo/util/concurrency/thread_name.h"
+#include "mongo/util/concurrency/ticketholder.h"
+#include "mongo/util/exit.h"
+#include "mongo/util/log.h"
+#include "mongo/util/net/listen.h"
+#include "mongo/util/net/message.h"
+#include "mongo/util/net/message_assembler.h"
+
+namespace mongo {
+
+namespace {
+
+    /**
+     * Runs tasks on at least 'minThreads' threads, and starts another thread whenever a task is
+     * scheduled while none is idle.  Threads beyond the minimum exit once they have been idle
+     * for kIdleSecs.
+     *
+     * The reactor schedules at most one task per connection at a time, so there are never more
+     * threads than a thread per connection server would have.
+     */
+    class WorkerPool : boost::noncopyable {
+    public:
+        explicit WorkerPool( int minThreads )
+            : _minThreads( minThreads ), _threads( 0 ), _idle( 0 ) {
+        }
+
+        void startThreads() {
+            boost::mutex::scoped_lock lk( _mutex );
+            while ( _threads < _minThreads && _startThread() ) {
+            }
+        }
+
+        void schedule( const stdx::function<void()>& task ) {
+            boost::mutex::scoped_lock lk( _mutex );
+            _tasks.push_back( task );
+            if ( _tasks.size() > static_cast<size_t>( _idle ) )
+                _startThread();
+            _condition.notify_one();
+        }
+
+    private:
+        static const int kIdleSecs = 30;
+
+        /**
+         * If the thread can't be started the task waits for a running one.
+         * @return false if the thread couldn't be started
+         */
+        bool _startThread() {
+            try {
+                boost::thread worker( stdx::bind( &WorkerPool::_run, this ) );
+                worker.detach();
+            }
+            catch ( const boost::thread_resource_error& ) {
+                warning() << "network reactor could not start a worker thread, "
+                          << _threads << " threads running" << endl;
+                return false;
+            }
+            _threads++;
+            return true;
+        }
+
+        void _run() {
+            setThreadName( "reactorWorker" );
+
+            boost::mutex::scoped_lock lk( _mutex );
+            while ( true ) {
+                while ( _tasks.empty() ) {
+                    _idle++;
+                    const bool notified =
+                        _condition.timed_wait( lk, boost::posix_time::seconds( kIdleSecs ) );
+                    _idle--;
+                    if ( ! notified && _tasks.empty() && _threads > _minThreads ) {
+                        _threads--;
+                        return;
+                    }
+                }
+
+                stdx::function<void()> task = _tasks.front();
+                _tasks.pop_front();
+
+                lk.unlock();
+                task();
+                lk.lock();
+            }
+        }
+
+        const int _minThreads;
+
+        boost::mutex _mutex;
+        boost::condition_variable _condition;
+        std::deque<stdx::function<void()> > _tasks;
+        int _threads;
+        int _idle;      // threads waiting for a task
+    };
+
+    class ReactorMessageServer : public MessageServer , public Listener {
+    public:
+        /**
+         * @param handler must support detachable sessions and outlive this server
+         * @param workerThreads number of threads always running handler callbacks
+         */
+        ReactorMessageServer( const MessageServer::Options& opts,
+                              MessageHandler* handler,
+                              int workerThreads )
+            : Listener( "" , opts.ipList, opts.port ),
+              _handler( handler ),
+              _workerThreads( workerThreads ),
+              _workers( workerThreads ),
+              _epfd( -1 ) {
+            verify( _handler->canDetachSessions() );
+        }
+
+        virtual ~ReactorMessageServer() {
+            if ( _epfd >= 0 )
+                close( _epfd );
+        }
+
+        virtual void acceptedMP(MessagingPort * p) {
+            if ( ! Listener::globalTicketHolder.tryAcquire() ) {
+                log() << "connection refused because too many open connections: " << Listener::globalTicketHolder.used() << endl;
+
+                p->shutdown();
+                delete p;
+
+                sleepmillis(2); // otherwise we'll hard loop
+                return;
+            }
+
+            p->psock->setLogLevel(logger::LogSeverity::Debug(1));
+
+            // connected() runs on a worker so that handlers see every callback on a pool thread
+            _workers.schedule( stdx::bind( &ReactorMessageServer::_serviceConnected,
+                                           this,
+                                           new Connection(p) ) );
+        }
+
+        virtual void setAsTimeTracker() {
+            Listener::setAsTimeTracker();
+        }
+
+        virtual void setupSockets() {
+            Listener::setupSockets();
+        }
+
+        void run() {
+            _epfd = epoll_create1( EPOLL_CLOEXEC );
+            if ( _epfd < 0 ) {
+                error() << "epoll_create1 failed: " << errnoWithDescription() << endl;
+                fassertFailed( 18650 );
+            }
+
+            log() << "network reactor using " << _workerThreads << " worker threads" << endl;
+            _workers.startThreads();
+            boost::thread reactor( stdx::bind( &ReactorMessageServer::_reactorLoop, this ) );
+
+            initAndListen();
+        }
+
+        virtual bool useUnixSockets() const { return true; }
+
+    private:
+        /**
+         * Per connection state that the thread-per-connection server keeps on its stack.
+         */
+        struct Connection {
+            explicit Connection( MessagingPort* p )
+                : port( p ), lastError( new LastError() ), session( NULL ), armed( false ) {
+            }
+
+            scoped_ptr<MessagingPort> port;
+            scoped_ptr<LastError> lastError;
+            void* session;      // owned by the handler; see MessageHandler::detachSession
+            bool armed;         // registered with the epoll set
+
+            MessageAssembler assembler;
+            Message incoming;   // set by the assembler once a whole message has arrived
+        };
+
+        /**
+         * Installs a connection's thread locals on the current worker for the lifetime of
+         * this object.  The handler's session is attached and detached by the caller, since
+         * the very first and very last callbacks do not have one.
+         */
+        class ConnectionScope : boost::noncopyable {
+        public:
+            explicit ConnectionScope( Connection* conn ) {
+                lastError.reset( conn->lastError.get() );
+                const std::string name = str::stream() << "conn" << conn->port->connectionId();
+                setThreadName( name );
+            }
+
+            ~ConnectionScope() {
+                // the Connection owns the LastError, not the thread
+                lastError.release();
+                setThreadName( "reactorWorker" );
+            }
+        };
+
+        void _reactorLoop() {
+            setThreadName( "reactor" );
+
+            const int kMaxEvents = 256;
+            epoll_event events[kMaxEvents];
+
+            while ( ! inShutdown() ) {
+                // wake up once a second to notice shutdown
+                int n = epoll_wait( _epfd, events, kMaxEvents, 1000 );
+                if ( n < 0 ) {
+                    if ( errno == EINTR )
+                        continue;
+                    error() << "epoll_wait failed: " << errnoWithDescription() << endl;
+                    fassertFailed( 18651 );
+                }
+
+                for ( int i = 0; i < n; i++ ) {
+                    _readReady( static_cast<Connection*>( events[i].data.ptr ) );
+                }
+            }
+        }
+
+        /**
+         * Runs on the reactor thread: reads what the connection has ready, and hands it to a
+         * worker if a message is complete or the connection needs closing.
+         */
+        void _readReady( Connection* conn ) {
+            MessageAssembler::State state;
+            try {
+                state = conn->assembler.readFrom( conn->port->psock.get(), &conn->incoming );
+            }
+            catch ( const SocketException& ) {
+                // hung up or in error, already logged by the socket
+                _workers.schedule( stdx::bind( &ReactorMessageServer::_serviceClosed,
+                                               this,
+                                               conn ) );
+                return;
+            }
+
+            if ( state == MessageAssembler::kNeedMore ) {
+                if ( ! _arm( conn ) ) {
+                    _workers.schedule( stdx::bind( &ReactorMessageServer::_serviceClosed,
+                                                   this,
+                                                   conn ) );
+                }
+                return;
+            }
+
+            _workers.schedule( stdx::bind( &ReactorMessageServer::_serviceReadable,
+                                           this,
+                                           conn,
+                                           state ) );
+        }
+
+        void _serviceConnected( Connection* conn ) {
+            bool ok = false;
+            {
+                ConnectionScope scope( conn );
+                ok = _guard( stdx::bind( &ReactorMessageServer::_connected, this, conn ) );
+                conn->session = _handler->detachSession( conn->port.get() );
+            }
+
+            if ( ok )
+                ok = _arm( conn );
+            if ( ! ok )
+                _close( conn );
+        }
+
+        void _serviceReadable( Connection* conn, MessageAssembler::State state ) {
+            bool ok = false;
+            {
+                ConnectionScope scope( conn );
+                _handler->attachSession( conn->port.get(), conn->session );
+                conn->session = NULL;
+
+                ok = _guard( stdx::bind( &ReactorMessageServer::_processOne, this, conn, state ) );
+                conn->session = _handler->detachSession( conn->port.get() );
+            }
+
+            if ( ok )
+                ok = _arm( conn );
+            if ( ! ok )
+                _close( conn );
+        }
+
+        void _serviceClosed( Connection* conn ) {
+            _logEndConnection( conn->port.get() );
+            _close( conn );
+        }
+
+        bool _connected( Connection* conn ) {
+            _handler->connected( conn->port.get() );
+            return true;
+        }
+
+        /**
+         * Processes what the assembler found on the connection, as MessagingPort::recv and the
+         * thread-per-connection server would.
+         * @return false if the connection must be closed
+         */
+        bool _processOne( Connection* conn, MessageAssembler::State state ) {
+            if ( inShutdown() )
+                return false;
+
+            MessagingPort* p = conn->port.get();
+            switch ( state ) {
+            case MessageAssembler::kMessage:
+                break;
+            case MessageAssembler::kEndianCheck: {
+                // Endian check from the client, after connecting, to see what mode server is
+                // running in.
+                unsigned foo = 0x10203040;
+                p->psock->send( (char *) &foo, 4, "endian" );
+                p->psock->setHandshakeReceived();
+                return true;
+            }
+            case MessageAssembler::kHttp: {
+                string msg = "It looks like you are trying to access MongoDB over HTTP on the native driver port.\n";
+                LOG( p->psock->getLogLevel() ) << msg;
+                std::stringstream ss;
+                ss << "HTTP/1.0 200 OK\r\nConnection: close\r\nContent-Type: text/plain\r\nContent-Length: " << msg.size() << "\r\n\r\n" << msg;
+                string s = ss.str();
+                p->psock->send( s.c_str(), s.size(), "http" );
+                _logEndConnection( p );
+                return false;
+            }
+            case MessageAssembler::kInvalid:
+                LOG(0) << "recv(): message len is invalid. "
+                       << "Min " << sizeof(MSGHEADER::Value) << " Max: " << MaxMessageSizeBytes;
+                _logEndConnection( p );
+                return false;
+            default:
+                invariant( false );
+            }
+
+            Message& m = conn->incoming;
+
+            // The reactor is never used with SSL enabled, see createServer().
+            if ( p->psock->isAwaitingHandshake() ) {
+                const int responseTo = m.header().getResponseTo();
+                uassert( 18657,
+                         "SSL handshake received but the network reactor does not support SSL",
+                         responseTo == 0 || responseTo == -1 );
+                p->psock->setHandshakeReceived();
+            }
+
+            _handler->process( m , p , conn->lastError.get() );
+            m.reset();
+            networkCounter.hit( p->psock->getBytesIn() , p->psock->getBytesOut() );
+            p->psock->clearCounters();
+            return true;
+        }
+
+        void _logEndConnection( MessagingPort* p ) {
+            if (!serverGlobalParams.quiet) {
+                int conns = Listener::globalTicketHolder.used()-1;
+                const char* word = (conns == 1 ? " connection" : " connections");
+                log() << "end connection " << p->psock->remoteString() << " (" << conns << word << " now open)" << endl;
+            }
+        }
+        /**
+         * Runs a handler callback with the same exception policy as the thread-per-connection
+         * server.
+         * @return false if the connection must be closed
+         */
+        bool _guard( const stdx::function<bool()>& fn ) {
+            try {
+                return fn();
+            }
+            catch ( AssertionException& e ) {
+                log() << "AssertionException handling request, closing client connection: " << e << endl;
+            }
+            catch ( SocketException& e ) {
+                log() << "SocketException handling request, closing client connection: " << e << endl;
+            }
+            catch ( const DBException& e ) { // must be right above std::exception to avoid catching subclasses
+                log() << "DBException handling request, closing client connection: " << e << endl;
+            }
+            catch ( std::exception &e ) {
+                error() << "Uncaught std::exception: " << e.what() << ", terminating" << endl;
+                dbexit( EXIT_UNCAUGHT );
+            }
+            return false;
+        }
+
+        /**
+         * (Re)registers the connection for a single readiness notification.
+         */
+        bool _arm( Connection* conn ) {
+            epoll_event ev;
+            ev.events = EPOLLIN | EPOLLRDHUP | EPOLLONESHOT;
+            ev.data.ptr = conn;
+
+            const int op = conn->armed ? EPOLL_CTL_MOD : EPOLL_CTL_ADD;
+            if ( epoll_ctl( _epfd, op, conn->port->psock->rawFD(), &ev ) != 0 ) {
+                log() << "epoll_ctl failed, closing client connection: "
+                      << errnoWithDescription() << endl;
+                return false;
+            }
+            conn->armed = true;
+            return true;
+        }
+
+        /**
+         * Runs the handler's disconnect path and frees the connection.  Called on the worker
+         * that currently owns it, so the reactor can not hand it out concurrently.
+         */
+        void _close( Connection* conn ) {
+            MessagingPort* p = conn->port.get();
+            {
+                ConnectionScope scope( conn );
+                _handler->attachSession( p, conn->session );
+                _handler->disconnected( p );
+                _handler->destroySession( _handler->detachSession( p ) );
+                conn->session = NULL;
+            }
+
+            if ( conn->armed )
+                epoll_ctl( _epfd, EPOLL_CTL_DEL, p->psock->rawFD(), NULL );
+            p->shutdown();
+
+            delete conn;
+            Listener::globalTicketHolder.release();
+        }
+
+        MessageHandler* _handler;
+        const int _workerThreads;
+        WorkerPool _workers;
+        int _epfd;
+    };
+
+}  // namespace
+
+    MessageServer * createReactorServer( const MessageServer::Options& opts,
+                                         MessageHandler * handler,
+                                         int workerThreads ) {
+        return new ReactorMessageServer( opts, handler, workerThreads );
+    }
+
+}  // namespace mongo
+
+#else
+
+namespace mongo {
+
+    MessageServer * createReactorServer( const MessageServer::Options& opts,
+                                         MessageHandler * handler,
+                                         int workerThreads ) {
+        return NULL;
+    }
+
+}  // namespace mongo
+
+#endif
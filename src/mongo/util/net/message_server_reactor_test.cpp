@@ -0,0 +1,347 @@
+// message_server_reactor_test.cpp
+
+/*    Copyright 2014 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/tss.hpp>
+
+#include "mongo/db/server_options.h"
+#include "mongo/unittest/unittest.h"
+#include "mongo/util/net/listen.h"
+#include "mongo/util/net/message.h"
+#include "mongo/util/net/message_port.h"
+#include "mongo/util/net/message_server.h"
+#include "mongo/util/time_support.h"
+#include "mongo/util/timer.h"
+
+/**
+ * Tests for the network reactor MessageServer, run against a server on a local port with a
+ * single worker thread, so that anything holding a worker for longer than one message shows.
+ */
+
+#ifdef __linux__
+
+namespace mongo {
+
+    class DBClientBase;
+    class OperationContext;
+
+    // Symbols defined to build the binary correctly.
+
+    bool inShutdown() {
+        return false;
+    }
+
+    DBClientBase* createDirectClient(OperationContext* txn) { return NULL; }
+
+    void dbexit(ExitCode rc, const char *why) {
+        ::_exit(rc);
+    }
+
+    bool haveLocalShardingInfo(const std::string& ns) {
+        return false;
+    }
+
+}  // namespace mongo
+
+namespace {
+
+    using namespace mongo;
+    using std::string;
+
+    const int kPort = 27029;
+    const double kTimeoutSecs = 30;
+
+    /**
+     * Replies to each message with a reply computed from its text:
+     *   "echo:<text>"  replies <text>
+     *   "count"        replies the number of messages seen on this connection, kept in a thread
+     *                  local which follows the connection through the session hooks
+     *   "block"        waits for a "release" from another connection, then replies "released"
+     *   "release"      releases the blocked requests and replies "ok"
+     */
+    class TestHandler : public MessageHandler {
+    public:
+        TestHandler() : _released(false) {}
+
+        virtual void connected(AbstractMessagingPort* p) {
+            _count.reset(new int(0));
+        }
+
+        virtual void process(Message& m, AbstractMessagingPort* p, LastError* le) {
+            ++*_count;
+
+            const string text(m.singleData().data());
+            string reply;
+            if (text.compare(0, 5, "echo:") == 0) {
+                reply = text.substr(5);
+            }
+            else if (text == "count") {
+                reply = str::stream() << *_count;
+            }
+            else if (text == "block") {
+                boost::mutex::scoped_lock lk(_mutex);
+                const boost::system_time deadline =
+                    boost::get_system_time() + boost::posix_time::seconds(kTimeoutSecs);
+                while (!_released && _condition.timed_wait(lk, deadline)) {
+                }
+                reply = _released ? "released" : "timed out";
+            }
+            else if (text == "release") {
+                boost::mutex::scoped_lock lk(_mutex);
+                _released = true;
+                _condition.notify_all();
+                reply = "ok";
+            }
+
+            Message response;
+            response.setData(opReply, reply.c_str());
+            p->reply(m, response);
+        }
+
+        virtual void disconnected(AbstractMessagingPort* p) {
+        }
+
+        virtual bool canDetachSessions() const { return true; }
+
+        virtual void* detachSession(AbstractMessagingPort* p) {
+            return _count.release();
+        }
+
+        virtual void attachSession(AbstractMessagingPort* p, void* session) {
+            _count.reset(static_cast<int*>(session));
+        }
+
+        virtual void destroySession(void* session) {
+            delete static_cast<int*>(session);
+        }
+
+    private:
+        boost::thread_specific_ptr<int> _count;
+
+        boost::mutex _mutex;
+        boost::condition_variable _condition;
+        bool _released;
+    };
+
+    TestHandler testHandler;
+
+    void runServer(MessageServer* server) {
+        server->setupSockets();
+        server->run();
+    }
+
+    /**
+     * Starts the server the first time, it then runs until the test binary exits.
+     */
+    void startServer() {
+        static MessageServer* server = NULL;
+        if (server) {
+            return;
+        }
+
+        serverGlobalParams.reactorWorkerThreads = 1;
+
+        MessageServer::Options options;
+        options.port = kPort;
+        options.ipList = "127.0.0.1";
+        server = createServer(options, &testHandler);
+        boost::thread(runServer, server).detach();
+    }
+
+    /**
+     * A client of the test server, connected when constructed.
+     */
+    class TestClient {
+    public:
+        TestClient() : _port(kTimeoutSecs) {
+            SockAddr addr("127.0.0.1", kPort);
+            Timer timer;
+            while (!_port.connect(addr)) {
+                ASSERT_LESS_THAN(timer.seconds(), kTimeoutSecs);
+                sleepmillis(10);
+            }
+        }
+
+        /** Sends the message with 'text', and returns the reply. */
+        string call(const string& text) {
+            send(text, 0, std::numeric_limits<int>::max());
+            return recv();
+        }
+
+        /** Sends bytes [begin, end) of the message with 'text'. */
+        void send(const string& text, int begin, int end) {
+            Message m;
+            m.setData(dbMsg, text.c_str());
+            m.header().setId(nextMessageId());
+            m.header().setResponseTo(0);
+
+            end = std::min(end, m.header().getLen());
+            _port.psock->send(m.singleData().view2ptr() + begin, end - begin, "test");
+        }
+
+        /** Sends the message with 'text' a byte at a time, pausing after each. */
+        void sendSlowly(const string& text, int pauseMillis) {
+            Message m;
+            m.setData(dbMsg, text.c_str());
+            for (int i = 0; i < m.header().getLen(); i++) {
+                send(text, i, i + 1);
+                sleepmillis(pauseMillis);
+            }
+        }
+
+        string recv() {
+            Message response;
+            ASSERT(_port.recv(response));
+            return response.singleData().data();
+        }
+
+        Socket* socket() {
+            return _port.psock.get();
+        }
+
+    private:
+        MessagingPort _port;
+    };
+
+    class ReactorTest : public unittest::Test {
+    protected:
+        void setUp() {
+            startServer();
+        }
+    };
+
+    TEST_F(ReactorTest, Echo) {
+        TestClient client;
+        ASSERT_EQUALS("hello", client.call("echo:hello"));
+        ASSERT_EQUALS("again", client.call("echo:again"));
+    }
+
+    TEST_F(ReactorTest, LargeMessage) {
+        TestClient client;
+        const string big(4 * 1024 * 1024, 'x');
+        ASSERT_EQUALS(big, client.call("echo:" + big));
+    }
+
+    // A client that stops part way through a message doesn't hold the only worker.
+    TEST_F(ReactorTest, PartialMessage) {
+        TestClient partial;
+        TestClient other;
+
+        // Part of the header, then part of the body
+        partial.send("echo:partial", 0, 7);
+        ASSERT_EQUALS("first", other.call("echo:first"));
+        partial.send("echo:partial", 7, 20);
+        ASSERT_EQUALS("second", other.call("echo:second"));
+
+        partial.send("echo:partial", 20, std::numeric_limits<int>::max());
+        ASSERT_EQUALS("partial", partial.recv());
+    }
+
+    // Two messages sent at once are both answered.
+    TEST_F(ReactorTest, PipelinedMessages) {
+        TestClient client;
+        client.send("echo:one", 0, std::numeric_limits<int>::max());
+        client.send("echo:two", 0, std::numeric_limits<int>::max());
+        ASSERT_EQUALS("one", client.recv());
+        ASSERT_EQUALS("two", client.recv());
+    }
+
+    // Another client is served while a slow client's message trickles in.
+    TEST_F(ReactorTest, SlowClient) {
+        TestClient slow;
+        TestClient other;
+
+        // Takes over a second to send
+        boost::thread slowThread(stdx::bind(&TestClient::sendSlowly, &slow, "echo:slow", 50));
+        Timer timer;
+        for (int i = 0; i < 10; i++) {
+            const string text = str::stream() << i;
+            ASSERT_EQUALS(text, other.call("echo:" + text));
+        }
+        ASSERT_LESS_THAN(timer.millis(), 500);
+
+        slowThread.join();
+        ASSERT_EQUALS("slow", slow.recv());
+    }
+
+    // A request blocked until another connection releases it doesn't deadlock the pool.
+    TEST_F(ReactorTest, BlockedRequest) {
+        TestClient blocked;
+        TestClient releaser;
+
+        blocked.send("block", 0, std::numeric_limits<int>::max());
+        ASSERT_EQUALS("other", releaser.call("echo:other"));
+        ASSERT_EQUALS("ok", releaser.call("release"));
+        ASSERT_EQUALS("released", blocked.recv());
+    }
+
+    // The handler's thread locals follow each connection from worker to worker.
+    TEST_F(ReactorTest, SessionFollowsConnection) {
+        TestClient a;
+        TestClient b;
+        ASSERT_EQUALS("1", a.call("count"));
+        ASSERT_EQUALS("1", b.call("count"));
+        ASSERT_EQUALS("2", a.call("count"));
+        ASSERT_EQUALS("3", a.call("count"));
+        ASSERT_EQUALS("2", b.call("count"));
+    }
+
+    TEST_F(ReactorTest, EndianCheck) {
+        TestClient client;
+
+        MSGHEADER::Value header;
+        memset(&header, 0, sizeof(header));
+        header.view().setMessageLength(-1);
+        client.socket()->send(reinterpret_cast<const char*>(&header), sizeof(header), "test");
+
+        unsigned endian = 0;
+        client.socket()->recv(reinterpret_cast<char*>(&endian), sizeof(endian));
+        ASSERT_EQUALS(0x10203040U, endian);
+        ASSERT_EQUALS("after", client.call("echo:after"));
+    }
+
+    TEST_F(ReactorTest, InvalidLengthCloses) {
+        TestClient client;
+
+        MSGHEADER::Value header;
+        memset(&header, 0, sizeof(header));
+        header.view().setMessageLength(5);
+        client.socket()->send(reinterpret_cast<const char*>(&header), sizeof(header), "test");
+
+        char c;
+        ASSERT_THROWS(client.socket()->recv(&c, 1), SocketException);
+    }
+
+} // namespace
+
+#endif
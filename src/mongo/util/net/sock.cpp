@@ -733,6 +733,24 @@ namespace mongo {
         return x;
     }
 
+#ifndef _WIN32
+    int Socket::recvAvailable( char* buf, int max ) {
+#ifdef MONGO_SSL
+        verify( ! _sslConnection.get() );
+#endif
+        while ( true ) {
+            int ret = ::recv( _fd , buf , max , portRecvFlags | MSG_DONTWAIT );
+            if ( ret > 0 ) {
+                _bytesIn += ret;
+                return ret;
+            }
+            if ( ret < 0 && ( errno == EAGAIN || errno == EWOULDBLOCK ) )
+                return 0;
+            handleRecvError( ret, max ); // returns only on EINTR
+        }
+    }
+#endif
+
     // throws if SSL_read fails or recv returns an error
     int Socket::_recv( char *buf, int max ) {
 #ifdef MONGO_SSL
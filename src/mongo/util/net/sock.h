@@ -222,6 +222,16 @@ namespace mongo {
         // recv len or throw SocketException
         void recv( char * data , int len );
         int unsafe_recv( char *buf, int max );
+
+#ifndef _WIN32
+        /**
+         * Reads whatever is already buffered for this socket, up to 'max' bytes, without
+         * blocking.  Not supported on SSL sockets, where SSL_read may need to block.
+         * @return the number of bytes read, 0 if none are available
+         * @throws SocketException if the connection was closed or failed
+         */
+        int recvAvailable( char* buf, int max );
+#endif
         
         logger::LogSeverity getLogLevel() const { return _logLevel; }
         void setLogLevel( logger::LogSeverity ll ) { _logLevel = ll; }